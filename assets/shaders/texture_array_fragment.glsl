@@ -0,0 +1,19 @@
+#version 330 core
+
+in vec4 oCol;
+in vec3 oUV;
+
+out vec4 fragColor;
+
+uniform bool debug_depth;
+uniform sampler2DArray textures;
+
+void main() {
+    vec4 outputColor;
+    if (debug_depth) {
+        outputColor = vec4(vec3(gl_FragCoord.z), 1.0);
+    } else {
+        outputColor = texture(textures, oUV) * oCol;
+    }
+    fragColor = outputColor;
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 330 core
+
+layout (location = 0) in vec3 iPos;
+layout (location = 1) in vec4 iCol;
+layout (location = 2) in vec2 iUV;
+layout (location = 3) in float iLayer;
+
+out vec4 oCol;
+out vec3 oUV;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+void main() {
+    gl_Position = projection * view * model * vec4(iPos, 1.0);
+    oCol = iCol;
+    // the third texture coordinate selects the texture array layer
+    oUV = vec3(iUV, iLayer);
+}
\ No newline at end of file
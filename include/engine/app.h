@@ -7,16 +7,79 @@ Contains all the app-related functions
 #define APP_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 #include <GLFW/glfw3.h>
 
-// creates the app with the given window parameters
+// the archive built from the assets folder by the G3CE_assets CMake target, mounted by app_create() when it exists
+#define APP_ASSETS_ARCHIVE "./bin/assets.g3pak"
+
+// fixed updates run at most in a frame by app_loopFixed() when not given
+#define APP_DEFAULT_MAX_STEPS 5
+
+// settings of the headless benchmark mode (see app_createHeadless())
+typedef struct {
+    unsigned int frames;       // frames measured before the app closes
+    unsigned int warmupFrames; // frames rendered before the measured ones (to leave out shader compilation, caches, etc...)
+    double timestep;           // seconds every frame lasts (see app_getFrameTime()), 0 means 1/60
+    char* reportPath;          // where the JSON report is written when the loop ends (NULL to only log the summary)
+} AppBenchmark;
+
+// creates the app with the given window parameters (and mounts APP_ASSETS_ARCHIVE if it has been built, and initializes the asynchronous reads, the job threads and logging)
 void app_create(int width, int height, char* title, bool resizable);
+/*
+Creates the app without a display: the window is an offscreen one on GLFW's null platform (see window_createHeadless()),
+vsync is off and every frame lasts the same timestep (see app_getFrameTime()). The app loop renders the warmup frames and then the
+measured ones, closes the app by itself and writes the benchmark report (frame time percentiles, CPU and GPU scopes,
+render counters, etc...), so the performance of the app can be tracked on machines without a display nor a GPU.
+Parameters:
+    - width (int): the framebuffer width
+    - height (int): the framebuffer height
+    - benchmark (AppBenchmark): the frames to run and where to write the report
+*/
+void app_createHeadless(int width, int height, AppBenchmark benchmark);
+// returns whether the app has been created by app_createHeadless()
+bool app_isHeadless();
 // starts the app by running the given functions in a loop
 void app_loop(void (*main_init)(), void (*main_tick)(), void (*main_draw)(), void (*main_exit)(), void (*on_resize)());
+/*
+Starts the app with a fixed update rate: every frame runs main_tick() as many times as needed (possibly none) for the
+updates to keep up with the real time, each of them advancing the app by exactly 1 / updateRate seconds, so the
+simulation does not depend on the frame rate. main_draw() gets how far the frame is between the last two updates, to
+interpolate the rendered state. When a frame would need more than maxSteps updates (rendering too slow, a debugger
+break, etc...) the excess time is dropped: the simulation slows down instead of falling further and further behind.
+Parameters:
+    - updateRate (double): the updates per second (e.g. 60)
+    - maxSteps (unsigned int): the updates run at most in a frame (0 means APP_DEFAULT_MAX_STEPS)
+    - main_init, main_tick, main_exit, on_resize: the same functions app_loop() takes
+    - main_draw (void (*)(float alpha)): the rendering function, alpha is in [0, 1) (0 is the state of the last update)
+*/
+void app_loopFixed(double updateRate, unsigned int maxSteps, void (*main_init)(), void (*main_tick)(), void (*main_draw)(float alpha), void (*main_exit)(), void (*on_resize)());
+/*
+Starts the app with the simulation and the rendering pipelined on two threads: while the render thread (the calling one,
+which owns the window and the OpenGL context) renders the frame N, a simulation thread runs main_tick() for the frame
+N + 1, so a frame lasts the longest of the two instead of their sum. The state the rendering needs (transforms, camera,
+etc...) goes in a snapshot: main_tick() writes the next one (which starts as a copy of the current one) and main_draw()
+only reads the current one, the two are swapped at the end of every frame. The rest of the state of the simulation
+MUST NOT be touched by main_draw(), nor OpenGL and the window by main_tick() (reading the input and app_requestClose()
+are fine: the events are polled and the close request checked while the simulation thread is idle). main_init(), main_exit(), on_resize() and the callbacks of the
+asynchronous reads run on the render thread. The first tick runs before the first frame, with a delta time of 0.
+Parameters:
+    - snapshotSize (size_t): the bytes of a snapshot (both start zeroed)
+    - main_init, main_exit, on_resize: the same functions app_loop() takes
+    - main_tick (void (*)(void* snapshot)): the update function, writing the next snapshot
+    - main_draw (void (*)(const void* snapshot)): the rendering function, reading the current snapshot
+*/
+void app_loopPipelined(size_t snapshotSize, void (*main_init)(), void (*main_tick)(void* snapshot), void (*main_draw)(const void* snapshot), void (*main_exit)(), void (*on_resize)());
+// returns the seconds the current update advances the app by (the fixed timestep with app_loopFixed(), the frame time otherwise)
+double app_getDeltaTime();
+// returns the seconds between the starts of the last two frames (the benchmark timestep when headless)
+double app_getFrameTime();
+// returns how far the current frame is between the last two fixed updates, in [0, 1) (always 0 with app_loop())
+float app_getInterpolationAlpha();
 // requests the app to close, it CANNOT be called outside of the app main loop
 void app_requestClose();
-// closes the app by terminating GLFW
+// closes the app by terminating GLFW (and stopping the job threads, shutting down the asynchronous reads, unmounting the archives, freeing the profiler and the engine arenas, reporting the memory leaks and writing out the pending logs)
 void app_terminate();
 
 #endif
\ No newline at end of file
@@ -43,21 +43,21 @@ void object_destroy(Object* o);
 // SETTERS
 // sets the given object transform to the given transform
 void object_setTransformByTransform(Object* o, Transform t);
-// sets the given object transform vectors to the given transform vectors
+// sets the given object transform vectors to the given transform vectors (the rotation as pitch, yaw and roll in degrees)
 void object_setTransformByVectors(Object* o, vec3 position, vec3 rotation, vec3 scale);
-// sets the given object transform values to the given transform values
+// sets the given object transform values to the given transform values (angles are in degrees)
 void object_setTransformByValues(Object* o, float x, float y, float z, float pitch, float yaw, float roll, float xs, float ys, float zs);
 
 // sets the given object position to the given position vector
 void object_setPositionByVector(Object* o, vec3 position);
-// sets the given object rotation to the given rotation vector
+// sets the given object rotation to the given rotation vector (pitch, yaw, roll) (angles are in degrees)
 void object_setRotationByVector(Object* o, vec3 rotation);
 // sets the given object scale to the given scale vector
 void object_setScaleByVector(Object* o, vec3 scale);
 
 // sets the given object position to the given position values
 void object_setPositionByValues(Object* o, float x, float y, float z);
-// sets the given object rotation to the given rotation values
+// sets the given object rotation to the given rotation values (angles are in degrees)
 void object_setRotationByValues(Object* o, float pitch, float yaw, float roll);
 // sets the given object scale to the given scale values
 void object_setScaleByValues(Object* o, float xs, float ys, float zs);
@@ -65,14 +65,14 @@ void object_setScaleByValues(Object* o, float xs, float ys, float zs);
 // OPERATIONS
 // increments the given object position by the given translation vector
 void object_changePositionByVector(Object* o, vec3 translation);
-// increments the given object rotation by the given rotation vector
+// rotates the given object by the given rotation vector (pitch, yaw, roll) around the parent axes (angles are in degrees)
 void object_changeRotationByVector(Object* o, vec3 rotation);
 // increments the given object scale by the given scaling vector
 void object_changeScaleByVector(Object* o, vec3 scaling);
 
 // increments the given object position by the given position values
 void object_changePositionByValues(Object* o, float xm, float ym, float zm);
-// increments the given object rotation by the given rotation values
+// rotates the given object by the given rotation values around the parent axes (angles are in degrees)
 void object_changeRotationByValues(Object* o, float xr, float yr, float zr);
 // increments the given object scale by the given scale values
 void object_changeScaleByValues(Object* o, float xs, float ys, float zs);
@@ -0,0 +1,106 @@
+/*
+SCENE:
+Scene graph: a hierarchy of nodes, each one with a local transform (relative to its parent) and a world matrix (its
+parent world matrix multiplied by its local matrix), e.g. the parts of an articulated model or a camera attached to
+a moving object.
+The nodes are stored sorted by depth (the roots first, then their children, and so on), so the world matrices are
+updated in a single linear pass where every parent comes before its children, and the nodes of a depth, which do not
+depend on each other, are split among the job threads. Only the nodes whose local transform changed, and their
+subtrees, are updated.
+A node can be linked to an entity of a world (see world.h): its world matrix then becomes the model matrix of the
+Renderable of the entity (which needs no WORLD_TRANSFORM).
+*/
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "engine/core/world.h"
+#include "engine/math/linal.h"
+#include "engine/math/transform.h"
+
+// a node handle (the generation in the high 32 bits, the id in the low ones), 0 is never a valid node
+typedef uint64_t SceneNode;
+#define SCENE_NODE_NULL 0
+
+typedef struct {
+    // id -> node (ids are stable, the positions change when the nodes are sorted)
+    unsigned int* generations;
+    bool* alive;
+    unsigned int* positions;
+    unsigned int* freeIds;
+    unsigned int freeCount;
+    unsigned int idCount;
+    unsigned int idCapacity;
+    // position -> node, sorted by depth when sorted is true
+    unsigned int* ids;
+    unsigned int* parents;  // the parent ids (UINT32_MAX for the roots)
+    unsigned int* depths;
+    Transform* locals;
+    mat4* worlds;
+    Entity* entities;       // the linked entities (ENTITY_NULL if none)
+    unsigned char* dirty;   // the local transform changed since the last update
+    unsigned char* changed; // the world matrix changed in the last update
+    unsigned int count;
+    unsigned int capacity;
+    bool sorted;
+    // the first position of every depth (levelCount + 1 entries)
+    unsigned int* levels;
+    unsigned int levelCount;
+    unsigned int levelCapacity;
+} Scene;
+
+/*
+Creates an empty scene.
+You MUST call scene_destroy(Scene*) once the scene is not used anymore
+Parameters:
+    - capacity (unsigned int): the nodes allocated up front (the scene grows when needed, 0 picks a default)
+Returns:
+    The pointer to the scene, NULL if it could not be allocated
+*/
+Scene* scene_create(unsigned int capacity);
+// destroys the given scene with all its nodes (the linked entities are not destroyed)
+void scene_destroy(Scene* scene);
+
+// NODES
+// creates a node with a blank local transform as a child of the given parent (SCENE_NODE_NULL for a root), returns SCENE_NODE_NULL on failure
+SceneNode scene_createNode(Scene* scene, SceneNode parent);
+// destroys a node and all its descendants
+void scene_destroyNode(Scene* scene, SceneNode node);
+// returns true if the handle refers to a node that has not been destroyed
+bool scene_isAlive(Scene* scene, SceneNode node);
+// returns the number of nodes
+unsigned int scene_getNodeCount(Scene* scene);
+// moves a node (and its descendants) under another parent (SCENE_NODE_NULL makes it a root), keeping its local transform, returns false if the parent is in its subtree
+bool scene_setParent(Scene* scene, SceneNode node, SceneNode parent);
+// returns the parent of a node (SCENE_NODE_NULL for a root)
+SceneNode scene_getParent(Scene* scene, SceneNode node);
+// links a node to an entity of the world given to scene_update(), its world matrix becomes the model matrix of the entity Renderable (ENTITY_NULL unlinks it)
+void scene_setEntity(Scene* scene, SceneNode node, Entity entity);
+
+// TRANSFORMS
+// sets the local transform of a node (relative to its parent)
+void scene_setLocalTransform(Scene* scene, SceneNode node, Transform transform);
+// returns the local transform of a node
+Transform scene_getLocalTransform(Scene* scene, SceneNode node);
+// returns the local transform of a node to modify it in place, marking it as changed (valid until a node is created, destroyed or moved)
+Transform* scene_editLocalTransform(Scene* scene, SceneNode node);
+// returns the world matrix of a node as of the last scene_update()
+mat4 scene_getWorldMatrix(Scene* scene, SceneNode node);
+// returns the world position of a node as of the last scene_update()
+vec3 scene_getWorldPosition(Scene* scene, SceneNode node);
+
+/*
+Updates the world matrices of the nodes whose local transform changed and of their descendants (sorting the nodes
+first if the hierarchy changed), the nodes of every depth in parallel on the job threads.
+Parameters:
+    - scene (Scene*): the scene
+    - world (World*): the world of the linked entities, their Renderable model matrices are written (NULL to skip them)
+Returns:
+    The number of nodes updated
+*/
+unsigned int scene_update(Scene* scene, World* world);
+
+#endif
@@ -12,6 +12,17 @@ Window handling with GLFW and OpenGL initialization with GLAD
 
 // creates the window with given parameters
 GLFWwindow* window_create(int width, int height, char* title, bool resizable);
+/*
+Creates an invisible window on GLFW's null platform, which needs no display server: its OpenGL context is created by
+EGL on Mesa's surfaceless platform, rendering into an offscreen (pbuffer) default framebuffer of the given size.
+Vsync is disabled. It works with Mesa's software rasterizer (llvmpipe), so machines without a display nor a GPU can run the app.
+Parameters:
+    - width (int): the framebuffer width
+    - height (int): the framebuffer height
+Returns:
+    the window, NULL if it could not be created
+*/
+GLFWwindow* window_createHeadless(int width, int height);
 // destroyes the window
 void window_destroy();
 
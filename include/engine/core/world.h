@@ -0,0 +1,158 @@
+/*
+WORLD:
+Entity-component storage.
+An entity is only a handle: an index in the world and the generation of that index, so the handle of a destroyed
+entity stays invalid even after its index has been reused by another one. Its data lives in components, every
+component type owning a pool (a sparse set): the components of a type are packed in a contiguous array, so walking
+all the transforms of the world, or all the renderables, reads memory linearly instead of chasing pointers.
+The world starts with two components, WORLD_TRANSFORM (a Transform) and WORLD_RENDERABLE (a Renderable, a mesh shared
+by any number of entities instead of a copy of it), and the systems that draw them: their model matrices are updated,
+culled against the camera frustum and drawn (or recorded into command buffers) in parallel on the job threads.
+Components MUST NOT be added nor removed (and entities not created nor destroyed) while iterating a world.
+*/
+
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "engine/gfx/commandbuffer.h"
+#include "engine/gfx/mesh.h"
+#include "engine/math/linal.h"
+#include "engine/math/transform.h"
+
+// component types a world can have at most
+#define WORLD_MAX_COMPONENTS 32
+// the components every world starts with
+#define WORLD_TRANSFORM 0
+#define WORLD_RENDERABLE 1
+// the mask of a component type (masks are ORed to iterate the entities having all of them)
+#define WORLD_MASK(component) (1u << (component))
+
+// an entity handle (the generation in the high 32 bits, the index in the low ones), 0 is never a valid entity
+typedef uint64_t Entity;
+#define ENTITY_NULL 0
+
+// the data of a drawn entity
+typedef struct {
+    Mesh* mesh;          // shared by the entities drawing it, it MUST outlive them
+    unsigned int shader; // if set to 0 it will be using the currently active shader
+    mat4 model;          // computed from the transform by world_updateModels(), or written by a scene (see scene.h)
+    bool visible;        // computed by world_cull() (true until then)
+} Renderable;
+
+// the components of one type, packed
+typedef struct {
+    size_t size;              // bytes of a component
+    unsigned char* initial;   // the value of an added component
+    unsigned int count;
+    unsigned int capacity;
+    unsigned int* sparse;     // entity index -> index in the pool (UINT32_MAX if the entity does not have it)
+    unsigned int* entities;   // index in the pool -> entity index
+    unsigned char* data;      // the components
+} ComponentPool;
+
+typedef struct {
+    unsigned int* generations; // entity index -> generation of the index
+    uint32_t* masks;           // entity index -> mask of its components
+    bool* alive;
+    unsigned int* freeIndices; // the indices of the destroyed entities, reused first
+    unsigned int freeCount;
+    unsigned int entityCount;  // alive entities
+    unsigned int indexCount;   // indices used so far
+    unsigned int capacity;     // indices allocated
+    ComponentPool pools[WORLD_MAX_COMPONENTS];
+    unsigned int componentCount;
+} World;
+
+// walks the entities having a set of components (see world_iterate())
+typedef struct {
+    World* world;
+    uint32_t mask;
+    unsigned int driver; // the smallest pool of the set, the one walked
+    unsigned int next;
+    Entity entity;                             // the current entity
+    void* components[WORLD_MAX_COMPONENTS];    // its components, indexed by type (only the ones of the mask are set)
+} WorldIterator;
+
+// called on every entity of a set of components, components is indexed by type (only the ones of the mask are set)
+typedef void (*WorldFunction)(Entity entity, void** components, void* data);
+
+/*
+Creates an empty world.
+You MUST call world_destroy(World*) once the world is not used anymore
+Parameters:
+    - capacity (unsigned int): the entities allocated up front (the world grows when needed, 0 picks a default)
+Returns:
+    The pointer to the world, NULL if it could not be allocated
+*/
+World* world_create(unsigned int capacity);
+// destroys the given world with all its entities and components (the meshes are not destroyed)
+void world_destroy(World* world);
+/*
+Registers a component type.
+Parameters:
+    - world (World*): the world
+    - size (size_t): the bytes of a component
+    - initial (const void*): the value of an added component, NULL means all zeroes (it is copied)
+Returns:
+    The component type (WORLD_MASK() gives its mask), -1 if the world has WORLD_MAX_COMPONENTS types already
+*/
+int world_registerComponent(World* world, size_t size, const void* initial);
+
+// ENTITIES
+// creates an entity without components, returns ENTITY_NULL if the world cannot grow
+Entity world_createEntity(World* world);
+// destroys an entity and its components (destroyed or invalid handles are ignored)
+void world_destroyEntity(World* world, Entity entity);
+// returns true if the handle refers to an entity that has not been destroyed
+bool world_isAlive(World* world, Entity entity);
+// returns the number of alive entities
+unsigned int world_getEntityCount(World* world);
+
+// COMPONENTS
+// adds a component to an entity (initialized to the initial value of its type), returns it (the existing one if the entity already has it) or NULL on failure
+void* world_addComponent(World* world, Entity entity, unsigned int component);
+// removes a component from an entity (the last component of the pool takes its place)
+void world_removeComponent(World* world, Entity entity, unsigned int component);
+// returns the component of an entity, NULL if the entity does not have it (valid until a component of the same type is added or removed)
+void* world_getComponent(World* world, Entity entity, unsigned int component);
+// returns true if the entity has all the components of the mask
+bool world_hasComponents(World* world, Entity entity, uint32_t mask);
+
+// ITERATION
+/*
+Starts walking the entities having all the components of a mask, call world_next() before reading every entity:
+for (WorldIterator it = world_iterate(world, mask); world_next(&it);) { Transform* t = it.components[WORLD_TRANSFORM]; ... }
+The smallest pool of the mask is walked in order, the other components are looked up.
+*/
+WorldIterator world_iterate(World* world, uint32_t mask);
+// moves to the next entity of an iteration, returns false when there are no more
+bool world_next(WorldIterator* iterator);
+// calls a function on every entity having all the components of a mask
+void world_forEach(World* world, uint32_t mask, WorldFunction function, void* data);
+// calls a function on every entity having all the components of a mask, in parallel on the job threads (it returns when all are done)
+void world_parallelForEach(World* world, uint32_t mask, WorldFunction function, void* data);
+
+// SYSTEMS (in parallel on the job threads)
+// computes the model matrix of every renderable from its transform
+void world_updateModels(World* world);
+/*
+Culls the renderables against the frustum of a camera: the bounding box of every mesh, moved by the model matrix,
+is tested against the planes of the frustum. The culled ones are counted in renderStats.culledObjects.
+Parameters:
+    - world (World*): the world
+    - viewProjection (mat4): the projection matrix multiplied by the view matrix
+Returns:
+    The number of visible renderables
+*/
+unsigned int world_cull(World* world, mat4 viewProjection);
+// draws the visible renderables on the render thread, like renderer_renderObject() does
+void world_render(World* world);
+// records the draws of the visible renderables into the command buffer of every job thread (buffers[job_getThreadIndex()], see commandbuffer.h)
+// it MUST be called by the main thread or a job thread while the workers run: a thread outside of the pool has no buffer of its own (it logs an error and records nothing)
+void world_record(World* world, CommandBuffer** buffers);
+
+#endif
@@ -0,0 +1,63 @@
+/*
+BCN:
+Block compression (BC1, BC3 and BC7) encoder and decoder.
+Every block holds 4x4 RGBA8 pixels: BC1 compresses them to 8 bytes, BC3 and BC7 to 16 bytes.
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools.
+*/
+
+#ifndef BCN_H
+#define BCN_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+typedef enum {
+    BCN_FORMAT_BC1, // RGB + 1 bit alpha, 8 bytes per block
+    BCN_FORMAT_BC3, // RGB + interpolated alpha, 16 bytes per block
+    BCN_FORMAT_BC7  // high quality RGBA, 16 bytes per block (only mode 6 blocks are produced and decoded)
+} BcnFormat;
+
+// returns the number of bytes a 4x4 block takes in the given format
+unsigned int bcn_getBlockSize(BcnFormat format);
+// returns the number of bytes needed to store a width x height image in the given format
+size_t bcn_getImageSize(BcnFormat format, unsigned int width, unsigned int height);
+
+/*
+Compresses a whole RGBA8 image.
+Parameters:
+    - format (BcnFormat): the format to compress to
+    - pixels (unsigned char*): the RGBA8 pixels (width * height * 4 bytes, rows are tightly packed)
+    - width (unsigned int): the image width (it does not need to be a multiple of 4, edge pixels are repeated to fill the blocks)
+    - height (unsigned int): the image height (it does not need to be a multiple of 4, edge pixels are repeated to fill the blocks)
+    - output (unsigned char*): where to write the blocks, it must be at least bcn_getImageSize() bytes long
+*/
+void bcn_compressImage(BcnFormat format, const unsigned char* pixels, unsigned int width, unsigned int height, unsigned char* output);
+/*
+Decompresses a whole image to RGBA8.
+Parameters:
+    - format (BcnFormat): the format of the blocks
+    - blocks (unsigned char*): the compressed blocks (bcn_getImageSize() bytes)
+    - width (unsigned int): the image width
+    - height (unsigned int): the image height
+    - output (unsigned char*): where to write the RGBA8 pixels, it must be at least width * height * 4 bytes long
+Returns:
+    true on success, false if a block could not be decoded (BC7 blocks that are not mode 6 are not supported)
+*/
+bool bcn_decompressImage(BcnFormat format, const unsigned char* blocks, unsigned int width, unsigned int height, unsigned char* output);
+
+// BLOCKS
+// compresses 16 RGBA8 pixels (4x4, row by row) to an 8 bytes BC1 block
+void bcn_compressBC1(const unsigned char pixels[64], unsigned char block[8]);
+// compresses 16 RGBA8 pixels (4x4, row by row) to a 16 bytes BC3 block
+void bcn_compressBC3(const unsigned char pixels[64], unsigned char block[16]);
+// compresses 16 RGBA8 pixels (4x4, row by row) to a 16 bytes BC7 (mode 6) block
+void bcn_compressBC7(const unsigned char pixels[64], unsigned char block[16]);
+
+// decompresses an 8 bytes BC1 block to 16 RGBA8 pixels (4x4, row by row)
+void bcn_decompressBC1(const unsigned char block[8], unsigned char pixels[64]);
+// decompresses a 16 bytes BC3 block to 16 RGBA8 pixels (4x4, row by row)
+void bcn_decompressBC3(const unsigned char block[16], unsigned char pixels[64]);
+// decompresses a 16 bytes BC7 block to 16 RGBA8 pixels (4x4, row by row), returns false if the block is not a mode 6 block
+bool bcn_decompressBC7(const unsigned char block[16], unsigned char pixels[64]);
+
+#endif
@@ -0,0 +1,97 @@
+/*
+COMMANDBUFFER:
+Render command buffers.
+OpenGL can only be called by the thread owning the context, but most of the work of building the draws of a large
+scene (walking the objects, computing their model matrices, picking their state) does not need it. A command buffer
+records draws (the shader, the mesh and the uniforms of every draw) into plain memory, without calling OpenGL, so
+many threads can record at once, each into its own buffer (e.g. one per job thread, see job_getThreadIndex(): it is -1 for
+the threads outside of the pool, which need a buffer of their own).
+The render thread then submits all the buffers at once: their draws are sorted by state (shader, texture, vertex
+array) and replayed through the renderer_* and shader_* functions, so the draws sharing a shader bind it once.
+Every buffer MUST be recorded by one thread at a time, and submitted when no thread is recording it.
+*/
+
+#ifndef COMMANDBUFFER_H
+#define COMMANDBUFFER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "engine/core/object.h"
+#include "engine/gfx/mesh.h"
+#include "engine/math/linal.h"
+
+// a recorded draw
+typedef struct {
+    uint64_t key;       // sort key (shader, texture and vertex array)
+    unsigned int shader; // 0 means the shader active when the buffer is submitted
+    Mesh* mesh;
+    size_t uniforms;    // offset of its first uniform in the uniform data
+    size_t uniformsEnd; // offset past its last uniform
+} CommandDraw;
+
+typedef struct {
+    // the uniforms of the draws, packed one after the other
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+    CommandDraw* draws;
+    unsigned int drawCount;
+    unsigned int drawCapacity;
+    // recording state
+    unsigned int shader;
+    Mesh* mesh;
+    size_t uniforms; // offset of the first uniform of the next draw
+} CommandBuffer;
+
+/*
+Creates an empty command buffer.
+You MUST call commandbuffer_destroy(CommandBuffer*) once the buffer is not used anymore
+Parameters:
+    - capacity (size_t): the bytes of uniform data reserved up front (the buffer grows when needed, 0 picks a default)
+Returns:
+    The pointer to the buffer, NULL if it could not be allocated
+*/
+CommandBuffer* commandbuffer_create(size_t capacity);
+// destroys the given command buffer
+void commandbuffer_destroy(CommandBuffer* buffer);
+// empties the given command buffer (keeping its memory) and resets its recording state, call it before recording a new frame
+void commandbuffer_reset(CommandBuffer* buffer);
+
+// RECORDING (any thread, no OpenGL calls)
+// records the shader used by the following draws (0 means the shader active when the buffer is submitted)
+void commandbuffer_bindShader(CommandBuffer* buffer, unsigned int shader);
+// records the mesh drawn by the following draws (it MUST stay alive until the buffer is submitted)
+void commandbuffer_bindMesh(CommandBuffer* buffer, Mesh* mesh);
+// records an integer uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setInteger(CommandBuffer* buffer, const char* name, int value);
+// records a float uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat(CommandBuffer* buffer, const char* name, float value);
+// records a float vector 2 uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat2(CommandBuffer* buffer, const char* name, vec2 value);
+// records a float vector 3 uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat3(CommandBuffer* buffer, const char* name, vec3 value);
+// records a float vector 4 uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat4(CommandBuffer* buffer, const char* name, vec4 value);
+// records a 3x3 float matrix uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setMatrix3(CommandBuffer* buffer, const char* name, mat3 value);
+// records a 4x4 float matrix uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setMatrix4(CommandBuffer* buffer, const char* name, mat4 value);
+// records a draw of the bound mesh with the bound shader and the uniforms recorded since the previous draw
+void commandbuffer_draw(CommandBuffer* buffer);
+// records the draw of an object like renderer_renderObject() does (its shader if it has one, its model matrix computed right away, its mesh), the bound shader and mesh are left as they were
+void commandbuffer_drawObject(CommandBuffer* buffer, Object* object);
+
+/*
+Replays the draws of the given command buffers on the render thread, sorted by state: the draws sharing a shader,
+a texture and a vertex array run one after the other, in the order they have been recorded (buffer after buffer).
+When the shader changes the view matrix of the active camera is uploaded, like renderer_prepare() does.
+The uniforms shared by the draws of a shader (e.g. the projection) are not part of the buffers: set them before
+submitting (they are kept by the shader) or record them before every draw.
+Parameters:
+    - buffers (CommandBuffer**): the buffers to submit (NULL ones are skipped)
+    - count (unsigned int): the number of buffers
+*/
+void commandbuffer_submit(CommandBuffer** buffers, unsigned int count);
+
+#endif
@@ -0,0 +1,60 @@
+/*
+DDS:
+DirectDraw Surface container reader/writer for block compressed textures (BC1, BC3 and BC7) and their mip chains.
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools.
+*/
+
+#ifndef DDS_H
+#define DDS_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "engine/gfx/bcn.h"
+
+#define DDS_MAX_LEVELS 16
+
+// a single mip level, pointing into the memory the DDS was parsed from
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    unsigned int width;
+    unsigned int height;
+} DdsLevel;
+
+// a parsed DDS image (it does not own any memory)
+typedef struct {
+    BcnFormat format;
+    unsigned int width;
+    unsigned int height;
+    unsigned int levelCount;
+    DdsLevel levels[DDS_MAX_LEVELS];
+} DdsImage;
+
+/*
+Parses a DDS file that has already been loaded (or mapped) into memory.
+The levels of the resulting image point straight into the given memory, so it must outlive the image.
+Parameters:
+    - data (unsigned char*): the DDS file content
+    - size (size_t): the DDS file size in bytes
+    - image (DdsImage*): where to store the parsed image
+Returns:
+    true on success, false if the file is not a supported DDS (BC1, BC3 or BC7 2D texture)
+*/
+bool dds_parse(const unsigned char* data, size_t size, DdsImage* image);
+
+/*
+Writes a DDS file at the given path ("./file" means it is in "g3ce").
+Parameters:
+    - path (char*): the output file path
+    - format (BcnFormat): the format of the blocks
+    - width (unsigned int): the width of the first mip level
+    - height (unsigned int): the height of the first mip level
+    - levels (unsigned char**): the compressed blocks of every mip level (the first one being the full size image)
+    - levelCount (unsigned int): the number of mip levels
+Returns:
+    true on success, false otherwise
+*/
+bool dds_write(char* path, BcnFormat format, unsigned int width, unsigned int height, unsigned char** levels, unsigned int levelCount);
+
+#endif
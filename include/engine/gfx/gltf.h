@@ -0,0 +1,58 @@
+/*
+GLTF:
+glTF 2.0 loader (binary ".glb" files, and ".gltf" files with their buffers in separate ".bin" files).
+glTF data is already laid out the way the GPU wants it, so the buffers are mapped and every primitive gets its vertex
+and index ranges uploaded as they are (the accessors become vertex attributes pointing into them, normalized and
+quantized types included), without touching a single vertex.
+Every primitive becomes a mesh, and the node hierarchy is imported as local transforms with a parent index.
+
+Attribute locations (the same as the other mesh loaders, see meshfile.h):
+    - POSITION: MESHFILE_LOCATION_POSITION
+    - COLOR_0: MESHFILE_LOCATION_COLOR (without it the shaders get the OpenGL default (0, 0, 0, 1))
+    - TEXCOORD_0: MESHFILE_LOCATION_UV
+    - NORMAL: MESHFILE_LOCATION_NORMAL
+The other attributes (tangents, skinning, additional UV sets, etc...) are ignored, as well as materials, animations and sparse accessors.
+*/
+
+#ifndef GLTF_H
+#define GLTF_H
+
+#include <stdbool.h>
+
+#include "engine/gfx/mesh.h"
+#include "engine/math/linal.h"
+#include "engine/math/transform.h"
+
+#define GLTF_MAX_NAME 64
+
+typedef struct {
+    char name[GLTF_MAX_NAME];
+    Transform transform;    // local transform (relative to the parent node)
+    int parent;             // index of the parent node (-1 for the root nodes)
+    unsigned int firstMesh; // index of the first mesh of the node (a glTF mesh becomes a mesh per primitive)
+    unsigned int meshCount; // 0 if the node has no mesh
+} GltfNode;
+
+typedef struct {
+    Mesh* meshes;           // one mesh per primitive, the meshes of a glTF mesh are consecutive
+    unsigned int meshCount;
+    GltfNode* nodes;
+    unsigned int nodeCount;
+} GltfModel;
+
+/*
+Loads a glTF 2.0 model, uploading all its meshes.
+REMEMBER TO DESTROY THE MODEL BY CALLING gltf_destroy()!
+Parameters:
+    - path (char*): the ".glb" or ".gltf" file path ("./file" means it is in "g3ce", external buffers are relative to it)
+    - model (GltfModel*): where to store the loaded model
+Returns:
+    true on success, false otherwise (the error has already been logged)
+*/
+bool gltf_load(char* path, GltfModel* model);
+// destroys the meshes of a model loaded by gltf_load() and frees its memory
+void gltf_destroy(GltfModel* model);
+// returns the model matrix of a node (its local transform combined with the ones of all its ancestors)
+mat4 gltf_getWorldMatrix(GltfModel* model, unsigned int node);
+
+#endif
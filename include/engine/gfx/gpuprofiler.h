@@ -0,0 +1,61 @@
+/*
+GPUPROFILER:
+GPU frame profiler.
+Named GPU scopes are measured with GL_TIMESTAMP queries (timestamps, unlike GL_TIME_ELAPSED queries, can be nested).
+The queries of a frame are only read back GPU_PROFILER_FRAMES - 1 frames later, and only once the GPU reports them
+as available, so profiling never stalls the pipeline (a frame whose results are still pending when its queries have
+to be reused is skipped). The results are converted to the CPU profiler clock and added to the "GPU" track of the
+profiler (see profiler.h), so they show up next to the CPU scopes in the statistics and in the exported traces.
+Every frame is also measured as a whole, on the CPU (from gpuprofiler_beginFrame() to gpuprofiler_endFrame(), the
+swap excluded) and on the GPU, telling whether the app is CPU or GPU bound.
+Timer queries are core in OpenGL 3.3 (Mesa's software rasterizer included); without them everything is a no-op.
+The GPU_PROFILE_* macros are compiled out unless G3CE_PROFILE is defined, like the CPU ones.
+*/
+
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+
+#include <stdbool.h>
+
+// frames in flight (the results of a frame are read this many frames - 1 later)
+#define GPU_PROFILER_FRAMES 4
+// scopes recorded per frame (the following ones are ignored)
+#define GPU_PROFILER_MAX_SCOPES 64
+#define GPU_PROFILER_MAX_DEPTH 16
+
+// CPU and GPU time of a frame
+typedef struct {
+    double cpu;     // milliseconds from gpuprofiler_beginFrame() to gpuprofiler_endFrame() on the CPU
+    double gpu;     // milliseconds the GPU took to execute the commands of the same frame
+    double latency; // milliseconds from the end of the frame on the CPU to its end on the GPU
+    bool gpuBound;  // whether the GPU took longer than the CPU
+    unsigned long long frame; // index of the measured frame (0 if no frame has been measured yet)
+} GpuFrameStats;
+
+#ifdef G3CE_PROFILE
+// begins a GPU scope, which MUST be ended by GPU_PROFILE_END() in the same frame
+#define GPU_PROFILE_BEGIN(name) gpuprofiler_begin(name)
+#define GPU_PROFILE_END() gpuprofiler_end()
+#else
+#define GPU_PROFILE_BEGIN(name) ((void) 0)
+#define GPU_PROFILE_END() ((void) 0)
+#endif
+
+// creates the query ring (called by app_create() when G3CE_PROFILE is defined), returns false if timer queries are not supported
+bool gpuprofiler_init();
+// reads back the results of the previous frames that are available and starts measuring a new frame (called by the app loop)
+void gpuprofiler_beginFrame();
+// stops measuring the current frame, closing its open scopes (called by the app loop before swapping the buffers)
+void gpuprofiler_endFrame();
+// begins a GPU scope in the current frame (see GPU_PROFILE_BEGIN())
+void gpuprofiler_begin(const char* name);
+// ends the last GPU scope begun in the current frame (see GPU_PROFILE_END())
+void gpuprofiler_end();
+// returns the CPU and GPU time of the last frame read back
+GpuFrameStats gpuprofiler_getFrameStats();
+// returns the number of frames skipped because their results were still pending when their queries had to be reused
+unsigned long long gpuprofiler_getSkippedFrames();
+// deletes the query ring (called by app_terminate())
+void gpuprofiler_shutdown();
+
+#endif
@@ -6,6 +6,9 @@ MESH:
 Handles mesh creation and destruction
 */
 
+#include "engine/gfx/meshfile.h"
+#include "engine/gfx/obj.h"
+
 typedef struct {
     unsigned int vao;
     unsigned int vbo;
@@ -15,10 +18,18 @@ typedef struct {
     unsigned int indicesLength;
     unsigned int stride;
     unsigned int texture;
+    unsigned int textureTarget; // GL_TEXTURE_2D or GL_TEXTURE_2D_ARRAY
     unsigned int textureUnit;
+    unsigned int sampler; // if set to 0 the texture own filter and wrapping state will be used
+    unsigned int indexType; // GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+    unsigned int indexOffset; // offset in bytes of the first index to draw (see mesh_selectLod())
+    float boundsMin[3]; // axis aligned bounding box of the vertex positions
+    float boundsMax[3];
+    unsigned int lodCount; // meshes created from arrays have a single LOD made of all their indices
+    MeshFileLod lods[MESHFILE_MAX_LODS];
 } Mesh;
 
-// creates a stack allocated mesh and returns it. This does not need to be destroyed
+// creates a stack allocated mesh and returns it. This does not need to be destroyed, but its OpenGL objects MUST be deleted via mesh_delete()
 Mesh mesh_new(float* vertices, unsigned int verticesSize, unsigned int* indices, unsigned int indicesSize, unsigned int vertexLength, unsigned int drawMode);
 
 /*
@@ -34,17 +45,47 @@ Parameters:
     - vertexLength (unsigned int): the number of floats that defines a vertex (e.g.: 3 for 3D position + 4 for RGBA color = 7)
     - drawMode (unsigned int): the drawing mode OpenGL has to use (GL_TRIANGLES, GL_QUADS, etc...)
 Returns:
-    The pointer to the mesh struct that has been created. It points to dynamically allocated memory,
-    so you MUST call mesh_destroy(Mesh*) that handles the free() procedure
+    The pointer to the mesh struct that has been created. It points to memory of the mesh pool (see memory.h),
+    so you MUST call mesh_destroy(Mesh*) that gives it back (never free() it)
 */
 Mesh* mesh_create(float* vertices, unsigned int verticesSize, unsigned int* indices, unsigned int indicesSize, unsigned int vertexLength, unsigned int drawMode);
 
+/*
+Loads a mesh from a binary mesh file (see meshfile.h and the meshconv tool) and returns a pointer to it.
+The file is mapped and its vertex and index blobs are uploaded as they are, and its vertex attributes are registered
+from the file layout, so the mesh is ready to be rendered.
+You MUST call mesh_destroy(Mesh*) once the mesh is not used anymore
+Parameters:
+    - path (char*): the mesh file path ("./file" means it is in "g3ce")
+Returns:
+    The pointer to the mesh struct that has been created (NULL if the file could not be loaded)
+*/
+Mesh* mesh_load(char* path);
+
+/*
+Creates a mesh from a model loaded by obj_load() and returns a pointer to it (the model can be freed right after).
+The vertex attributes are registered at the MESHFILE_LOCATION_* locations (see obj.h for the vertex layout).
+You MUST call mesh_destroy(Mesh*) once the mesh is not used anymore
+Parameters:
+    - model (ObjModel*): the loaded model
+Returns:
+    The pointer to the mesh struct that has been created (NULL on failure)
+*/
+Mesh* mesh_createFromObj(ObjModel* model);
+
 /*
 Destroys the given mesh object.
 Parameters:
     - mesh (Mesh*): the mesh to destroy
 */
 void mesh_destroy(Mesh* mesh);
+/*
+Deletes the OpenGL objects of the given mesh (its buffers, its vertex array and its texture, if any) without freeing the mesh itself,
+so it is the way to destroy a stack allocated mesh (see mesh_new()).
+Parameters:
+    - mesh (Mesh*): the mesh whose OpenGL objects are deleted
+*/
+void mesh_delete(Mesh* mesh);
 
 /*
 Registers a vertex attribute of type float for the given mesh.
@@ -55,6 +96,29 @@ Parameters:
 */
 void mesh_registerVertexAttribute(Mesh* mesh, unsigned int attributeLocation, unsigned int size);
 
+/*
+Registers a vertex attribute of any type at an explicit offset and stride for the given mesh.
+Parameters:
+    - mesh (Mesh*): the pointer to the mesh to associate the new vertex attribute
+    - attributeLocation (unsigned int): the attribute location in the shader
+    - size (unsigned int): number of components of the attribute (1 to 4)
+    - type (unsigned int): the type of the components (GL_FLOAT, GL_UNSIGNED_BYTE, etc...)
+    - normalized (bool): whether integer types are mapped to [0, 1] ([-1, 1] if signed) or converted as they are
+    - stride (unsigned int): the distance in bytes between two consecutive attributes (0 uses the mesh stride)
+    - offset (unsigned int): offset in bytes of the attribute from the start of the vertex
+*/
+void mesh_registerVertexAttributeEx(Mesh* mesh, unsigned int attributeLocation, unsigned int size, unsigned int type, bool normalized, unsigned int stride, unsigned int offset);
+
+/*
+Selects the level of detail to render (0 is the full detail one).
+Parameters:
+    - mesh (Mesh*): the mesh
+    - lod (unsigned int): the LOD index (it is clamped to the LODs of the mesh)
+*/
+void mesh_selectLod(Mesh* mesh, unsigned int lod);
+// returns the LOD to use at the given distance from the camera (the last one whose distance is not greater than the given one)
+unsigned int mesh_getLodForDistance(Mesh* mesh, float distance);
+
 /*
 Assings a texture to a given mesh via a texture id (this means that the texture will be automatically bound when rendering the mesh via renderer_renderMesh()).
 Parameters:
@@ -63,4 +127,21 @@ Parameters:
 */
 void mesh_assignTexture(Mesh* mesh, unsigned int texture, unsigned int unit);
 
+/*
+Assings a texture array to a given mesh via a texture id (this means that the texture array will be automatically bound when rendering the mesh via renderer_renderMesh()).
+The layer to sample can be provided per-vertex by registering a 1 float vertex attribute holding the layer index.
+Parameters:
+    - texture (unsigned int): the texture array id (see texture_createArray())
+    - unit (unsigned int): the texture unit to attach the texture array to
+*/
+void mesh_assignTextureArray(Mesh* mesh, unsigned int texture, unsigned int unit);
+
+/*
+Assigns a sampler to a given mesh (this means that the sampler will be automatically bound to the mesh texture unit when rendering the mesh via renderer_renderMesh()).
+The sampler is NOT destroyed when destroying the mesh, as it is meant to be shared between meshes.
+Parameters:
+    - sampler (unsigned int): the sampler id (see sampler_create()), 0 removes the assigned sampler
+*/
+void mesh_assignSampler(Mesh* mesh, unsigned int sampler);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,126 @@
+/*
+MESHFILE:
+Binary mesh format (".g3mesh") reader/writer.
+The vertex and index data are stored exactly as the GPU consumes them, so loading a mesh (see mesh_load()) is just mapping
+the file and handing the blobs to OpenGL, without parsing a single vertex.
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools
+(the type and draw mode values are the OpenGL ones, so they are defined here too).
+
+File layout (little endian):
+    - header (MeshFileHeader)
+    - attribute layout (MeshFileAttribute array)
+    - LOD table (MeshFileLod array, the first LOD is the full detail one)
+    - vertex blob (interleaved vertices, MESHFILE_ALIGNMENT bytes aligned)
+    - index blob (16 or 32 bits indices of all the LODs one after the other, MESHFILE_ALIGNMENT bytes aligned)
+*/
+
+#ifndef MESHFILE_H
+#define MESHFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define MESHFILE_MAGIC "G3MS"
+#define MESHFILE_VERSION 1
+#define MESHFILE_ALIGNMENT 16
+#define MESHFILE_MAX_ATTRIBUTES 16
+#define MESHFILE_MAX_LODS 8
+
+// attribute component types (same values as the OpenGL ones)
+#define MESHFILE_TYPE_BYTE 0x1400
+#define MESHFILE_TYPE_UNSIGNED_BYTE 0x1401
+#define MESHFILE_TYPE_SHORT 0x1402
+#define MESHFILE_TYPE_UNSIGNED_SHORT 0x1403
+#define MESHFILE_TYPE_INT 0x1404
+#define MESHFILE_TYPE_UNSIGNED_INT 0x1405
+#define MESHFILE_TYPE_FLOAT 0x1406
+#define MESHFILE_TYPE_HALF_FLOAT 0x140B
+
+// draw modes (same values as the OpenGL ones)
+#define MESHFILE_DRAW_LINES 0x0001
+#define MESHFILE_DRAW_TRIANGLES 0x0004
+
+// default attribute locations of the mesh loaders (the shaders in assets/shaders use the same ones, location 3 is the texture array layer)
+#define MESHFILE_LOCATION_POSITION 0
+#define MESHFILE_LOCATION_COLOR 1
+#define MESHFILE_LOCATION_UV 2
+#define MESHFILE_LOCATION_NORMAL 4
+
+typedef struct {
+    char magic[4];         // MESHFILE_MAGIC
+    uint32_t version;      // MESHFILE_VERSION
+    uint32_t attributeCount;
+    uint32_t lodCount;
+    uint32_t vertexCount;
+    uint32_t vertexStride; // bytes per vertex
+    uint32_t indexCount;   // indices of all the LODs
+    uint32_t indexSize;    // 2 or 4 bytes
+    uint32_t drawMode;     // MESHFILE_DRAW_*
+    uint32_t reserved;
+    uint64_t vertexOffset; // offset of the vertex blob from the start of the file
+    uint64_t indexOffset;  // offset of the index blob from the start of the file
+    float boundsMin[3];    // axis aligned bounding box of the positions
+    float boundsMax[3];
+} MeshFileHeader;
+
+typedef struct {
+    uint32_t location;   // the attribute location in the shader
+    uint32_t components; // 1 to 4
+    uint32_t type;       // MESHFILE_TYPE_*
+    uint32_t normalized; // whether integer types are mapped to [0, 1] ([-1, 1] if signed)
+    uint32_t offset;     // offset from the start of the vertex
+} MeshFileAttribute;
+
+typedef struct {
+    uint32_t indexStart; // first index of the LOD in the index blob
+    uint32_t indexCount;
+    float distance;      // the distance from which this LOD should be used
+} MeshFileLod;
+
+// a parsed mesh file (it does not own any memory, everything points into the file content)
+typedef struct {
+    const MeshFileHeader* header;
+    const MeshFileAttribute* attributes;
+    const MeshFileLod* lods;
+    const unsigned char* vertices;
+    const unsigned char* indices;
+} MeshFile;
+
+// returns the size in bytes of a component type (0 if it is not a valid one)
+unsigned int meshfile_getTypeSize(uint32_t type);
+
+/*
+Parses a mesh file that has already been loaded (or mapped) into memory, validating all its offsets and sizes,
+its draw mode and its indices (which must all refer to a vertex of the file, so the GPU never reads outside of the vertex buffer).
+The resulting mesh file points straight into the given memory, so it must outlive it.
+Parameters:
+    - data (unsigned char*): the file content (it must be at least 8 bytes aligned, as mapped and allocated memory is)
+    - size (size_t): the file size in bytes
+    - file (MeshFile*): where to store the parsed mesh file
+Returns:
+    true on success, false if the file is not a valid mesh file
+*/
+bool meshfile_parse(const unsigned char* data, size_t size, MeshFile* file);
+
+/*
+Writes a mesh file at the given path ("./file" means it is in "g3ce").
+The bounds are computed from the attribute at MESHFILE_LOCATION_POSITION (which must be made of 3 floats).
+Parameters:
+    - path (char*): the output file path
+    - attributes (MeshFileAttribute*): the vertex layout
+    - attributeCount (unsigned int): the number of attributes
+    - vertices (void*): the interleaved vertices
+    - vertexCount (unsigned int): the number of vertices
+    - vertexStride (unsigned int): the size of a vertex in bytes
+    - indices (uint32_t*): the indices of all the LODs (they are stored as 16 bits indices when possible)
+    - lods (MeshFileLod*): the LOD table
+    - lodCount (unsigned int): the number of LODs
+    - drawMode (uint32_t): MESHFILE_DRAW_* (or any other OpenGL primitive)
+Returns:
+    true on success, false otherwise (e.g. an index is not below the vertex count)
+*/
+bool meshfile_write(char* path, const MeshFileAttribute* attributes, unsigned int attributeCount, const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+    const uint32_t* indices, const MeshFileLod* lods, unsigned int lodCount, uint32_t drawMode);
+
+#endif
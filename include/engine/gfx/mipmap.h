@@ -0,0 +1,59 @@
+/*
+MIPMAP:
+CPU mip chain generator for RGBA8 images (box and Kaiser filters, optionally gamma-correct for sRGB images).
+The filtering is done in floating point (SSE2 or AVX2 when the compiler targets them, plain C otherwise).
+This module does not depend on OpenGL and does not use any global state, so it can run on any thread
+(e.g. while loading textures in the background) and it can also be used by the offline tools.
+*/
+
+#ifndef MIPMAP_H
+#define MIPMAP_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#define MIPMAP_MAX_LEVELS 16
+
+typedef enum {
+    MIPMAP_FILTER_BOX,   // averages 2x2 pixels (fast, slightly blurry)
+    MIPMAP_FILTER_KAISER // Kaiser windowed sinc (sharper, keeps more detail in the smaller levels)
+} MipmapFilter;
+
+// a single mip level (RGBA8, rows are tightly packed)
+typedef struct {
+    unsigned char* data;
+    unsigned int width;
+    unsigned int height;
+} MipLevel;
+
+// a whole mip chain, the first level being the full size image (all the levels share a single allocation)
+typedef struct {
+    unsigned int levelCount;
+    MipLevel levels[MIPMAP_MAX_LEVELS];
+    unsigned char* memory;
+} MipChain;
+
+/*
+Generates the whole mip chain (down to 1x1) of an RGBA8 image.
+Every level is computed from the previous one in floating point, so the rounding errors do not add up along the chain.
+REMEMBER TO FREE IT BY CALLING mipmap_free()!
+Parameters:
+    - pixels (unsigned char*): the RGBA8 pixels of the full size image (width * height * 4 bytes, rows are tightly packed)
+    - width (unsigned int): the image width
+    - height (unsigned int): the image height
+    - filter (MipmapFilter): the downsampling filter
+    - srgb (bool): whether the RGB channels are sRGB encoded (they get filtered in linear space, alpha is always linear)
+    - chain (MipChain*): where to store the mip chain (the first level is a copy of the given image)
+Returns:
+    true on success, false otherwise
+*/
+bool mipmap_generate(const unsigned char* pixels, unsigned int width, unsigned int height, MipmapFilter filter, bool srgb, MipChain* chain);
+// frees the memory of a mip chain generated by mipmap_generate()
+void mipmap_free(MipChain* chain);
+
+// returns the number of mip levels (down to 1x1) of a width x height image
+unsigned int mipmap_getLevelCount(unsigned int width, unsigned int height);
+// returns the name of the instruction set used for filtering ("AVX2", "SSE2" or "scalar")
+const char* mipmap_getInstructionSet();
+
+#endif
@@ -0,0 +1,67 @@
+/*
+OBJ:
+Wavefront OBJ (and MTL) importer.
+The file is mapped and split into line aligned chunks that are parsed in parallel (with a dedicated number parser,
+as strtod() and sscanf() are way too slow for files of hundreds of MB), then the face corners are deduplicated through
+a hash map into indexed, interleaved vertices that can be given straight to mesh_create() (see mesh_createFromObj()).
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools (see meshconv).
+
+Vertex layout (floats, in this order, matching mesh_registerVertexAttribute()):
+    - position (3 floats, MESHFILE_LOCATION_POSITION)
+    - color (4 floats, MESHFILE_LOCATION_COLOR): the vertex color if the OBJ has one, otherwise the material diffuse color (white without a material)
+    - UV (2 floats, MESHFILE_LOCATION_UV): only if the OBJ has texture coordinates
+    - normal (3 floats, MESHFILE_LOCATION_NORMAL): only if the OBJ has normals
+The indices are grouped by material (see ObjSubmesh) and polygons are triangulated as fans.
+*/
+
+#ifndef OBJ_H
+#define OBJ_H
+
+#include <stdbool.h>
+
+#define OBJ_MAX_THREADS 32
+#define OBJ_MAX_PATH 256
+#define OBJ_MAX_NAME 64
+
+typedef struct {
+    char name[OBJ_MAX_NAME];
+    float diffuse[4];                // "Kd" and "d" (alpha)
+    char diffuseMap[OBJ_MAX_PATH];   // "map_Kd" path (relative to "g3ce", as the OBJ path), empty if the material has none
+} ObjMaterial;
+
+// a range of indices using the same material
+typedef struct {
+    unsigned int indexStart;
+    unsigned int indexCount;
+    int material; // index into the model materials, -1 for the faces without a material
+} ObjSubmesh;
+
+typedef struct {
+    float* vertices;           // interleaved vertices (see the vertex layout above)
+    unsigned int vertexCount;
+    unsigned int vertexLength; // floats per vertex (7, 9, 10 or 12)
+    unsigned int* indices;     // triangle list
+    unsigned int indexCount;
+    bool hasUvs;
+    bool hasNormals;
+    ObjMaterial* materials;
+    unsigned int materialCount;
+    ObjSubmesh* submeshes;     // the submeshes cover all the indices, one after the other
+    unsigned int submeshCount;
+} ObjModel;
+
+/*
+Loads an OBJ file (and the MTL files it references).
+REMEMBER TO FREE THE MODEL BY CALLING obj_free()!
+Parameters:
+    - path (char*): the OBJ file path ("./file" means it is in "g3ce")
+    - threadCount (unsigned int): the number of parsing threads (0 uses one per CPU core, small files are always parsed by a single thread)
+    - model (ObjModel*): where to store the loaded model
+Returns:
+    true on success, false otherwise (the error has already been logged)
+*/
+bool obj_load(char* path, unsigned int threadCount, ObjModel* model);
+// frees the memory of a model loaded by obj_load()
+void obj_free(ObjModel* model);
+
+#endif
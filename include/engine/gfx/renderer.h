@@ -6,13 +6,38 @@ Contains some useful rendering functions
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <stdbool.h>
+
 #include "engine/core/object.h"
 #include "engine/math/camera.h"
 #include "engine/gfx/mesh.h"
 
+// counters of a frame (see renderer_getStats())
+typedef struct {
+    unsigned int drawCalls;
+    unsigned long long vertices;  // vertices (indices) submitted by the draw calls
+    unsigned long long triangles; // triangles submitted by the draw calls (0 for points and lines)
+    // state changes by type
+    unsigned int shaderBinds;
+    unsigned int vertexArrayBinds;
+    unsigned int textureBinds;
+    unsigned int samplerBinds;
+    unsigned int polygonModeChanges;
+    unsigned int cullModeChanges;
+    unsigned int depthTestChanges;
+    unsigned int uniformUploads;
+    unsigned long long bufferBytesUploaded; // vertex and index data uploaded with glBufferData()
+    unsigned int culledObjects;             // objects skipped by the culling code (it adds them to renderStats)
+} RenderStats;
+
 extern float clearColor[4];
 extern Camera* activeCamera;
 extern int activeShader;
+// counters of the frame being rendered (incremented by the renderer, shader and mesh modules, reset every frame)
+extern RenderStats renderStats;
+
+// returns true if the current OpenGL context supports the given extension (e.g. "GL_EXT_texture_compression_s3tc")
+bool renderer_hasGLExtension(const char* name);
 
 // sets the clear color with RGBA values (default color is white (1, 1, 1, 1))
 void renderer_setGLClearColor(float r, float g, float b, float a);
@@ -53,6 +78,22 @@ Parameters:
 */
 void renderer_bindTexture(unsigned int texture, unsigned int unit);
 
+/*
+Binds a texture array.
+Parameters:
+    - texuture (unsigned int): the texture array id
+    - unit (unsigned int): the texture unit to bind the texture array to
+*/
+void renderer_bindTextureArray(unsigned int texture, unsigned int unit);
+
+/*
+Binds a sampler (its filter and wrapping state override the ones of the texture bound to the same unit).
+Parameters:
+    - sampler (unsigned int): the sampler id (0 unbinds the sampler, restoring the texture own state)
+    - unit (unsigned int): the texture unit to bind the sampler to
+*/
+void renderer_bindSampler(unsigned int sampler, unsigned int unit);
+
 /*
 Uses a camera.
 Parameters:
@@ -74,4 +115,14 @@ void renderer_renderMesh(Mesh* mesh);
 // (or the currently active one if the assigned shader is 0)
 void renderer_renderObject(Object* object);
 
+// STATISTICS
+// returns the counters of the last rendered frame
+RenderStats renderer_getStats();
+// ends the counters of a frame, making them the ones returned by renderer_getStats() (called by the app loop after swapping the buffers)
+void renderer_collectStats();
+// writes the counters of the last rendered frame to the console
+void renderer_printStats();
+// writes the counters to the console every given number of frames (0, the default, disables it)
+void renderer_setStatsDumpInterval(unsigned int frames);
+
 #endif
\ No newline at end of file
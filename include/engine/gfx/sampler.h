@@ -0,0 +1,49 @@
+/*
+SAMPLER:
+Sampler object handler module
+A sampler holds the filtering and wrapping state that is used when sampling a texture,
+so the same texture can be sampled in different ways and many textures can share the same sampling state
+*/
+
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+/*
+Creates a sampler object with the given filtering and wrapping modes.
+REMEMBER TO DESTROY IT BY CALLING sampler_destroy()!
+Samplers are NOT destroyed when destroying a mesh they are assigned to, as they are meant to be shared.
+Parameters:
+    - minFilter (unsigned int): the minifying filter (GL_NEAREST, GL_LINEAR, GL_NEAREST_MIPMAP_NEAREST, GL_LINEAR_MIPMAP_NEAREST, GL_NEAREST_MIPMAP_LINEAR or GL_LINEAR_MIPMAP_LINEAR)
+    - magFilter (unsigned int): the magnifying filter (either GL_NEAREST or GL_LINEAR)
+    - wrap (unsigned int): the wrap mode used for all the texture coordinates (GL_REPEAT, GL_MIRRORED_REPEAT, GL_CLAMP_TO_EDGE or GL_CLAMP_TO_BORDER)
+Returns:
+    The sampler id
+*/
+unsigned int sampler_create(unsigned int minFilter, unsigned int magFilter, unsigned int wrap);
+// destroys a given sampler
+void sampler_destroy(unsigned int sampler);
+
+/*
+Sets the filter for a given sampler.
+Parameters:
+    - sampler (unsigned int): the sampler id
+    - filter (unsigned int): the filter to set the mode for (either GL_TEXTURE_MIN_FILTER for minifying textures or GL_TEXTURE_MAG_FILTER for magnifying textures)
+    - mode (unsigned int): the filter mode to set (GL_NEAREST or GL_LINEAR, the minifying filter also accepts the GL_*_MIPMAP_* modes)
+*/
+void sampler_setFilter(unsigned int sampler, unsigned int filter, unsigned int mode);
+/*
+Sets the wrapping mode for a given sampler.
+Parameters:
+    - sampler (unsigned int): the sampler id
+    - wrap (unsigned int): the wrap to set the mode for (GL_TEXTURE_WRAP_S for horizontal wrapping, GL_TEXTURE_WRAP_T for vertical wrapping or GL_TEXTURE_WRAP_R for depth wrapping)
+    - mode (unsigned int): the wrap mode to set. It can be one of the following:
+        + GL_REPEAT (the default one) repeats the texture indefinitively
+        + GL_MIRRORED_REPEAT repeats the texture indefinitively but also mirrors it with each repeat
+        + GL_CLAMP_TO_EDGE clamps UVs between 0 and 1
+        + GL_CLAMP_TO_BORDER UVs outside of the range [0, 1] are given a user-specified color
+*/
+void sampler_setWrapping(unsigned int sampler, unsigned int wrap, unsigned int mode);
+// sets the border color for when the sampler wrapping is set to GL_CLAMP_TO_BORDER mode
+void sampler_setBorderColor(unsigned int sampler, float r, float g, float b, float a);
+
+#endif
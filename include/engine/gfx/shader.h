@@ -6,6 +6,8 @@ Shader handler
 #ifndef SHADER_H
 #define SHADER_H
 
+#include <stdbool.h>
+
 #include "engine/math/linal.h"
 
 // creates a shader program from the given vertex and fragment shader codes ("./file" means it is in "g3ce")
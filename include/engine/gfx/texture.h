@@ -1,20 +1,85 @@
 /*
 TEXTURE:
-2D Texture handler module
+2D Texture and 2D Texture Array handler module
 */
 
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
+#include <stddef.h>
 #include <stdbool.h>
 
+#include "engine/gfx/mipmap.h"
+
 // creates a texture loading an image from the given path ("./file" means it is in "g3ce").
 // REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
 // If you assign the texture to a mesh via mesh_assignTexture() destroying the mesh will also destroy the texture.
 unsigned int texture_create(char* path, bool hasTransparency);
+/*
+Creates a texture decoding an image file (PNG, JPG, ...) that has already been read into memory,
+e.g. by an asynchronous read (see io.h) or from a packed archive.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - data (unsigned char*): the image file content
+    - size (size_t): the image file size in bytes
+    - hasTransparency (bool): whether the image has an alpha channel
+Returns:
+    The texture id
+*/
+unsigned int texture_createFromMemory(const unsigned char* data, size_t size, bool hasTransparency);
+/*
+Creates a texture loading an image from the given path ("./file" means it is in "g3ce"), generating its mip chain on the CPU
+(see mipmap.h) instead of calling glGenerateMipmap(), so the filter can be chosen and sRGB images are filtered in linear space.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - path (char*): the image path
+    - hasTransparency (bool): whether the image has an alpha channel
+    - filter (MipmapFilter): the filter used for downsampling (MIPMAP_FILTER_BOX or MIPMAP_FILTER_KAISER)
+    - srgb (bool): whether the image colors are sRGB encoded (almost every color texture is)
+Returns:
+    The texture id
+*/
+unsigned int texture_createWithMipmaps(char* path, bool hasTransparency, MipmapFilter filter, bool srgb);
+/*
+Creates a texture from a mip chain generated by mipmap_generate(), uploading all of its levels at once.
+The mip chain can be generated on any thread (e.g. while loading in the background), only this call needs the OpenGL context.
+The mip chain is not freed, so call mipmap_free() when it is not needed anymore.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - chain (MipChain*): the mip chain to upload
+    - hasTransparency (bool): whether the alpha channel has to be kept
+Returns:
+    The texture id
+*/
+unsigned int texture_createFromMipChain(const MipChain* chain, bool hasTransparency);
+/*
+Creates a texture loading a block compressed DDS file (BC1, BC3 or BC7) from the given path ("./file" means it is in "g3ce"),
+including all the mip levels stored in the file (see the G3CE_texconv tool to create such files).
+The blocks are uploaded as they are when the driver supports the format, otherwise they are decompressed on the CPU first.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+*/
+unsigned int texture_createCompressed(char* path);
+
+/*
+Creates a 2D texture array loading one image per layer from the given paths ("./file" means it is in "g3ce").
+All the images MUST have the same size. Each layer can then be selected in the shader via the third texture coordinate
+(e.g. a per-vertex layer index attribute), so differently textured meshes can share the same texture binding (and draw call).
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - paths (char**): the array of image paths, the first path is layer 0
+    - count (unsigned int): the number of paths (and so of layers)
+    - hasTransparency (bool): whether the images have an alpha channel
+Returns:
+    The texture id (it must be bound as a GL_TEXTURE_2D_ARRAY, see renderer_bindTextureArray() and mesh_assignTextureArray())
+*/
+unsigned int texture_createArray(char** paths, unsigned int count, bool hasTransparency);
 // destroys a given texture
 void texture_destroy(unsigned int texture);
 
+// NOTE: the filter, wrapping and border color state set by the following functions lives on the texture itself.
+// Prefer using sampler objects (see sampler.h) assigned via mesh_assignSampler() or bound via renderer_bindSampler():
+// a sampler bound to a texture unit overrides the state of the texture bound to the same unit.
+
 /*
 Sets the filter for a given texture.
 Parameters:
@@ -1,6 +1,9 @@
 /*
 CAMERA:
 Holds all camera related functions (basically more matrix math!)
+The rotation is stored as a normalized quaternion turning the camera axes into the world ones:
+yawing turns around the world up axis while pitching and rolling turn around the camera own axes,
+so an orbiting camera never locks its gimbal.
 */
 
 #ifndef CAMERA_H
@@ -10,7 +13,7 @@ Holds all camera related functions (basically more matrix math!)
 
 typedef struct {
     vec3 position;
-    vec3 rotation;
+    quat rotation; // normalized
 } Camera;
 
 // creates a camera positioned at the world origin (0, 0, 0)
@@ -23,7 +26,7 @@ void camera_destroy(Camera* c);
 // SETTERS
 // sets the given camera position to the given coordinates values
 void camera_setPosition(Camera* c, float x, float y, float z);
-// sets the given camera position to the given pitch, yaw and roll values
+// sets the given camera rotation to the given pitch, yaw and roll values (angles are in degrees)
 void camera_setRotation(Camera* c, float pitch, float yaw, float roll);
 
 // OPERATIONS
@@ -31,10 +34,14 @@ void camera_setRotation(Camera* c, float pitch, float yaw, float roll);
 void camera_moveByVector(Camera* c, vec3 move);
 // moves the given camera by the given motion values
 void camera_move(Camera* c, float xm, float ym, float zm);
-// rotates the camera by the given rotation vector
+// rotates the camera by the given rotation vector (pitch, yaw, roll) (angles are in degrees)
 void camera_rotateByVector(Camera* c, vec3 rotation);
-// rotates the camera by the given angles
+// rotates the camera by the given angles (pitch, yaw, roll) (angles are in degrees)
 void camera_rotate(Camera* c, float xr, float yr, float zr);
+// rotates the camera by the given angle (in degrees) around the given world axis
+void camera_rotateAxisAngle(Camera* c, vec3 axis, float angle);
+// rotates the camera to look at the given target, with its up vector towards the given up direction
+void camera_lookAt(Camera* c, vec3 target, vec3 up);
 
 // CAMERA COORDINATE SYSTEM
 // returns the x axis direction of the camera centered coordinate system
@@ -176,6 +176,10 @@ quat quat_zero();
 quat quat_identity();
 // returns a rotation quaternion based on the given axis direction and angle value
 quat quat_rotation(vec3 axis, float angle);
+// returns a rotation quaternion based on the given Tait-Bryan angles (pitch, yaw, roll) in degrees, composed as the transforms do (Rx * Ry * Rz)
+quat quat_fromEuler(vec3 angles);
+// returns the rotation quaternion turning the negative z axis towards the given forward direction, keeping the y axis as close as possible to the given up direction
+quat quat_lookRotation(vec3 forward, vec3 up);
 
 // LINEAR ALGEBRA OPERATIONS
 
@@ -301,6 +305,16 @@ mat4 mat4_negate(mat4 m);
 
 // multiplies two quaternions and returns the result
 quat quat_multiply(quat q0, quat q1);
+// evaluates the dot product of two quaternions and returns the result
+float quat_dot(quat q0, quat q1);
+// returns the conjugate of the given quaternion (the inverse rotation of a unit quaternion)
+quat quat_conjugate(quat q);
+// normalizes the given quaternion and returns the result (an identity quaternion if its magnitude is zero)
+quat quat_normalize(quat q);
+// interpolates linearly between two rotation quaternions along the shortest path and returns the normalized result (t from 0 to 1)
+quat quat_nlerp(quat q0, quat q1, float t);
+// interpolates spherically between two rotation quaternions along the shortest path (constant angular speed) and returns the result (t from 0 to 1)
+quat quat_slerp(quat q0, quat q1, float t);
 
 // MIXED OPERATIONS
 // 2D, 3D
@@ -314,11 +328,17 @@ vec3 mat3_vec3_multiply(mat3 m, vec3 v);
 // multiplies a matrix by a vector and returns the result
 vec4 mat4_vec4_multiply(mat4 m, vec4 v);
 
+// QUATERNION with VECTOR ROTATION
+// rotates a vector by a rotation quaternion and returns the result
+vec3 quat_vec3_rotate(quat q, vec3 v);
+
 // MATRIX to QUATERNION and viceversa
 // converts a rotation quaternion to a 4D rotation matrix
 mat4 quat_to_mat4(quat q);
 // converts a 4D rotation matrix to a rotation quaternion
 quat mat4_to_quat(mat4 m);
+// converts a rotation quaternion to the Tait-Bryan angles (pitch, yaw, roll) in degrees of quat_fromEuler()
+vec3 quat_toEuler(quat q);
 
 // OUTPUT
 // prints out the given vector (precision specifies the number of decimal digits)
@@ -4,6 +4,8 @@ This is the transform object.
 It contains all the necessary functions and parameters to describe
 an object position, rotation and scaling.
 It essentially serves bridges the gap between local space and world space
+The rotation is stored as a normalized quaternion: the Euler angles (pitch, yaw, roll) are only converted
+from when set or incremented, so building the model matrix costs no trigonometry.
 */
 
 #ifndef TRANSFORM_H
@@ -13,14 +15,14 @@ It essentially serves bridges the gap between local space and world space
 
 typedef struct {
     vec3 position;
-    vec3 rotation;
+    quat rotation; // normalized
     vec3 scale;
 } Transform;
 
 // creates a stack allocated blank transform and returns it. This does not need to be destroyed
 Transform transform_new();
 
-// creates a blank transform (posision and rotation are zero vectors, while scale is a one vector)
+// creates a blank transform (posision is a zero vector, rotation an identity quaternion, while scale is a one vector)
 // REMEMBER: you MUST also DESTROY IT at the end via transform_destroy()!
 Transform* transform_create();
 // destroys the given transform object
@@ -29,7 +31,7 @@ void transform_destroy(Transform* t);
 // SETTERS
 // sets the given transform position to the given position values (x, y, z) (right-handed system: +x to the right, +y up, +z towards you that are reading this right now!)
 void transform_setPosition(Transform* t, float x, float y, float z);
-// sets the given transform rotation to the given rotation values
+// sets the given transform rotation to the given rotation values (pitch, yaw, roll) (angles are in degrees, applied as Rx * Ry * Rz)
 void transform_setRotation(Transform* t, float pitch, float yaw, float roll);
 // sets the given transform scale to the given scale values
 void transform_setScale(Transform* t, float xs, float ys, float zs);
@@ -37,18 +39,23 @@ void transform_setScale(Transform* t, float xs, float ys, float zs);
 // OPERATIONS
 // increments the given transform position by the given translation vector (x, y, z) (right-handed system: +x to the right, +y up, +z towards you that are reading this right now!)
 void transform_changePosition(Transform* t, vec3 translation);
-// increments the given transform rotation by the given rotation vector (pitch, yaw, roll) (angles are in degrees)
+// rotates the given transform by the given rotation vector (pitch, yaw, roll) around the parent axes (angles are in degrees)
 void transform_changeRotation(Transform* t, vec3 rotation);
 // increment the the given transform scale by the given scaling vector (xs, ys, zs)
 void transform_changeScale(Transform* t, vec3 scaling);
 
 // increments the given transform position by the given translation values (x, y, z) (right-handed system: +x to the right, +y up, +z towards you that are reading this right now!)
 void transform_changePositionValues(Transform* t, float xm, float ym, float zm);
-// increments the given transform rotation by the given rotation values (pitch, yaw, roll) (angles are in degrees)
+// rotates the given transform by the given rotation values (pitch, yaw, roll) around the parent axes (angles are in degrees)
 void transform_changeRotationValues(Transform* t, float xr, float yr, float zr);
 // increment the the given transform scale by the given scaling values (xs, ys, zs)
 void transform_changeScaleValues(Transform* t, float xs, float ys, float zs);
 
+// rotates the given transform by the given angle (in degrees) around the given axis of the parent space
+void transform_rotateAxisAngle(Transform* t, vec3 axis, float angle);
+// rotates the given transform so that its forward (the negative z axis, as for the cameras) points to the given target, with its y axis towards the given up direction
+void transform_lookAt(Transform* t, vec3 target, vec3 up);
+
 // MATRIX
 // calculates the model matrix for the given transform and returns it
 mat4 transform_getModelMatrix(Transform* t);
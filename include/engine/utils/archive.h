@@ -0,0 +1,81 @@
+/*
+ARCHIVE:
+Packed asset archives (created by the G3CE_pack tool) and the virtual file system built on top of them.
+Once an archive is mounted, file_map(), file_read() and file_readBytes() (and so the shader and texture loaders)
+look for the requested path inside the mounted archives first and only fall back to the disk when it is not packed.
+
+Archive layout (little endian):
+    - header (ArchiveHeader)
+    - index (ArchiveEntry array sorted by path hash, so a path is looked up with a binary search)
+    - path strings (not null terminated, referenced by the index)
+    - the entries data, each one starting at a ARCHIVE_ALIGNMENT bytes aligned offset (so they are page aligned when mapped)
+*/
+
+#ifndef ARCHIVE_H
+#define ARCHIVE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "engine/utils/file.h"
+
+#define ARCHIVE_MAGIC "G3PK"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_ALIGNMENT 4096
+#define ARCHIVE_MAX_MOUNTS 8
+
+// the entry data is LZ4 compressed (see lz4.h)
+#define ARCHIVE_FLAG_COMPRESSED 0x1
+
+typedef struct {
+    char magic[4];          // ARCHIVE_MAGIC
+    uint32_t version;       // ARCHIVE_VERSION
+    uint32_t entryCount;    // number of packed files
+    uint32_t reserved;
+    uint64_t indexOffset;   // offset of the index from the start of the archive
+    uint64_t stringsOffset; // offset of the path strings from the start of the archive
+} ArchiveHeader;
+
+typedef struct {
+    uint64_t hash;         // archive_hashPath() of the path
+    uint64_t offset;       // offset of the data from the start of the archive
+    uint64_t size;         // size of the stored data in bytes
+    uint64_t originalSize; // size of the file in bytes (the same as size when not compressed)
+    uint32_t pathOffset;   // offset of the path from the start of the path strings
+    uint32_t pathLength;   // length of the path in bytes
+    uint32_t flags;        // ARCHIVE_FLAG_* bits
+    uint32_t reserved;
+} ArchiveEntry;
+
+// returns the hash of a path, ignoring any leading "./" and treating "\" as "/" (FNV-1a, 64 bits)
+uint64_t archive_hashPath(const char* path);
+
+/*
+Mounts an archive (mapping it into memory), so that the files it contains can be loaded through the file module.
+Archives mounted later take precedence over the ones mounted before.
+Mount the archives before loading from other threads: the lookups are lock free, but mounting is not.
+Parameters:
+    - path (char*): the archive path ("./file" means it is in "g3ce")
+Returns:
+    true on success, false otherwise
+*/
+bool archive_mount(char* path);
+// unmounts all the mounted archives (the views returned by archive_map() without decompressing must not be used anymore)
+void archive_unmountAll();
+
+// returns true if the given path is packed in one of the mounted archives
+bool archive_contains(const char* path);
+/*
+Looks for a path in the mounted archives and returns a read-only view of its content.
+Uncompressed entries point straight into the mapped archive, compressed ones are decompressed into a heap buffer.
+This function does not log anything when the path is not found, so it can be used to check the archives before the disk.
+REMEMBER TO RELEASE IT BY CALLING file_unmap()!
+Parameters:
+    - path (char*): the path of the packed file (e.g. "./assets/shaders/default_vertex.glsl")
+    - view (FileView*): where to store the view
+Returns:
+    true if the path has been found (and decompressed), false otherwise
+*/
+bool archive_map(const char* path, FileView* view);
+
+#endif
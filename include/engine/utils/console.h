@@ -1,11 +1,16 @@
 /*
 CONSOLE:
 Output handling (info, warning, error, debug)
+By default the messages are written synchronously by the calling thread. Once console_startAsync() has been called
+(app_create() does it) the callers only format their message into a lock-free ring buffer and a background thread
+writes it out, so a log storm costs the calling threads a formatting each instead of a blocking write each.
 */
 
 #ifndef CONSOLE_H
 #define CONSOLE_H
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>    // For printf, vprintf
 #include <stdarg.h>   // For va_list, va_start, va_end
 #include <string.h>   // For strlen (optional, for safety check)
@@ -20,6 +25,120 @@ Output handling (info, warning, error, debug)
 #define COLOR_ORANGE  "\x1b[38;5;208m"
 #define COLOR_RESET   "\x1b[0m"
 
+// ASYNCHRONOUS OUTPUT
+// longer messages are truncated when the output is asynchronous
+#define CONSOLE_MAX_MESSAGE 512
+#define CONSOLE_DEFAULT_CAPACITY 2048
+
+// what the console functions do when the ring buffer is full
+typedef enum {
+    CONSOLE_OVERFLOW_DROP, // the message is discarded (the number of dropped messages is reported by the background thread)
+    CONSOLE_OVERFLOW_BLOCK // the caller waits for a free slot
+} ConsoleOverflow;
+
+/*
+Starts the asynchronous output: from now on the console functions only format their message into a ring buffer
+and a background thread writes it out. The queued messages are also written out if the process crashes.
+Parameters:
+    - capacity (unsigned int): the number of messages the ring can hold (rounded up to a power of two, 0 means CONSOLE_DEFAULT_CAPACITY)
+    - overflow (ConsoleOverflow): what to do when the ring is full (drop the message or wait for a free slot)
+Returns:
+    true on success (or if it was already running), false otherwise (the output stays synchronous)
+*/
+bool console_startAsync(unsigned int capacity, ConsoleOverflow overflow);
+// stops the asynchronous output after writing out all the queued messages (the output goes back to being synchronous)
+void console_stopAsync();
+// waits until all the messages queued so far have been written out
+void console_flush();
+// returns the number of messages dropped because the ring was full (with the CONSOLE_OVERFLOW_DROP policy)
+unsigned long long console_getDroppedCount();
+
+// LEVELS
+#define CONSOLE_LEVEL_DEBUG   0
+#define CONSOLE_LEVEL_INFO    1
+#define CONSOLE_LEVEL_LOG     2
+#define CONSOLE_LEVEL_WARNING 3
+#define CONSOLE_LEVEL_ERROR   4
+#define CONSOLE_LEVEL_NONE    5
+
+// the log sites below this level are compiled out (the CONSOLE_* macros, the console_* functions are not affected)
+#ifndef CONSOLE_MIN_LEVEL
+#ifdef NDEBUG
+#define CONSOLE_MIN_LEVEL CONSOLE_LEVEL_INFO
+#else
+#define CONSOLE_MIN_LEVEL CONSOLE_LEVEL_DEBUG
+#endif
+#endif
+
+// the file the log site is in (without its directories when the compiler provides it)
+#ifdef __FILE_NAME__
+#define CONSOLE_FILE __FILE_NAME__
+#else
+#define CONSOLE_FILE __FILE__
+#endif
+
+// state of a rate limited log site (one per site, see CONSOLE_AT_RATE())
+typedef struct {
+    uint64_t window;         // the second the count refers to
+    unsigned int count;      // messages logged in that second
+    unsigned int suppressed; // messages suppressed since the last logged one
+} ConsoleRateLimit;
+
+/*
+LOG SITES:
+Every macro logs "file:line: message" at its level and costs nothing when the level is below CONSOLE_MIN_LEVEL (the
+condition is a constant, so the call and the evaluation of its arguments are removed by the compiler).
+    - CONSOLE_<LEVEL>(format, ...): logs every time
+    - CONSOLE_<LEVEL>_ONCE(format, ...): logs only the first time the site is reached
+    - CONSOLE_<LEVEL>_RATE(perSecond, format, ...): logs at most perSecond times per second (the suppressed messages are counted and reported by the next logged one)
+e.g.: CONSOLE_WARNING_RATE(1, "Missing uniform \"%s\"", name);
+*/
+#define CONSOLE_AT(level, ...) do { \
+    if ((level) >= CONSOLE_MIN_LEVEL) console_logAt((level), CONSOLE_FILE, __LINE__, 0, __VA_ARGS__); \
+} while (0)
+#define CONSOLE_AT_ONCE(level, ...) do { \
+    static bool consoleLogged_ = false; \
+    if ((level) >= CONSOLE_MIN_LEVEL && !__atomic_load_n(&consoleLogged_, __ATOMIC_RELAXED) && !__atomic_exchange_n(&consoleLogged_, true, __ATOMIC_RELAXED)) \
+        console_logAt((level), CONSOLE_FILE, __LINE__, 0, __VA_ARGS__); \
+} while (0)
+#define CONSOLE_AT_RATE(level, perSecond, ...) do { \
+    static ConsoleRateLimit consoleLimit_ = { 0, 0, 0 }; \
+    unsigned int consoleSuppressed_; \
+    if ((level) >= CONSOLE_MIN_LEVEL && console_rateLimit(&consoleLimit_, (perSecond), &consoleSuppressed_)) \
+        console_logAt((level), CONSOLE_FILE, __LINE__, consoleSuppressed_, __VA_ARGS__); \
+} while (0)
+
+#define CONSOLE_DEBUG(...) CONSOLE_AT(CONSOLE_LEVEL_DEBUG, __VA_ARGS__)
+#define CONSOLE_INFO(...) CONSOLE_AT(CONSOLE_LEVEL_INFO, __VA_ARGS__)
+#define CONSOLE_LOG(...) CONSOLE_AT(CONSOLE_LEVEL_LOG, __VA_ARGS__)
+#define CONSOLE_WARNING(...) CONSOLE_AT(CONSOLE_LEVEL_WARNING, __VA_ARGS__)
+#define CONSOLE_ERROR(...) CONSOLE_AT(CONSOLE_LEVEL_ERROR, __VA_ARGS__)
+
+#define CONSOLE_DEBUG_ONCE(...) CONSOLE_AT_ONCE(CONSOLE_LEVEL_DEBUG, __VA_ARGS__)
+#define CONSOLE_INFO_ONCE(...) CONSOLE_AT_ONCE(CONSOLE_LEVEL_INFO, __VA_ARGS__)
+#define CONSOLE_LOG_ONCE(...) CONSOLE_AT_ONCE(CONSOLE_LEVEL_LOG, __VA_ARGS__)
+#define CONSOLE_WARNING_ONCE(...) CONSOLE_AT_ONCE(CONSOLE_LEVEL_WARNING, __VA_ARGS__)
+#define CONSOLE_ERROR_ONCE(...) CONSOLE_AT_ONCE(CONSOLE_LEVEL_ERROR, __VA_ARGS__)
+
+#define CONSOLE_DEBUG_RATE(perSecond, ...) CONSOLE_AT_RATE(CONSOLE_LEVEL_DEBUG, perSecond, __VA_ARGS__)
+#define CONSOLE_INFO_RATE(perSecond, ...) CONSOLE_AT_RATE(CONSOLE_LEVEL_INFO, perSecond, __VA_ARGS__)
+#define CONSOLE_LOG_RATE(perSecond, ...) CONSOLE_AT_RATE(CONSOLE_LEVEL_LOG, perSecond, __VA_ARGS__)
+#define CONSOLE_WARNING_RATE(perSecond, ...) CONSOLE_AT_RATE(CONSOLE_LEVEL_WARNING, perSecond, __VA_ARGS__)
+#define CONSOLE_ERROR_RATE(perSecond, ...) CONSOLE_AT_RATE(CONSOLE_LEVEL_ERROR, perSecond, __VA_ARGS__)
+
+/*
+Logs a message at the given level with its location (used by the CONSOLE_* macros).
+Parameters:
+    - level (int): one of the CONSOLE_LEVEL_* levels
+    - file (const char*): the file of the log site
+    - line (int): the line of the log site
+    - suppressed (unsigned int): the number of messages of this site suppressed by the rate limit (reported if not 0)
+    - format (const char*): the printf format of the message
+*/
+void console_logAt(int level, const char* file, int line, unsigned int suppressed, const char* format, ...) __attribute__((format(printf, 5, 6)));
+// returns whether a rate limited site can log now (storing in suppressed how many of its messages have been suppressed since the last one)
+bool console_rateLimit(ConsoleRateLimit* limit, unsigned int perSecond, unsigned int* suppressed);
+
 // literally a printf
 void console_printf(const char* format, ...);
 // generic output (just like a printf but with also a new line character at the end)
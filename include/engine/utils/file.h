@@ -7,16 +7,63 @@ File reader/writer
 #define FILE_H
 
 #include <stdio.h>
+#include <stddef.h>
 #include <stdbool.h>
 
+// where the content of a file view lives
+typedef enum {
+    FILE_VIEW_MAPPED,  // the file is memory mapped
+    FILE_VIEW_HEAP,    // the file has been read (or decompressed) into a heap buffer
+    FILE_VIEW_ARCHIVE  // the file is packed in a mounted archive (see archive.h), the view points into the archive mapping
+} FileViewType;
+
+// read-only view of a whole file, created by file_map() and released by file_unmap()
+typedef struct {
+    const unsigned char* data; // the file content (NOT null terminated)
+    size_t size;               // the file size in bytes
+    FileViewType type;         // where the content lives
+} FileView;
+
+// access pattern hints for a mapped file (see file_advise())
+typedef enum {
+    FILE_ACCESS_NORMAL,     // no particular access pattern
+    FILE_ACCESS_SEQUENTIAL, // the file is read from start to end (more aggressive read-ahead, pages can be dropped after use)
+    FILE_ACCESS_RANDOM,     // the file is read at random offsets (no read-ahead)
+    FILE_ACCESS_WILLNEED    // the whole file will be needed soon (start reading it in the background)
+} FileAccess;
+
 // returns the file pointer corresponding to the file at the given path ("./file" means it is in "g3ce")
 FILE* file_open(char* path, char* mode);
 
 // writes content to a file at path ("./file" means it is in "g3ce")
 bool file_write(char* path, char* content);
-// reads a file at path and outputs its content to content ("./file" means it is in "g3ce")
+// reads a file at path and outputs its content to content ("./file" means it is in "g3ce", the mounted archives are looked up first)
 // YOU MUST FREE THE RETURN VALUE!
 char* file_read(char* path);
+// reads a binary file at path and returns its content, storing its size in bytes in length ("./file" means it is in "g3ce", the mounted archives are looked up first)
+// YOU MUST FREE THE RETURN VALUE!
+unsigned char* file_readBytes(char* path, size_t* length);
+
+/*
+Maps a whole file at path ("./file" means it is in "g3ce") into memory as a read-only view, without copying its content.
+The pages are loaded lazily by the OS straight from its page cache, so the content is never double buffered.
+The mounted archives are looked up first (see archive.h), then the disk.
+On platforms without mmap() the file is read into a heap buffer instead (view->type is FILE_VIEW_HEAP).
+REMEMBER TO RELEASE IT BY CALLING file_unmap()!
+Parameters:
+    - path (char*): the file path
+    - view (FileView*): where to store the view
+Returns:
+    true on success, false otherwise
+*/
+bool file_map(char* path, FileView* view);
+// releases a view created by file_map() (its data must not be used anymore)
+void file_unmap(FileView* view);
+// tells the OS how a mapped file is going to be accessed (it is just a hint, it does nothing if the file is not mapped)
+void file_advise(FileView* view, FileAccess access);
+
+// returns true if a file exists on the disk at path ("./file" means it is in "g3ce", the mounted archives are NOT looked up)
+bool file_exists(char* path);
 // removes a file at path ("./file" means it is in "g3ce")
 int file_remove(char* path);
 
@@ -0,0 +1,79 @@
+/*
+IO:
+Asynchronous file reading.
+A read is submitted with io_readFile() and completes in the background: its state can be polled and its callback
+is run by io_poll() (called by the app loop once per frame), so callbacks always run on the thread that polls,
+meaning that they can safely use OpenGL (e.g. to create a texture from the data that has just been read).
+On Linux the reads go through io_uring (many reads in flight with a single system call), otherwise (or when io_uring
+is not available) a small pool of threads performs blocking reads.
+Paths packed in a mounted archive (see archive.h) complete right away without touching the disk.
+The functions of this module are NOT thread safe: submit, poll and release from the same thread.
+*/
+
+#ifndef IO_H
+#define IO_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "engine/utils/file.h"
+
+typedef enum {
+    IO_BACKEND_AUTO,    // io_uring when available, the thread pool otherwise
+    IO_BACKEND_URING,   // io_uring only (io_init() fails when it is not available)
+    IO_BACKEND_THREADS  // blocking reads on a pool of threads
+} IoBackend;
+
+typedef enum {
+    IO_STATUS_PENDING, // the read is still in flight
+    IO_STATUS_DONE,    // the whole file has been read
+    IO_STATUS_FAILED   // the read failed (the error has already been logged)
+} IoStatus;
+
+typedef struct IoRequest IoRequest;
+
+// called by io_poll() when a read completes (successfully or not), the request can be released inside the callback
+typedef void (*IoCallback)(IoRequest* request, void* userData);
+
+/*
+Initializes the asynchronous reading backend (app_create() calls it with IO_BACKEND_AUTO).
+Parameters:
+    - backend (IoBackend): the backend to use
+    - threadCount (unsigned int): the number of reading threads of the thread pool backend (0 picks a default)
+Returns:
+    true on success, false otherwise
+*/
+bool io_init(IoBackend backend, unsigned int threadCount);
+// waits for all the reads in flight and shuts the backend down (app_terminate() calls it)
+void io_shutdown();
+// returns the name of the backend in use ("io_uring", "threads" or "none" when not initialized)
+const char* io_getBackendName();
+
+/*
+Starts reading a whole file asynchronously ("./file" means it is in "g3ce", the mounted archives are looked up first).
+REMEMBER TO RELEASE THE REQUEST BY CALLING io_release()!
+Parameters:
+    - path (char*): the file path
+    - callback (IoCallback): the function to call when the read completes (it can be NULL)
+    - userData (void*): the pointer passed to the callback
+Returns:
+    the request (NULL if it could not even be submitted, e.g. when the file does not exist)
+*/
+IoRequest* io_readFile(char* path, IoCallback callback, void* userData);
+// runs the callbacks of the reads completed since the last call without blocking, returns the number of completed reads
+unsigned int io_poll();
+// blocks until the given read completes (running the callbacks of all the reads completing in the meantime)
+void io_wait(IoRequest* request);
+// blocks until all the reads in flight complete (running their callbacks)
+void io_waitAll();
+
+// returns the status of a read
+IoStatus io_getStatus(IoRequest* request);
+// returns the path of a read
+const char* io_getPath(IoRequest* request);
+// returns the content of a completed read (the view belongs to the request, so it is valid until io_release() is called)
+const FileView* io_getView(IoRequest* request);
+// releases a completed read and its data (it must not be called on a pending read)
+void io_release(IoRequest* request);
+
+#endif
@@ -0,0 +1,87 @@
+/*
+JOB:
+Work-stealing job system.
+A fixed pool of worker threads (one per core, the main thread being the last one) runs small functions, the jobs.
+Every worker and the main thread own a Chase-Lev deque: jobs are pushed to and popped from the bottom of the deque of
+the thread that submits them (the most recent first, while its data is still in the cache), and the idle threads steal
+from the top of the others (the oldest first), so there are no locks on the common path.
+Jobs are grouped by counters: submitting a job increments its counter, finishing it decrements it. A job can wait for
+a counter before starting (a dependency), and any thread can wait for a counter: it runs jobs while it waits instead
+of blocking (so waiting inside a job never deadlocks the pool).
+job_parallelFor() splits an index range into batches run as jobs (e.g. updating the transforms of an array of objects).
+The threads that are not part of the pool (e.g. the asynchronous reads) can submit jobs too, through a shared queue.
+app_create() initializes the pool and app_terminate() shuts it down.
+*/
+
+#ifndef JOB_H
+#define JOB_H
+
+#include <stdbool.h>
+
+// threads in the pool at most (the main thread included)
+#define JOB_MAX_THREADS 64
+// jobs every thread can have queued and in flight (a power of two), submitting more runs them right away
+#define JOB_QUEUE_CAPACITY 1024
+
+// a job
+typedef void (*JobFunction)(void* data);
+// a batch of a parallel for, running the indices from start to end (excluded)
+typedef void (*JobRangeFunction)(unsigned int start, unsigned int end, void* data);
+
+typedef struct Job Job;
+
+// counts the unfinished jobs of a group, zero initialize it (JobCounter counter = { 0 };) and keep it alive until they are done
+typedef struct {
+    unsigned int pending; // jobs submitted and not finished yet
+    bool lock;            // protects the list of the jobs waiting for it
+    Job* waiting;         // jobs to submit when pending drops to zero
+} JobCounter;
+
+/*
+Starts the worker threads (app_create() calls it), the calling thread becomes the main thread of the pool.
+Parameters:
+    - threadCount (unsigned int): the threads running jobs, the main thread included (0 means one per core)
+Returns:
+    true on success, false otherwise
+*/
+bool job_init(unsigned int threadCount);
+// runs the jobs still queued and stops the worker threads (app_terminate() calls it)
+void job_shutdown();
+// returns the threads running jobs (the main thread included, 1 when the pool is not initialized)
+unsigned int job_getThreadCount();
+// returns the index of the calling thread in the pool (0 is the main thread, the workers go from 1 to job_getThreadCount() - 1, -1 for the threads outside of the pool)
+int job_getThreadIndex();
+
+/*
+Submits a job.
+Parameters:
+    - function (JobFunction): the function to run
+    - data (void*): the pointer passed to the function (it must stay valid until the job is done)
+    - counter (JobCounter*): the counter of the job (it can be NULL)
+*/
+void job_run(JobFunction function, void* data, JobCounter* counter);
+/*
+Submits a job which starts only when all the jobs of another counter are done.
+Parameters:
+    - dependency (JobCounter*): the counter to wait for
+    - function (JobFunction): the function to run
+    - data (void*): the pointer passed to the function (it must stay valid until the job is done)
+    - counter (JobCounter*): the counter of the job (it can be NULL, it MUST NOT be the dependency)
+*/
+void job_runAfter(JobCounter* dependency, JobFunction function, void* data, JobCounter* counter);
+/*
+Runs a function over a range of indices, split in batches run in parallel.
+Parameters:
+    - count (unsigned int): the indices (from 0 to count - 1)
+    - batchSize (unsigned int): the indices of every batch (0 picks a size giving a few batches per thread)
+    - function (JobRangeFunction): the function run on every batch
+    - data (void*): the pointer passed to the function
+    - counter (JobCounter*): the counter of the batches, NULL to wait for all of them before returning
+*/
+void job_parallelFor(unsigned int count, unsigned int batchSize, JobRangeFunction function, void* data, JobCounter* counter);
+// waits for all the jobs of a counter, running queued jobs meanwhile
+void job_wait(JobCounter* counter);
+// returns true if all the jobs of a counter are done
+bool job_isDone(JobCounter* counter);
+
+#endif
@@ -0,0 +1,75 @@
+/*
+JSON:
+Minimal JSON parser (and the string writer of the JSON reports).
+The whole text is parsed at once into a flat array of tokens (values, object keys included) in document order, where
+every token knows where its children end, so walking a document never allocates and skipping a value is O(1).
+Tokens are referred to by their index (0 is the root value), and all the getters accept -1 (missing token) returning
+-1 or the given fallback, so lookups can be chained without checking every step:
+    json_getNumber(&document, json_getElement(&document, json_getMember(&document, 0, "scale"), 1), 1.0)
+The strings are not copied nor unescaped: they point into the parsed text, which must outlive the document.
+*/
+
+#ifndef JSON_H
+#define JSON_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdbool.h>
+
+typedef enum {
+    JSON_NULL,
+    JSON_BOOL,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} JsonType;
+
+typedef struct {
+    JsonType type;
+    unsigned int start;  // offset of the value in the text (the first character after the quote for strings)
+    unsigned int length; // length of the value in the text (without the quotes for strings)
+    unsigned int count;  // number of elements of an array or members of an object (each member is a key token followed by its value)
+    unsigned int next;   // index of the first token after this value and all its children
+    double number;       // the value of numbers (and 1 or 0 for booleans)
+} JsonToken;
+
+typedef struct {
+    const char* text;
+    JsonToken* tokens;
+    unsigned int tokenCount;
+} JsonDocument;
+
+/*
+Parses a JSON text.
+REMEMBER TO FREE THE DOCUMENT BY CALLING json_free()!
+Parameters:
+    - text (char*): the JSON text (it does not need to be null terminated and it must outlive the document)
+    - length (size_t): the text length in bytes
+    - document (JsonDocument*): where to store the parsed document
+Returns:
+    true on success, false if the text is not valid JSON (the error has already been logged)
+*/
+bool json_parse(const char* text, size_t length, JsonDocument* document);
+// frees a document parsed by json_parse()
+void json_free(JsonDocument* document);
+
+// returns the type of a token (JSON_NULL for the missing token -1)
+JsonType json_getType(const JsonDocument* document, int token);
+// returns the value token of an object member (-1 if the token is not an object or it has no such member)
+int json_getMember(const JsonDocument* document, int object, const char* key);
+// returns the token of an array element (-1 if the token is not an array or the index is out of range)
+int json_getElement(const JsonDocument* document, int array, unsigned int index);
+// returns the number of elements of an array or members of an object (0 for any other token)
+unsigned int json_getCount(const JsonDocument* document, int token);
+// returns the value of a number or boolean token (fallback for any other token)
+double json_getNumber(const JsonDocument* document, int token, double fallback);
+// returns whether a token is a string equal to the given one
+bool json_equals(const JsonDocument* document, int token, const char* string);
+// copies a string token into the buffer (always null terminated, truncated if needed), returns false if the token is not a string
+bool json_copyString(const JsonDocument* document, int token, char* buffer, size_t size);
+
+// writes a string as a JSON string (quotes, backslashes and control characters escaped), NULL is written as null
+void json_writeString(FILE* file, const char* string);
+
+#endif
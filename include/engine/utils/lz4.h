@@ -0,0 +1,39 @@
+/*
+LZ4:
+LZ4 block format compressor and decompressor (no frame format, the sizes have to be stored by the caller).
+The compressor is a simple greedy one: fast, but it does not reach the ratio of the reference high compression mode.
+*/
+
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+// returns the maximum compressed size of size bytes (the output buffer of lz4_compress() should be this big)
+size_t lz4_compressBound(size_t size);
+
+/*
+Compresses a buffer to an LZ4 block.
+Parameters:
+    - source (unsigned char*): the data to compress
+    - sourceSize (size_t): the size of the data in bytes
+    - destination (unsigned char*): where to write the compressed block
+    - destinationCapacity (size_t): the size of the destination buffer in bytes
+Returns:
+    the size of the compressed block, 0 if it does not fit in the destination buffer
+*/
+size_t lz4_compress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationCapacity);
+/*
+Decompresses an LZ4 block (every offset and length is checked, so corrupted blocks are rejected instead of overflowing).
+Parameters:
+    - source (unsigned char*): the compressed block
+    - sourceSize (size_t): the size of the compressed block in bytes
+    - destination (unsigned char*): where to write the decompressed data
+    - destinationSize (size_t): the exact size of the decompressed data in bytes
+Returns:
+    true on success, false if the block is corrupted or does not decompress to exactly destinationSize bytes
+*/
+bool lz4_decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize);
+
+#endif
@@ -0,0 +1,156 @@
+/*
+MEMORY:
+Allocators for the engine temporaries, so they do not go through malloc() and free() every frame.
+An arena (linear allocator) hands out memory by moving an offset forward in a block, and frees all of it at once by
+moving the offset back: it is rewound to a mark taken before a temporary allocation, or reset entirely. When a block
+is full the arena chains another one, and the last block it frees is kept as a spare for the next time.
+Two arenas are managed by the engine:
+    - the frame arena, reset at the start of every frame of the app loop (the memory handed out lives until the next
+      frame starts), for the main thread only
+    - the scratch arenas, one per thread (created on its first call to memory_getScratch()), rewound by their users
+A pool hands out elements of a fixed size from blocks of many of them, recycling the freed ones through a free list
+(a pool is thread safe). The objects, the transforms, the cameras and the meshes are allocated from pools.
+The memory is tracked by tag (what it is used for) and by kind (heap or GPU): live and peak bytes, live allocations and
+an optional budget per tag and kind, warning when the live bytes go over it. The heap allocations are tracked when they
+go through memory_alloc() and its siblings, the arenas and the pools; the GPU objects when their creator reports their
+size (the meshes, the textures and the shaders do). memory_shutdown() reports the allocations never freed.
+*/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// the alignment of every arena allocation and of every pool element
+#define MEMORY_ALIGNMENT 16
+// the size of the first block of the frame arena and of every scratch arena
+#define MEMORY_FRAME_CAPACITY (256 * 1024)
+#define MEMORY_SCRATCH_CAPACITY (64 * 1024)
+
+// what the tracked memory is used for
+typedef enum {
+    MEMORY_TAG_ENGINE,
+    MEMORY_TAG_MESH,
+    MEMORY_TAG_TEXTURE,
+    MEMORY_TAG_SHADER,
+    MEMORY_TAG_USER,
+    MEMORY_TAG_COUNT
+} MemoryTag;
+
+// where the tracked memory lives
+typedef enum {
+    MEMORY_HEAP,
+    MEMORY_GPU,
+    MEMORY_KIND_COUNT
+} MemoryKind;
+
+// the tracked GPU objects (the names of the different types can overlap)
+typedef enum {
+    MEMORY_GPU_BUFFER,
+    MEMORY_GPU_TEXTURE,
+    MEMORY_GPU_PROGRAM
+} MemoryGpuObject;
+
+// the counters of a tag and a kind
+typedef struct {
+    size_t live;              // bytes in use
+    size_t peak;              // the highest live bytes so far
+    unsigned int allocations; // allocations (or GPU objects) in use
+    size_t budget;            // the live bytes above which a warning is logged (0 for no budget)
+} MemoryStats;
+
+typedef struct ArenaBlock ArenaBlock;
+
+// a linear allocator, initialize it with ARENA_INIT() (the first block is allocated by the first allocation)
+typedef struct {
+    ArenaBlock* block; // the current block (the previous ones are chained to it)
+    ArenaBlock* spare; // the last block freed, reused before allocating a new one
+    size_t blockSize;  // the size of a new block (grown by arena_reset() to fit a whole frame in a block)
+    MemoryTag tag;     // the tag the blocks are tracked with
+} Arena;
+#define ARENA_INIT(capacity, memoryTag) { .block = NULL, .spare = NULL, .blockSize = (capacity), .tag = (memoryTag) }
+
+// the state of an arena, to rewind it with arena_rewind()
+typedef struct {
+    ArenaBlock* block;
+    size_t size;
+} ArenaMark;
+
+// a fixed size allocator, initialize it with POOL_INIT() (the first block is allocated by the first allocation)
+typedef struct {
+    size_t stride;            // the bytes of an element (rounded to MEMORY_ALIGNMENT)
+    unsigned int blockLength; // the elements in a block
+    void* freeList;           // the freed elements, reused first
+    void* blocks;             // the blocks allocated (chained)
+    unsigned int count;       // the elements in use
+    MemoryTag tag;            // the tag the elements in use are tracked with
+    bool lock;
+} Pool;
+#define POOL_INIT(size, length, memoryTag) { .stride = ((size) + MEMORY_ALIGNMENT - 1) / MEMORY_ALIGNMENT * MEMORY_ALIGNMENT, .blockLength = (length), .tag = (memoryTag) }
+
+// HEAP
+// allocates size bytes tracked with a tag (aligned to MEMORY_ALIGNMENT), returns NULL on failure (free it with memory_free())
+void* memory_alloc(MemoryTag tag, size_t size);
+// allocates count elements of size bytes set to zero, tracked with a tag, returns NULL on failure (free it with memory_free())
+void* memory_calloc(MemoryTag tag, size_t count, size_t size);
+// resizes an allocation of memory_alloc() (NULL allocates a new one with the tag), returns NULL on failure (the allocation is left untouched)
+void* memory_realloc(MemoryTag tag, void* memory, size_t size);
+// frees an allocation of memory_alloc() (NULL is ignored)
+void memory_free(void* memory);
+
+// ARENAS
+// allocates size bytes from an arena (aligned to MEMORY_ALIGNMENT), returns NULL on failure
+void* arena_alloc(Arena* arena, size_t size);
+// returns the state of an arena, every allocation made after it is freed by arena_rewind()
+ArenaMark arena_getMark(Arena* arena);
+// frees all the allocations made after a mark (the blocks chained after it are freed too)
+void arena_rewind(Arena* arena, ArenaMark mark);
+// frees all the allocations of an arena, keeping a single block large enough for all of them
+void arena_reset(Arena* arena);
+// frees all the blocks of an arena (it can still be used, it starts over)
+void arena_release(Arena* arena);
+// returns the bytes allocated from an arena
+size_t arena_getUsed(Arena* arena);
+
+// POOLS
+// allocates an element from a pool (its content is undefined), returns NULL on failure
+void* pool_alloc(Pool* pool);
+// gives an element back to a pool (NULL is ignored)
+void pool_free(Pool* pool, void* element);
+// frees all the blocks of a pool, the elements MUST NOT be used anymore (it can still be used, it starts over)
+void pool_release(Pool* pool);
+
+// TRACKING
+// tracks the size of a GPU object (replacing its previous size if it is already tracked, e.g. after a new glBufferData())
+void memory_trackGpu(MemoryGpuObject type, unsigned int name, MemoryTag tag, size_t bytes);
+// stops tracking a GPU object once deleted (the objects not tracked are ignored)
+void memory_untrackGpu(MemoryGpuObject type, unsigned int name);
+// sets the budget of a tag and a kind in bytes: a warning is logged when the live bytes go over it (0 removes it)
+void memory_setBudget(MemoryTag tag, MemoryKind kind, size_t budget);
+// returns the counters of a tag and a kind
+MemoryStats memory_getStats(MemoryTag tag, MemoryKind kind);
+// returns the name of a tag ("engine", "mesh", "texture", "shader" or "user")
+const char* memory_getTagName(MemoryTag tag);
+// logs the counters of every tag
+void memory_logStats();
+
+// ENGINE ARENAS
+// allocates size bytes from the frame arena, valid until the next frame starts (main thread only), returns NULL on failure
+void* memory_frameAlloc(size_t size);
+// returns the frame arena (main thread only)
+Arena* memory_getFrameArena();
+// frees the allocations of the frame arena (the app loop calls it at the start of every frame)
+void memory_beginFrame();
+/*
+Returns the scratch arena of the calling thread, creating it on the first call. Take a mark before allocating and
+rewind the arena to it once done, so the callers up the stack keep their own allocations:
+ArenaMark mark = arena_getMark(scratch); ... arena_alloc(scratch, size) ... arena_rewind(scratch, mark);
+Returns:
+    The arena, NULL if it could not be allocated
+*/
+Arena* memory_getScratch();
+// frees the frame arena and the scratch arenas of all the threads (no other thread may be using them anymore) and reports the tracked memory never freed, it is called by app_terminate()
+void memory_shutdown();
+
+#endif
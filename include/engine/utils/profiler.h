@@ -0,0 +1,113 @@
+/*
+PROFILER:
+CPU frame profiler.
+Code is instrumented with named scopes (PROFILE_BEGIN()/PROFILE_END() pairs or PROFILE_SCOPE() for a whole block),
+which only read the clock and append an event to a ring buffer owned by the calling thread (no locks, no allocations),
+so any thread can be profiled. At every frame boundary (profiler_frame(), called by the app loop) the events of the
+frame are aggregated per scope, giving the time spent in every scope per frame (last, min, avg and max since the last
+reset), and the events still in the rings can be exported as a Chrome trace (chrome://tracing or ui.perfetto.dev).
+GPU scopes (see gpuprofiler.h) are reported on their own "GPU" track, next to the CPU ones.
+The macros are compiled out unless G3CE_PROFILE is defined (CMake defines it outside of Release builds when the
+G3CE_ENABLE_PROFILER option is ON), the functions are always available.
+Scope names MUST be string literals (or strings that outlive the profiler): only their pointer is recorded.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// events kept by every thread (the oldest ones are overwritten)
+#define PROFILER_RING_EVENTS 16384
+// nesting levels recorded per thread (deeper scopes are ignored)
+#define PROFILER_MAX_DEPTH 64
+// distinct scope names aggregated
+#define PROFILER_MAX_SCOPES 256
+#define PROFILER_MAX_THREAD_NAME 32
+
+typedef struct {
+    const char* name;
+    bool gpu;              // measured on the GPU (see gpuprofiler.h)
+    unsigned int depth;    // nesting level the scope was first seen at
+    unsigned int calls;    // times the scope ended in the last frame
+    unsigned int frames;   // frames the scope has been seen in since the last reset
+    double last;           // milliseconds spent in the scope in the last frame
+    double min;            // per frame milliseconds since the last reset (only the frames the scope was seen in)
+    double avg;
+    double max;
+} ProfilerScopeStats;
+
+#ifdef G3CE_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+// begins a scope, which MUST be ended by PROFILE_END() on the same thread
+#define PROFILE_BEGIN(name) profiler_begin(name)
+#define PROFILE_END() profiler_end()
+// profiles the rest of the enclosing block (ended automatically on every exit path)
+#define PROFILE_SCOPE(name) \
+    __attribute__((cleanup(profiler_endScope))) int PROFILE_CONCAT(profileScope_, __LINE__) = (profiler_begin(name), 0)
+// profiles the whole function
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+// names the calling thread in the exported traces
+#define PROFILE_THREAD(name) profiler_setThreadName(name)
+#else
+#define PROFILE_BEGIN(name) ((void) 0)
+#define PROFILE_END() ((void) 0)
+#define PROFILE_SCOPE(name) ((void) 0)
+#define PROFILE_FUNCTION() ((void) 0)
+#define PROFILE_THREAD(name) ((void) 0)
+#endif
+
+// returns the profiler clock in nanoseconds (monotonic)
+uint64_t profiler_getTime();
+// begins a scope on the calling thread (see PROFILE_BEGIN())
+void profiler_begin(const char* name);
+// ends the last scope begun on the calling thread (see PROFILE_END())
+void profiler_end();
+// ends the last scope begun on the calling thread (cleanup function of PROFILE_SCOPE())
+void profiler_endScope(int* scope);
+// names the calling thread in the exported traces (the main thread is called "main" by the app loop)
+void profiler_setThreadName(const char* name);
+/*
+Adds a scope measured on the GPU to the "GPU" track (used by the GPU profiler, only from the thread owning the context).
+Parameters:
+    - name (const char*): the scope name
+    - depth (unsigned int): the nesting level of the scope
+    - start (uint64_t): when the scope started, in nanoseconds of the profiler clock
+    - end (uint64_t): when the scope ended, in nanoseconds of the profiler clock
+*/
+void profiler_addGpuEvent(const char* name, unsigned int depth, uint64_t start, uint64_t end);
+
+/*
+Marks the end of a frame: aggregates the scopes ended since the previous call on all the threads.
+It is called by the app loop after swapping the buffers.
+*/
+void profiler_frame();
+/*
+Copies the per scope statistics (in the order the scopes have been first seen).
+Parameters:
+    - stats (ProfilerScopeStats*): where to store the statistics
+    - maxScopes (unsigned int): the capacity of stats
+Returns:
+    the number of scopes copied
+*/
+unsigned int profiler_getScopeStats(ProfilerScopeStats* stats, unsigned int maxScopes);
+// returns the statistics of the whole frame (the time between two profiler_frame() calls)
+ProfilerScopeStats profiler_getFrameStats();
+// resets the min, avg and max of all the scopes
+void profiler_resetStats();
+// writes the per scope statistics to the console (indented by nesting level)
+void profiler_printStats();
+/*
+Exports the events still in the rings of all the threads as a Chrome trace (JSON Trace Event Format).
+Parameters:
+    - path (char*): the output file path ("./file" means it is in "g3ce")
+Returns:
+    true on success, false otherwise
+*/
+bool profiler_exportChromeTrace(char* path);
+// frees the rings of all the threads (no thread may be profiling anymore), it is called by app_terminate()
+void profiler_shutdown();
+
+#endif
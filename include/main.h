@@ -3,10 +3,10 @@
 
 // init function (called before entering the app main loop)
 void main_init();
-// tick function (called once every frame, here you should put all you update code)
+// tick function (called 60 times per second, here you should put all you update code)
 void main_tick();
-// draw function (called once every frame, here you should put all you rendering code)
-void main_draw();
+// draw function (called once every frame, here you should put all you rendering code), alpha is how far the frame is between the last two ticks
+void main_draw(float alpha);
 // exit function (called after breaking out from the app main loop, before terminating the app)
 void main_exit();
 // resize function (called once at the start after the main_init() call and once every time a window resize event occurs)
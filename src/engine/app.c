@@ -3,10 +3,24 @@ APP:
 Contains all the app-related functions
 */
 
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stbi/stb_image.h>
 
 #include "engine/core/window.h"
+#include "engine/gfx/gpuprofiler.h"
 #include "engine/gfx/renderer.h"
+#include "engine/utils/archive.h"
+#include "engine/utils/console.h"
+#include "engine/utils/file.h"
+#include "engine/utils/io.h"
+#include "engine/utils/job.h"
+#include "engine/utils/json.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
 #include "engine/globals.h"
 
 #include "engine/app.h"
@@ -17,42 +31,524 @@ Contains all the app-related functions
 // // WINDOW
 // GLFWwindow* window;
 
-// creates the app with the given window parameters
+// frame timing (see app_getDeltaTime(), app_getFrameTime() and app_getInterpolationAlpha())
+static double app_deltaTime = 0.0;
+static double app_frameTime = 0.0;
+static float app_alpha = 0.0f;
+// fixed timestep mode (see app_loopFixed()), the step is 0 when every frame runs a single update
+static uint64_t app_fixedStep = 0; // nanoseconds
+static unsigned int app_maxSteps = 0;
+
+// PIPELINED MODE (see app_loopPipelined())
+static bool app_pipelined = false;
+static void (*app_pipelineTick)(void* snapshot) = NULL;
+static void (*app_pipelineDraw)(const void* snapshot) = NULL;
+static size_t app_snapshotSize = 0;
+static void* app_snapshots[2] = { NULL, NULL }; // double buffered: one is rendered while the other one is written
+static unsigned int app_currentSnapshot = 0;    // the snapshot rendered by the current frame
+// the simulation thread (started and waited for by the render thread, which owns the window and the context)
+static pthread_t app_simulationThread;
+static pthread_mutex_t app_simulationMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t app_simulationStart = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t app_simulationDone = PTHREAD_COND_INITIALIZER;
+static bool app_simulationPending = false; // a tick has been requested and is not done yet
+static bool app_simulationQuit = false;
+
+// HEADLESS BENCHMARK
+static bool app_headless = false;
+static AppBenchmark app_benchmark;
+static uint64_t app_benchmarkStep = 0; // the timestep in nanoseconds
+static int app_benchmarkWidth, app_benchmarkHeight;
+
+// measurements of the headless benchmark
+static double* app_frameTimes = NULL;          // CPU milliseconds of every measured frame
+static unsigned int app_measuredFrames = 0;
+static uint64_t app_benchmarkStart = 0;        // when the first measured frame started (profiler clock)
+static unsigned long long app_lastGpuFrame = 0; // last frame read back from the GPU profiler
+static unsigned int app_gpuSamples = 0;        // measured frames read back from the GPU profiler (it does not see every frame)
+static double app_gpuTotal = 0.0, app_gpuMax = 0.0;
+static RenderStats app_renderTotals;           // render counters summed over the measured frames
+
+// the initialization shared by app_create() and app_createHeadless() (the window is already created)
+static void app_init() {
+    stbi_set_flip_vertically_on_load(true); // vertically flip all the loaded textures for OpenGL
+
+    // load the assets from the packed archive when available (the files that are not packed are still loaded from the disk)
+    if (file_exists(APP_ASSETS_ARCHIVE)) archive_mount(APP_ASSETS_ARCHIVE);
+    // asynchronous file reads (their callbacks are run at the start of every frame)
+    io_init(IO_BACKEND_AUTO, 0);
+    // one job thread per core, the main thread included
+    job_init(0);
+}
+
+// creates the app with the given window parameters (and mounts APP_ASSETS_ARCHIVE if it has been built, and initializes the asynchronous reads, the job threads and logging)
 void app_create(int width, int height, char* title, bool resizable) {
+    // the logs are written by a background thread (dropping them when a log storm fills the ring, instead of stalling the frame)
+    console_startAsync(0, CONSOLE_OVERFLOW_DROP);
     window = window_create(width, height, title, resizable);
-    stbi_set_flip_vertically_on_load(true); // vertically flip all the loaded textures for OpenGL
+    app_init();
+#ifdef G3CE_PROFILE
+    // GPU scopes next to the CPU ones (see profiler.h)
+    gpuprofiler_init();
+#endif
 }
 
-// starts the app by running the given functions in a loop
-void app_loop(void (*main_init)(), void (*main_tick)(), void (*main_draw)(), void (*main_exit)(), void (*on_resize)()) {
+/*
+Creates the app without a display: the window is an offscreen one on GLFW's null platform (see window_createHeadless()),
+vsync is off and every frame lasts the same timestep (see app_getFrameTime()). The app loop renders the warmup frames and then the
+measured ones, closes the app by itself and writes the benchmark report (frame time percentiles, CPU and GPU scopes,
+render counters, etc...), so the performance of the app can be tracked on machines without a display nor a GPU.
+Parameters:
+    - width (int): the framebuffer width
+    - height (int): the framebuffer height
+    - benchmark (AppBenchmark): the frames to run and where to write the report
+*/
+void app_createHeadless(int width, int height, AppBenchmark benchmark) {
+    console_startAsync(0, CONSOLE_OVERFLOW_DROP);
+    window = window_createHeadless(width, height);
+    if (window == NULL) {
+        // there is nothing to benchmark, fail loudly instead of crashing in the loop
+        console_stopAsync();
+        exit(EXIT_FAILURE);
+    }
+
+    app_headless = true;
+    app_benchmark = benchmark;
+    if (app_benchmark.frames == 0) app_benchmark.frames = 1;
+    if (app_benchmark.timestep <= 0.0) app_benchmark.timestep = 1.0 / 60.0;
+    app_benchmarkStep = (uint64_t) llround(app_benchmark.timestep * 1000000000.0);
+    app_benchmarkWidth = width;
+    app_benchmarkHeight = height;
+    app_frameTimes = malloc(app_benchmark.frames * sizeof(double));
+    if (app_frameTimes == NULL) {
+        console_error("Failed to allocate the benchmark frame times");
+        console_stopAsync();
+        exit(EXIT_FAILURE);
+    }
+
+    app_init();
+    // the GPU frame times are part of the report, even when the profiler scopes are compiled out
+    gpuprofiler_init();
+}
+
+// returns whether the app has been created by app_createHeadless()
+bool app_isHeadless() {
+    return app_headless;
+}
+
+// returns the seconds the current update advances the app by (the fixed timestep with app_loopFixed(), the frame time otherwise)
+double app_getDeltaTime() {
+    return app_deltaTime;
+}
+
+// returns the seconds between the starts of the last two frames (the benchmark timestep when headless)
+double app_getFrameTime() {
+    return app_frameTime;
+}
+
+// returns how far the current frame is between the last two fixed updates, in [0, 1) (always 0 with app_loop())
+float app_getInterpolationAlpha() {
+    return app_alpha;
+}
+
+// starts measuring the benchmark (called at the start of the first frame after the warmup ones)
+static void app_beginBenchmark(uint64_t frameStart) {
+    app_benchmarkStart = frameStart;
+    app_measuredFrames = 0;
+    app_gpuSamples = 0;
+    app_gpuTotal = 0.0;
+    app_gpuMax = 0.0;
+    app_lastGpuFrame = app_benchmark.warmupFrames; // the GPU profiler counts the frames from 1 (its index of the warmup frames)
+    memset(&app_renderTotals, 0, sizeof(RenderStats));
+    profiler_resetStats();
+}
+
+// records a measured frame (called at the end of the frame), returns true once all the frames have been measured
+static bool app_measureFrame(uint64_t frameStart) {
+    app_frameTimes[app_measuredFrames++] = (double) (profiler_getTime() - frameStart) / 1000000.0;
+
+    // the GPU profiler reads the frames back a few frames later, only the frames it reports after the warmup are measured ones
+    const GpuFrameStats gpu = gpuprofiler_getFrameStats();
+    if (gpu.frame > app_lastGpuFrame) {
+        app_lastGpuFrame = gpu.frame;
+        app_gpuSamples++;
+        app_gpuTotal += gpu.gpu;
+        if (gpu.gpu > app_gpuMax) app_gpuMax = gpu.gpu;
+    }
+
+    const RenderStats stats = renderer_getStats();
+    app_renderTotals.drawCalls += stats.drawCalls;
+    app_renderTotals.vertices += stats.vertices;
+    app_renderTotals.triangles += stats.triangles;
+    app_renderTotals.shaderBinds += stats.shaderBinds;
+    app_renderTotals.vertexArrayBinds += stats.vertexArrayBinds;
+    app_renderTotals.textureBinds += stats.textureBinds;
+    app_renderTotals.samplerBinds += stats.samplerBinds;
+    app_renderTotals.polygonModeChanges += stats.polygonModeChanges;
+    app_renderTotals.cullModeChanges += stats.cullModeChanges;
+    app_renderTotals.depthTestChanges += stats.depthTestChanges;
+    app_renderTotals.uniformUploads += stats.uniformUploads;
+    app_renderTotals.bufferBytesUploaded += stats.bufferBytesUploaded;
+    app_renderTotals.culledObjects += stats.culledObjects;
+
+    return app_measuredFrames >= app_benchmark.frames;
+}
+
+static int app_compareDoubles(const void* a, const void* b) {
+    const double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// writes the benchmark report (the frame times are sorted, the raw ones are written in order)
+static bool app_writeBenchmarkReport(char* path, const double* sorted, double seconds, double avg, double stddev) {
+    FILE* file = file_open(path, "w");
+    if (file == NULL) return false;
+
+    const unsigned int n = app_measuredFrames;
+    // nearest rank percentiles
+    #define APP_PERCENTILE(p) sorted[(unsigned int) ((p) / 100.0 * (n - 1) + 0.5)]
+
+    fprintf(file, "{\n  \"gl\": {\"vendor\": ");
+    json_writeString(file, (const char*) glGetString(GL_VENDOR));
+    fprintf(file, ", \"renderer\": ");
+    json_writeString(file, (const char*) glGetString(GL_RENDERER));
+    fprintf(file, ", \"version\": ");
+    json_writeString(file, (const char*) glGetString(GL_VERSION));
+    fprintf(file, "},\n");
+    fprintf(file, "  \"width\": %d, \"height\": %d, \"frames\": %u, \"warmupFrames\": %u, \"timestep\": %.9g,\n",
+        app_benchmarkWidth, app_benchmarkHeight, n, app_benchmark.warmupFrames, app_benchmark.timestep);
+    fprintf(file, "  \"seconds\": %.6f, \"fps\": %.3f,\n", seconds, seconds > 0.0 ? n / seconds : 0.0);
+    fprintf(file, "  \"frameTime\": {\"min\": %.6f, \"avg\": %.6f, \"p50\": %.6f, \"p90\": %.6f, \"p95\": %.6f, \"p99\": %.6f, \"max\": %.6f, \"stddev\": %.6f},\n",
+        sorted[0], avg, APP_PERCENTILE(50), APP_PERCENTILE(90), APP_PERCENTILE(95), APP_PERCENTILE(99), sorted[n - 1], stddev);
+    fprintf(file, "  \"gpuFrameTime\": {\"samples\": %u, \"avg\": %.6f, \"max\": %.6f, \"skippedFrames\": %llu},\n",
+        app_gpuSamples, app_gpuSamples > 0 ? app_gpuTotal / app_gpuSamples : 0.0, app_gpuMax, gpuprofiler_getSkippedFrames());
+    #undef APP_PERCENTILE
+
+    // render counters per frame
+    const RenderStats* totals = &app_renderTotals;
+    fprintf(file, "  \"renderStats\": {\"drawCalls\": %.3f, \"vertices\": %.3f, \"triangles\": %.3f, \"shaderBinds\": %.3f, \"vertexArrayBinds\": %.3f, "
+        "\"textureBinds\": %.3f, \"samplerBinds\": %.3f, \"polygonModeChanges\": %.3f, \"cullModeChanges\": %.3f, \"depthTestChanges\": %.3f, "
+        "\"uniformUploads\": %.3f, \"bufferBytesUploaded\": %.3f, \"culledObjects\": %.3f},\n",
+        (double) totals->drawCalls / n, (double) totals->vertices / n, (double) totals->triangles / n, (double) totals->shaderBinds / n,
+        (double) totals->vertexArrayBinds / n, (double) totals->textureBinds / n, (double) totals->samplerBinds / n,
+        (double) totals->polygonModeChanges / n, (double) totals->cullModeChanges / n, (double) totals->depthTestChanges / n,
+        (double) totals->uniformUploads / n, (double) totals->bufferBytesUploaded / n, (double) totals->culledObjects / n);
+
+    // profiler scopes seen in the measured frames (only the GPU ones when the PROFILE_* macros are compiled out)
+    static ProfilerScopeStats scopes[PROFILER_MAX_SCOPES];
+    const unsigned int scopeCount = profiler_getScopeStats(scopes, PROFILER_MAX_SCOPES);
+    unsigned int written = 0;
+    fprintf(file, "  \"scopes\": [");
+    for (unsigned int i = 0; i < scopeCount; i++) {
+        if (scopes[i].frames == 0) continue;
+        fprintf(file, "%s\n    {\"name\": ", written++ == 0 ? "" : ",");
+        json_writeString(file, scopes[i].name);
+        fprintf(file, ", \"gpu\": %s, \"depth\": %u, \"frames\": %u, \"min\": %.6f, \"avg\": %.6f, \"max\": %.6f}",
+            scopes[i].gpu ? "true" : "false", scopes[i].depth, scopes[i].frames, scopes[i].min, scopes[i].avg, scopes[i].max);
+    }
+    fprintf(file, "%s],\n", written > 0 ? "\n  " : "");
+
+    // tracked memory at the end of the run, per tag (see memory.h)
+    fprintf(file, "  \"memory\": {");
+    for (unsigned int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        const MemoryStats heap = memory_getStats(tag, MEMORY_HEAP);
+        const MemoryStats gpu = memory_getStats(tag, MEMORY_GPU);
+        fprintf(file, "%s\n    \"%s\": {\"heapLive\": %zu, \"heapPeak\": %zu, \"gpuLive\": %zu, \"gpuPeak\": %zu}",
+            tag == 0 ? "" : ",", memory_getTagName(tag), heap.live, heap.peak, gpu.live, gpu.peak);
+    }
+    fprintf(file, "\n  },\n");
+
+    fprintf(file, "  \"frameTimes\": [");
+    for (unsigned int i = 0; i < n; i++) fprintf(file, "%s%.6f", i == 0 ? "" : ", ", app_frameTimes[i]);
+    fprintf(file, "]\n}\n");
+
+    const bool success = ferror(file) == 0;
+    if (fclose(file) != 0 || !success) {
+        console_error("Failed to write the benchmark report at \"%s\"", path);
+        return false;
+    }
+    return true;
+}
+
+// ends the benchmark: waits for the GPU, logs the summary and writes the report
+static void app_endBenchmark() {
+    // the frames are only done once the GPU has executed them
+    glFinish();
+    const double seconds = (double) (profiler_getTime() - app_benchmarkStart) / 1000000000.0;
+    const unsigned int n = app_measuredFrames;
+    if (n == 0) return;
+
+    double* sorted = malloc(n * sizeof(double));
+    if (sorted == NULL) {
+        console_error("Failed to allocate the benchmark statistics");
+        return;
+    }
+    memcpy(sorted, app_frameTimes, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), app_compareDoubles);
+
+    double total = 0.0;
+    for (unsigned int i = 0; i < n; i++) total += app_frameTimes[i];
+    const double avg = total / n;
+    double variance = 0.0;
+    for (unsigned int i = 0; i < n; i++) variance += (app_frameTimes[i] - avg) * (app_frameTimes[i] - avg);
+    const double stddev = n > 1 ? sqrt(variance / (n - 1)) : 0.0;
+
+    console_info("Benchmark: %u frames in %.3f s (%.1f fps), frame time min %.3f ms, avg %.3f ms, max %.3f ms, GPU avg %.3f ms",
+        n, seconds, seconds > 0.0 ? n / seconds : 0.0, sorted[0], avg, sorted[n - 1], app_gpuSamples > 0 ? app_gpuTotal / app_gpuSamples : 0.0);
+    if (app_benchmark.reportPath != NULL && app_writeBenchmarkReport(app_benchmark.reportPath, sorted, seconds, avg, stddev)) {
+        console_info("Benchmark report written to \"%s\"", app_benchmark.reportPath);
+    }
+    free(sorted);
+}
+
+// the simulation thread: runs a tick every time the render thread asks for one
+static void* app_simulate(void* arg) {
+    (void) arg;
+    PROFILE_THREAD("simulation");
+    pthread_mutex_lock(&app_simulationMutex);
+    while (true) {
+        while (!app_simulationPending && !app_simulationQuit) pthread_cond_wait(&app_simulationStart, &app_simulationMutex);
+        if (!app_simulationPending) break;
+        pthread_mutex_unlock(&app_simulationMutex);
+
+        // the next snapshot starts as a copy of the current one (which the render thread only reads meanwhile)
+        void* next = app_snapshots[1 - app_currentSnapshot];
+        memcpy(next, app_snapshots[app_currentSnapshot], app_snapshotSize);
+        PROFILE_BEGIN("tick");
+        app_pipelineTick(next);
+        PROFILE_END();
+
+        pthread_mutex_lock(&app_simulationMutex);
+        app_simulationPending = false;
+        pthread_cond_signal(&app_simulationDone);
+    }
+    pthread_mutex_unlock(&app_simulationMutex);
+    return NULL;
+}
+
+// asks the simulation thread to tick the next snapshot
+static void app_startTick() {
+    pthread_mutex_lock(&app_simulationMutex);
+    app_simulationPending = true;
+    pthread_cond_signal(&app_simulationStart);
+    pthread_mutex_unlock(&app_simulationMutex);
+}
+
+// waits for the tick of the next snapshot, which becomes the current one
+static void app_waitTick() {
+    pthread_mutex_lock(&app_simulationMutex);
+    while (app_simulationPending) pthread_cond_wait(&app_simulationDone, &app_simulationMutex);
+    pthread_mutex_unlock(&app_simulationMutex);
+    app_currentSnapshot = 1 - app_currentSnapshot;
+}
+
+// stops the simulation thread and frees the snapshots (the thread is idle, every tick started has been waited for)
+static void app_stopSimulation() {
+    pthread_mutex_lock(&app_simulationMutex);
+    app_simulationQuit = true;
+    pthread_cond_signal(&app_simulationStart);
+    pthread_mutex_unlock(&app_simulationMutex);
+    pthread_join(app_simulationThread, NULL);
+    free(app_snapshots[0]);
+    free(app_snapshots[1]);
+    app_snapshots[0] = app_snapshots[1] = NULL;
+    app_pipelined = false;
+}
+
+// runs the app loop (main_draw() or main_drawInterpolated() is called, whichever is not NULL, neither of them in the pipelined mode)
+static void app_run(void (*main_init)(), void (*main_tick)(), void (*main_draw)(), void (*main_drawInterpolated)(float alpha), void (*main_exit)(), void (*on_resize)()) {
+    PROFILE_THREAD("main");
+    PROFILE_BEGIN("init");
     main_init();
+    PROFILE_END();
 
+    if (app_pipelined) {
+        // the first snapshot, rendered by the first frame while the second one is ticked
+        app_deltaTime = 0.0;
+        app_startTick();
+        app_waitTick();
+    }
+
+    uint64_t previousFrame = profiler_getTime();
+    unsigned long long frameIndex = 0;
+    uint64_t accumulator = 0; // nanoseconds the fixed updates are behind the real time
+    app_alpha = 0.0f;
     while (!glfwWindowShouldClose(window)) {
+        const uint64_t frameStart = profiler_getTime();
+        // the headless frames all last the same, so the updates they run do not depend on the machine
+        const uint64_t frameTime = app_headless ? app_benchmarkStep : frameStart - previousFrame;
+        app_frameTime = (double) frameTime / 1000000000.0;
+        previousFrame = frameStart;
+        if (app_headless && frameIndex == app_benchmark.warmupFrames) app_beginBenchmark(frameStart);
+
+        PROFILE_BEGIN("frame");
+        // the temporaries of the previous frame are gone
+        memory_beginFrame();
+
         // events
         // resize event
         if (FLAG_WINDOW_RESIZED) {
+            PROFILE_BEGIN("resize");
             on_resize();
+            PROFILE_END();
             FLAG_WINDOW_RESIZED = false;
         }
 
+        // run the callbacks of the completed asynchronous reads
+        PROFILE_BEGIN("io_poll");
+        io_poll();
+        PROFILE_END();
+
         // tick
-        main_tick();
+        if (app_pipelined) {
+            // the next snapshot is ticked on the simulation thread while this frame renders the current one
+            app_deltaTime = app_frameTime;
+            app_startTick();
+        } else if (app_fixedStep == 0) {
+            app_deltaTime = app_frameTime;
+            PROFILE_BEGIN("tick");
+            main_tick();
+            PROFILE_END();
+        } else {
+            // as many updates as the real time needs (possibly none), dropping the time of those over the maximum
+            accumulator += frameTime;
+            for (unsigned int step = 0; accumulator >= app_fixedStep && step < app_maxSteps; step++) {
+                PROFILE_BEGIN("tick");
+                main_tick();
+                PROFILE_END();
+                accumulator -= app_fixedStep;
+            }
+            if (accumulator >= app_fixedStep) {
+                CONSOLE_WARNING_RATE(1, "The simulation cannot keep up, %.1f ms dropped (more than %u updates needed in a frame)",
+                    (double) (accumulator - accumulator % app_fixedStep) / 1000000.0, app_maxSteps);
+                accumulator %= app_fixedStep;
+            }
+            // (the float rounding could otherwise give 1 when the next update is a nanosecond away)
+            app_alpha = fminf((float) ((double) accumulator / (double) app_fixedStep), nextafterf(1.0f, 0.0f));
+        }
 
         // RENDER
+        gpuprofiler_beginFrame();
         // clear
+        PROFILE_BEGIN("clear");
+        GPU_PROFILE_BEGIN("clear");
         glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        main_draw();
+        GPU_PROFILE_END();
+        PROFILE_END();
+
+        PROFILE_BEGIN("draw");
+        GPU_PROFILE_BEGIN("main pass");
+        if (app_pipelined) app_pipelineDraw(app_snapshots[app_currentSnapshot]);
+        else if (main_drawInterpolated != NULL) main_drawInterpolated(app_alpha);
+        else main_draw();
+        GPU_PROFILE_END();
+        PROFILE_END();
+        gpuprofiler_endFrame();
 
         // finalize frame
+        PROFILE_BEGIN("swap");
         glfwSwapBuffers(window);
+        PROFILE_END();
+        if (app_pipelined) {
+            // the events are polled (and the close flag checked) only while the simulation thread is idle
+            PROFILE_BEGIN("wait_tick");
+            app_waitTick();
+            PROFILE_END();
+        }
+        PROFILE_BEGIN("poll_events");
         glfwPollEvents();
+        PROFILE_END();
+
+        PROFILE_END();
+        // aggregate the scopes and the render counters of the frame
+        profiler_frame();
+        renderer_collectStats();
+
+        // the headless app closes itself once all the frames have been measured
+        if (app_headless && frameIndex++ >= app_benchmark.warmupFrames && app_measureFrame(frameStart)) app_requestClose();
     }
 
+    if (app_headless) app_endBenchmark();
+    if (app_pipelined) app_stopSimulation();
     main_exit();
 }
 
+// starts the app by running the given functions in a loop
+void app_loop(void (*main_init)(), void (*main_tick)(), void (*main_draw)(), void (*main_exit)(), void (*on_resize)()) {
+    app_fixedStep = 0;
+    app_run(main_init, main_tick, main_draw, NULL, main_exit, on_resize);
+}
+
+/*
+Starts the app with a fixed update rate: every frame runs main_tick() as many times as needed (possibly none) for the
+updates to keep up with the real time, each of them advancing the app by exactly 1 / updateRate seconds, so the
+simulation does not depend on the frame rate. main_draw() gets how far the frame is between the last two updates, to
+interpolate the rendered state. When a frame would need more than maxSteps updates (rendering too slow, a debugger
+break, etc...) the excess time is dropped: the simulation slows down instead of falling further and further behind.
+Parameters:
+    - updateRate (double): the updates per second (e.g. 60)
+    - maxSteps (unsigned int): the updates run at most in a frame (0 means APP_DEFAULT_MAX_STEPS)
+    - main_init, main_tick, main_exit, on_resize: the same functions app_loop() takes
+    - main_draw (void (*)(float alpha)): the rendering function, alpha is in [0, 1) (0 is the state of the last update)
+*/
+void app_loopFixed(double updateRate, unsigned int maxSteps, void (*main_init)(), void (*main_tick)(), void (*main_draw)(float alpha), void (*main_exit)(), void (*on_resize)()) {
+    if (updateRate <= 0.0) {
+        console_error("Invalid update rate %f, it must be positive", updateRate);
+        return;
+    }
+    app_fixedStep = (uint64_t) llround(1000000000.0 / updateRate);
+    if (app_fixedStep == 0) app_fixedStep = 1;
+    app_maxSteps = maxSteps > 0 ? maxSteps : APP_DEFAULT_MAX_STEPS;
+    app_deltaTime = (double) app_fixedStep / 1000000000.0;
+    app_run(main_init, main_tick, NULL, main_draw, main_exit, on_resize);
+}
+
+/*
+Starts the app with the simulation and the rendering pipelined on two threads: while the render thread (the calling one,
+which owns the window and the OpenGL context) renders the frame N, a simulation thread runs main_tick() for the frame
+N + 1, so a frame lasts the longest of the two instead of their sum. The state the rendering needs (transforms, camera,
+etc...) goes in a snapshot: main_tick() writes the next one (which starts as a copy of the current one) and main_draw()
+only reads the current one, the two are swapped at the end of every frame. The rest of the state of the simulation
+MUST NOT be touched by main_draw(), nor OpenGL and the window by main_tick() (reading the input and app_requestClose()
+are fine: the events are polled and the close request checked while the simulation thread is idle). main_init(), main_exit(), on_resize() and the callbacks of the
+asynchronous reads run on the render thread. The first tick runs before the first frame, with a delta time of 0.
+Parameters:
+    - snapshotSize (size_t): the bytes of a snapshot (both start zeroed)
+    - main_init, main_exit, on_resize: the same functions app_loop() takes
+    - main_tick (void (*)(void* snapshot)): the update function, writing the next snapshot
+    - main_draw (void (*)(const void* snapshot)): the rendering function, reading the current snapshot
+*/
+void app_loopPipelined(size_t snapshotSize, void (*main_init)(), void (*main_tick)(void* snapshot), void (*main_draw)(const void* snapshot), void (*main_exit)(), void (*on_resize)()) {
+    // (calloc does not take 0 bytes everywhere)
+    app_snapshots[0] = calloc(1, snapshotSize > 0 ? snapshotSize : 1);
+    app_snapshots[1] = calloc(1, snapshotSize > 0 ? snapshotSize : 1);
+    if (app_snapshots[0] == NULL || app_snapshots[1] == NULL) {
+        console_error("Failed to allocate the snapshots of the pipelined loop");
+        free(app_snapshots[0]);
+        free(app_snapshots[1]);
+        app_snapshots[0] = app_snapshots[1] = NULL;
+        return;
+    }
+    app_snapshotSize = snapshotSize;
+    app_currentSnapshot = 1; // the first tick writes the snapshot 0
+    app_pipelineTick = main_tick;
+    app_pipelineDraw = main_draw;
+    app_simulationPending = false;
+    app_simulationQuit = false;
+    if (pthread_create(&app_simulationThread, NULL, app_simulate, NULL) != 0) {
+        console_error("Failed to start the simulation thread");
+        free(app_snapshots[0]);
+        free(app_snapshots[1]);
+        app_snapshots[0] = app_snapshots[1] = NULL;
+        return;
+    }
+
+    app_fixedStep = 0;
+    app_pipelined = true;
+    app_run(main_init, NULL, NULL, NULL, main_exit, on_resize);
+}
+
 // requests the app to close, it CANNOT be called outside of the app main loop
 void app_requestClose() {
     // skip if close was already requested
@@ -62,7 +558,16 @@ void app_requestClose() {
     glfwSetWindowShouldClose(window, GLFW_TRUE);
 }
 
-// closes the app by terminating GLFW
+// closes the app by terminating GLFW (and stopping the job threads, shutting down the asynchronous reads, unmounting the archives, freeing the profiler and the engine arenas, reporting the memory leaks and writing out the pending logs)
 void app_terminate() {
+    job_shutdown();
+    gpuprofiler_shutdown();
+    io_shutdown();
+    archive_unmountAll();
     glfwTerminate();
+    profiler_shutdown();
+    memory_shutdown();
+    free(app_frameTimes);
+    app_frameTimes = NULL;
+    console_stopAsync();
 }
\ No newline at end of file
@@ -7,9 +7,13 @@ It's basically an easier way to manage objects in code.
 #include <stdlib.h>
 
 #include "engine/utils/console.h"
+#include "engine/utils/memory.h"
 
 #include "engine/core/object.h"
 
+// the heap objects (see object_create())
+static Pool object_pool = POOL_INIT(sizeof(Object), 64, MEMORY_TAG_ENGINE);
+
 // creates a stack allocated object using the given mesh, with a blank transform an assigned shader = 0. It does not need to be destroyed
 Object object_new(Mesh mesh) {
     return (Object) {
@@ -22,7 +26,7 @@ Object object_new(Mesh mesh) {
 // creates an object with a given mesh and a blank transform (by default the assigned shader is 0)
 // YOU MUST DESTROY IT ONCE YOU'RE DONE WITH IT TO AVOID MEMORY LEAKS
 Object* object_create(Mesh mesh) {
-    Object* o = (Object*) malloc(sizeof(Object));
+    Object* o = (Object*) pool_alloc(&object_pool);
     if (o == NULL) {
         console_error("Failed to allocate memory for the object");
         return NULL;
@@ -36,7 +40,7 @@ Object* object_create(Mesh mesh) {
 }
 // destroys the given object
 void object_destroy(Object* o) {
-    free(o);
+    pool_free(&object_pool, o);
 }
 
 // SETTERS
@@ -44,20 +48,18 @@ void object_destroy(Object* o) {
 void object_setTransformByTransform(Object* o, Transform t) {
     o->transform = t;
 }
-// sets the given object transform vectors to the given transform vectors
+// sets the given object transform vectors to the given transform vectors (the rotation as pitch, yaw and roll in degrees)
 void object_setTransformByVectors(Object* o, vec3 position, vec3 rotation, vec3 scale) {
     o->transform.position = position;
-    o->transform.rotation = rotation;
+    o->transform.rotation = quat_fromEuler(rotation);
     o->transform.scale = scale;
 }
-// sets the given object transform values to the given transform values
+// sets the given object transform values to the given transform values (angles are in degrees)
 void object_setTransformByValues(Object* o, float x, float y, float z, float pitch, float yaw, float roll, float xs, float ys, float zs) {
     o->transform.position.x = x;
     o->transform.position.y = y;
     o->transform.position.z = z;
-    o->transform.rotation.x = pitch;
-    o->transform.rotation.y = yaw;
-    o->transform.rotation.z = roll;
+    transform_setRotation(&o->transform, pitch, yaw, roll);
     o->transform.scale.x = xs;
     o->transform.scale.y = ys;
     o->transform.scale.z = zs;
@@ -67,9 +69,9 @@ void object_setTransformByValues(Object* o, float x, float y, float z, float pit
 void object_setPositionByVector(Object* o, vec3 position) {
     o->transform.position = position;
 }
-// sets the given object rotation to the given rotation vector
+// sets the given object rotation to the given rotation vector (pitch, yaw, roll) (angles are in degrees)
 void object_setRotationByVector(Object* o, vec3 rotation) {
-    o->transform.rotation = rotation;
+    o->transform.rotation = quat_fromEuler(rotation);
 }
 // sets the given object scale to the given scale vector
 void object_setScaleByVector(Object* o, vec3 scale) {
@@ -82,11 +84,9 @@ void object_setPositionByValues(Object* o, float x, float y, float z) {
     o->transform.position.y = y;
     o->transform.position.z = z;
 }
-// sets the given object rotation to the given rotation values
+// sets the given object rotation to the given rotation values (angles are in degrees)
 void object_setRotationByValues(Object* o, float pitch, float yaw, float roll) {
-    o->transform.rotation.x = pitch;
-    o->transform.rotation.y = yaw;
-    o->transform.rotation.z = roll;
+    transform_setRotation(&o->transform, pitch, yaw, roll);
 }
 // sets the given object scale to the given scale values
 void object_setScaleByValues(Object* o, float xs, float ys, float zs) {
@@ -102,11 +102,9 @@ void object_changePositionByVector(Object* o, vec3 translation) {
     o->transform.position.y += translation.y;
     o->transform.position.z += translation.z;
 }
-// increments the given object rotation by the given rotation vector
+// rotates the given object by the given rotation vector (pitch, yaw, roll) around the parent axes (angles are in degrees)
 void object_changeRotationByVector(Object* o, vec3 rotation) {
-    o->transform.rotation.x += rotation.x;
-    o->transform.rotation.y += rotation.y;
-    o->transform.rotation.z += rotation.z;
+    transform_changeRotation(&o->transform, rotation);
 }
 // increments the given object scale by the given scaling vector
 void object_changeScaleByVector(Object* o, vec3 scaling) {
@@ -121,11 +119,9 @@ void object_changePositionByValues(Object* o, float xm, float ym, float zm) {
     o->transform.position.y += ym;
     o->transform.position.z += zm;
 }
-// increments the given object rotation by the given rotation values
+// rotates the given object by the given rotation values around the parent axes (angles are in degrees)
 void object_changeRotationByValues(Object* o, float xr, float yr, float zr) {
-    o->transform.rotation.x += xr;
-    o->transform.rotation.y += yr;
-    o->transform.rotation.z += zr;
+    transform_changeRotationValues(&o->transform, xr, yr, zr);
 }
 // increments the given object scale by the given scale values
 void object_changeScaleByValues(Object* o, float xs, float ys, float zs) {
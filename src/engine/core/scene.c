@@ -0,0 +1,414 @@
+/*
+SCENE:
+Scene graph.
+The nodes refer to their parent by id, so the nodes can be moved around: creating and moving nodes only marks the
+scene as unsorted, and the next update sorts it again by depth with a counting sort (stable, so the siblings keep
+their order). Destroying a subtree sorts the scene first, so a single pass finds the descendants (every parent
+comes before its children), then compacts the arrays keeping them sorted.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine/utils/console.h"
+#include "engine/utils/job.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/core/scene.h"
+
+#define SCENE_DEFAULT_CAPACITY 256
+#define SCENE_NONE UINT32_MAX
+// the nodes of a depth are updated on the job threads only when there are at least this many
+#define SCENE_PARALLEL_THRESHOLD 1024
+
+#define SCENE_NODE(id, generation) ((SceneNode) (generation) << 32 | (SceneNode) (id))
+#define SCENE_ID(node) ((unsigned int) ((node) & 0xFFFFFFFFu))
+#define SCENE_GENERATION(node) ((unsigned int) ((node) >> 32))
+
+// the parameters of the update of a depth
+typedef struct {
+    Scene* scene;
+    World* world;
+    unsigned int start; // the first position of the depth
+    unsigned int updated;
+} SceneLevelTask;
+
+// grows the arrays of the nodes to hold at least the given number of them
+static bool scene_reserve(Scene* scene, unsigned int capacity) {
+    if (capacity <= scene->capacity) return true;
+    unsigned int newCapacity = scene->capacity > 0 ? scene->capacity : SCENE_DEFAULT_CAPACITY;
+    while (newCapacity < capacity) newCapacity *= 2;
+
+    #define SCENE_GROW(array) do { \
+        void* grown = memory_realloc(MEMORY_TAG_ENGINE, scene->array, newCapacity * sizeof(*scene->array)); \
+        if (grown == NULL) goto fail; \
+        scene->array = grown; \
+    } while (0)
+    SCENE_GROW(ids);
+    SCENE_GROW(parents);
+    SCENE_GROW(depths);
+    SCENE_GROW(locals);
+    SCENE_GROW(worlds);
+    SCENE_GROW(entities);
+    SCENE_GROW(dirty);
+    SCENE_GROW(changed);
+    #undef SCENE_GROW
+    scene->capacity = newCapacity;
+    return true;
+
+fail:
+    // the arrays that did grow are kept, they are only used up to the old capacity
+    console_error("Failed to grow a scene to %u nodes", newCapacity);
+    return false;
+}
+
+// grows the id table by one id
+static bool scene_reserveId(Scene* scene) {
+    if (scene->idCount < scene->idCapacity) return true;
+    const unsigned int capacity = scene->idCapacity > 0 ? scene->idCapacity * 2 : SCENE_DEFAULT_CAPACITY;
+    unsigned int* generations = memory_realloc(MEMORY_TAG_ENGINE, scene->generations, capacity * sizeof(unsigned int));
+    if (generations != NULL) scene->generations = generations;
+    bool* alive = memory_realloc(MEMORY_TAG_ENGINE, scene->alive, capacity * sizeof(bool));
+    if (alive != NULL) scene->alive = alive;
+    unsigned int* positions = memory_realloc(MEMORY_TAG_ENGINE, scene->positions, capacity * sizeof(unsigned int));
+    if (positions != NULL) scene->positions = positions;
+    unsigned int* freeIds = memory_realloc(MEMORY_TAG_ENGINE, scene->freeIds, capacity * sizeof(unsigned int));
+    if (freeIds != NULL) scene->freeIds = freeIds;
+    if (generations == NULL || alive == NULL || positions == NULL || freeIds == NULL) {
+        console_error("Failed to grow a scene to %u node ids", capacity);
+        return false;
+    }
+    scene->idCapacity = capacity;
+    return true;
+}
+
+/*
+Creates an empty scene.
+You MUST call scene_destroy(Scene*) once the scene is not used anymore
+Parameters:
+    - capacity (unsigned int): the nodes allocated up front (the scene grows when needed, 0 picks a default)
+Returns:
+    The pointer to the scene, NULL if it could not be allocated
+*/
+Scene* scene_create(unsigned int capacity) {
+    Scene* scene = memory_calloc(MEMORY_TAG_ENGINE, 1, sizeof(Scene));
+    if (scene == NULL) {
+        console_error("Failed to allocate a scene");
+        return NULL;
+    }
+    scene->sorted = true;
+    if (!scene_reserve(scene, capacity > 0 ? capacity : SCENE_DEFAULT_CAPACITY) || !scene_reserveId(scene)) {
+        scene_destroy(scene);
+        return NULL;
+    }
+    return scene;
+}
+
+// destroys the given scene with all its nodes (the linked entities are not destroyed)
+void scene_destroy(Scene* scene) {
+    if (scene == NULL) return;
+    memory_free(scene->generations);
+    memory_free(scene->alive);
+    memory_free(scene->positions);
+    memory_free(scene->freeIds);
+    memory_free(scene->ids);
+    memory_free(scene->parents);
+    memory_free(scene->depths);
+    memory_free(scene->locals);
+    memory_free(scene->worlds);
+    memory_free(scene->entities);
+    memory_free(scene->dirty);
+    memory_free(scene->changed);
+    memory_free(scene->levels);
+    memory_free(scene);
+}
+
+// returns true if the handle refers to a node that has not been destroyed
+bool scene_isAlive(Scene* scene, SceneNode node) {
+    const unsigned int id = SCENE_ID(node);
+    return id < scene->idCount && scene->alive[id] && scene->generations[id] == SCENE_GENERATION(node);
+}
+
+// returns the number of nodes
+unsigned int scene_getNodeCount(Scene* scene) {
+    return scene->count;
+}
+
+// creates a node with a blank local transform as a child of the given parent (SCENE_NODE_NULL for a root), returns SCENE_NODE_NULL on failure
+SceneNode scene_createNode(Scene* scene, SceneNode parent) {
+    if (parent != SCENE_NODE_NULL && !scene_isAlive(scene, parent)) {
+        console_error("Cannot create a node under a destroyed parent");
+        return SCENE_NODE_NULL;
+    }
+    if (!scene_reserve(scene, scene->count + 1)) return SCENE_NODE_NULL;
+
+    unsigned int id;
+    if (scene->freeCount > 0) {
+        id = scene->freeIds[--scene->freeCount];
+    } else {
+        if (!scene_reserveId(scene)) return SCENE_NODE_NULL;
+        id = scene->idCount++;
+        scene->generations[id] = 1;
+    }
+
+    const unsigned int position = scene->count++;
+    const unsigned int parentId = parent != SCENE_NODE_NULL ? SCENE_ID(parent) : SCENE_NONE;
+    scene->alive[id] = true;
+    scene->positions[id] = position;
+    scene->ids[position] = id;
+    scene->parents[position] = parentId;
+    scene->depths[position] = parentId != SCENE_NONE ? scene->depths[scene->positions[parentId]] + 1 : 0;
+    scene->locals[position] = transform_new();
+    scene->worlds[position] = mat4_identity();
+    scene->entities[position] = ENTITY_NULL;
+    scene->dirty[position] = true;
+    scene->changed[position] = false;
+    if (scene->sorted) {
+        // appending a node to the deepest depth keeps the order, anything else needs a sort
+        if (scene->levelCount > 0 && scene->depths[position] == scene->levelCount - 1) scene->levels[scene->levelCount]++;
+        else scene->sorted = false;
+    }
+    return SCENE_NODE(id, scene->generations[id]);
+}
+
+// sorts the nodes by depth (stable) and rebuilds the positions and the levels, returns false if it cannot allocate
+static bool scene_sort(Scene* scene) {
+    if (scene->sorted) return true;
+    PROFILE_SCOPE("scene_sort");
+
+    const unsigned int count = scene->count;
+    unsigned int levelCount = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        if (scene->depths[i] + 1 > levelCount) levelCount = scene->depths[i] + 1;
+    }
+    if (levelCount + 1 > scene->levelCapacity) {
+        unsigned int* levels = memory_realloc(MEMORY_TAG_ENGINE, scene->levels, (levelCount + 1) * sizeof(unsigned int));
+        if (levels == NULL) {
+            console_error("Failed to sort a scene of %u levels", levelCount);
+            return false;
+        }
+        scene->levels = levels;
+        scene->levelCapacity = levelCount + 1;
+    }
+
+    // the new position of every node: the first position of its depth plus the nodes of the same depth before it
+    unsigned int* order = memory_alloc(MEMORY_TAG_ENGINE, (count > 0 ? count : 1) * sizeof(unsigned int));
+    unsigned char* scratch = memory_alloc(MEMORY_TAG_ENGINE, (count > 0 ? count : 1) * sizeof(mat4));
+    if (order == NULL || scratch == NULL) {
+        console_error("Failed to sort a scene of %u nodes", count);
+        memory_free(order);
+        memory_free(scratch);
+        return false;
+    }
+    memset(scene->levels, 0, (levelCount + 1) * sizeof(unsigned int));
+    for (unsigned int i = 0; i < count; i++) scene->levels[scene->depths[i] + 1]++;
+    for (unsigned int i = 0; i < levelCount; i++) scene->levels[i + 1] += scene->levels[i];
+    unsigned int* next = memory_alloc(MEMORY_TAG_ENGINE, (levelCount > 0 ? levelCount : 1) * sizeof(unsigned int));
+    if (next == NULL) {
+        console_error("Failed to sort a scene of %u nodes", count);
+        memory_free(order);
+        memory_free(scratch);
+        return false;
+    }
+    memcpy(next, scene->levels, (levelCount > 0 ? levelCount : 1) * sizeof(unsigned int));
+    for (unsigned int i = 0; i < count; i++) order[i] = next[scene->depths[i]]++;
+    memory_free(next);
+
+    // moves every array through the scratch buffer (large enough for the largest element)
+    #define SCENE_PERMUTE(array) do { \
+        __typeof__(scene->array) sorted = (__typeof__(scene->array)) scratch; \
+        for (unsigned int i = 0; i < count; i++) sorted[order[i]] = scene->array[i]; \
+        memcpy(scene->array, sorted, count * sizeof(*scene->array)); \
+    } while (0)
+    SCENE_PERMUTE(ids);
+    SCENE_PERMUTE(parents);
+    SCENE_PERMUTE(depths);
+    SCENE_PERMUTE(locals);
+    SCENE_PERMUTE(worlds);
+    SCENE_PERMUTE(entities);
+    SCENE_PERMUTE(dirty);
+    SCENE_PERMUTE(changed);
+    #undef SCENE_PERMUTE
+    memory_free(order);
+    memory_free(scratch);
+
+    for (unsigned int i = 0; i < count; i++) scene->positions[scene->ids[i]] = i;
+    scene->levelCount = levelCount;
+    scene->sorted = true;
+    return true;
+}
+
+// destroys a node and all its descendants
+void scene_destroyNode(Scene* scene, SceneNode node) {
+    if (!scene_isAlive(scene, node) || !scene_sort(scene)) return;
+
+    // the descendants come after the node: a node is destroyed when its parent is
+    const unsigned int first = scene->positions[SCENE_ID(node)];
+    scene->alive[SCENE_ID(node)] = false;
+    unsigned int kept = first;
+    for (unsigned int i = first + 1; i < scene->count; i++) {
+        const unsigned int parent = scene->parents[i];
+        if (parent != SCENE_NONE && !scene->alive[parent]) scene->alive[scene->ids[i]] = false;
+    }
+    // release the ids of the destroyed nodes and compact the others (still sorted)
+    for (unsigned int i = first; i < scene->count; i++) {
+        const unsigned int id = scene->ids[i];
+        if (!scene->alive[id]) {
+            if (++scene->generations[id] == 0) scene->generations[id] = 1;
+            scene->freeIds[scene->freeCount++] = id;
+            continue;
+        }
+        if (kept != i) {
+            scene->ids[kept] = id;
+            scene->parents[kept] = scene->parents[i];
+            scene->depths[kept] = scene->depths[i];
+            scene->locals[kept] = scene->locals[i];
+            scene->worlds[kept] = scene->worlds[i];
+            scene->entities[kept] = scene->entities[i];
+            scene->dirty[kept] = scene->dirty[i];
+            scene->changed[kept] = scene->changed[i];
+            scene->positions[id] = kept;
+        }
+        kept++;
+    }
+    scene->count = kept;
+    // the levels are rebuilt by the next update (some depths may be empty now)
+    scene->sorted = false;
+}
+
+// moves a node (and its descendants) under another parent (SCENE_NODE_NULL makes it a root), keeping its local transform, returns false if the parent is in its subtree
+bool scene_setParent(Scene* scene, SceneNode node, SceneNode parent) {
+    if (!scene_isAlive(scene, node) || (parent != SCENE_NODE_NULL && !scene_isAlive(scene, parent))) return false;
+    const unsigned int id = SCENE_ID(node);
+    const unsigned int parentId = parent != SCENE_NODE_NULL ? SCENE_ID(parent) : SCENE_NONE;
+
+    // the new parent cannot be the node itself nor one of its descendants
+    for (unsigned int ancestor = parentId; ancestor != SCENE_NONE; ancestor = scene->parents[scene->positions[ancestor]]) {
+        if (ancestor == id) {
+            console_error("Cannot move a node under one of its descendants");
+            return false;
+        }
+    }
+    if (!scene_sort(scene)) return false;
+
+    // the depths of the subtree change by the same amount: a single pass in the current order (parents first) finds it
+    const unsigned int position = scene->positions[id];
+    const unsigned int depth = parentId != SCENE_NONE ? scene->depths[scene->positions[parentId]] + 1 : 0;
+    const int shift = (int) depth - (int) scene->depths[position];
+    scene->parents[position] = parentId;
+    scene->dirty[position] = true;
+    if (shift != 0) {
+        // (changed is free until the next update, it marks the subtree meanwhile)
+        memset(scene->changed, 0, scene->count);
+        scene->changed[position] = true;
+        scene->depths[position] = depth;
+        for (unsigned int i = position + 1; i < scene->count; i++) {
+            const unsigned int parentOf = scene->parents[i];
+            if (parentOf != SCENE_NONE && scene->changed[scene->positions[parentOf]]) {
+                scene->changed[i] = true;
+                scene->depths[i] = (unsigned int) ((int) scene->depths[i] + shift);
+            }
+        }
+        memset(scene->changed, 0, scene->count);
+        scene->sorted = false;
+    }
+    return true;
+}
+
+// returns the parent of a node (SCENE_NODE_NULL for a root)
+SceneNode scene_getParent(Scene* scene, SceneNode node) {
+    if (!scene_isAlive(scene, node)) return SCENE_NODE_NULL;
+    const unsigned int parentId = scene->parents[scene->positions[SCENE_ID(node)]];
+    return parentId != SCENE_NONE ? SCENE_NODE(parentId, scene->generations[parentId]) : SCENE_NODE_NULL;
+}
+
+// links a node to an entity of the world given to scene_update(), its world matrix becomes the model matrix of the entity Renderable (ENTITY_NULL unlinks it)
+void scene_setEntity(Scene* scene, SceneNode node, Entity entity) {
+    if (!scene_isAlive(scene, node)) return;
+    const unsigned int position = scene->positions[SCENE_ID(node)];
+    scene->entities[position] = entity;
+    scene->dirty[position] = true;
+}
+
+// sets the local transform of a node (relative to its parent)
+void scene_setLocalTransform(Scene* scene, SceneNode node, Transform transform) {
+    if (!scene_isAlive(scene, node)) return;
+    const unsigned int position = scene->positions[SCENE_ID(node)];
+    scene->locals[position] = transform;
+    scene->dirty[position] = true;
+}
+
+// returns the local transform of a node
+Transform scene_getLocalTransform(Scene* scene, SceneNode node) {
+    if (!scene_isAlive(scene, node)) return transform_new();
+    return scene->locals[scene->positions[SCENE_ID(node)]];
+}
+
+// returns the local transform of a node to modify it in place, marking it as changed (valid until a node is created, destroyed or moved)
+Transform* scene_editLocalTransform(Scene* scene, SceneNode node) {
+    if (!scene_isAlive(scene, node)) return NULL;
+    const unsigned int position = scene->positions[SCENE_ID(node)];
+    scene->dirty[position] = true;
+    return &scene->locals[position];
+}
+
+// returns the world matrix of a node as of the last scene_update()
+mat4 scene_getWorldMatrix(Scene* scene, SceneNode node) {
+    if (!scene_isAlive(scene, node)) return mat4_identity();
+    return scene->worlds[scene->positions[SCENE_ID(node)]];
+}
+
+// returns the world position of a node as of the last scene_update()
+vec3 scene_getWorldPosition(Scene* scene, SceneNode node) {
+    const mat4 world = scene_getWorldMatrix(scene, node);
+    return vec3_new(world.entries[3], world.entries[7], world.entries[11]);
+}
+
+// updates a range of the nodes of a depth (their parents are all up to date)
+static void scene_updateRange(unsigned int start, unsigned int end, void* data) {
+    SceneLevelTask* task = data;
+    Scene* scene = task->scene;
+    unsigned int updated = 0;
+    for (unsigned int i = task->start + start; i < task->start + end; i++) {
+        const unsigned int parentId = scene->parents[i];
+        const unsigned int parent = parentId != SCENE_NONE ? scene->positions[parentId] : SCENE_NONE;
+        const bool changed = scene->dirty[i] || (parent != SCENE_NONE && scene->changed[parent]);
+        scene->changed[i] = changed;
+        if (!changed) continue;
+
+        const mat4 local = transform_getModelMatrix(&scene->locals[i]);
+        scene->worlds[i] = parent != SCENE_NONE ? mat4_multiply(scene->worlds[parent], local) : local;
+        scene->dirty[i] = false;
+        updated++;
+        if (task->world != NULL && scene->entities[i] != ENTITY_NULL) {
+            Renderable* renderable = world_getComponent(task->world, scene->entities[i], WORLD_RENDERABLE);
+            if (renderable != NULL) renderable->model = scene->worlds[i];
+        }
+    }
+    __atomic_add_fetch(&task->updated, updated, __ATOMIC_RELAXED);
+}
+
+/*
+Updates the world matrices of the nodes whose local transform changed and of their descendants (sorting the nodes
+first if the hierarchy changed), the nodes of every depth in parallel on the job threads.
+Parameters:
+    - scene (Scene*): the scene
+    - world (World*): the world of the linked entities, their Renderable model matrices are written (NULL to skip them)
+Returns:
+    The number of nodes updated
+*/
+unsigned int scene_update(Scene* scene, World* world) {
+    PROFILE_SCOPE("scene_update");
+    if (!scene_sort(scene)) return 0;
+
+    // depth after depth, every node reads the world matrix of its parent, updated by the previous depth
+    SceneLevelTask task = { .scene = scene, .world = world, .updated = 0 };
+    for (unsigned int level = 0; level < scene->levelCount; level++) {
+        task.start = scene->levels[level];
+        const unsigned int count = scene->levels[level + 1] - task.start;
+        if (count >= SCENE_PARALLEL_THRESHOLD) job_parallelFor(count, 0, scene_updateRange, &task, NULL);
+        else scene_updateRange(0, count, &task);
+    }
+    return task.updated;
+}
@@ -23,13 +23,17 @@ bool is_fullscreen;
 
 // creates the window with given parameters
 GLFWwindow* window_create(int width, int height, char* title, bool resizable) {
-    // initialize GLFW
-    glfwInit();
+    // initialize GLFW (on any of the platforms it has been built for, the platform is an init hint and not a window one)
+    glfwInitHint(GLFW_PLATFORM, GLFW_ANY_PLATFORM);
+    if (!glfwInit()) {
+        console_error("Failed to initialize GLFW");
+        return NULL;
+    }
     // set some GLFW flags
+    glfwDefaultWindowHints();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_PLATFORM, GLFW_PLATFORM_X11);
     
     glfwWindowHint(GLFW_RESIZABLE, resizable);
     
@@ -67,6 +71,51 @@ GLFWwindow* window_create(int width, int height, char* title, bool resizable) {
     return window;
 }
 
+/*
+Creates an invisible window on GLFW's null platform, which needs no display server: its OpenGL context is created by
+EGL on Mesa's surfaceless platform, rendering into an offscreen (pbuffer) default framebuffer of the given size.
+Vsync is disabled. It works with Mesa's software rasterizer (llvmpipe), so machines without a display nor a GPU can run the app.
+Parameters:
+    - width (int): the framebuffer width
+    - height (int): the framebuffer height
+Returns:
+    the window, NULL if it could not be created
+*/
+GLFWwindow* window_createHeadless(int width, int height) {
+    glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    if (!glfwInit()) {
+        console_error("Failed to initialize the GLFW null platform");
+        return NULL;
+    }
+    glfwDefaultWindowHints();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    // the native context API of the null platform is OSMesa, EGL is far more widely available
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_DEPTH_BITS, 24);
+
+    GLFWwindow* window = glfwCreateWindow(width, height, "", NULL, NULL);
+    if (window == NULL) {
+        console_error("Failed to create the headless GLFW window (is EGL with the Mesa surfaceless platform available?)");
+        window_destroy();
+        return NULL;
+    }
+
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        console_error("Failed to load GLAD");
+        return NULL;
+    }
+    // the frames are not paced by a display
+    glfwSwapInterval(0);
+    glViewport(0, 0, width, height);
+
+    return window;
+}
+
 // destroyes the window
 void window_destroy() {
     glfwTerminate();
@@ -154,6 +203,7 @@ float window_getHeight() {
 }
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    (void) window;
     // set OpenGL viewport
     glViewport(0, 0, width, height);
 
@@ -0,0 +1,473 @@
+/*
+WORLD:
+Entity-component storage.
+Every pool is a sparse set: a sparse array indexed by the entity index gives the position of its component in the
+packed array (and the packed array of entity indices gives back the entity of every component), so adding, removing
+and looking up a component are constant time, and removing moves the last component into the hole.
+The sparse arrays cover all the entity indices, they grow with the world.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "engine/gfx/renderer.h"
+#include "engine/gfx/shader.h"
+#include "engine/math/camera.h"
+#include "engine/utils/console.h"
+#include "engine/utils/job.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/core/world.h"
+
+#define WORLD_DEFAULT_CAPACITY 1024
+#define WORLD_NONE UINT32_MAX
+
+#define WORLD_ENTITY(index, generation) ((Entity) (generation) << 32 | (Entity) (index))
+#define WORLD_INDEX(entity) ((unsigned int) ((entity) & 0xFFFFFFFFu))
+#define WORLD_GENERATION(entity) ((unsigned int) ((entity) >> 32))
+
+// the parameters of the parallel iterations
+typedef struct {
+    World* world;
+    uint32_t mask;
+    unsigned int driver;
+    WorldFunction function;
+    void* data;
+} WorldParallelTask;
+
+/*
+Creates an empty world.
+You MUST call world_destroy(World*) once the world is not used anymore
+Parameters:
+    - capacity (unsigned int): the entities allocated up front (the world grows when needed, 0 picks a default)
+Returns:
+    The pointer to the world, NULL if it could not be allocated
+*/
+World* world_create(unsigned int capacity) {
+    World* world = memory_calloc(MEMORY_TAG_ENGINE, 1, sizeof(World));
+    if (world == NULL) {
+        console_error("Failed to allocate a world");
+        return NULL;
+    }
+    world->capacity = capacity > 0 ? capacity : WORLD_DEFAULT_CAPACITY;
+    world->generations = memory_alloc(MEMORY_TAG_ENGINE, world->capacity * sizeof(unsigned int));
+    world->masks = memory_alloc(MEMORY_TAG_ENGINE, world->capacity * sizeof(uint32_t));
+    world->alive = memory_alloc(MEMORY_TAG_ENGINE, world->capacity * sizeof(bool));
+    world->freeIndices = memory_alloc(MEMORY_TAG_ENGINE, world->capacity * sizeof(unsigned int));
+    if (world->generations == NULL || world->masks == NULL || world->alive == NULL || world->freeIndices == NULL) {
+        console_error("Failed to allocate a world of %u entities", world->capacity);
+        world_destroy(world);
+        return NULL;
+    }
+
+    // the components of every world
+    const Transform transform = transform_new();
+    const Renderable renderable = { .mesh = NULL, .shader = 0, .model = mat4_identity(), .visible = true };
+    if (world_registerComponent(world, sizeof(Transform), &transform) != WORLD_TRANSFORM
+        || world_registerComponent(world, sizeof(Renderable), &renderable) != WORLD_RENDERABLE) {
+        world_destroy(world);
+        return NULL;
+    }
+    return world;
+}
+
+// destroys the given world with all its entities and components (the meshes are not destroyed)
+void world_destroy(World* world) {
+    if (world == NULL) return;
+    for (unsigned int i = 0; i < world->componentCount; i++) {
+        ComponentPool* pool = &world->pools[i];
+        memory_free(pool->initial);
+        memory_free(pool->sparse);
+        memory_free(pool->entities);
+        memory_free(pool->data);
+    }
+    memory_free(world->generations);
+    memory_free(world->masks);
+    memory_free(world->alive);
+    memory_free(world->freeIndices);
+    memory_free(world);
+}
+
+/*
+Registers a component type.
+Parameters:
+    - world (World*): the world
+    - size (size_t): the bytes of a component
+    - initial (const void*): the value of an added component, NULL means all zeroes (it is copied)
+Returns:
+    The component type (WORLD_MASK() gives its mask), -1 if the world has WORLD_MAX_COMPONENTS types already
+*/
+int world_registerComponent(World* world, size_t size, const void* initial) {
+    if (world->componentCount == WORLD_MAX_COMPONENTS) {
+        console_error("Cannot register more than %d component types in a world", WORLD_MAX_COMPONENTS);
+        return -1;
+    }
+
+    ComponentPool* pool = &world->pools[world->componentCount];
+    memset(pool, 0, sizeof(ComponentPool));
+    pool->size = size > 0 ? size : 1;
+    pool->initial = memory_calloc(MEMORY_TAG_ENGINE, 1, pool->size);
+    pool->sparse = memory_alloc(MEMORY_TAG_ENGINE, world->capacity * sizeof(unsigned int));
+    if (pool->initial == NULL || pool->sparse == NULL) {
+        console_error("Failed to allocate a component pool");
+        memory_free(pool->initial);
+        memory_free(pool->sparse);
+        return -1;
+    }
+    if (initial != NULL) memcpy(pool->initial, initial, size);
+    for (unsigned int i = 0; i < world->capacity; i++) pool->sparse[i] = WORLD_NONE;
+    return (int) world->componentCount++;
+}
+
+// doubles the entities of the world (the sparse arrays of the pools included), returns false if it cannot
+static bool world_grow(World* world) {
+    const unsigned int capacity = world->capacity * 2;
+    unsigned int* generations = memory_realloc(MEMORY_TAG_ENGINE, world->generations, capacity * sizeof(unsigned int));
+    if (generations != NULL) world->generations = generations;
+    uint32_t* masks = memory_realloc(MEMORY_TAG_ENGINE, world->masks, capacity * sizeof(uint32_t));
+    if (masks != NULL) world->masks = masks;
+    bool* alive = memory_realloc(MEMORY_TAG_ENGINE, world->alive, capacity * sizeof(bool));
+    if (alive != NULL) world->alive = alive;
+    unsigned int* freeIndices = memory_realloc(MEMORY_TAG_ENGINE, world->freeIndices, capacity * sizeof(unsigned int));
+    if (freeIndices != NULL) world->freeIndices = freeIndices;
+    if (generations == NULL || masks == NULL || alive == NULL || freeIndices == NULL) goto fail;
+
+    for (unsigned int i = 0; i < world->componentCount; i++) {
+        ComponentPool* pool = &world->pools[i];
+        unsigned int* sparse = memory_realloc(MEMORY_TAG_ENGINE, pool->sparse, capacity * sizeof(unsigned int));
+        if (sparse == NULL) goto fail;
+        pool->sparse = sparse;
+        for (unsigned int j = world->capacity; j < capacity; j++) pool->sparse[j] = WORLD_NONE;
+    }
+    world->capacity = capacity;
+    return true;
+
+fail:
+    // the arrays that did grow are kept, they are only used up to the old capacity
+    console_error("Failed to grow a world to %u entities", capacity);
+    return false;
+}
+
+// creates an entity without components, returns ENTITY_NULL if the world cannot grow
+Entity world_createEntity(World* world) {
+    unsigned int index;
+    if (world->freeCount > 0) {
+        index = world->freeIndices[--world->freeCount];
+    } else {
+        if (world->indexCount == world->capacity && !world_grow(world)) return ENTITY_NULL;
+        index = world->indexCount++;
+        world->generations[index] = 1;
+    }
+    world->masks[index] = 0;
+    world->alive[index] = true;
+    world->entityCount++;
+    return WORLD_ENTITY(index, world->generations[index]);
+}
+
+// returns true if the handle refers to an entity that has not been destroyed
+bool world_isAlive(World* world, Entity entity) {
+    const unsigned int index = WORLD_INDEX(entity);
+    return index < world->indexCount && world->alive[index] && world->generations[index] == WORLD_GENERATION(entity);
+}
+
+// destroys an entity and its components (destroyed or invalid handles are ignored)
+void world_destroyEntity(World* world, Entity entity) {
+    if (!world_isAlive(world, entity)) return;
+    const unsigned int index = WORLD_INDEX(entity);
+    for (unsigned int i = 0; i < world->componentCount; i++) {
+        if (world->masks[index] & WORLD_MASK(i)) world_removeComponent(world, entity, i);
+    }
+    world->alive[index] = false;
+    // the handles of the destroyed entity never match the index again (0 is skipped, ENTITY_NULL stays invalid)
+    if (++world->generations[index] == 0) world->generations[index] = 1;
+    world->freeIndices[world->freeCount++] = index;
+    world->entityCount--;
+}
+
+// returns the number of alive entities
+unsigned int world_getEntityCount(World* world) {
+    return world->entityCount;
+}
+
+// adds a component to an entity (initialized to the initial value of its type), returns it (the existing one if the entity already has it) or NULL on failure
+void* world_addComponent(World* world, Entity entity, unsigned int component) {
+    if (component >= world->componentCount || !world_isAlive(world, entity)) return NULL;
+    ComponentPool* pool = &world->pools[component];
+    const unsigned int index = WORLD_INDEX(entity);
+    if (pool->sparse[index] != WORLD_NONE) return pool->data + (size_t) pool->sparse[index] * pool->size;
+
+    if (pool->count == pool->capacity) {
+        const unsigned int capacity = pool->capacity > 0 ? pool->capacity * 2 : 64;
+        unsigned int* entities = memory_realloc(MEMORY_TAG_ENGINE, pool->entities, capacity * sizeof(unsigned int));
+        if (entities != NULL) pool->entities = entities;
+        unsigned char* data = memory_realloc(MEMORY_TAG_ENGINE, pool->data, capacity * pool->size);
+        if (data != NULL) pool->data = data;
+        if (entities == NULL || data == NULL) {
+            console_error("Failed to grow a component pool to %u components", capacity);
+            return NULL;
+        }
+        pool->capacity = capacity;
+    }
+
+    const unsigned int position = pool->count++;
+    pool->sparse[index] = position;
+    pool->entities[position] = index;
+    world->masks[index] |= WORLD_MASK(component);
+    void* data = pool->data + (size_t) position * pool->size;
+    memcpy(data, pool->initial, pool->size);
+    return data;
+}
+
+// removes a component from an entity (the last component of the pool takes its place)
+void world_removeComponent(World* world, Entity entity, unsigned int component) {
+    if (component >= world->componentCount || !world_isAlive(world, entity)) return;
+    ComponentPool* pool = &world->pools[component];
+    const unsigned int index = WORLD_INDEX(entity);
+    const unsigned int position = pool->sparse[index];
+    if (position == WORLD_NONE) return;
+
+    const unsigned int last = --pool->count;
+    if (position != last) {
+        memcpy(pool->data + (size_t) position * pool->size, pool->data + (size_t) last * pool->size, pool->size);
+        pool->entities[position] = pool->entities[last];
+        pool->sparse[pool->entities[position]] = position;
+    }
+    pool->sparse[index] = WORLD_NONE;
+    world->masks[index] &= ~WORLD_MASK(component);
+}
+
+// returns the component of an entity, NULL if the entity does not have it (valid until a component of the same type is added or removed)
+void* world_getComponent(World* world, Entity entity, unsigned int component) {
+    if (component >= world->componentCount || !world_isAlive(world, entity)) return NULL;
+    const ComponentPool* pool = &world->pools[component];
+    const unsigned int position = pool->sparse[WORLD_INDEX(entity)];
+    return position != WORLD_NONE ? pool->data + (size_t) position * pool->size : NULL;
+}
+
+// returns true if the entity has all the components of the mask
+bool world_hasComponents(World* world, Entity entity, uint32_t mask) {
+    return world_isAlive(world, entity) && (world->masks[WORLD_INDEX(entity)] & mask) == mask;
+}
+
+// returns the smallest pool of a mask (the one to walk), WORLD_NONE if the mask has a type that is not registered
+static unsigned int world_getDriver(World* world, uint32_t mask) {
+    if (mask == 0 || (world->componentCount < 32 && (mask >> world->componentCount) != 0)) return WORLD_NONE;
+    unsigned int driver = WORLD_NONE;
+    for (unsigned int i = 0; i < world->componentCount; i++) {
+        if ((mask & WORLD_MASK(i)) && (driver == WORLD_NONE || world->pools[i].count < world->pools[driver].count)) driver = i;
+    }
+    return driver;
+}
+
+// points the components of the mask of an entity, returns false if it does not have all of them
+static inline bool world_gather(World* world, uint32_t mask, unsigned int index, void** components) {
+    if ((world->masks[index] & mask) != mask) return false;
+    for (uint32_t bits = mask; bits != 0; bits &= bits - 1) {
+        const unsigned int component = (unsigned int) __builtin_ctz(bits);
+        const ComponentPool* pool = &world->pools[component];
+        components[component] = pool->data + (size_t) pool->sparse[index] * pool->size;
+    }
+    return true;
+}
+
+/*
+Starts walking the entities having all the components of a mask, call world_next() before reading every entity:
+for (WorldIterator it = world_iterate(world, mask); world_next(&it);) { Transform* t = it.components[WORLD_TRANSFORM]; ... }
+The smallest pool of the mask is walked in order, the other components are looked up.
+*/
+WorldIterator world_iterate(World* world, uint32_t mask) {
+    WorldIterator iterator;
+    iterator.world = world;
+    iterator.mask = mask;
+    iterator.driver = world_getDriver(world, mask);
+    iterator.next = 0;
+    iterator.entity = ENTITY_NULL;
+    return iterator;
+}
+
+// moves to the next entity of an iteration, returns false when there are no more
+bool world_next(WorldIterator* iterator) {
+    if (iterator->driver == WORLD_NONE) return false;
+    World* world = iterator->world;
+    const ComponentPool* pool = &world->pools[iterator->driver];
+    while (iterator->next < pool->count) {
+        const unsigned int index = pool->entities[iterator->next++];
+        if (world_gather(world, iterator->mask, index, iterator->components)) {
+            iterator->entity = WORLD_ENTITY(index, world->generations[index]);
+            return true;
+        }
+    }
+    iterator->entity = ENTITY_NULL;
+    return false;
+}
+
+// runs the function on the entities of a range of the driver pool
+static void world_forEachRange(unsigned int start, unsigned int end, void* data) {
+    const WorldParallelTask* task = data;
+    World* world = task->world;
+    const ComponentPool* pool = &world->pools[task->driver];
+    void* components[WORLD_MAX_COMPONENTS];
+    for (unsigned int i = start; i < end; i++) {
+        const unsigned int index = pool->entities[i];
+        if (world_gather(world, task->mask, index, components)) task->function(WORLD_ENTITY(index, world->generations[index]), components, task->data);
+    }
+}
+
+// calls a function on every entity having all the components of a mask
+void world_forEach(World* world, uint32_t mask, WorldFunction function, void* data) {
+    WorldParallelTask task = { .world = world, .mask = mask, .driver = world_getDriver(world, mask), .function = function, .data = data };
+    if (task.driver == WORLD_NONE) return;
+    world_forEachRange(0, world->pools[task.driver].count, &task);
+}
+
+// calls a function on every entity having all the components of a mask, in parallel on the job threads (it returns when all are done)
+void world_parallelForEach(World* world, uint32_t mask, WorldFunction function, void* data) {
+    WorldParallelTask task = { .world = world, .mask = mask, .driver = world_getDriver(world, mask), .function = function, .data = data };
+    if (task.driver == WORLD_NONE) return;
+    job_parallelFor(world->pools[task.driver].count, 0, world_forEachRange, &task, NULL);
+}
+
+// SYSTEMS
+static void world_updateModel(Entity entity, void** components, void* data) {
+    (void) entity;
+    (void) data;
+    Renderable* renderable = components[WORLD_RENDERABLE];
+    renderable->model = transform_getModelMatrix(components[WORLD_TRANSFORM]);
+}
+
+// computes the model matrix of every renderable from its transform
+void world_updateModels(World* world) {
+    PROFILE_SCOPE("world_updateModels");
+    world_parallelForEach(world, WORLD_MASK(WORLD_TRANSFORM) | WORLD_MASK(WORLD_RENDERABLE), world_updateModel, NULL);
+}
+
+// the frustum planes (ax + by + cz + d >= 0 inside) and the renderables counted by world_cull()
+typedef struct {
+    World* world;
+    unsigned int driver;
+    vec4 planes[6];
+    unsigned int tested;
+    unsigned int visible;
+} WorldFrustum;
+
+// returns whether a renderable is (at least partly) inside the frustum
+static inline bool world_isVisible(const WorldFrustum* frustum, const Renderable* renderable) {
+    const Mesh* mesh = renderable->mesh;
+    if (mesh == NULL) return false;
+
+    // the bounding box in world space: its center moved by the model matrix and its half extents by its absolute value
+    const float* m = renderable->model.entries;
+    const float c[3] = { (mesh->boundsMin[0] + mesh->boundsMax[0]) * 0.5f, (mesh->boundsMin[1] + mesh->boundsMax[1]) * 0.5f, (mesh->boundsMin[2] + mesh->boundsMax[2]) * 0.5f };
+    const float e[3] = { (mesh->boundsMax[0] - mesh->boundsMin[0]) * 0.5f, (mesh->boundsMax[1] - mesh->boundsMin[1]) * 0.5f, (mesh->boundsMax[2] - mesh->boundsMin[2]) * 0.5f };
+    float center[3], extent[3];
+    for (int row = 0; row < 3; row++) {
+        center[row] = m[row * 4] * c[0] + m[row * 4 + 1] * c[1] + m[row * 4 + 2] * c[2] + m[row * 4 + 3];
+        extent[row] = fabsf(m[row * 4]) * e[0] + fabsf(m[row * 4 + 1]) * e[1] + fabsf(m[row * 4 + 2]) * e[2];
+    }
+
+    for (int i = 0; i < 6; i++) {
+        const vec4 p = frustum->planes[i];
+        const float distance = p.x * center[0] + p.y * center[1] + p.z * center[2] + p.w;
+        const float radius = fabsf(p.x) * extent[0] + fabsf(p.y) * extent[1] + fabsf(p.z) * extent[2];
+        if (distance < -radius) return false;
+    }
+    return true;
+}
+
+// culls the renderables of a range of the driver pool (counting them locally, the totals are shared once per range)
+static void world_cullRange(unsigned int start, unsigned int end, void* data) {
+    WorldFrustum* frustum = data;
+    World* world = frustum->world;
+    const uint32_t mask = WORLD_MASK(WORLD_RENDERABLE);
+    const ComponentPool* pool = &world->pools[frustum->driver];
+    void* components[WORLD_MAX_COMPONENTS];
+    unsigned int tested = 0, visible = 0;
+    for (unsigned int i = start; i < end; i++) {
+        if (!world_gather(world, mask, pool->entities[i], components)) continue;
+        Renderable* renderable = components[WORLD_RENDERABLE];
+        renderable->visible = world_isVisible(frustum, renderable);
+        tested++;
+        visible += renderable->visible;
+    }
+    __atomic_add_fetch(&frustum->tested, tested, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&frustum->visible, visible, __ATOMIC_RELAXED);
+}
+
+/*
+Culls the renderables against the frustum of a camera: the bounding box of every mesh, moved by the model matrix,
+is tested against the planes of the frustum. The culled ones are counted in renderStats.culledObjects.
+Parameters:
+    - world (World*): the world
+    - viewProjection (mat4): the projection matrix multiplied by the view matrix
+Returns:
+    The number of visible renderables
+*/
+unsigned int world_cull(World* world, mat4 viewProjection) {
+    PROFILE_SCOPE("world_cull");
+
+    // the planes are the sums and differences of the last row with the other ones (clip = viewProjection * position)
+    const uint32_t mask = WORLD_MASK(WORLD_RENDERABLE);
+    const float* m = viewProjection.entries;
+    WorldFrustum frustum = { .world = world, .driver = world_getDriver(world, mask), .tested = 0, .visible = 0 };
+    for (int i = 0; i < 3; i++) {
+        frustum.planes[i * 2] = vec4_new(m[12] + m[i * 4], m[13] + m[i * 4 + 1], m[14] + m[i * 4 + 2], m[15] + m[i * 4 + 3]);
+        frustum.planes[i * 2 + 1] = vec4_new(m[12] - m[i * 4], m[13] - m[i * 4 + 1], m[14] - m[i * 4 + 2], m[15] - m[i * 4 + 3]);
+    }
+
+    job_parallelFor(world->pools[frustum.driver].count, 0, world_cullRange, &frustum, NULL);
+    renderStats.culledObjects += frustum.tested - frustum.visible;
+    return frustum.visible;
+}
+
+// draws the visible renderables on the render thread, like renderer_renderObject() does
+void world_render(World* world) {
+    PROFILE_SCOPE("world_render");
+
+    const bool hasView = activeCamera != NULL;
+    const mat4 view = hasView ? camera_getViewMatrix(activeCamera) : mat4_identity();
+    const unsigned int defaultShader = activeShader;
+    unsigned int shader = 0;
+    bool first = true;
+    for (WorldIterator it = world_iterate(world, WORLD_MASK(WORLD_RENDERABLE)); world_next(&it);) {
+        const Renderable* renderable = it.components[WORLD_RENDERABLE];
+        if (!renderable->visible || renderable->mesh == NULL) continue;
+
+        // bind the shader and upload the view matrix only when the shader changes
+        const unsigned int renderableShader = renderable->shader > 0 ? renderable->shader : defaultShader;
+        if (first || renderableShader != shader) {
+            first = false;
+            shader = renderableShader;
+            if (shader != (unsigned int) activeShader) renderer_useShader(shader);
+            if (hasView && shader != 0 && shader_hasUniform(shader, "view")) shader_setMatrix4(shader, "view", view);
+        }
+        shader_setMatrix4(shader, "model", renderable->model);
+        renderer_renderMesh(renderable->mesh);
+    }
+}
+
+static void world_recordRenderable(Entity entity, void** components, void* data) {
+    (void) entity;
+    const Renderable* renderable = components[WORLD_RENDERABLE];
+    if (!renderable->visible || renderable->mesh == NULL) return;
+    // only the threads of the pool run it, or the caller alone when there are no workers (see world_record())
+    const int thread = job_getThreadIndex();
+    CommandBuffer* buffer = ((CommandBuffer**) data)[thread > 0 ? thread : 0];
+    commandbuffer_bindShader(buffer, renderable->shader);
+    commandbuffer_bindMesh(buffer, renderable->mesh);
+    commandbuffer_setMatrix4(buffer, "model", renderable->model);
+    commandbuffer_draw(buffer);
+}
+
+// records the draws of the visible renderables into the command buffer of every job thread (buffers[job_getThreadIndex()], see commandbuffer.h)
+// it MUST be called by the main thread or a job thread while the workers run: a thread outside of the pool has no buffer of its own (it logs an error and records nothing)
+void world_record(World* world, CommandBuffer** buffers) {
+    PROFILE_SCOPE("world_record");
+    // the caller records too: outside of the pool it would share the buffer of the main thread, which may be recording while it waits
+    if (job_getThreadIndex() < 0 && job_getThreadCount() > 1) {
+        console_error("world_record() must be called by the main thread or a job thread");
+        return;
+    }
+    world_parallelForEach(world, WORLD_MASK(WORLD_RENDERABLE), world_recordRenderable, buffers);
+}
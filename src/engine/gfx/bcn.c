@@ -0,0 +1,528 @@
+/*
+BCN:
+Block compression (BC1, BC3 and BC7) encoder and decoder.
+Every block holds 4x4 RGBA8 pixels: BC1 compresses them to 8 bytes, BC3 and BC7 to 16 bytes.
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "engine/gfx/bcn.h"
+
+// returns the number of bytes a 4x4 block takes in the given format
+unsigned int bcn_getBlockSize(BcnFormat format) {
+    return format == BCN_FORMAT_BC1 ? 8 : 16;
+}
+
+// returns the number of bytes needed to store a width x height image in the given format
+size_t bcn_getImageSize(BcnFormat format, unsigned int width, unsigned int height) {
+    const size_t blocksX = (width + 3) / 4;
+    const size_t blocksY = (height + 3) / 4;
+    return blocksX * blocksY * bcn_getBlockSize(format);
+}
+
+// gathers the 4x4 block at the given block coordinates, repeating the edge pixels when the block goes past the image bounds
+static void bcn_gatherBlock(const unsigned char* pixels, unsigned int width, unsigned int height, unsigned int bx, unsigned int by, unsigned char block[64]) {
+    for (unsigned int y = 0; y < 4; y++) {
+        unsigned int py = by * 4 + y;
+        if (py >= height) py = height - 1;
+        for (unsigned int x = 0; x < 4; x++) {
+            unsigned int px = bx * 4 + x;
+            if (px >= width) px = width - 1;
+            memcpy(block + (x + y * 4) * 4, pixels + ((size_t) px + (size_t) py * width) * 4, 4);
+        }
+    }
+}
+
+// scatters a decoded 4x4 block back into the image, skipping the pixels past the image bounds
+static void bcn_scatterBlock(const unsigned char block[64], unsigned int width, unsigned int height, unsigned int bx, unsigned int by, unsigned char* pixels) {
+    for (unsigned int y = 0; y < 4; y++) {
+        const unsigned int py = by * 4 + y;
+        if (py >= height) break;
+        for (unsigned int x = 0; x < 4; x++) {
+            const unsigned int px = bx * 4 + x;
+            if (px >= width) break;
+            memcpy(pixels + ((size_t) px + (size_t) py * width) * 4, block + (x + y * 4) * 4, 4);
+        }
+    }
+}
+
+/*
+Compresses a whole RGBA8 image.
+Parameters:
+    - format (BcnFormat): the format to compress to
+    - pixels (unsigned char*): the RGBA8 pixels (width * height * 4 bytes, rows are tightly packed)
+    - width (unsigned int): the image width (it does not need to be a multiple of 4, edge pixels are repeated to fill the blocks)
+    - height (unsigned int): the image height (it does not need to be a multiple of 4, edge pixels are repeated to fill the blocks)
+    - output (unsigned char*): where to write the blocks, it must be at least bcn_getImageSize() bytes long
+*/
+void bcn_compressImage(BcnFormat format, const unsigned char* pixels, unsigned int width, unsigned int height, unsigned char* output) {
+    const unsigned int blockSize = bcn_getBlockSize(format);
+    const unsigned int blocksX = (width + 3) / 4;
+    const unsigned int blocksY = (height + 3) / 4;
+
+    unsigned char block[64];
+    for (unsigned int by = 0; by < blocksY; by++) {
+        for (unsigned int bx = 0; bx < blocksX; bx++) {
+            bcn_gatherBlock(pixels, width, height, bx, by, block);
+            unsigned char* destination = output + ((size_t) bx + (size_t) by * blocksX) * blockSize;
+            switch (format) {
+                case BCN_FORMAT_BC1: bcn_compressBC1(block, destination); break;
+                case BCN_FORMAT_BC3: bcn_compressBC3(block, destination); break;
+                case BCN_FORMAT_BC7: bcn_compressBC7(block, destination); break;
+            }
+        }
+    }
+}
+
+/*
+Decompresses a whole image to RGBA8.
+Parameters:
+    - format (BcnFormat): the format of the blocks
+    - blocks (unsigned char*): the compressed blocks (bcn_getImageSize() bytes)
+    - width (unsigned int): the image width
+    - height (unsigned int): the image height
+    - output (unsigned char*): where to write the RGBA8 pixels, it must be at least width * height * 4 bytes long
+Returns:
+    true on success, false if a block could not be decoded (BC7 blocks that are not mode 6 are not supported)
+*/
+bool bcn_decompressImage(BcnFormat format, const unsigned char* blocks, unsigned int width, unsigned int height, unsigned char* output) {
+    const unsigned int blockSize = bcn_getBlockSize(format);
+    const unsigned int blocksX = (width + 3) / 4;
+    const unsigned int blocksY = (height + 3) / 4;
+
+    unsigned char block[64];
+    for (unsigned int by = 0; by < blocksY; by++) {
+        for (unsigned int bx = 0; bx < blocksX; bx++) {
+            const unsigned char* source = blocks + ((size_t) bx + (size_t) by * blocksX) * blockSize;
+            switch (format) {
+                case BCN_FORMAT_BC1: bcn_decompressBC1(source, block); break;
+                case BCN_FORMAT_BC3: bcn_decompressBC3(source, block); break;
+                case BCN_FORMAT_BC7: if (!bcn_decompressBC7(source, block)) return false; break;
+            }
+            bcn_scatterBlock(block, width, height, bx, by, output);
+        }
+    }
+    return true;
+}
+
+// COLOR ENDPOINTS
+// packs an 8 bit per channel color to a 5:6:5 color
+static unsigned short bcn_pack565(const float color[3]) {
+    int r = (int) (color[0] * 31.0f / 255.0f + 0.5f);
+    int g = (int) (color[1] * 63.0f / 255.0f + 0.5f);
+    int b = (int) (color[2] * 31.0f / 255.0f + 0.5f);
+    r = r < 0 ? 0 : (r > 31 ? 31 : r);
+    g = g < 0 ? 0 : (g > 63 ? 63 : g);
+    b = b < 0 ? 0 : (b > 31 ? 31 : b);
+    return (unsigned short) ((r << 11) | (g << 5) | b);
+}
+
+// expands a 5:6:5 color to 8 bits per channel (replicating the high bits in the low ones)
+static void bcn_unpack565(unsigned short packed, int color[3]) {
+    const int r = (packed >> 11) & 31;
+    const int g = (packed >> 5) & 63;
+    const int b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+// finds the two colors that best span the given pixels along their principal axis
+// only the pixels with mask[i] set are considered
+static void bcn_findColorEndpoints(const unsigned char pixels[64], const bool mask[16], float minColor[3], float maxColor[3]) {
+    // average color
+    float mean[3] = { 0, 0, 0 };
+    int count = 0;
+    for (int i = 0; i < 16; i++) {
+        if (!mask[i]) continue;
+        for (int c = 0; c < 3; c++) mean[c] += pixels[i * 4 + c];
+        count++;
+    }
+    if (count == 0) {
+        for (int c = 0; c < 3; c++) minColor[c] = maxColor[c] = 0;
+        return;
+    }
+    for (int c = 0; c < 3; c++) mean[c] /= count;
+
+    // covariance matrix (symmetric, so only 6 entries are needed)
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        if (!mask[i]) continue;
+        const float r = pixels[i * 4 + 0] - mean[0];
+        const float g = pixels[i * 4 + 1] - mean[1];
+        const float b = pixels[i * 4 + 2] - mean[2];
+        cov[0] += r * r; cov[1] += r * g; cov[2] += r * b;
+        cov[3] += g * g; cov[4] += g * b; cov[5] += b * b;
+    }
+
+    // principal axis via power iteration
+    float axis[3] = { 1, 1, 1 };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        const float x = axis[0] * cov[0] + axis[1] * cov[1] + axis[2] * cov[2];
+        const float y = axis[0] * cov[1] + axis[1] * cov[3] + axis[2] * cov[4];
+        const float z = axis[0] * cov[2] + axis[1] * cov[4] + axis[2] * cov[5];
+        const float length = fmaxf(fabsf(x), fmaxf(fabsf(y), fabsf(z)));
+        if (length < 1e-6f) break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    // the extremes of the projection on the axis are the endpoints
+    float minDot = INFINITY, maxDot = -INFINITY;
+    int minIndex = 0, maxIndex = 0;
+    for (int i = 0; i < 16; i++) {
+        if (!mask[i]) continue;
+        const float dot = pixels[i * 4 + 0] * axis[0] + pixels[i * 4 + 1] * axis[1] + pixels[i * 4 + 2] * axis[2];
+        if (dot < minDot) { minDot = dot; minIndex = i; }
+        if (dot > maxDot) { maxDot = dot; maxIndex = i; }
+    }
+
+    // inset the endpoints a bit, as the extremes are rarely hit exactly once quantized
+    for (int c = 0; c < 3; c++) {
+        const float low = pixels[minIndex * 4 + c];
+        const float high = pixels[maxIndex * 4 + c];
+        const float inset = (high - low) / 16.0f;
+        minColor[c] = low + inset;
+        maxColor[c] = high - inset;
+    }
+}
+
+// writes the BC1 color part of a block (8 bytes)
+// when allowTransparency is true, pixels with alpha < 128 use the transparent palette entry (3 colors mode)
+static void bcn_compressColorBlock(const unsigned char pixels[64], unsigned char block[8], bool allowTransparency) {
+    bool mask[16];
+    bool hasTransparency = false;
+    for (int i = 0; i < 16; i++) {
+        mask[i] = !allowTransparency || pixels[i * 4 + 3] >= 128;
+        if (!mask[i]) hasTransparency = true;
+    }
+
+    float minColor[3], maxColor[3];
+    bcn_findColorEndpoints(pixels, mask, minColor, maxColor);
+    unsigned short c0 = bcn_pack565(maxColor);
+    unsigned short c1 = bcn_pack565(minColor);
+
+    // the endpoints order selects the mode: c0 > c1 is 4 colors mode, c0 <= c1 is 3 colors + transparent mode
+    if ((hasTransparency && c0 > c1) || (!hasTransparency && c0 < c1)) {
+        const unsigned short tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+    }
+
+    // build the palette
+    int palette[4][3];
+    bcn_unpack565(c0, palette[0]);
+    bcn_unpack565(c1, palette[1]);
+    const bool fourColors = c0 > c1;
+    for (int c = 0; c < 3; c++) {
+        if (fourColors) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        } else {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+
+    // pick the closest palette entry for every pixel
+    unsigned int indices = 0;
+    const int entries = fourColors ? 4 : 3;
+    for (int i = 0; i < 16; i++) {
+        unsigned int best = 0;
+        if (!mask[i]) {
+            best = 3;
+        } else {
+            int bestError = 0x7fffffff;
+            for (int p = 0; p < entries; p++) {
+                const int dr = pixels[i * 4 + 0] - palette[p][0];
+                const int dg = pixels[i * 4 + 1] - palette[p][1];
+                const int db = pixels[i * 4 + 2] - palette[p][2];
+                const int error = dr * dr + dg * dg + db * db;
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+        }
+        indices |= best << (i * 2);
+    }
+
+    block[0] = c0 & 0xff;
+    block[1] = c0 >> 8;
+    block[2] = c1 & 0xff;
+    block[3] = c1 >> 8;
+    block[4] = indices & 0xff;
+    block[5] = (indices >> 8) & 0xff;
+    block[6] = (indices >> 16) & 0xff;
+    block[7] = (indices >> 24) & 0xff;
+}
+
+// decodes the BC1 color part of a block (8 bytes)
+// when forceFourColors is true the endpoints order is ignored (BC3 color blocks are always in 4 colors mode)
+static void bcn_decompressColorBlock(const unsigned char block[8], unsigned char pixels[64], bool forceFourColors) {
+    const unsigned short c0 = block[0] | (block[1] << 8);
+    const unsigned short c1 = block[2] | (block[3] << 8);
+    const unsigned int indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((unsigned int) block[7] << 24);
+
+    int palette[4][4];
+    bcn_unpack565(c0, palette[0]);
+    bcn_unpack565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    if (forceFourColors || c0 > c1) {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        palette[2][3] = palette[3][3] = 255;
+    } else {
+        for (int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        const int index = (indices >> (i * 2)) & 3;
+        for (int c = 0; c < 4; c++) pixels[i * 4 + c] = (unsigned char) palette[index][c];
+    }
+}
+
+// BC1
+// compresses 16 RGBA8 pixels (4x4, row by row) to an 8 bytes BC1 block
+void bcn_compressBC1(const unsigned char pixels[64], unsigned char block[8]) {
+    bcn_compressColorBlock(pixels, block, true);
+}
+
+// decompresses an 8 bytes BC1 block to 16 RGBA8 pixels (4x4, row by row)
+void bcn_decompressBC1(const unsigned char block[8], unsigned char pixels[64]) {
+    bcn_decompressColorBlock(block, pixels, false);
+}
+
+// BC3
+// compresses 16 RGBA8 pixels (4x4, row by row) to a 16 bytes BC3 block
+void bcn_compressBC3(const unsigned char pixels[64], unsigned char block[16]) {
+    // alpha endpoints (a0 > a1 selects the 8 values mode)
+    int a0 = 0, a1 = 255;
+    for (int i = 0; i < 16; i++) {
+        const int alpha = pixels[i * 4 + 3];
+        if (alpha > a0) a0 = alpha;
+        if (alpha < a1) a1 = alpha;
+    }
+
+    int palette[8];
+    palette[0] = a0;
+    palette[1] = a1;
+    for (int i = 2; i < 8; i++) palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+
+    // 3 bits per pixel, 48 bits in total
+    unsigned long long indices = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0;
+        int bestError = 256;
+        if (a0 != a1) {
+            for (int p = 0; p < 8; p++) {
+                const int error = abs(pixels[i * 4 + 3] - palette[p]);
+                if (error < bestError) {
+                    bestError = error;
+                    best = p;
+                }
+            }
+        }
+        indices |= (unsigned long long) best << (i * 3);
+    }
+
+    block[0] = (unsigned char) a0;
+    block[1] = (unsigned char) a1;
+    for (int i = 0; i < 6; i++) block[2 + i] = (indices >> (i * 8)) & 0xff;
+
+    // the color part is always decoded in 4 colors mode
+    bcn_compressColorBlock(pixels, block + 8, false);
+}
+
+// decompresses a 16 bytes BC3 block to 16 RGBA8 pixels (4x4, row by row)
+void bcn_decompressBC3(const unsigned char block[16], unsigned char pixels[64]) {
+    bcn_decompressColorBlock(block + 8, pixels, true);
+
+    const int a0 = block[0];
+    const int a1 = block[1];
+    int palette[8];
+    palette[0] = a0;
+    palette[1] = a1;
+    if (a0 > a1) {
+        for (int i = 2; i < 8; i++) palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    } else {
+        for (int i = 2; i < 6; i++) palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    unsigned long long indices = 0;
+    for (int i = 0; i < 6; i++) indices |= (unsigned long long) block[2 + i] << (i * 8);
+    for (int i = 0; i < 16; i++) {
+        pixels[i * 4 + 3] = (unsigned char) palette[(indices >> (i * 3)) & 7];
+    }
+}
+
+// BC7
+// only mode 6 is used: 1 subset, RGBA endpoints with 7 bits per channel plus a shared bit each, 4 bits indices
+static const int bcn_bc7Weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// writes count bits of value to the block starting from the given bit position (least significant bit first)
+static void bcn_writeBits(unsigned char block[16], unsigned int* position, unsigned int value, unsigned int count) {
+    for (unsigned int i = 0; i < count; i++) {
+        const unsigned int bit = *position + i;
+        if ((value >> i) & 1) block[bit >> 3] |= 1 << (bit & 7);
+    }
+    *position += count;
+}
+
+// reads count bits from the block starting from the given bit position (least significant bit first)
+static unsigned int bcn_readBits(const unsigned char block[16], unsigned int* position, unsigned int count) {
+    unsigned int value = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        const unsigned int bit = *position + i;
+        value |= ((block[bit >> 3] >> (bit & 7)) & 1) << i;
+    }
+    *position += count;
+    return value;
+}
+
+// quantizes an 8 bit value to 7 bits given the shared (p) bit that will be appended when decoding
+static int bcn_quantize7(float value, int pBit) {
+    int q = (int) floorf((value - pBit) / 2.0f + 0.5f);
+    return q < 0 ? 0 : (q > 127 ? 127 : q);
+}
+
+// evaluates the mode 6 indices for the given endpoints and returns the total squared error
+static int bcn_evaluateBC7(const unsigned char pixels[64], const int e0[4], const int e1[4], unsigned char indices[16]) {
+    int palette[16][4];
+    for (int i = 0; i < 16; i++) {
+        for (int c = 0; c < 4; c++) {
+            palette[i][c] = ((64 - bcn_bc7Weights4[i]) * e0[c] + bcn_bc7Weights4[i] * e1[c] + 32) >> 6;
+        }
+    }
+
+    int totalError = 0;
+    for (int i = 0; i < 16; i++) {
+        int best = 0;
+        int bestError = 0x7fffffff;
+        for (int p = 0; p < 16; p++) {
+            int error = 0;
+            for (int c = 0; c < 4; c++) {
+                const int d = pixels[i * 4 + c] - palette[p][c];
+                error += d * d;
+            }
+            if (error < bestError) {
+                bestError = error;
+                best = p;
+            }
+        }
+        indices[i] = (unsigned char) best;
+        totalError += bestError;
+    }
+    return totalError;
+}
+
+// compresses 16 RGBA8 pixels (4x4, row by row) to a 16 bytes BC7 (mode 6) block
+void bcn_compressBC7(const unsigned char pixels[64], unsigned char block[16]) {
+    // endpoints along the RGB principal axis, with the alpha range on top
+    bool mask[16];
+    for (int i = 0; i < 16; i++) mask[i] = true;
+    float low[4], high[4];
+    bcn_findColorEndpoints(pixels, mask, low, high);
+    int minAlpha = 255, maxAlpha = 0;
+    for (int i = 0; i < 16; i++) {
+        if (pixels[i * 4 + 3] < minAlpha) minAlpha = pixels[i * 4 + 3];
+        if (pixels[i * 4 + 3] > maxAlpha) maxAlpha = pixels[i * 4 + 3];
+    }
+    low[3] = minAlpha;
+    high[3] = maxAlpha;
+
+    // try all the shared bit combinations and keep the best one
+    int bestError = 0x7fffffff;
+    int bestQ0[4] = { 0 }, bestQ1[4] = { 0 };
+    int bestP0 = 0, bestP1 = 0;
+    unsigned char bestIndices[16] = { 0 };
+    for (int p0 = 0; p0 < 2; p0++) {
+        for (int p1 = 0; p1 < 2; p1++) {
+            int q0[4], q1[4], e0[4], e1[4];
+            for (int c = 0; c < 4; c++) {
+                q0[c] = bcn_quantize7(low[c], p0);
+                q1[c] = bcn_quantize7(high[c], p1);
+                e0[c] = (q0[c] << 1) | p0;
+                e1[c] = (q1[c] << 1) | p1;
+            }
+            unsigned char indices[16];
+            const int error = bcn_evaluateBC7(pixels, e0, e1, indices);
+            if (error < bestError) {
+                bestError = error;
+                memcpy(bestQ0, q0, sizeof(q0));
+                memcpy(bestQ1, q1, sizeof(q1));
+                memcpy(bestIndices, indices, sizeof(indices));
+                bestP0 = p0;
+                bestP1 = p1;
+            }
+        }
+    }
+
+    // the first pixel index (anchor) is stored with 3 bits, so its most significant bit must be 0
+    if (bestIndices[0] & 8) {
+        for (int c = 0; c < 4; c++) {
+            const int tmp = bestQ0[c];
+            bestQ0[c] = bestQ1[c];
+            bestQ1[c] = tmp;
+        }
+        const int tmp = bestP0;
+        bestP0 = bestP1;
+        bestP1 = tmp;
+        for (int i = 0; i < 16; i++) bestIndices[i] = 15 - bestIndices[i];
+    }
+
+    memset(block, 0, 16);
+    unsigned int position = 0;
+    bcn_writeBits(block, &position, 1 << 6, 7); // mode 6
+    for (int c = 0; c < 4; c++) {
+        bcn_writeBits(block, &position, bestQ0[c], 7);
+        bcn_writeBits(block, &position, bestQ1[c], 7);
+    }
+    bcn_writeBits(block, &position, bestP0, 1);
+    bcn_writeBits(block, &position, bestP1, 1);
+    bcn_writeBits(block, &position, bestIndices[0], 3);
+    for (int i = 1; i < 16; i++) bcn_writeBits(block, &position, bestIndices[i], 4);
+}
+
+// decompresses a 16 bytes BC7 block to 16 RGBA8 pixels (4x4, row by row), returns false if the block is not a mode 6 block
+bool bcn_decompressBC7(const unsigned char block[16], unsigned char pixels[64]) {
+    // the mode is given by the position of the first set bit
+    if ((block[0] & 0x7f) != (1 << 6)) return false;
+
+    unsigned int position = 7;
+    int q0[4], q1[4];
+    for (int c = 0; c < 4; c++) {
+        q0[c] = bcn_readBits(block, &position, 7);
+        q1[c] = bcn_readBits(block, &position, 7);
+    }
+    const int p0 = bcn_readBits(block, &position, 1);
+    const int p1 = bcn_readBits(block, &position, 1);
+
+    int e0[4], e1[4];
+    for (int c = 0; c < 4; c++) {
+        e0[c] = (q0[c] << 1) | p0;
+        e1[c] = (q1[c] << 1) | p1;
+    }
+
+    for (int i = 0; i < 16; i++) {
+        const int index = bcn_readBits(block, &position, i == 0 ? 3 : 4);
+        const int weight = bcn_bc7Weights4[index];
+        for (int c = 0; c < 4; c++) {
+            pixels[i * 4 + c] = (unsigned char) (((64 - weight) * e0[c] + weight * e1[c] + 32) >> 6);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,290 @@
+/*
+COMMANDBUFFER:
+Render command buffers.
+A uniform is packed as a CommandUniform header followed by its value (padded to keep the next header aligned), every
+draw knows the range of the uniforms recorded since the previous draw of its buffer. Submitting gathers the draws of
+all the buffers in a single array, sorts it and replays it.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine/gfx/renderer.h"
+#include "engine/gfx/shader.h"
+#include "engine/math/camera.h"
+#include "engine/math/transform.h"
+#include "engine/utils/console.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/gfx/commandbuffer.h"
+
+#define COMMANDBUFFER_DEFAULT_CAPACITY 4096
+#define COMMANDBUFFER_ALIGNMENT sizeof(void*)
+
+typedef enum {
+    COMMAND_UNIFORM_INTEGER,
+    COMMAND_UNIFORM_FLOAT,
+    COMMAND_UNIFORM_FLOAT2,
+    COMMAND_UNIFORM_FLOAT3,
+    COMMAND_UNIFORM_FLOAT4,
+    COMMAND_UNIFORM_MATRIX3,
+    COMMAND_UNIFORM_MATRIX4
+} CommandUniformType;
+
+// the header of a recorded uniform (its value follows it)
+typedef struct {
+    const char* name;
+    CommandUniformType type;
+    unsigned int size; // bytes of the header, the value and the padding
+} CommandUniform;
+
+// a draw gathered by commandbuffer_submit()
+typedef struct {
+    uint64_t key;
+    uint64_t order; // buffer index and draw index, keeping the recording order among the draws with the same key
+    const CommandBuffer* buffer;
+    const CommandDraw* draw;
+} CommandSortItem;
+
+/*
+Creates an empty command buffer.
+You MUST call commandbuffer_destroy(CommandBuffer*) once the buffer is not used anymore
+Parameters:
+    - capacity (size_t): the bytes of uniform data reserved up front (the buffer grows when needed, 0 picks a default)
+Returns:
+    The pointer to the buffer, NULL if it could not be allocated
+*/
+CommandBuffer* commandbuffer_create(size_t capacity) {
+    CommandBuffer* buffer = memory_calloc(MEMORY_TAG_ENGINE, 1, sizeof(CommandBuffer));
+    if (buffer == NULL) {
+        console_error("Failed to allocate a command buffer");
+        return NULL;
+    }
+    buffer->capacity = capacity > 0 ? capacity : COMMANDBUFFER_DEFAULT_CAPACITY;
+    buffer->data = memory_alloc(MEMORY_TAG_ENGINE, buffer->capacity);
+    // about one draw every model matrix and name
+    buffer->drawCapacity = (unsigned int) (buffer->capacity / (sizeof(CommandUniform) + sizeof(mat4))) + 1;
+    buffer->draws = memory_alloc(MEMORY_TAG_ENGINE, buffer->drawCapacity * sizeof(CommandDraw));
+    if (buffer->data == NULL || buffer->draws == NULL) {
+        console_error("Failed to allocate a command buffer of %llu bytes", (unsigned long long) buffer->capacity);
+        commandbuffer_destroy(buffer);
+        return NULL;
+    }
+    return buffer;
+}
+
+// destroys the given command buffer
+void commandbuffer_destroy(CommandBuffer* buffer) {
+    if (buffer == NULL) return;
+    memory_free(buffer->data);
+    memory_free(buffer->draws);
+    memory_free(buffer);
+}
+
+// empties the given command buffer (keeping its memory) and resets its recording state, call it before recording a new frame
+void commandbuffer_reset(CommandBuffer* buffer) {
+    buffer->size = 0;
+    buffer->drawCount = 0;
+    buffer->shader = 0;
+    buffer->mesh = NULL;
+    buffer->uniforms = 0;
+}
+
+// records the shader used by the following draws (0 means the shader active when the buffer is submitted)
+void commandbuffer_bindShader(CommandBuffer* buffer, unsigned int shader) {
+    buffer->shader = shader;
+}
+
+// records the mesh drawn by the following draws (it MUST stay alive until the buffer is submitted)
+void commandbuffer_bindMesh(CommandBuffer* buffer, Mesh* mesh) {
+    buffer->mesh = mesh;
+}
+
+// appends a uniform to the data of the buffer (dropped with an error if the buffer cannot grow)
+static void commandbuffer_pushUniform(CommandBuffer* buffer, const char* name, CommandUniformType type, const void* value, size_t valueSize) {
+    const size_t size = (sizeof(CommandUniform) + valueSize + COMMANDBUFFER_ALIGNMENT - 1) & ~(COMMANDBUFFER_ALIGNMENT - 1);
+    if (buffer->size + size > buffer->capacity) {
+        size_t capacity = buffer->capacity * 2;
+        while (capacity < buffer->size + size) capacity *= 2;
+        unsigned char* data = memory_realloc(MEMORY_TAG_ENGINE, buffer->data, capacity);
+        if (data == NULL) {
+            console_error("Failed to grow a command buffer to %llu bytes, the uniform \"%s\" is dropped", (unsigned long long) capacity, name);
+            return;
+        }
+        buffer->data = data;
+        buffer->capacity = capacity;
+    }
+
+    CommandUniform* uniform = (CommandUniform*) (buffer->data + buffer->size);
+    uniform->name = name;
+    uniform->type = type;
+    uniform->size = (unsigned int) size;
+    memcpy(uniform + 1, value, valueSize);
+    buffer->size += size;
+}
+
+// records an integer uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setInteger(CommandBuffer* buffer, const char* name, int value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_INTEGER, &value, sizeof(value));
+}
+
+// records a float uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat(CommandBuffer* buffer, const char* name, float value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_FLOAT, &value, sizeof(value));
+}
+
+// records a float vector 2 uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat2(CommandBuffer* buffer, const char* name, vec2 value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_FLOAT2, &value, sizeof(value));
+}
+
+// records a float vector 3 uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat3(CommandBuffer* buffer, const char* name, vec3 value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_FLOAT3, &value, sizeof(value));
+}
+
+// records a float vector 4 uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setFloat4(CommandBuffer* buffer, const char* name, vec4 value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_FLOAT4, &value, sizeof(value));
+}
+
+// records a 3x3 float matrix uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setMatrix3(CommandBuffer* buffer, const char* name, mat3 value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_MATRIX3, &value, sizeof(value));
+}
+
+// records a 4x4 float matrix uniform of the next draw (the name MUST stay alive until the buffer is submitted, e.g. a literal)
+void commandbuffer_setMatrix4(CommandBuffer* buffer, const char* name, mat4 value) {
+    commandbuffer_pushUniform(buffer, name, COMMAND_UNIFORM_MATRIX4, &value, sizeof(value));
+}
+
+// records a draw of the bound mesh with the bound shader and the uniforms recorded since the previous draw
+void commandbuffer_draw(CommandBuffer* buffer) {
+    if (buffer->mesh == NULL) {
+        CONSOLE_WARNING_RATE(1, "Recorded a draw without a mesh, bind one with commandbuffer_bindMesh() first");
+        return;
+    }
+    if (buffer->drawCount == buffer->drawCapacity) {
+        const unsigned int capacity = buffer->drawCapacity * 2;
+        CommandDraw* draws = memory_realloc(MEMORY_TAG_ENGINE, buffer->draws, capacity * sizeof(CommandDraw));
+        if (draws == NULL) {
+            console_error("Failed to grow a command buffer to %u draws, the draw is dropped", capacity);
+            return;
+        }
+        buffer->draws = draws;
+        buffer->drawCapacity = capacity;
+    }
+
+    // the most expensive state changes in the most significant bits (the ids are truncated, which only makes the sorting coarser)
+    const Mesh* mesh = buffer->mesh;
+    CommandDraw* draw = &buffer->draws[buffer->drawCount++];
+    draw->key = (uint64_t) (buffer->shader & 0xFFFF) << 48 | (uint64_t) (mesh->texture & 0xFFFF) << 32 | (uint64_t) (mesh->vao & 0xFFFF) << 16;
+    draw->shader = buffer->shader;
+    draw->mesh = buffer->mesh;
+    draw->uniforms = buffer->uniforms;
+    draw->uniformsEnd = buffer->size;
+    buffer->uniforms = buffer->size;
+}
+
+// records the draw of an object like renderer_renderObject() does (its shader if it has one, its model matrix computed right away, its mesh), the bound shader and mesh are left as they were
+void commandbuffer_drawObject(CommandBuffer* buffer, Object* object) {
+    const unsigned int shader = buffer->shader;
+    Mesh* mesh = buffer->mesh;
+    if (object->shader > 0) buffer->shader = object->shader;
+    commandbuffer_setMatrix4(buffer, "model", transform_getModelMatrix(&(object->transform)));
+    buffer->mesh = &(object->mesh);
+    commandbuffer_draw(buffer);
+    buffer->shader = shader;
+    buffer->mesh = mesh;
+}
+
+static int commandbuffer_compareItems(const void* a, const void* b) {
+    const CommandSortItem* x = a;
+    const CommandSortItem* y = b;
+    if (x->key != y->key) return x->key < y->key ? -1 : 1;
+    return (x->order > y->order) - (x->order < y->order);
+}
+
+// uploads the uniforms of a draw to the shader in use
+static void commandbuffer_uploadUniforms(const CommandBuffer* buffer, const CommandDraw* draw, unsigned int shader) {
+    for (size_t offset = draw->uniforms; offset < draw->uniformsEnd;) {
+        const CommandUniform* uniform = (const CommandUniform*) (buffer->data + offset);
+        const void* value = uniform + 1;
+        switch (uniform->type) {
+            case COMMAND_UNIFORM_INTEGER: shader_setInteger(shader, uniform->name, *(const int*) value); break;
+            case COMMAND_UNIFORM_FLOAT: shader_setFloat(shader, uniform->name, *(const float*) value); break;
+            case COMMAND_UNIFORM_FLOAT2: shader_setFloat2(shader, uniform->name, *(const vec2*) value); break;
+            case COMMAND_UNIFORM_FLOAT3: shader_setFloat3(shader, uniform->name, *(const vec3*) value); break;
+            case COMMAND_UNIFORM_FLOAT4: shader_setFloat4(shader, uniform->name, *(const vec4*) value); break;
+            case COMMAND_UNIFORM_MATRIX3: shader_setMatrix3(shader, uniform->name, *(const mat3*) value); break;
+            case COMMAND_UNIFORM_MATRIX4: shader_setMatrix4(shader, uniform->name, *(const mat4*) value); break;
+        }
+        offset += uniform->size;
+    }
+}
+
+/*
+Replays the draws of the given command buffers on the render thread, sorted by state: the draws sharing a shader,
+a texture and a vertex array run one after the other, in the order they have been recorded (buffer after buffer).
+When the shader changes the view matrix of the active camera is uploaded, like renderer_prepare() does.
+The uniforms shared by the draws of a shader (e.g. the projection) are not part of the buffers: set them before
+submitting (they are kept by the shader) or record them before every draw.
+Parameters:
+    - buffers (CommandBuffer**): the buffers to submit (NULL ones are skipped)
+    - count (unsigned int): the number of buffers
+*/
+void commandbuffer_submit(CommandBuffer** buffers, unsigned int count) {
+    PROFILE_SCOPE("commandbuffer_submit");
+
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        if (buffers[i] != NULL) total += buffers[i]->drawCount;
+    }
+    if (total == 0) return;
+    // the draws are gathered in the scratch arena of the render thread, it keeps its memory from a frame to the next
+    Arena* scratch = memory_getScratch();
+    if (scratch == NULL) return;
+    const ArenaMark mark = arena_getMark(scratch);
+    CommandSortItem* items = arena_alloc(scratch, total * sizeof(CommandSortItem));
+    if (items == NULL) {
+        console_error("Failed to allocate the sorting of %u draws", total);
+        return;
+    }
+
+    // gather and sort the draws
+    PROFILE_BEGIN("sort");
+    unsigned int itemCount = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        const CommandBuffer* buffer = buffers[i];
+        if (buffer == NULL) continue;
+        for (unsigned int j = 0; j < buffer->drawCount; j++) {
+            items[itemCount++] = (CommandSortItem) {
+                .key = buffer->draws[j].key,
+                .order = (uint64_t) i << 32 | j,
+                .buffer = buffer,
+                .draw = &buffer->draws[j]
+            };
+        }
+    }
+    qsort(items, itemCount, sizeof(CommandSortItem), commandbuffer_compareItems);
+    PROFILE_END();
+
+    // replay them
+    const unsigned int defaultShader = activeShader;
+    const bool hasView = activeCamera != NULL;
+    const mat4 view = hasView ? camera_getViewMatrix(activeCamera) : mat4_identity();
+    unsigned int shader = 0;
+    for (unsigned int i = 0; i < itemCount; i++) {
+        const CommandDraw* draw = items[i].draw;
+        const unsigned int drawShader = draw->shader > 0 ? draw->shader : defaultShader;
+        if (i == 0 || drawShader != shader) {
+            shader = drawShader;
+            if (shader != (unsigned int) activeShader) renderer_useShader(shader);
+            if (hasView && shader != 0 && shader_hasUniform(shader, "view")) shader_setMatrix4(shader, "view", view);
+        }
+        commandbuffer_uploadUniforms(items[i].buffer, draw, shader);
+        renderer_renderMesh(draw->mesh);
+    }
+    arena_rewind(scratch, mark);
+}
@@ -0,0 +1,195 @@
+/*
+DDS:
+DirectDraw Surface container reader/writer for block compressed textures (BC1, BC3 and BC7) and their mip chains.
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools.
+*/
+
+#include <string.h>
+
+#include "engine/utils/file.h"
+#include "engine/utils/console.h"
+
+#include "engine/gfx/dds.h"
+
+// the DDS layout is: "DDS " magic, 124 bytes header, (optional) 20 bytes DX10 header, then the mip levels one after the other
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 124
+#define DDS_PIXEL_FORMAT_SIZE 32
+#define DDS_DX10_HEADER_SIZE 20
+
+// header flags
+#define DDSD_CAPS 0x1
+#define DDSD_HEIGHT 0x2
+#define DDSD_WIDTH 0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE 0x80000
+#define DDPF_FOURCC 0x4
+#define DDSCAPS_COMPLEX 0x8
+#define DDSCAPS_TEXTURE 0x1000
+#define DDSCAPS_MIPMAP 0x400000
+
+// four character codes
+#define FOURCC(a, b, c, d) ((unsigned int) (a) | ((unsigned int) (b) << 8) | ((unsigned int) (c) << 16) | ((unsigned int) (d) << 24))
+#define FOURCC_DXT1 FOURCC('D', 'X', 'T', '1')
+#define FOURCC_DXT5 FOURCC('D', 'X', 'T', '5')
+#define FOURCC_DX10 FOURCC('D', 'X', '1', '0')
+
+// DXGI formats used by the DX10 header
+#define DXGI_FORMAT_BC1_UNORM 71
+#define DXGI_FORMAT_BC3_UNORM 77
+#define DXGI_FORMAT_BC7_UNORM 98
+#define DXGI_RESOURCE_DIMENSION_TEXTURE2D 3
+
+// reads a little endian 32 bit unsigned integer
+static unsigned int dds_read32(const unsigned char* data) {
+    return (unsigned int) data[0] | ((unsigned int) data[1] << 8) | ((unsigned int) data[2] << 16) | ((unsigned int) data[3] << 24);
+}
+
+// writes a little endian 32 bit unsigned integer
+static void dds_write32(unsigned char* data, unsigned int value) {
+    data[0] = value & 0xff;
+    data[1] = (value >> 8) & 0xff;
+    data[2] = (value >> 16) & 0xff;
+    data[3] = (value >> 24) & 0xff;
+}
+
+/*
+Parses a DDS file that has already been loaded (or mapped) into memory.
+The levels of the resulting image point straight into the given memory, so it must outlive the image.
+Parameters:
+    - data (unsigned char*): the DDS file content
+    - size (size_t): the DDS file size in bytes
+    - image (DdsImage*): where to store the parsed image
+Returns:
+    true on success, false if the file is not a supported DDS (BC1, BC3 or BC7 2D texture)
+*/
+bool dds_parse(const unsigned char* data, size_t size, DdsImage* image) {
+    if (size < 4 + DDS_HEADER_SIZE || dds_read32(data) != DDS_MAGIC || dds_read32(data + 4) != DDS_HEADER_SIZE) {
+        console_error("Invalid DDS header");
+        return false;
+    }
+
+    const unsigned char* header = data + 4;
+    const unsigned char* pixelFormat = header + 72;
+    image->height = dds_read32(header + 8);
+    image->width = dds_read32(header + 12);
+    if (image->width == 0 || image->height == 0) {
+        console_error("Invalid DDS size %ux%u", image->width, image->height);
+        return false;
+    }
+    const unsigned int flags = dds_read32(header + 4);
+    image->levelCount = (flags & DDSD_MIPMAPCOUNT) ? dds_read32(header + 24) : 1;
+    if (image->levelCount == 0) image->levelCount = 1;
+    if (image->levelCount > DDS_MAX_LEVELS) image->levelCount = DDS_MAX_LEVELS;
+
+    if (!(dds_read32(pixelFormat + 4) & DDPF_FOURCC)) {
+        console_error("Unsupported DDS pixel format (only block compressed textures are supported)");
+        return false;
+    }
+
+    size_t offset = 4 + DDS_HEADER_SIZE;
+    const unsigned int fourCC = dds_read32(pixelFormat + 8);
+    if (fourCC == FOURCC_DXT1) {
+        image->format = BCN_FORMAT_BC1;
+    } else if (fourCC == FOURCC_DXT5) {
+        image->format = BCN_FORMAT_BC3;
+    } else if (fourCC == FOURCC_DX10) {
+        if (size < offset + DDS_DX10_HEADER_SIZE) {
+            console_error("Truncated DDS DX10 header");
+            return false;
+        }
+        const unsigned int dxgiFormat = dds_read32(data + offset);
+        if (dxgiFormat == DXGI_FORMAT_BC1_UNORM) image->format = BCN_FORMAT_BC1;
+        else if (dxgiFormat == DXGI_FORMAT_BC3_UNORM) image->format = BCN_FORMAT_BC3;
+        else if (dxgiFormat == DXGI_FORMAT_BC7_UNORM) image->format = BCN_FORMAT_BC7;
+        else {
+            console_error("Unsupported DDS DXGI format %u", dxgiFormat);
+            return false;
+        }
+        offset += DDS_DX10_HEADER_SIZE;
+    } else {
+        console_error("Unsupported DDS four character code 0x%08x", fourCC);
+        return false;
+    }
+
+    // the levels are stored one after the other, from the biggest to the smallest
+    unsigned int width = image->width;
+    unsigned int height = image->height;
+    for (unsigned int i = 0; i < image->levelCount; i++) {
+        const size_t levelSize = bcn_getImageSize(image->format, width, height);
+        if (offset + levelSize > size) {
+            console_error("Truncated DDS mip level %u", i);
+            return false;
+        }
+        image->levels[i] = (DdsLevel) {
+            .data = data + offset,
+            .size = levelSize,
+            .width = width,
+            .height = height
+        };
+        offset += levelSize;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+
+    return true;
+}
+
+/*
+Writes a DDS file at the given path ("./file" means it is in "g3ce").
+Parameters:
+    - path (char*): the output file path
+    - format (BcnFormat): the format of the blocks
+    - width (unsigned int): the width of the first mip level
+    - height (unsigned int): the height of the first mip level
+    - levels (unsigned char**): the compressed blocks of every mip level (the first one being the full size image)
+    - levelCount (unsigned int): the number of mip levels
+Returns:
+    true on success, false otherwise
+*/
+bool dds_write(char* path, BcnFormat format, unsigned int width, unsigned int height, unsigned char** levels, unsigned int levelCount) {
+    unsigned char header[4 + DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE];
+    memset(header, 0, sizeof(header));
+
+    dds_write32(header, DDS_MAGIC);
+    unsigned char* surface = header + 4;
+    dds_write32(surface + 0, DDS_HEADER_SIZE);
+    dds_write32(surface + 4, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE);
+    dds_write32(surface + 8, height);
+    dds_write32(surface + 12, width);
+    dds_write32(surface + 16, (unsigned int) bcn_getImageSize(format, width, height));
+    dds_write32(surface + 24, levelCount);
+
+    unsigned char* pixelFormat = surface + 72;
+    dds_write32(pixelFormat + 0, DDS_PIXEL_FORMAT_SIZE);
+    dds_write32(pixelFormat + 4, DDPF_FOURCC);
+    // BC7 has no legacy four character code, so it needs the DX10 header
+    const bool needsDX10 = format == BCN_FORMAT_BC7;
+    dds_write32(pixelFormat + 8, needsDX10 ? FOURCC_DX10 : (format == BCN_FORMAT_BC1 ? FOURCC_DXT1 : FOURCC_DXT5));
+    dds_write32(surface + 104, DDSCAPS_TEXTURE | (levelCount > 1 ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0));
+
+    size_t headerSize = 4 + DDS_HEADER_SIZE;
+    if (needsDX10) {
+        unsigned char* dx10 = header + headerSize;
+        dds_write32(dx10 + 0, DXGI_FORMAT_BC7_UNORM);
+        dds_write32(dx10 + 4, DXGI_RESOURCE_DIMENSION_TEXTURE2D);
+        dds_write32(dx10 + 12, 1); // array size
+        headerSize += DDS_DX10_HEADER_SIZE;
+    }
+
+    FILE* file = file_open(path, "wb");
+    if (file == NULL) return false;
+
+    bool success = fwrite(header, 1, headerSize, file) == headerSize;
+    for (unsigned int i = 0; i < levelCount && success; i++) {
+        const size_t levelSize = bcn_getImageSize(format, width, height);
+        success = fwrite(levels[i], 1, levelSize, file) == levelSize;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    fclose(file);
+
+    if (!success) console_error("Failed to write DDS file at \"%s\"", path);
+    return success;
+}
@@ -0,0 +1,604 @@
+/*
+GLTF:
+glTF 2.0 loader (binary ".glb" files, and ".gltf" files with their buffers in separate ".bin" files).
+glTF data is already laid out the way the GPU wants it, so the buffers are mapped and every primitive gets its vertex
+and index ranges uploaded as they are (the accessors become vertex attributes pointing into them, normalized and
+quantized types included), without touching a single vertex (the indices are only checked to be in range).
+Every primitive becomes a mesh, and the node hierarchy is imported as local transforms with a parent index.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <math.h>
+#include <glad/glad.h>
+
+#include "engine/utils/file.h"
+#include "engine/utils/json.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/console.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/gfx/renderer.h"
+#include "engine/gfx/gltf.h"
+
+#define GLTF_MAGIC 0x46546C67      // "glTF"
+#define GLTF_VERSION 2
+#define GLTF_CHUNK_JSON 0x4E4F534A // "JSON"
+#define GLTF_CHUNK_BIN 0x004E4942  // "BIN\0"
+#define GLTF_MAX_PATH 256
+// the vertex range of a primitive is uploaded as it is unless it is this many times bigger than its attributes
+// (when the attributes of many primitives are stored one after the other, the range of one also covers the others)
+#define GLTF_MAX_SPAN_WASTE 2
+#define GLTF_SEMANTIC_COUNT 4
+
+typedef struct {
+    const unsigned char* data;
+    size_t size;
+    FileView view; // only for the external buffers
+    bool mapped;
+} GltfBuffer;
+
+typedef struct {
+    char* path;
+    JsonDocument json;
+    GltfBuffer* buffers;
+    unsigned int bufferCount;
+} GltfLoader;
+
+// an accessor with all its offsets resolved and validated
+typedef struct {
+    int token;
+    unsigned int buffer;
+    size_t start;            // offset of the first element in the buffer
+    size_t end;              // offset right after the last element in the buffer
+    unsigned int count;
+    unsigned int components;
+    unsigned int componentType;
+    unsigned int stride;
+    bool normalized;
+} GltfAccessor;
+
+static const struct {
+    const char* name;
+    unsigned int location;
+} gltf_semantics[GLTF_SEMANTIC_COUNT] = {
+    { "POSITION", MESHFILE_LOCATION_POSITION },
+    { "COLOR_0", MESHFILE_LOCATION_COLOR },
+    { "TEXCOORD_0", MESHFILE_LOCATION_UV },
+    { "NORMAL", MESHFILE_LOCATION_NORMAL }
+};
+
+static uint32_t gltf_readUint32(const unsigned char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+// returns the element of a top level array of the document (-1 if missing)
+static int gltf_getElement(GltfLoader* loader, const char* array, int index) {
+    if (index < 0) return -1;
+    return json_getElement(&loader->json, json_getMember(&loader->json, 0, array), (unsigned int) index);
+}
+
+// returns a non negative integer member (fallback if missing or invalid)
+static double gltf_getSize(GltfLoader* loader, int token, const char* member, double fallback) {
+    const double value = json_getNumber(&loader->json, json_getMember(&loader->json, token, member), fallback);
+    return value >= 0.0 && value == floor(value) ? value : fallback;
+}
+
+static bool gltf_resolveAccessor(GltfLoader* loader, int index, GltfAccessor* accessor) {
+    const JsonDocument* json = &loader->json;
+    accessor->token = gltf_getElement(loader, "accessors", index);
+    if (accessor->token < 0) {
+        console_error("Invalid accessor %d in \"%s\"", index, loader->path);
+        return false;
+    }
+    if (json_getMember(json, accessor->token, "sparse") >= 0) {
+        console_error("Sparse accessor %d in \"%s\" is not supported", index, loader->path);
+        return false;
+    }
+    const int view = gltf_getElement(loader, "bufferViews", (int) gltf_getSize(loader, accessor->token, "bufferView", -1));
+    if (view < 0) {
+        console_error("Accessor %d in \"%s\" has no buffer view", index, loader->path);
+        return false;
+    }
+
+    const int type = json_getMember(json, accessor->token, "type");
+    accessor->components = json_equals(json, type, "SCALAR") ? 1 : json_equals(json, type, "VEC2") ? 2 : json_equals(json, type, "VEC3") ? 3 : json_equals(json, type, "VEC4") ? 4 : 0;
+    accessor->componentType = (unsigned int) gltf_getSize(loader, accessor->token, "componentType", 0);
+    accessor->count = (unsigned int) gltf_getSize(loader, accessor->token, "count", 0);
+    accessor->normalized = json_getNumber(json, json_getMember(json, accessor->token, "normalized"), 0.0) != 0.0;
+
+    // the component types are the OpenGL ones (5120 is GL_BYTE, etc...)
+    const unsigned int componentSize = meshfile_getTypeSize(accessor->componentType);
+    const unsigned int elementSize = accessor->components * componentSize;
+    const double buffer = gltf_getSize(loader, view, "buffer", -1);
+    const double viewOffset = gltf_getSize(loader, view, "byteOffset", 0);
+    const double viewLength = gltf_getSize(loader, view, "byteLength", 0);
+    const double byteStride = gltf_getSize(loader, view, "byteStride", 0);
+    accessor->stride = byteStride > 0 ? (unsigned int) byteStride : elementSize;
+    accessor->buffer = (unsigned int) buffer;
+    accessor->start = (size_t) (viewOffset + gltf_getSize(loader, accessor->token, "byteOffset", 0));
+    accessor->end = accessor->start + (size_t) (accessor->count > 0 ? accessor->count - 1 : 0) * accessor->stride + elementSize;
+
+    if (elementSize == 0 || accessor->count == 0 || buffer < 0 || accessor->buffer >= loader->bufferCount
+        || viewOffset + viewLength > (double) loader->buffers[accessor->buffer].size || (double) accessor->end > viewOffset + viewLength) {
+        console_error("Invalid accessor %d in \"%s\"", index, loader->path);
+        return false;
+    }
+    return true;
+}
+
+// reads the local transform of a node (either a matrix or translation, rotation and scale)
+static Transform gltf_readTransform(GltfLoader* loader, int node) {
+    const JsonDocument* json = &loader->json;
+    Transform transform = transform_new();
+
+    const int matrix = json_getMember(json, node, "matrix");
+    if (json_getCount(json, matrix) == 16) {
+        // column major
+        float m[16];
+        for (unsigned int i = 0; i < 16; i++) m[i] = (float) json_getNumber(json, json_getElement(json, matrix, i), 0.0);
+        transform.position = vec3_new(m[12], m[13], m[14]);
+        float scale[3];
+        // the rotation is what is left of the upper 3x3 once the scale is divided out of its columns (row major)
+        mat4 rotation = mat4_identity();
+        for (int c = 0; c < 3; c++) {
+            scale[c] = sqrtf(m[c * 4] * m[c * 4] + m[c * 4 + 1] * m[c * 4 + 1] + m[c * 4 + 2] * m[c * 4 + 2]);
+            for (int row = 0; row < 3; row++) rotation.entries[row * 4 + c] = scale[c] > 0.0f ? m[c * 4 + row] / scale[c] : (row == c ? 1.0f : 0.0f);
+        }
+        transform.scale = vec3_new(scale[0], scale[1], scale[2]);
+        transform.rotation = quat_normalize(mat4_to_quat(rotation));
+    } else {
+        const int translation = json_getMember(json, node, "translation");
+        const int rotation = json_getMember(json, node, "rotation");
+        const int scale = json_getMember(json, node, "scale");
+        transform.position = vec3_new(
+            (float) json_getNumber(json, json_getElement(json, translation, 0), 0.0),
+            (float) json_getNumber(json, json_getElement(json, translation, 1), 0.0),
+            (float) json_getNumber(json, json_getElement(json, translation, 2), 0.0)
+        );
+        transform.scale = vec3_new(
+            (float) json_getNumber(json, json_getElement(json, scale, 0), 1.0),
+            (float) json_getNumber(json, json_getElement(json, scale, 1), 1.0),
+            (float) json_getNumber(json, json_getElement(json, scale, 2), 1.0)
+        );
+
+        // (x, y, z, w) unit quaternion, the same rotation the transforms store
+        transform.rotation = quat_normalize(quat_new(
+            (float) json_getNumber(json, json_getElement(json, rotation, 3), 1.0),
+            (float) json_getNumber(json, json_getElement(json, rotation, 0), 0.0),
+            (float) json_getNumber(json, json_getElement(json, rotation, 1), 0.0),
+            (float) json_getNumber(json, json_getElement(json, rotation, 2), 0.0)
+        ));
+    }
+
+    return transform;
+}
+
+// sets the bounds of a mesh from the "min" and "max" of its position accessor (required by the specification)
+static void gltf_readBounds(GltfLoader* loader, const GltfAccessor* position, Mesh* mesh) {
+    const JsonDocument* json = &loader->json;
+    const int min = json_getMember(json, position->token, "min");
+    const int max = json_getMember(json, position->token, "max");
+
+    // quantized positions are stored as integers (mapped to [0, 1] or [-1, 1] when normalized)
+    double scale = 1.0;
+    if (position->normalized) {
+        switch (position->componentType) {
+            case GL_BYTE: scale = 1.0 / 127.0; break;
+            case GL_UNSIGNED_BYTE: scale = 1.0 / 255.0; break;
+            case GL_SHORT: scale = 1.0 / 32767.0; break;
+            case GL_UNSIGNED_SHORT: scale = 1.0 / 65535.0; break;
+        }
+    }
+    for (unsigned int c = 0; c < 3; c++) {
+        mesh->boundsMin[c] = (float) (json_getNumber(json, json_getElement(json, min, c), 0.0) * scale);
+        mesh->boundsMax[c] = (float) (json_getNumber(json, json_getElement(json, max, c), 0.0) * scale);
+    }
+}
+
+// returns the first index of an accessor that is not below the vertex count (indexCount if they all are)
+static unsigned int gltf_findInvalidIndex(const unsigned char* indices, unsigned int indexCount, unsigned int indexType, unsigned int vertexCount) {
+    // the buffer views are not required to keep their indices aligned, so they are read byte by byte
+    for (unsigned int i = 0; i < indexCount; i++) {
+        uint32_t index;
+        if (indexType == GL_UNSIGNED_BYTE) {
+            index = indices[i];
+        } else if (indexType == GL_UNSIGNED_SHORT) {
+            uint16_t index16;
+            memcpy(&index16, indices + i * 2, 2);
+            index = index16;
+        } else {
+            memcpy(&index, indices + i * 4, 4);
+        }
+        if (index >= vertexCount) return i;
+    }
+    return indexCount;
+}
+
+// uploads a primitive as a mesh
+static bool gltf_loadPrimitive(GltfLoader* loader, int primitive, Mesh* mesh) {
+    const JsonDocument* json = &loader->json;
+    const int attributeTokens = json_getMember(json, primitive, "attributes");
+
+    GltfAccessor attributes[GLTF_SEMANTIC_COUNT];
+    bool present[GLTF_SEMANTIC_COUNT];
+    for (unsigned int i = 0; i < GLTF_SEMANTIC_COUNT; i++) {
+        const int index = (int) json_getNumber(json, json_getMember(json, attributeTokens, gltf_semantics[i].name), -1.0);
+        present[i] = index >= 0;
+        if (present[i] && !gltf_resolveAccessor(loader, index, &attributes[i])) return false;
+    }
+    if (!present[0]) {
+        console_error("Primitive without positions in \"%s\"", loader->path);
+        return false;
+    }
+    const unsigned int vertexCount = attributes[0].count;
+    for (unsigned int i = 1; i < GLTF_SEMANTIC_COUNT; i++) {
+        if (present[i] && attributes[i].count != vertexCount) {
+            console_error("Primitive with attributes of different lengths in \"%s\"", loader->path);
+            return false;
+        }
+    }
+    // the glTF modes are the OpenGL ones (GL_POINTS to GL_TRIANGLE_FAN)
+    const double drawMode = gltf_getSize(loader, primitive, "mode", GL_TRIANGLES);
+    if (drawMode > GL_TRIANGLE_FAN) {
+        console_error("Invalid primitive mode %.0f in \"%s\"", drawMode, loader->path);
+        return false;
+    }
+
+    // vertex range: the span covering all the attributes when it is compact enough, otherwise the attributes are packed
+    bool sameBuffer = true;
+    size_t spanStart = SIZE_MAX, spanEnd = 0, usedSize = 0;
+    for (unsigned int i = 0; i < GLTF_SEMANTIC_COUNT; i++) {
+        if (!present[i]) continue;
+        sameBuffer = sameBuffer && attributes[i].buffer == attributes[0].buffer;
+        if (attributes[i].start < spanStart) spanStart = attributes[i].start;
+        if (attributes[i].end > spanEnd) spanEnd = attributes[i].end;
+        usedSize += attributes[i].end - attributes[i].start;
+    }
+    spanStart &= ~(size_t) 3; // keep the attributes offsets 4 bytes aligned
+
+    size_t offsets[GLTF_SEMANTIC_COUNT] = { 0 };
+    const unsigned char* vertexData;
+    size_t vertexSize;
+    unsigned char* packed = NULL;
+    if (sameBuffer && spanEnd - spanStart <= usedSize * GLTF_MAX_SPAN_WASTE) {
+        vertexData = loader->buffers[attributes[0].buffer].data + spanStart;
+        vertexSize = spanEnd - spanStart;
+        for (unsigned int i = 0; i < GLTF_SEMANTIC_COUNT; i++) offsets[i] = present[i] ? attributes[i].start - spanStart : 0;
+    } else {
+        vertexSize = 0;
+        for (unsigned int i = 0; i < GLTF_SEMANTIC_COUNT; i++) {
+            if (present[i]) vertexSize += (attributes[i].end - attributes[i].start + 3) & ~(size_t) 3;
+        }
+        packed = (unsigned char*) malloc(vertexSize);
+        if (packed == NULL) {
+            console_error("Failed to allocate memory for a primitive of \"%s\"", loader->path);
+            return false;
+        }
+        size_t offset = 0;
+        for (unsigned int i = 0; i < GLTF_SEMANTIC_COUNT; i++) {
+            if (!present[i]) continue;
+            offsets[i] = offset;
+            memcpy(packed + offset, loader->buffers[attributes[i].buffer].data + attributes[i].start, attributes[i].end - attributes[i].start);
+            offset += (attributes[i].end - attributes[i].start + 3) & ~(size_t) 3;
+        }
+        vertexData = packed;
+    }
+
+    // index range (non indexed primitives get a sequence of indices)
+    const int indexAccessor = (int) json_getNumber(json, json_getMember(json, primitive, "indices"), -1.0);
+    const void* indexData;
+    size_t indexSize;
+    unsigned int indexCount;
+    unsigned int indexType;
+    unsigned int* sequence = NULL;
+    if (indexAccessor >= 0) {
+        GltfAccessor indices;
+        if (!gltf_resolveAccessor(loader, indexAccessor, &indices)) {
+            free(packed);
+            return false;
+        }
+        if (indices.components != 1 || indices.stride != meshfile_getTypeSize(indices.componentType)
+            || (indices.componentType != GL_UNSIGNED_BYTE && indices.componentType != GL_UNSIGNED_SHORT && indices.componentType != GL_UNSIGNED_INT)) {
+            console_error("Invalid index accessor %d in \"%s\"", indexAccessor, loader->path);
+            free(packed);
+            return false;
+        }
+        // the GPU must never read outside of the vertex buffer
+        const unsigned char* indexBytes = loader->buffers[indices.buffer].data + indices.start;
+        const unsigned int invalidIndex = gltf_findInvalidIndex(indexBytes, indices.count, indices.componentType, vertexCount);
+        if (invalidIndex < indices.count) {
+            console_error("Invalid index at position %u of accessor %d in \"%s\" (the primitive has %u vertices)", invalidIndex, indexAccessor, loader->path, vertexCount);
+            free(packed);
+            return false;
+        }
+        indexData = indexBytes;
+        indexSize = indices.end - indices.start;
+        indexCount = indices.count;
+        indexType = indices.componentType;
+    } else {
+        sequence = (unsigned int*) malloc(vertexCount * sizeof(unsigned int));
+        if (sequence == NULL) {
+            console_error("Failed to allocate memory for a primitive of \"%s\"", loader->path);
+            free(packed);
+            return false;
+        }
+        for (unsigned int i = 0; i < vertexCount; i++) sequence[i] = i;
+        indexData = sequence;
+        indexSize = vertexCount * sizeof(unsigned int);
+        indexCount = vertexCount;
+        indexType = GL_UNSIGNED_INT;
+    }
+
+    *mesh = (Mesh) {
+        .drawMode = (unsigned int) drawMode,
+        .lastOffset = 0,
+        .indicesLength = indexCount,
+        .stride = attributes[0].stride,
+        .texture = 0, // by default no texture is assigned
+        .textureTarget = GL_TEXTURE_2D,
+        .textureUnit = 0, // by default is texture unit 0
+        .sampler = 0, // by default no sampler is assigned
+        .indexType = indexType,
+        .indexOffset = 0,
+        .lodCount = 1,
+        .lods = { { .indexStart = 0, .indexCount = indexCount, .distance = 0.0f } }
+    };
+    gltf_readBounds(loader, &attributes[0], mesh);
+
+    glGenVertexArrays(1, &(mesh->vao));
+    glBindVertexArray(mesh->vao);
+
+    // upload the ranges straight from the mapped buffers
+    glGenBuffers(1, &(mesh->vbo));
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) vertexSize, vertexData, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &(mesh->ebo));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) indexSize, indexData, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += vertexSize + indexSize;
+    memory_trackGpu(MEMORY_GPU_BUFFER, mesh->vbo, MEMORY_TAG_MESH, vertexSize);
+    memory_trackGpu(MEMORY_GPU_BUFFER, mesh->ebo, MEMORY_TAG_MESH, indexSize);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    for (unsigned int i = 0; i < GLTF_SEMANTIC_COUNT; i++) {
+        if (!present[i]) continue;
+        mesh_registerVertexAttributeEx(mesh, gltf_semantics[i].location, attributes[i].components, attributes[i].componentType,
+            attributes[i].normalized, attributes[i].stride, (unsigned int) offsets[i]);
+    }
+
+    free(packed);
+    free(sequence);
+    return true;
+}
+
+// maps the buffers of the document (the GLB binary chunk is the first buffer without an uri)
+static bool gltf_loadBuffers(GltfLoader* loader, const unsigned char* binary, size_t binarySize) {
+    const JsonDocument* json = &loader->json;
+    const int buffers = json_getMember(json, 0, "buffers");
+    loader->bufferCount = json_getCount(json, buffers);
+    loader->buffers = (GltfBuffer*) calloc(loader->bufferCount > 0 ? loader->bufferCount : 1, sizeof(GltfBuffer));
+    if (loader->buffers == NULL) {
+        console_error("Failed to allocate memory for the buffers of \"%s\"", loader->path);
+        return false;
+    }
+
+    size_t directoryLength = strlen(loader->path);
+    while (directoryLength > 0 && loader->path[directoryLength - 1] != '/' && loader->path[directoryLength - 1] != '\\') directoryLength--;
+
+    for (unsigned int i = 0; i < loader->bufferCount; i++) {
+        const int buffer = json_getElement(json, buffers, i);
+        const int uri = json_getMember(json, buffer, "uri");
+        GltfBuffer* target = &loader->buffers[i];
+
+        if (uri < 0) {
+            if (i != 0 || binary == NULL) {
+                console_error("Buffer %u of \"%s\" has no data", i, loader->path);
+                return false;
+            }
+            target->data = binary;
+            target->size = binarySize;
+        } else {
+            char name[GLTF_MAX_PATH];
+            json_copyString(json, uri, name, sizeof(name));
+            if (strncmp(name, "data:", 5) == 0) {
+                console_error("Buffer %u of \"%s\" is embedded as base64, which is not supported (use a .glb file)", i, loader->path);
+                return false;
+            }
+            // (a name filling the whole buffer may have been truncated)
+            char path[GLTF_MAX_PATH];
+            const int pathLength = snprintf(path, sizeof(path), "%.*s%s", (int) directoryLength, loader->path, name);
+            if (strlen(name) >= sizeof(name) - 1 || pathLength < 0 || (size_t) pathLength >= sizeof(path)) {
+                console_error("The path of buffer %u of \"%s\" is too long", i, loader->path);
+                return false;
+            }
+            if (!file_map(path, &target->view)) return false;
+            file_advise(&target->view, FILE_ACCESS_SEQUENTIAL);
+            target->mapped = true;
+            target->data = target->view.data;
+            target->size = target->view.size;
+        }
+
+        const double byteLength = gltf_getSize(loader, buffer, "byteLength", 0);
+        if (byteLength > (double) target->size) {
+            console_error("Buffer %u of \"%s\" is truncated", i, loader->path);
+            return false;
+        }
+        target->size = (size_t) byteLength;
+    }
+    return true;
+}
+
+// reads the nodes and their hierarchy (meshFirst and meshCounts give the meshes of every glTF mesh)
+static bool gltf_loadNodes(GltfLoader* loader, GltfModel* model, const unsigned int* meshFirst, const unsigned int* meshCounts, unsigned int gltfMeshCount) {
+    const JsonDocument* json = &loader->json;
+    const int nodes = json_getMember(json, 0, "nodes");
+    const unsigned int nodeCount = json_getCount(json, nodes);
+    model->nodes = (GltfNode*) calloc(nodeCount > 0 ? nodeCount : 1, sizeof(GltfNode));
+    if (model->nodes == NULL) {
+        console_error("Failed to allocate memory for the nodes of \"%s\"", loader->path);
+        return false;
+    }
+    model->nodeCount = nodeCount;
+
+    for (unsigned int i = 0; i < nodeCount; i++) model->nodes[i].parent = -1;
+    for (unsigned int i = 0; i < nodeCount; i++) {
+        const int node = json_getElement(json, nodes, i);
+        GltfNode* target = &model->nodes[i];
+        json_copyString(json, json_getMember(json, node, "name"), target->name, sizeof(target->name));
+        target->transform = gltf_readTransform(loader, node);
+
+        const double mesh = gltf_getSize(loader, node, "mesh", -1);
+        if (mesh >= (double) gltfMeshCount) {
+            console_error("Node %u of \"%s\" has an invalid mesh", i, loader->path);
+            return false;
+        }
+        if (mesh >= 0) {
+            target->firstMesh = meshFirst[(unsigned int) mesh];
+            target->meshCount = meshCounts[(unsigned int) mesh];
+        }
+
+        const int children = json_getMember(json, node, "children");
+        for (unsigned int c = 0; c < json_getCount(json, children); c++) {
+            const double child = json_getNumber(json, json_getElement(json, children, c), -1.0);
+            if (child < 0 || child >= (double) nodeCount || child == (double) i || model->nodes[(unsigned int) child].parent >= 0) {
+                console_error("Node %u of \"%s\" has an invalid child", i, loader->path);
+                return false;
+            }
+            model->nodes[(unsigned int) child].parent = (int) i;
+        }
+    }
+    return true;
+}
+
+/*
+Loads a glTF 2.0 model, uploading all its meshes.
+REMEMBER TO DESTROY THE MODEL BY CALLING gltf_destroy()!
+Parameters:
+    - path (char*): the ".glb" or ".gltf" file path ("./file" means it is in "g3ce", external buffers are relative to it)
+    - model (GltfModel*): where to store the loaded model
+Returns:
+    true on success, false otherwise (the error has already been logged)
+*/
+bool gltf_load(char* path, GltfModel* model) {
+    PROFILE_FUNCTION();
+
+    memset(model, 0, sizeof(GltfModel));
+
+    FileView view;
+    if (!file_map(path, &view)) return false;
+
+    // a GLB file is a header followed by the JSON chunk and the (optional) binary chunk, anything else is plain JSON
+    const char* text = (const char*) view.data;
+    size_t textLength = view.size;
+    const unsigned char* binary = NULL;
+    size_t binarySize = 0;
+    if (view.size >= 12 && gltf_readUint32(view.data) == GLTF_MAGIC) {
+        const uint32_t version = gltf_readUint32(view.data + 4);
+        const size_t length = gltf_readUint32(view.data + 8);
+        const size_t jsonLength = view.size >= 20 ? gltf_readUint32(view.data + 12) : 0;
+        if (version != GLTF_VERSION || length > view.size || view.size < 20 || gltf_readUint32(view.data + 16) != GLTF_CHUNK_JSON || jsonLength > length - 20) {
+            console_error("Invalid or unsupported GLB file \"%s\"", path);
+            file_unmap(&view);
+            return false;
+        }
+        text = (const char*) view.data + 20;
+        textLength = jsonLength;
+
+        const size_t binaryChunk = 20 + ((jsonLength + 3) & ~(size_t) 3);
+        if (binaryChunk + 8 <= length && gltf_readUint32(view.data + binaryChunk + 4) == GLTF_CHUNK_BIN) {
+            binarySize = gltf_readUint32(view.data + binaryChunk);
+            binary = view.data + binaryChunk + 8;
+            if (binarySize > length - binaryChunk - 8) {
+                console_error("Truncated GLB file \"%s\"", path);
+                file_unmap(&view);
+                return false;
+            }
+        }
+    }
+
+    GltfLoader loader = { .path = path };
+    if (!json_parse(text, textLength, &loader.json)) {
+        console_error("Failed to load \"%s\"", path);
+        file_unmap(&view);
+        return false;
+    }
+
+    bool success = gltf_loadBuffers(&loader, binary, binarySize);
+
+    // every primitive of every mesh becomes a mesh
+    const int meshes = json_getMember(&loader.json, 0, "meshes");
+    const unsigned int gltfMeshCount = json_getCount(&loader.json, meshes);
+    unsigned int* meshFirst = (unsigned int*) calloc(gltfMeshCount > 0 ? gltfMeshCount : 1, sizeof(unsigned int));
+    unsigned int* meshCounts = (unsigned int*) calloc(gltfMeshCount > 0 ? gltfMeshCount : 1, sizeof(unsigned int));
+    unsigned int primitiveCount = 0;
+    for (unsigned int i = 0; i < gltfMeshCount; i++) {
+        primitiveCount += json_getCount(&loader.json, json_getMember(&loader.json, json_getElement(&loader.json, meshes, i), "primitives"));
+    }
+    model->meshes = (Mesh*) malloc((primitiveCount > 0 ? primitiveCount : 1) * sizeof(Mesh));
+    if (success && (meshFirst == NULL || meshCounts == NULL || model->meshes == NULL)) {
+        console_error("Failed to allocate memory for the meshes of \"%s\"", path);
+        success = false;
+    }
+    for (unsigned int i = 0; i < gltfMeshCount && success; i++) {
+        const int primitives = json_getMember(&loader.json, json_getElement(&loader.json, meshes, i), "primitives");
+        meshFirst[i] = model->meshCount;
+        meshCounts[i] = json_getCount(&loader.json, primitives);
+        for (unsigned int p = 0; p < meshCounts[i] && success; p++) {
+            success = gltf_loadPrimitive(&loader, json_getElement(&loader.json, primitives, p), &model->meshes[model->meshCount]);
+            if (success) model->meshCount++;
+        }
+    }
+
+    if (success) success = gltf_loadNodes(&loader, model, meshFirst, meshCounts, gltfMeshCount);
+
+    // the data has been copied by the driver, the files are not needed anymore
+    for (unsigned int i = 0; i < loader.bufferCount; i++) {
+        if (loader.buffers[i].mapped) file_unmap(&loader.buffers[i].view);
+    }
+    free(loader.buffers);
+    free(meshFirst);
+    free(meshCounts);
+    json_free(&loader.json);
+    file_unmap(&view);
+
+    if (!success) {
+        console_error("Failed to load \"%s\"", path);
+        gltf_destroy(model);
+    }
+    return success;
+}
+
+// destroys the meshes of a model loaded by gltf_load() and frees its memory
+void gltf_destroy(GltfModel* model) {
+    for (unsigned int i = 0; i < model->meshCount; i++) {
+        memory_untrackGpu(MEMORY_GPU_BUFFER, model->meshes[i].vbo);
+        memory_untrackGpu(MEMORY_GPU_BUFFER, model->meshes[i].ebo);
+        glDeleteBuffers(1, &(model->meshes[i].vbo));
+        glDeleteBuffers(1, &(model->meshes[i].ebo));
+        glDeleteVertexArrays(1, &(model->meshes[i].vao));
+    }
+    free(model->meshes);
+    free(model->nodes);
+    memset(model, 0, sizeof(GltfModel));
+}
+
+// returns the model matrix of a node (its local transform combined with the ones of all its ancestors)
+mat4 gltf_getWorldMatrix(GltfModel* model, unsigned int node) {
+    mat4 result = transform_getModelMatrix(&(model->nodes[node].transform));
+    int parent = model->nodes[node].parent;
+    for (unsigned int depth = 0; parent >= 0 && depth < model->nodeCount; depth++) {
+        result = mat4_multiply(transform_getModelMatrix(&(model->nodes[parent].transform)), result);
+        parent = model->nodes[parent].parent;
+    }
+    return result;
+}
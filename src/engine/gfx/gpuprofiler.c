@@ -0,0 +1,184 @@
+/*
+GPUPROFILER:
+GPU frame profiler.
+Every frame of the ring owns two timestamp queries per scope (plus the two of the frame itself). A frame is read back
+when the query of its end is available: the GPU completes the commands in order, so all its other queries are too.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <glad/glad.h>
+
+#include "engine/utils/console.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/gfx/gpuprofiler.h"
+
+// the frame begin and end queries come first, then two per scope
+#define GPU_PROFILER_QUERIES (2 + GPU_PROFILER_MAX_SCOPES * 2)
+// the offset between the GPU and CPU clocks is measured again every this many frames
+#define GPU_PROFILER_SYNC_INTERVAL 256
+
+typedef struct {
+    const char* name;
+    unsigned int depth;
+    bool ended;
+} GpuScope;
+
+typedef struct {
+    unsigned int queries[GPU_PROFILER_QUERIES];
+    GpuScope scopes[GPU_PROFILER_MAX_SCOPES];
+    unsigned int scopeCount;
+    unsigned int stack[GPU_PROFILER_MAX_DEPTH]; // open scopes
+    unsigned int depth;
+    uint64_t cpuBegin;
+    uint64_t cpuEnd;
+    unsigned long long index;
+    bool pending; // ended, waiting to be read back
+} GpuFrame;
+
+static bool gpuprofiler_enabled = false;
+static GpuFrame gpuprofiler_frames[GPU_PROFILER_FRAMES];
+static GpuFrame* gpuprofiler_current = NULL;
+static unsigned long long gpuprofiler_frameIndex = 0;
+static unsigned long long gpuprofiler_skippedFrames = 0;
+static int64_t gpuprofiler_clockOffset = 0; // CPU time - GPU time
+static GpuFrameStats gpuprofiler_stats = { 0 };
+
+// measures the offset between the GPU and the CPU clocks
+static void gpuprofiler_syncClocks() {
+    GLint64 gpuTime = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuTime);
+    gpuprofiler_clockOffset = (int64_t) profiler_getTime() - (int64_t) gpuTime;
+}
+
+// creates the query ring (called by app_create() when G3CE_PROFILE is defined), returns false if timer queries are not supported
+bool gpuprofiler_init() {
+    if (gpuprofiler_enabled) return true;
+    if (glQueryCounter == NULL || glGetQueryObjectui64v == NULL || glGetInteger64v == NULL) {
+        console_warning("Timer queries are not supported, the GPU profiler is disabled");
+        return false;
+    }
+
+    memset(gpuprofiler_frames, 0, sizeof(gpuprofiler_frames));
+    for (unsigned int i = 0; i < GPU_PROFILER_FRAMES; i++) glGenQueries(GPU_PROFILER_QUERIES, gpuprofiler_frames[i].queries);
+    gpuprofiler_current = NULL;
+    gpuprofiler_frameIndex = 0;
+    gpuprofiler_skippedFrames = 0;
+    memset(&gpuprofiler_stats, 0, sizeof(gpuprofiler_stats));
+    gpuprofiler_syncClocks();
+    gpuprofiler_enabled = true;
+    return true;
+}
+
+// returns the result of a query converted to the profiler clock
+static uint64_t gpuprofiler_getResult(unsigned int query) {
+    GLuint64 time = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &time);
+    return (uint64_t) ((int64_t) time + gpuprofiler_clockOffset);
+}
+
+// reads back a frame if its results are available (never waits for them), returns whether it has been read
+static bool gpuprofiler_readFrame(GpuFrame* frame) {
+    GLuint available = 0;
+    glGetQueryObjectuiv(frame->queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return false;
+
+    const uint64_t begin = gpuprofiler_getResult(frame->queries[0]);
+    const uint64_t end = gpuprofiler_getResult(frame->queries[1]);
+    profiler_addGpuEvent("gpu frame", 0, begin, end);
+    for (unsigned int i = 0; i < frame->scopeCount; i++) {
+        if (!frame->scopes[i].ended) continue;
+        profiler_addGpuEvent(frame->scopes[i].name, frame->scopes[i].depth + 1, gpuprofiler_getResult(frame->queries[2 + i * 2]), gpuprofiler_getResult(frame->queries[3 + i * 2]));
+    }
+
+    gpuprofiler_stats.cpu = (double) (frame->cpuEnd - frame->cpuBegin) / 1000000.0;
+    gpuprofiler_stats.gpu = (double) (end - begin) / 1000000.0;
+    gpuprofiler_stats.latency = (double) ((int64_t) end - (int64_t) frame->cpuEnd) / 1000000.0;
+    gpuprofiler_stats.gpuBound = gpuprofiler_stats.gpu > gpuprofiler_stats.cpu;
+    gpuprofiler_stats.frame = frame->index;
+    frame->pending = false;
+    return true;
+}
+
+// reads back the results of the previous frames that are available and starts measuring a new frame (called by the app loop)
+void gpuprofiler_beginFrame() {
+    if (!gpuprofiler_enabled) return;
+    if (gpuprofiler_current != NULL) gpuprofiler_endFrame();
+
+    // oldest first, stopping at the first frame that is not ready (the following ones cannot be either)
+    for (unsigned int i = 1; i <= GPU_PROFILER_FRAMES; i++) {
+        GpuFrame* frame = &gpuprofiler_frames[(gpuprofiler_frameIndex + i) % GPU_PROFILER_FRAMES];
+        if (frame->pending && !gpuprofiler_readFrame(frame)) break;
+    }
+
+    gpuprofiler_frameIndex++;
+    if (gpuprofiler_frameIndex % GPU_PROFILER_SYNC_INTERVAL == 0) gpuprofiler_syncClocks();
+
+    GpuFrame* frame = &gpuprofiler_frames[gpuprofiler_frameIndex % GPU_PROFILER_FRAMES];
+    if (frame->pending) gpuprofiler_skippedFrames++; // the GPU is more than GPU_PROFILER_FRAMES - 1 frames behind
+    frame->pending = false;
+    frame->scopeCount = 0;
+    frame->depth = 0;
+    frame->index = gpuprofiler_frameIndex;
+    frame->cpuBegin = profiler_getTime();
+    glQueryCounter(frame->queries[0], GL_TIMESTAMP);
+    gpuprofiler_current = frame;
+}
+
+// stops measuring the current frame, closing its open scopes (called by the app loop before swapping the buffers)
+void gpuprofiler_endFrame() {
+    GpuFrame* frame = gpuprofiler_current;
+    if (frame == NULL) return;
+    while (frame->depth > 0) gpuprofiler_end();
+    glQueryCounter(frame->queries[1], GL_TIMESTAMP);
+    frame->cpuEnd = profiler_getTime();
+    frame->pending = true;
+    gpuprofiler_current = NULL;
+}
+
+// begins a GPU scope in the current frame (see GPU_PROFILE_BEGIN())
+void gpuprofiler_begin(const char* name) {
+    GpuFrame* frame = gpuprofiler_current;
+    if (frame == NULL) return;
+    // the scopes that do not fit are still counted, so the matching ends are ignored too
+    if (frame->depth < GPU_PROFILER_MAX_DEPTH) {
+        frame->stack[frame->depth] = frame->scopeCount;
+        if (frame->scopeCount < GPU_PROFILER_MAX_SCOPES) {
+            frame->scopes[frame->scopeCount] = (GpuScope) { .name = name, .depth = frame->depth, .ended = false };
+            glQueryCounter(frame->queries[2 + frame->scopeCount * 2], GL_TIMESTAMP);
+            frame->scopeCount++;
+        }
+    }
+    frame->depth++;
+}
+
+// ends the last GPU scope begun in the current frame (see GPU_PROFILE_END())
+void gpuprofiler_end() {
+    GpuFrame* frame = gpuprofiler_current;
+    if (frame == NULL || frame->depth == 0) return;
+    frame->depth--;
+    if (frame->depth >= GPU_PROFILER_MAX_DEPTH) return;
+    const unsigned int scope = frame->stack[frame->depth];
+    if (scope >= GPU_PROFILER_MAX_SCOPES) return;
+    glQueryCounter(frame->queries[3 + scope * 2], GL_TIMESTAMP);
+    frame->scopes[scope].ended = true;
+}
+
+// returns the CPU and GPU time of the last frame read back
+GpuFrameStats gpuprofiler_getFrameStats() {
+    return gpuprofiler_stats;
+}
+
+// returns the number of frames skipped because their results were still pending when their queries had to be reused
+unsigned long long gpuprofiler_getSkippedFrames() {
+    return gpuprofiler_skippedFrames;
+}
+
+// deletes the query ring (called by app_terminate())
+void gpuprofiler_shutdown() {
+    if (!gpuprofiler_enabled) return;
+    for (unsigned int i = 0; i < GPU_PROFILER_FRAMES; i++) glDeleteQueries(GPU_PROFILER_QUERIES, gpuprofiler_frames[i].queries);
+    gpuprofiler_current = NULL;
+    gpuprofiler_enabled = false;
+}
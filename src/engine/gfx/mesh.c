@@ -4,13 +4,47 @@ Handles mesh creation and destruction
 */
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <float.h>
 #include <glad/glad.h>
 
 #include "engine/utils/console.h"
+#include "engine/utils/file.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
 
+#include "engine/gfx/renderer.h"
 #include "engine/gfx/mesh.h"
 
-// creates a stack allocated mesh and returns it. This does not need to be destroyed
+// the heap meshes (see mesh_create() and mesh_load())
+static Pool mesh_pool = POOL_INIT(sizeof(Mesh), 64, MEMORY_TAG_MESH);
+
+// sets the bounds of a mesh from its vertex array (the position is assumed to be the first 3 floats of each vertex, as in all the engine meshes)
+static void mesh_computeBounds(Mesh* mesh, float* vertices, unsigned int verticesSize, unsigned int vertexLength) {
+    const unsigned int vertexCount = vertexLength > 0 ? verticesSize / (vertexLength * sizeof(float)) : 0;
+    for (unsigned int c = 0; c < 3; c++) {
+        mesh->boundsMin[c] = vertexCount > 0 && vertexLength >= 3 ? FLT_MAX : 0.0f;
+        mesh->boundsMax[c] = vertexCount > 0 && vertexLength >= 3 ? -FLT_MAX : 0.0f;
+    }
+    if (vertexLength < 3) return;
+    for (unsigned int i = 0; i < vertexCount; i++) {
+        for (unsigned int c = 0; c < 3; c++) {
+            const float value = vertices[i * vertexLength + c];
+            if (value < mesh->boundsMin[c]) mesh->boundsMin[c] = value;
+            if (value > mesh->boundsMax[c]) mesh->boundsMax[c] = value;
+        }
+    }
+}
+
+// sets the single LOD of a mesh created from arrays
+static void mesh_setSingleLod(Mesh* mesh) {
+    mesh->indexType = GL_UNSIGNED_INT;
+    mesh->indexOffset = 0;
+    mesh->lodCount = 1;
+    mesh->lods[0] = (MeshFileLod) { .indexStart = 0, .indexCount = mesh->indicesLength, .distance = 0.0f };
+}
+
+// creates a stack allocated mesh and returns it. This does not need to be destroyed, but its OpenGL objects MUST be deleted via mesh_delete()
 Mesh mesh_new(float* vertices, unsigned int verticesSize, unsigned int* indices, unsigned int indicesSize, unsigned int vertexLength, unsigned int drawMode) {
     // generate VAO and assign it to the mesh
     unsigned int vao;
@@ -24,12 +58,16 @@ Mesh mesh_new(float* vertices, unsigned int verticesSize, unsigned int* indices,
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, verticesSize, vertices, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += verticesSize;
+    memory_trackGpu(MEMORY_GPU_BUFFER, vbo, MEMORY_TAG_MESH, verticesSize);
 
     // generate EBO and assign it to the mesh
     unsigned int ebo;
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += indicesSize;
+    memory_trackGpu(MEMORY_GPU_BUFFER, ebo, MEMORY_TAG_MESH, indicesSize);
 
     // unbind the mesh VAO
     glBindVertexArray(0);
@@ -40,7 +78,7 @@ Mesh mesh_new(float* vertices, unsigned int verticesSize, unsigned int* indices,
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     
-    return (Mesh) {
+    Mesh mesh = {
         .vao = vao,
         .vbo = vbo,
         .ebo = ebo,
@@ -49,8 +87,14 @@ Mesh mesh_new(float* vertices, unsigned int verticesSize, unsigned int* indices,
         .indicesLength = indicesSize / sizeof(int),
         .stride = vertexLength * sizeof(float),
         .texture = 0, // by default no texture is assigned
-        .textureUnit = 0 // by default is texture unit 0
+        .textureTarget = GL_TEXTURE_2D,
+        .textureUnit = 0, // by default is texture unit 0
+        .sampler = 0 // by default no sampler is assigned
     };
+    mesh_setSingleLod(&mesh);
+    mesh_computeBounds(&mesh, vertices, verticesSize, vertexLength);
+
+    return mesh;
 }
 
 /*
@@ -66,11 +110,11 @@ Parameters:
     - vertexLength (unsigned int): the number of floats that defines a vertex (e.g.: 3 for 3D position + 4 for RGBA color = 7)
     - drawMode (unsigned int): the drawing mode OpenGL has to use (GL_TRIANGLES, GL_QUADS, etc...)
 Returns:
-    The pointer to the mesh struct that has been created. It points to dynamically allocated memory,
-    so you MUST call mesh_destroy(Mesh*) that handles the free() procedure
+    The pointer to the mesh struct that has been created. It points to memory of the mesh pool (see memory.h),
+    so you MUST call mesh_destroy(Mesh*) that gives it back (never free() it)
 */
 Mesh* mesh_create(float* vertices, unsigned int verticesSize, unsigned int* indices, unsigned int indicesSize, unsigned int vertexLength, unsigned int drawMode) {
-    Mesh* mesh = (Mesh*) malloc(sizeof(Mesh));
+    Mesh* mesh = (Mesh*) pool_alloc(&mesh_pool);
     if (mesh == NULL) {
         console_error("Failed to allocate memory for mesh creation.");
         return NULL;
@@ -82,7 +126,11 @@ Mesh* mesh_create(float* vertices, unsigned int verticesSize, unsigned int* indi
     mesh->indicesLength = indicesSize / sizeof(int);
     mesh->stride = vertexLength * sizeof(float);
     mesh->texture = 0; // by default no texture is assigned
+    mesh->textureTarget = GL_TEXTURE_2D;
     mesh->textureUnit = 0; // by default is texture unit 0
+    mesh->sampler = 0; // by default no sampler is assigned
+    mesh_setSingleLod(mesh);
+    mesh_computeBounds(mesh, vertices, verticesSize, vertexLength);
 
     // generate VAO and assign it to the mesh
     unsigned int vao;
@@ -97,12 +145,16 @@ Mesh* mesh_create(float* vertices, unsigned int verticesSize, unsigned int* indi
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, verticesSize, vertices, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += verticesSize;
+    memory_trackGpu(MEMORY_GPU_BUFFER, vbo, MEMORY_TAG_MESH, verticesSize);
 
     // generate EBO and assign it to the mesh
     unsigned int ebo;
     glGenBuffers(1, &ebo);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indicesSize, indices, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += indicesSize;
+    memory_trackGpu(MEMORY_GPU_BUFFER, ebo, MEMORY_TAG_MESH, indicesSize);
 
     // unbind the mesh VAO
     glBindVertexArray(0);
@@ -119,19 +171,135 @@ Mesh* mesh_create(float* vertices, unsigned int verticesSize, unsigned int* indi
     return mesh;
 }
 
+/*
+Loads a mesh from a binary mesh file (see meshfile.h and the meshconv tool) and returns a pointer to it.
+The file is mapped and its vertex and index blobs are uploaded as they are, and its vertex attributes are registered
+from the file layout, so the mesh is ready to be rendered.
+You MUST call mesh_destroy(Mesh*) once the mesh is not used anymore
+Parameters:
+    - path (char*): the mesh file path ("./file" means it is in "g3ce")
+Returns:
+    The pointer to the mesh struct that has been created (NULL if the file could not be loaded)
+*/
+Mesh* mesh_load(char* path) {
+    PROFILE_FUNCTION();
+
+    FileView view;
+    if (!file_map(path, &view)) return NULL;
+    // the blobs are read once from start to end by the driver
+    file_advise(&view, FILE_ACCESS_SEQUENTIAL);
+
+    MeshFile file;
+    if (!meshfile_parse(view.data, view.size, &file)) {
+        console_error("Failed to load mesh at \"%s\"", path);
+        file_unmap(&view);
+        return NULL;
+    }
+    const MeshFileHeader* header = file.header;
+
+    Mesh* mesh = (Mesh*) pool_alloc(&mesh_pool);
+    if (mesh == NULL) {
+        console_error("Failed to allocate memory for mesh \"%s\"", path);
+        file_unmap(&view);
+        return NULL;
+    }
+
+    mesh->drawMode = header->drawMode;
+    mesh->lastOffset = header->vertexStride;
+    mesh->indicesLength = file.lods[0].indexCount;
+    mesh->stride = header->vertexStride;
+    mesh->texture = 0; // by default no texture is assigned
+    mesh->textureTarget = GL_TEXTURE_2D;
+    mesh->textureUnit = 0; // by default is texture unit 0
+    mesh->sampler = 0; // by default no sampler is assigned
+    mesh->indexType = header->indexSize == 2 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh->indexOffset = file.lods[0].indexStart * header->indexSize;
+    for (unsigned int c = 0; c < 3; c++) {
+        mesh->boundsMin[c] = header->boundsMin[c];
+        mesh->boundsMax[c] = header->boundsMax[c];
+    }
+    mesh->lodCount = header->lodCount;
+    for (unsigned int i = 0; i < header->lodCount; i++) mesh->lods[i] = file.lods[i];
+
+    glGenVertexArrays(1, &(mesh->vao));
+    glBindVertexArray(mesh->vao);
+
+    // upload the blobs straight from the mapped file
+    glGenBuffers(1, &(mesh->vbo));
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) header->vertexCount * header->vertexStride, file.vertices, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += (unsigned long long) header->vertexCount * header->vertexStride;
+    memory_trackGpu(MEMORY_GPU_BUFFER, mesh->vbo, MEMORY_TAG_MESH, (size_t) header->vertexCount * header->vertexStride);
+
+    glGenBuffers(1, &(mesh->ebo));
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr) header->indexCount * header->indexSize, file.indices, GL_STATIC_DRAW);
+    renderStats.bufferBytesUploaded += (unsigned long long) header->indexCount * header->indexSize;
+    memory_trackGpu(MEMORY_GPU_BUFFER, mesh->ebo, MEMORY_TAG_MESH, (size_t) header->indexCount * header->indexSize);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    for (unsigned int i = 0; i < header->attributeCount; i++) {
+        const MeshFileAttribute* attribute = &file.attributes[i];
+        mesh_registerVertexAttributeEx(mesh, attribute->location, attribute->components, attribute->type, attribute->normalized != 0, 0, attribute->offset);
+    }
+
+    // the data has been copied by the driver, the file is not needed anymore
+    file_unmap(&view);
+
+    return mesh;
+}
+
+/*
+Creates a mesh from a model loaded by obj_load() and returns a pointer to it (the model can be freed right after).
+The vertex attributes are registered at the MESHFILE_LOCATION_* locations (see obj.h for the vertex layout).
+You MUST call mesh_destroy(Mesh*) once the mesh is not used anymore
+Parameters:
+    - model (ObjModel*): the loaded model
+Returns:
+    The pointer to the mesh struct that has been created (NULL on failure)
+*/
+Mesh* mesh_createFromObj(ObjModel* model) {
+    Mesh* mesh = mesh_create(model->vertices, model->vertexCount * model->vertexLength * sizeof(float), model->indices, model->indexCount * sizeof(unsigned int), model->vertexLength, GL_TRIANGLES);
+    if (mesh == NULL) return NULL;
+
+    // the offsets follow the registration order, so the attributes must be registered as they are laid out
+    mesh_registerVertexAttribute(mesh, MESHFILE_LOCATION_POSITION, 3);
+    mesh_registerVertexAttribute(mesh, MESHFILE_LOCATION_COLOR, 4);
+    if (model->hasUvs) mesh_registerVertexAttribute(mesh, MESHFILE_LOCATION_UV, 2);
+    if (model->hasNormals) mesh_registerVertexAttribute(mesh, MESHFILE_LOCATION_NORMAL, 3);
+
+    return mesh;
+}
+
 /*
 Destroys the given mesh object.
 Parameters:
     - mesh (Mesh*): the mesh to destroy
 */
 void mesh_destroy(Mesh* mesh) {
-    glDeleteBuffers(GL_ARRAY_BUFFER, &(mesh->vbo));
-    glDeleteBuffers(GL_ELEMENT_ARRAY_BUFFER, &(mesh->ebo));
+    mesh_delete(mesh);
+    pool_free(&mesh_pool, mesh);
+}
+/*
+Deletes the OpenGL objects of the given mesh (its buffers, its vertex array and its texture, if any) without freeing the mesh itself,
+so it is the way to destroy a stack allocated mesh (see mesh_new()).
+Parameters:
+    - mesh (Mesh*): the mesh whose OpenGL objects are deleted
+*/
+void mesh_delete(Mesh* mesh) {
+    memory_untrackGpu(MEMORY_GPU_BUFFER, mesh->vbo);
+    memory_untrackGpu(MEMORY_GPU_BUFFER, mesh->ebo);
+    glDeleteBuffers(1, &(mesh->vbo));
+    glDeleteBuffers(1, &(mesh->ebo));
     glDeleteVertexArrays(1, &(mesh->vao));
 
-    if (mesh->texture > 0) glDeleteTextures(1, &(mesh->texture));
-
-    free(mesh);
+    if (mesh->texture > 0) {
+        memory_untrackGpu(MEMORY_GPU_TEXTURE, mesh->texture);
+        glDeleteTextures(1, &(mesh->texture));
+    }
 }
 
 /*
@@ -161,6 +329,49 @@ void mesh_registerVertexAttribute(Mesh* mesh, unsigned int attributeLocation, un
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+/*
+Registers a vertex attribute of any type at an explicit offset and stride for the given mesh.
+Parameters:
+    - mesh (Mesh*): the pointer to the mesh to associate the new vertex attribute
+    - attributeLocation (unsigned int): the attribute location in the shader
+    - size (unsigned int): number of components of the attribute (1 to 4)
+    - type (unsigned int): the type of the components (GL_FLOAT, GL_UNSIGNED_BYTE, etc...)
+    - normalized (bool): whether integer types are mapped to [0, 1] ([-1, 1] if signed) or converted as they are
+    - stride (unsigned int): the distance in bytes between two consecutive attributes (0 uses the mesh stride)
+    - offset (unsigned int): offset in bytes of the attribute from the start of the vertex
+*/
+void mesh_registerVertexAttributeEx(Mesh* mesh, unsigned int attributeLocation, unsigned int size, unsigned int type, bool normalized, unsigned int stride, unsigned int offset) {
+    glBindVertexArray(mesh->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
+
+    glVertexAttribPointer(attributeLocation, size, type, normalized ? GL_TRUE : GL_FALSE, stride > 0 ? stride : mesh->stride, (void*) (uintptr_t) offset);
+    glEnableVertexAttribArray(attributeLocation);
+
+    glBindVertexArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/*
+Selects the level of detail to render (0 is the full detail one).
+Parameters:
+    - mesh (Mesh*): the mesh
+    - lod (unsigned int): the LOD index (it is clamped to the LODs of the mesh)
+*/
+void mesh_selectLod(Mesh* mesh, unsigned int lod) {
+    if (lod >= mesh->lodCount) lod = mesh->lodCount - 1;
+    const unsigned int indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? 2 : 4;
+    mesh->indicesLength = mesh->lods[lod].indexCount;
+    mesh->indexOffset = mesh->lods[lod].indexStart * indexSize;
+}
+
+// returns the LOD to use at the given distance from the camera (the last one whose distance is not greater than the given one)
+unsigned int mesh_getLodForDistance(Mesh* mesh, float distance) {
+    unsigned int lod = 0;
+    while (lod + 1 < mesh->lodCount && mesh->lods[lod + 1].distance <= distance) lod++;
+    return lod;
+}
+
 /*
 Assings a texture to a given mesh via a texture id (this means that the texture will be automatically bound when rendering the mesh via renderer_renderMesh()).
 Parameters:
@@ -173,5 +384,33 @@ void mesh_assignTexture(Mesh* mesh, unsigned int texture, unsigned int unit) {
         return;
     }
     mesh->texture = texture;
+    mesh->textureTarget = GL_TEXTURE_2D;
     mesh->textureUnit = unit;
+}
+
+/*
+Assings a texture array to a given mesh via a texture id (this means that the texture array will be automatically bound when rendering the mesh via renderer_renderMesh()).
+The layer to sample can be provided per-vertex by registering a 1 float vertex attribute holding the layer index.
+Parameters:
+    - texture (unsigned int): the texture array id (see texture_createArray())
+    - unit (unsigned int): the texture unit to attach the texture array to
+*/
+void mesh_assignTextureArray(Mesh* mesh, unsigned int texture, unsigned int unit) {
+    if (unit > 32) {
+        console_warning("Invalid texture unit for %u. There are a total number of 32 texture units", unit);
+        return;
+    }
+    mesh->texture = texture;
+    mesh->textureTarget = GL_TEXTURE_2D_ARRAY;
+    mesh->textureUnit = unit;
+}
+
+/*
+Assigns a sampler to a given mesh (this means that the sampler will be automatically bound to the mesh texture unit when rendering the mesh via renderer_renderMesh()).
+The sampler is NOT destroyed when destroying the mesh, as it is meant to be shared between meshes.
+Parameters:
+    - sampler (unsigned int): the sampler id (see sampler_create()), 0 removes the assigned sampler
+*/
+void mesh_assignSampler(Mesh* mesh, unsigned int sampler) {
+    mesh->sampler = sampler;
 }
\ No newline at end of file
@@ -0,0 +1,241 @@
+/*
+MESHFILE:
+Binary mesh format (".g3mesh") reader/writer.
+The vertex and index data are stored exactly as the GPU consumes them, so loading a mesh (see mesh_load()) is just mapping
+the file and handing the blobs to OpenGL, without parsing a single vertex.
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools
+(the type and draw mode values are the OpenGL ones, so they are defined here too).
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <float.h>
+
+#include "engine/utils/file.h"
+#include "engine/utils/console.h"
+
+#include "engine/gfx/meshfile.h"
+
+// returns the given offset rounded up to the next MESHFILE_ALIGNMENT multiple
+static uint64_t meshfile_align(uint64_t offset) {
+    return (offset + MESHFILE_ALIGNMENT - 1) / MESHFILE_ALIGNMENT * MESHFILE_ALIGNMENT;
+}
+
+// returns the size in bytes of a component type (0 if it is not a valid one)
+unsigned int meshfile_getTypeSize(uint32_t type) {
+    switch (type) {
+        case MESHFILE_TYPE_BYTE:
+        case MESHFILE_TYPE_UNSIGNED_BYTE: return 1;
+        case MESHFILE_TYPE_SHORT:
+        case MESHFILE_TYPE_UNSIGNED_SHORT:
+        case MESHFILE_TYPE_HALF_FLOAT: return 2;
+        case MESHFILE_TYPE_INT:
+        case MESHFILE_TYPE_UNSIGNED_INT:
+        case MESHFILE_TYPE_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+// returns whether a draw mode is one of the OpenGL primitives (GL_POINTS to GL_TRIANGLE_FAN)
+static bool meshfile_isDrawMode(uint32_t drawMode) {
+    return drawMode <= 0x0006;
+}
+
+// returns the first index of a blob that is not below the vertex count (indexCount if they all are)
+static uint32_t meshfile_findInvalidIndex(const unsigned char* indices, uint32_t indexCount, uint32_t indexSize, uint32_t vertexCount) {
+    if (indexSize == 2) {
+        const uint16_t* indices16 = (const uint16_t*) indices;
+        for (uint32_t i = 0; i < indexCount; i++) if (indices16[i] >= vertexCount) return i;
+    } else {
+        const uint32_t* indices32 = (const uint32_t*) indices;
+        for (uint32_t i = 0; i < indexCount; i++) if (indices32[i] >= vertexCount) return i;
+    }
+    return indexCount;
+}
+
+/*
+Parses a mesh file that has already been loaded (or mapped) into memory, validating all its offsets and sizes,
+its draw mode and its indices (which must all refer to a vertex of the file, so the GPU never reads outside of the vertex buffer).
+The resulting mesh file points straight into the given memory, so it must outlive it.
+Parameters:
+    - data (unsigned char*): the file content (it must be at least 8 bytes aligned, as mapped and allocated memory is)
+    - size (size_t): the file size in bytes
+    - file (MeshFile*): where to store the parsed mesh file
+Returns:
+    true on success, false if the file is not a valid mesh file
+*/
+bool meshfile_parse(const unsigned char* data, size_t size, MeshFile* file) {
+    const MeshFileHeader* header = (const MeshFileHeader*) data;
+    if (size < sizeof(MeshFileHeader) || memcmp(header->magic, MESHFILE_MAGIC, 4) != 0) {
+        console_error("Invalid mesh file header");
+        return false;
+    }
+    if (header->version != MESHFILE_VERSION) {
+        console_error("Unsupported mesh file version %u (expected %u)", header->version, MESHFILE_VERSION);
+        return false;
+    }
+    if (header->attributeCount == 0 || header->attributeCount > MESHFILE_MAX_ATTRIBUTES || header->lodCount == 0 || header->lodCount > MESHFILE_MAX_LODS) {
+        console_error("Invalid mesh file layout (%u attributes, %u LODs)", header->attributeCount, header->lodCount);
+        return false;
+    }
+    if (header->indexSize != 2 && header->indexSize != 4) {
+        console_error("Invalid mesh file index size %u", header->indexSize);
+        return false;
+    }
+    if (!meshfile_isDrawMode(header->drawMode)) {
+        console_error("Invalid mesh file draw mode 0x%X", header->drawMode);
+        return false;
+    }
+
+    // the tables follow the header, the blobs can be anywhere after them
+    const uint64_t tablesEnd = sizeof(MeshFileHeader) + header->attributeCount * sizeof(MeshFileAttribute) + header->lodCount * sizeof(MeshFileLod);
+    const uint64_t vertexBytes = (uint64_t) header->vertexCount * header->vertexStride;
+    const uint64_t indexBytes = (uint64_t) header->indexCount * header->indexSize;
+    if (tablesEnd > size || header->vertexOffset < tablesEnd || header->vertexOffset > size || vertexBytes > size - header->vertexOffset
+        || header->indexOffset < tablesEnd || header->indexOffset > size || indexBytes > size - header->indexOffset) {
+        console_error("Truncated mesh file");
+        return false;
+    }
+    // the indices are read in place (the blobs are MESHFILE_ALIGNMENT bytes aligned by meshfile_write())
+    if (header->indexOffset % header->indexSize != 0) {
+        console_error("Misaligned mesh file index blob");
+        return false;
+    }
+
+    file->header = header;
+    file->attributes = (const MeshFileAttribute*) (data + sizeof(MeshFileHeader));
+    file->lods = (const MeshFileLod*) (data + sizeof(MeshFileHeader) + header->attributeCount * sizeof(MeshFileAttribute));
+    file->vertices = data + header->vertexOffset;
+    file->indices = data + header->indexOffset;
+
+    for (uint32_t i = 0; i < header->attributeCount; i++) {
+        const MeshFileAttribute* attribute = &file->attributes[i];
+        const unsigned int typeSize = meshfile_getTypeSize(attribute->type);
+        if (typeSize == 0 || attribute->components == 0 || attribute->components > 4 || (uint64_t) attribute->offset + (uint64_t) attribute->components * typeSize > header->vertexStride) {
+            console_error("Invalid mesh file attribute %u", i);
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < header->lodCount; i++) {
+        const MeshFileLod* lod = &file->lods[i];
+        if ((uint64_t) lod->indexStart + lod->indexCount > header->indexCount) {
+            console_error("Invalid mesh file LOD %u", i);
+            return false;
+        }
+    }
+    const uint32_t invalidIndex = meshfile_findInvalidIndex(file->indices, header->indexCount, header->indexSize, header->vertexCount);
+    if (invalidIndex < header->indexCount) {
+        console_error("Invalid mesh file index at position %u (the mesh has %u vertices)", invalidIndex, header->vertexCount);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+Writes a mesh file at the given path ("./file" means it is in "g3ce").
+The bounds are computed from the attribute at MESHFILE_LOCATION_POSITION (which must be made of 3 floats).
+Parameters:
+    - path (char*): the output file path
+    - attributes (MeshFileAttribute*): the vertex layout
+    - attributeCount (unsigned int): the number of attributes
+    - vertices (void*): the interleaved vertices
+    - vertexCount (unsigned int): the number of vertices
+    - vertexStride (unsigned int): the size of a vertex in bytes
+    - indices (uint32_t*): the indices of all the LODs (they are stored as 16 bits indices when possible)
+    - lods (MeshFileLod*): the LOD table
+    - lodCount (unsigned int): the number of LODs
+    - drawMode (uint32_t): MESHFILE_DRAW_* (or any other OpenGL primitive)
+Returns:
+    true on success, false otherwise (e.g. an index is not below the vertex count)
+*/
+bool meshfile_write(char* path, const MeshFileAttribute* attributes, unsigned int attributeCount, const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+    const uint32_t* indices, const MeshFileLod* lods, unsigned int lodCount, uint32_t drawMode) {
+    if (attributeCount == 0 || attributeCount > MESHFILE_MAX_ATTRIBUTES || lodCount == 0 || lodCount > MESHFILE_MAX_LODS) {
+        console_error("Invalid mesh layout (%u attributes, %u LODs)", attributeCount, lodCount);
+        return false;
+    }
+    if (!meshfile_isDrawMode(drawMode)) {
+        console_error("Invalid mesh draw mode 0x%X", drawMode);
+        return false;
+    }
+
+    MeshFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESHFILE_MAGIC, 4);
+    header.version = MESHFILE_VERSION;
+    header.attributeCount = attributeCount;
+    header.lodCount = lodCount;
+    header.vertexCount = vertexCount;
+    header.vertexStride = vertexStride;
+    header.indexSize = vertexCount <= 65536 ? 2 : 4;
+    header.drawMode = drawMode;
+    for (unsigned int i = 0; i < lodCount; i++) {
+        if (lods[i].indexStart + lods[i].indexCount > header.indexCount) header.indexCount = lods[i].indexStart + lods[i].indexCount;
+    }
+    // the loader rejects them anyway, better to know it when writing
+    const uint32_t invalidIndex = meshfile_findInvalidIndex((const unsigned char*) indices, header.indexCount, 4, vertexCount);
+    if (invalidIndex < header.indexCount) {
+        console_error("Invalid mesh index at position %u (the mesh has %u vertices)", invalidIndex, vertexCount);
+        return false;
+    }
+
+    // bounds
+    const MeshFileAttribute* position = NULL;
+    for (unsigned int i = 0; i < attributeCount; i++) {
+        if (attributes[i].location == MESHFILE_LOCATION_POSITION && attributes[i].type == MESHFILE_TYPE_FLOAT && attributes[i].components == 3) position = &attributes[i];
+    }
+    for (unsigned int c = 0; c < 3; c++) {
+        header.boundsMin[c] = vertexCount > 0 && position != NULL ? FLT_MAX : 0.0f;
+        header.boundsMax[c] = vertexCount > 0 && position != NULL ? -FLT_MAX : 0.0f;
+    }
+    for (unsigned int i = 0; position != NULL && i < vertexCount; i++) {
+        float value[3];
+        memcpy(value, (const unsigned char*) vertices + (size_t) i * vertexStride + position->offset, sizeof(value));
+        for (unsigned int c = 0; c < 3; c++) {
+            if (value[c] < header.boundsMin[c]) header.boundsMin[c] = value[c];
+            if (value[c] > header.boundsMax[c]) header.boundsMax[c] = value[c];
+        }
+    }
+
+    const uint64_t tablesEnd = sizeof(MeshFileHeader) + attributeCount * sizeof(MeshFileAttribute) + lodCount * sizeof(MeshFileLod);
+    header.vertexOffset = meshfile_align(tablesEnd);
+    header.indexOffset = meshfile_align(header.vertexOffset + (uint64_t) vertexCount * vertexStride);
+
+    // narrow the indices if they fit in 16 bits
+    const size_t indexBytes = (size_t) header.indexCount * header.indexSize;
+    unsigned char* indexBlob = (unsigned char*) malloc(indexBytes > 0 ? indexBytes : 1);
+    if (indexBlob == NULL) {
+        console_error("Failed to allocate memory for the indices of mesh file \"%s\"", path);
+        return false;
+    }
+    if (header.indexSize == 2) {
+        for (uint32_t i = 0; i < header.indexCount; i++) {
+            const uint16_t index = (uint16_t) indices[i];
+            memcpy(indexBlob + i * 2, &index, 2);
+        }
+    } else {
+        memcpy(indexBlob, indices, indexBytes);
+    }
+
+    FILE* file = file_open(path, "wb");
+    if (file == NULL) {
+        free(indexBlob);
+        return false;
+    }
+
+    static const unsigned char padding[MESHFILE_ALIGNMENT] = { 0 };
+    const size_t vertexBytes = (size_t) vertexCount * vertexStride;
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1
+        && fwrite(attributes, sizeof(MeshFileAttribute), attributeCount, file) == attributeCount
+        && fwrite(lods, sizeof(MeshFileLod), lodCount, file) == lodCount
+        && fwrite(padding, 1, header.vertexOffset - tablesEnd, file) == header.vertexOffset - tablesEnd
+        && fwrite(vertices, 1, vertexBytes, file) == vertexBytes
+        && fwrite(padding, 1, header.indexOffset - header.vertexOffset - vertexBytes, file) == header.indexOffset - header.vertexOffset - vertexBytes
+        && fwrite(indexBlob, 1, indexBytes, file) == indexBytes;
+    fclose(file);
+    free(indexBlob);
+
+    if (!success) console_error("Failed to write mesh file at \"%s\"", path);
+    return success;
+}
@@ -0,0 +1,350 @@
+/*
+MIPMAP:
+CPU mip chain generator for RGBA8 images (box and Kaiser filters, optionally gamma-correct for sRGB images).
+The filtering is done in floating point (SSE2 or AVX2 when the compiler targets them, plain C otherwise).
+This module does not depend on OpenGL and does not use any global state, so it can run on any thread
+(e.g. while loading textures in the background) and it can also be used by the offline tools.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "engine/utils/console.h"
+#include "engine/utils/memory.h"
+
+#include "engine/gfx/mipmap.h"
+
+// the Kaiser filter covers 2 pixels of the destination level on each side of the pixel center,
+// meaning 8 taps on the source level (the source pixel centers are at -3.5, -2.5, ..., +3.5 from the destination one)
+#define MIPMAP_KAISER_TAPS 8
+#define MIPMAP_KAISER_FIRST_TAP -3
+#define MIPMAP_KAISER_RADIUS 2.0
+#define MIPMAP_KAISER_ALPHA 4.0
+
+// sRGB <-> linear conversion tables (they are built for every chain, it only takes a few hundred pow() calls)
+typedef struct {
+    float decode[256];     // byte -> linear value
+    float thresholds[255]; // linear value halfway (in sRGB space) between two consecutive bytes
+} MipmapSrgbTables;
+
+static double mipmap_srgbToLinear(double value) {
+    return value <= 0.04045 ? value / 12.92 : pow((value + 0.055) / 1.055, 2.4);
+}
+
+static void mipmap_buildSrgbTables(MipmapSrgbTables* tables) {
+    for (unsigned int i = 0; i < 256; i++) tables->decode[i] = (float) mipmap_srgbToLinear(i / 255.0);
+    for (unsigned int i = 0; i < 255; i++) tables->thresholds[i] = (float) mipmap_srgbToLinear((i + 0.5) / 255.0);
+}
+
+// converts RGBA8 pixels to linear RGBA floats
+static void mipmap_toFloat(const unsigned char* pixels, size_t pixelCount, const MipmapSrgbTables* tables, float* output) {
+    for (size_t i = 0; i < pixelCount * 4; i++) {
+        // alpha is never gamma encoded
+        if (tables != NULL && (i & 3) != 3) output[i] = tables->decode[pixels[i]];
+        else output[i] = pixels[i] * (1.0f / 255.0f);
+    }
+}
+
+// converts linear RGBA floats back to RGBA8 pixels (clamping them, the Kaiser filter can overshoot)
+static void mipmap_toBytes(const float* values, size_t pixelCount, const MipmapSrgbTables* tables, unsigned char* output) {
+    for (size_t i = 0; i < pixelCount * 4; i++) {
+        float value = values[i];
+        if (value < 0.0f) value = 0.0f;
+        if (value > 1.0f) value = 1.0f;
+
+        if (tables != NULL && (i & 3) != 3) {
+            // binary search of the number of thresholds below the value, that is the nearest byte in sRGB space
+            unsigned int byte = 0;
+            for (unsigned int step = 128; step > 0; step >>= 1) {
+                if (byte + step <= 255 && value >= tables->thresholds[byte + step - 1]) byte += step;
+            }
+            output[i] = (unsigned char) byte;
+        } else {
+            output[i] = (unsigned char) (value * 255.0f + 0.5f);
+        }
+    }
+}
+
+// averages a block of countX x countY pixels of a linear RGBA float image into a pixel
+static void mipmap_averageBlock(const float* source, unsigned int width, unsigned int x0, unsigned int y0, unsigned int countX, unsigned int countY, float* output) {
+    float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (unsigned int y = y0; y < y0 + countY; y++) {
+        for (unsigned int x = x0; x < x0 + countX; x++) {
+            for (unsigned int c = 0; c < 4; c++) sum[c] += source[((size_t) y * width + x) * 4 + c];
+        }
+    }
+    const float scale = 1.0f / (float) (countX * countY);
+    for (unsigned int c = 0; c < 4; c++) output[c] = sum[c] * scale;
+}
+
+// halves a linear RGBA float image averaging 2x2 pixels (for odd sizes the last column and row are folded into the last pixels, averaging 3 of them)
+static void mipmap_downsampleBox(const float* source, unsigned int width, unsigned int height, float* destination) {
+    const unsigned int halfWidth = width > 1 ? width / 2 : 1;
+    const unsigned int halfHeight = height > 1 ? height / 2 : 1;
+
+    for (unsigned int y = 0; y < halfHeight; y++) {
+        const float* row0 = source + (size_t) (y * 2) * width * 4;
+        const float* row1 = source + (size_t) (y * 2 + 1 < height ? y * 2 + 1 : y * 2) * width * 4;
+        float* output = destination + (size_t) y * halfWidth * 4;
+
+        unsigned int x = 0;
+#if defined(__AVX2__)
+        // two destination pixels (four source pixels per row) at a time
+        const __m256 quarter8 = _mm256_set1_ps(0.25f);
+        for (; x + 1 < halfWidth && x * 2 + 3 < width; x += 2) {
+            const __m256 a = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8), _mm256_loadu_ps(row1 + x * 8));
+            const __m256 b = _mm256_add_ps(_mm256_loadu_ps(row0 + x * 8 + 8), _mm256_loadu_ps(row1 + x * 8 + 8));
+            // put the left pixels of both pairs in one register and the right ones in another
+            const __m256 left = _mm256_permute2f128_ps(a, b, 0x20);
+            const __m256 right = _mm256_permute2f128_ps(a, b, 0x31);
+            _mm256_storeu_ps(output + x * 4, _mm256_mul_ps(_mm256_add_ps(left, right), quarter8));
+        }
+#endif
+        for (; x < halfWidth; x++) {
+            const unsigned int x0 = x * 2;
+            const unsigned int x1 = x0 + 1 < width ? x0 + 1 : x0;
+#if defined(__SSE2__)
+            const __m128 sum = _mm_add_ps(
+                _mm_add_ps(_mm_loadu_ps(row0 + x0 * 4), _mm_loadu_ps(row0 + x1 * 4)),
+                _mm_add_ps(_mm_loadu_ps(row1 + x0 * 4), _mm_loadu_ps(row1 + x1 * 4))
+            );
+            _mm_storeu_ps(output + x * 4, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+            for (unsigned int c = 0; c < 4; c++) {
+                output[x * 4 + c] = (row0[x0 * 4 + c] + row0[x1 * 4 + c] + row1[x0 * 4 + c] + row1[x1 * 4 + c]) * 0.25f;
+            }
+#endif
+        }
+    }
+
+    // the last column and row of odd sizes (the ones above skipped them)
+    const bool oddWidth = width > 1 && (width & 1) != 0;
+    const bool oddHeight = height > 1 && (height & 1) != 0;
+    const unsigned int blockWidth = width > 1 ? 2 : 1;
+    const unsigned int blockHeight = height > 1 ? 2 : 1;
+    if (oddWidth) {
+        for (unsigned int y = 0; y < halfHeight; y++) {
+            const unsigned int countY = oddHeight && y == halfHeight - 1 ? 3 : blockHeight;
+            mipmap_averageBlock(source, width, (halfWidth - 1) * 2, y * 2, 3, countY, destination + ((size_t) y * halfWidth + halfWidth - 1) * 4);
+        }
+    }
+    if (oddHeight) {
+        // (the corner was done with the last column)
+        for (unsigned int x = 0; x < (oddWidth ? halfWidth - 1 : halfWidth); x++) {
+            mipmap_averageBlock(source, width, x * 2, (halfHeight - 1) * 2, blockWidth, 3, destination + ((size_t) (halfHeight - 1) * halfWidth + x) * 4);
+        }
+    }
+}
+
+// zeroth order modified Bessel function of the first kind (series expansion)
+static double mipmap_besselI0(double x) {
+    double sum = 1.0, term = 1.0;
+    for (unsigned int k = 1; k < 32; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+// computes the (normalized) weights of the Kaiser windowed sinc taps
+static void mipmap_buildKaiserWeights(float weights[MIPMAP_KAISER_TAPS]) {
+    const double pi = 3.14159265358979323846;
+    double total = 0.0;
+    double values[MIPMAP_KAISER_TAPS];
+    for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) {
+        // distance from the destination pixel center, in destination pixels
+        const double t = ((MIPMAP_KAISER_FIRST_TAP + k) - 0.5) / 2.0;
+        const double sinc = t == 0.0 ? 1.0 : sin(pi * t) / (pi * t);
+        const double window = t / MIPMAP_KAISER_RADIUS;
+        const double kaiser = mipmap_besselI0(MIPMAP_KAISER_ALPHA * sqrt(1.0 - window * window)) / mipmap_besselI0(MIPMAP_KAISER_ALPHA);
+        values[k] = sinc * kaiser;
+        total += values[k];
+    }
+    for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) weights[k] = (float) (values[k] / total);
+}
+
+// clamps a source coordinate of a tap to the image (edge pixels are repeated)
+static unsigned int mipmap_clampTap(int coordinate, unsigned int size) {
+    if (coordinate < 0) return 0;
+    if ((unsigned int) coordinate >= size) return size - 1;
+    return coordinate;
+}
+
+// halves a linear RGBA float image with a separable Kaiser filter (horizontal pass into temporary, then vertical pass)
+static void mipmap_downsampleKaiser(const float* source, unsigned int width, unsigned int height, const float weights[MIPMAP_KAISER_TAPS], float* temporary, float* destination) {
+    const unsigned int halfWidth = width > 1 ? width / 2 : 1;
+    const unsigned int halfHeight = height > 1 ? height / 2 : 1;
+
+    // horizontal pass (width x height -> halfWidth x height), one RGBA pixel per vector
+    for (unsigned int y = 0; y < height; y++) {
+        const float* row = source + (size_t) y * width * 4;
+        float* output = temporary + (size_t) y * halfWidth * 4;
+        for (unsigned int x = 0; x < halfWidth; x++) {
+#if defined(__SSE2__)
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) {
+                const unsigned int tap = mipmap_clampTap((int) x * 2 + MIPMAP_KAISER_FIRST_TAP + k, width);
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(row + tap * 4), _mm_set1_ps(weights[k])));
+            }
+            _mm_storeu_ps(output + x * 4, sum);
+#else
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) {
+                const unsigned int tap = mipmap_clampTap((int) x * 2 + MIPMAP_KAISER_FIRST_TAP + k, width);
+                for (unsigned int c = 0; c < 4; c++) sum[c] += row[tap * 4 + c] * weights[k];
+            }
+            for (unsigned int c = 0; c < 4; c++) output[x * 4 + c] = sum[c];
+#endif
+        }
+    }
+
+    // vertical pass (halfWidth x height -> halfWidth x halfHeight), whole rows are combined so it is plain vector math
+    const size_t rowLength = (size_t) halfWidth * 4;
+    for (unsigned int y = 0; y < halfHeight; y++) {
+        const float* rows[MIPMAP_KAISER_TAPS];
+        for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) {
+            rows[k] = temporary + mipmap_clampTap((int) y * 2 + MIPMAP_KAISER_FIRST_TAP + k, height) * rowLength;
+        }
+        float* output = destination + y * rowLength;
+
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 8 <= rowLength; i += 8) {
+            __m256 sum = _mm256_setzero_ps();
+            for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) {
+                sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(rows[k] + i), _mm256_set1_ps(weights[k])));
+            }
+            _mm256_storeu_ps(output + i, sum);
+        }
+#endif
+#if defined(__SSE2__)
+        for (; i + 4 <= rowLength; i += 4) {
+            __m128 sum = _mm_setzero_ps();
+            for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) {
+                sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), _mm_set1_ps(weights[k])));
+            }
+            _mm_storeu_ps(output + i, sum);
+        }
+#endif
+        for (; i < rowLength; i++) {
+            float sum = 0.0f;
+            for (int k = 0; k < MIPMAP_KAISER_TAPS; k++) sum += rows[k][i] * weights[k];
+            output[i] = sum;
+        }
+    }
+}
+
+/*
+Generates the whole mip chain (down to 1x1) of an RGBA8 image.
+Every level is computed from the previous one in floating point, so the rounding errors do not add up along the chain.
+REMEMBER TO FREE IT BY CALLING mipmap_free()!
+Parameters:
+    - pixels (unsigned char*): the RGBA8 pixels of the full size image (width * height * 4 bytes, rows are tightly packed)
+    - width (unsigned int): the image width
+    - height (unsigned int): the image height
+    - filter (MipmapFilter): the downsampling filter
+    - srgb (bool): whether the RGB channels are sRGB encoded (they get filtered in linear space, alpha is always linear)
+    - chain (MipChain*): where to store the mip chain (the first level is a copy of the given image)
+Returns:
+    true on success, false otherwise
+*/
+bool mipmap_generate(const unsigned char* pixels, unsigned int width, unsigned int height, MipmapFilter filter, bool srgb, MipChain* chain) {
+    memset(chain, 0, sizeof(MipChain));
+    if (width == 0 || height == 0) {
+        console_error("Cannot generate the mip chain of an empty image");
+        return false;
+    }
+
+    // lay out all the levels in a single allocation
+    chain->levelCount = mipmap_getLevelCount(width, height);
+    size_t totalSize = 0;
+    unsigned int levelWidth = width, levelHeight = height;
+    for (unsigned int i = 0; i < chain->levelCount; i++) {
+        chain->levels[i].width = levelWidth;
+        chain->levels[i].height = levelHeight;
+        totalSize += (size_t) levelWidth * levelHeight * 4;
+        levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+        levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+    }
+
+    const unsigned int halfWidth = width > 1 ? width / 2 : 1;
+    const unsigned int halfHeight = height > 1 ? height / 2 : 1;
+    chain->memory = (unsigned char*) memory_alloc(MEMORY_TAG_TEXTURE, totalSize);
+    // the current level in floating point, the next one, and the Kaiser horizontal pass output
+    float* current = (float*) memory_alloc(MEMORY_TAG_TEXTURE, (size_t) width * height * 4 * sizeof(float));
+    float* next = (float*) memory_alloc(MEMORY_TAG_TEXTURE, (size_t) halfWidth * halfHeight * 4 * sizeof(float));
+    float* temporary = filter == MIPMAP_FILTER_KAISER ? (float*) memory_alloc(MEMORY_TAG_TEXTURE, (size_t) halfWidth * height * 4 * sizeof(float)) : NULL;
+    if (chain->memory == NULL || current == NULL || next == NULL || (filter == MIPMAP_FILTER_KAISER && temporary == NULL)) {
+        console_error("Failed to allocate memory for a %ux%u mip chain", width, height);
+        memory_free(current);
+        memory_free(next);
+        memory_free(temporary);
+        mipmap_free(chain);
+        return false;
+    }
+
+    size_t offset = 0;
+    for (unsigned int i = 0; i < chain->levelCount; i++) {
+        chain->levels[i].data = chain->memory + offset;
+        offset += (size_t) chain->levels[i].width * chain->levels[i].height * 4;
+    }
+    memcpy(chain->levels[0].data, pixels, (size_t) width * height * 4);
+
+    MipmapSrgbTables tables;
+    if (srgb) mipmap_buildSrgbTables(&tables);
+    float weights[MIPMAP_KAISER_TAPS];
+    if (filter == MIPMAP_FILTER_KAISER) mipmap_buildKaiserWeights(weights);
+
+    mipmap_toFloat(pixels, (size_t) width * height, srgb ? &tables : NULL, current);
+    for (unsigned int i = 1; i < chain->levelCount; i++) {
+        const MipLevel* previous = &chain->levels[i - 1];
+        if (filter == MIPMAP_FILTER_KAISER) mipmap_downsampleKaiser(current, previous->width, previous->height, weights, temporary, next);
+        else mipmap_downsampleBox(current, previous->width, previous->height, next);
+
+        MipLevel* level = &chain->levels[i];
+        mipmap_toBytes(next, (size_t) level->width * level->height, srgb ? &tables : NULL, level->data);
+
+        // the level just computed is the source of the next one (the smaller levels always fit in either buffer)
+        float* swap = current;
+        current = next;
+        next = swap;
+    }
+
+    memory_free(current);
+    memory_free(next);
+    memory_free(temporary);
+
+    return true;
+}
+
+// frees the memory of a mip chain generated by mipmap_generate()
+void mipmap_free(MipChain* chain) {
+    memory_free(chain->memory);
+    memset(chain, 0, sizeof(MipChain));
+}
+
+// returns the number of mip levels (down to 1x1) of a width x height image
+unsigned int mipmap_getLevelCount(unsigned int width, unsigned int height) {
+    unsigned int levelCount = 1;
+    for (unsigned int size = width > height ? width : height; size > 1 && levelCount < MIPMAP_MAX_LEVELS; size /= 2) levelCount++;
+    return levelCount;
+}
+
+// returns the name of the instruction set used for filtering ("AVX2", "SSE2" or "scalar")
+const char* mipmap_getInstructionSet() {
+#if defined(__AVX2__)
+    return "AVX2";
+#elif defined(__SSE2__)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,828 @@
+/*
+OBJ:
+Wavefront OBJ (and MTL) importer.
+The file is mapped and split into line aligned chunks that are parsed in parallel (with a dedicated number parser,
+as strtod() and sscanf() are way too slow for files of hundreds of MB), then the face corners are deduplicated through
+a hash map into indexed, interleaved vertices that can be given straight to mesh_create() (see mesh_createFromObj()).
+This module does not depend on OpenGL, so it can be used both by the engine and by the offline tools (see meshconv).
+
+Loading happens in 3 steps:
+    1. every thread parses its chunk into local arrays (relative indices are resolved against the chunk local counts)
+    2. once the number of elements of each chunk is known, every thread turns its indices into global ones and copies
+       its positions, UVs and normals into the global arrays
+    3. the faces are walked in file order, deduplicating their corners into vertices and grouping the triangles by material
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "engine/utils/file.h"
+#include "engine/utils/console.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/gfx/obj.h"
+
+// files are split so that every thread parses at least this many bytes (smaller files are not worth the threads)
+#define OBJ_MIN_CHUNK_SIZE (1 << 20)
+// relative (negative) indices are stored as chunk local indices plus this bias until the chunk offsets are known
+#define OBJ_RELATIVE_BIAS ((int64_t) 1 << 40)
+// the parsed integers are clamped to this value (it is way more than any valid index)
+#define OBJ_MAX_INDEX ((int64_t) 1 << 36)
+
+// a growable array
+typedef struct {
+    void* data;
+    size_t count;
+    size_t capacity;
+} ObjBuffer;
+
+// a face corner as written in the file (0 means missing)
+typedef struct {
+    int64_t position;
+    int64_t uv;
+    int64_t normal;
+} ObjRawCorner;
+
+typedef struct {
+    uint32_t firstCorner; // index of the first corner in the chunk corners
+    uint32_t cornerCount;
+    int32_t material;     // index into the chunk material names, -1 when the material comes from the previous chunks
+} ObjRawFace;
+
+// a string pointing into the file
+typedef struct {
+    const char* start;
+    size_t length;
+} ObjName;
+
+typedef struct {
+    const char* start;
+    const char* end;
+    ObjBuffer positions;     // 3 floats each
+    ObjBuffer colors;        // 3 floats each, empty if the chunk has no vertex colors
+    ObjBuffer uvs;           // 2 floats each
+    ObjBuffer normals;       // 3 floats each
+    ObjBuffer corners;       // ObjRawCorner
+    ObjBuffer faces;         // ObjRawFace
+    ObjBuffer materialNames; // ObjName ("usemtl")
+    ObjBuffer libraries;     // ObjName ("mtllib")
+    int32_t material;        // the current "usemtl" of the chunk (-1 if none yet)
+    const char* errorLine;   // the line that failed to parse (NULL if the error is not tied to a line)
+    const char* error;       // NULL on success
+    // set once all the chunks have been parsed
+    size_t positionOffset;
+    size_t uvOffset;
+    size_t normalOffset;
+    int* materials;          // global index of every chunk material name
+    int inheritedMaterial;   // the material in use at the start of the chunk
+} ObjChunk;
+
+typedef enum {
+    OBJ_PHASE_PARSE,
+    OBJ_PHASE_RESOLVE
+} ObjPhase;
+
+typedef struct {
+    ObjPhase phase;
+    ObjChunk chunks[OBJ_MAX_THREADS];
+    unsigned int chunkCount;
+    // global arrays (step 2)
+    float* positions;
+    float* colors; // NULL if the file has no vertex colors
+    float* uvs;
+    float* normals;
+    size_t positionCount;
+    size_t uvCount;
+    size_t normalCount;
+} ObjLoader;
+
+typedef struct {
+    ObjLoader* loader;
+    unsigned int chunk;
+} ObjTask;
+
+// deduplication key of a vertex
+typedef struct {
+    uint32_t position;
+    uint32_t uv;
+    uint32_t normal;
+    int32_t material;
+} ObjVertexKey;
+
+typedef struct {
+    ObjVertexKey* keys;
+    uint32_t* values; // UINT32_MAX means empty slot
+    size_t capacity;  // power of 2
+    size_t count;
+} ObjVertexMap;
+
+static const double obj_powersOf10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static bool obj_bufferReserve(ObjBuffer* buffer, size_t elementSize, size_t count) {
+    if (buffer->count + count <= buffer->capacity) return true;
+    size_t capacity = buffer->capacity > 0 ? buffer->capacity * 2 : 1024;
+    while (capacity < buffer->count + count) capacity *= 2;
+    void* data = realloc(buffer->data, capacity * elementSize);
+    if (data == NULL) return false;
+    buffer->data = data;
+    buffer->capacity = capacity;
+    return true;
+}
+
+static bool obj_bufferPush(ObjBuffer* buffer, size_t elementSize, const void* elements, size_t count) {
+    if (!obj_bufferReserve(buffer, elementSize, count)) return false;
+    memcpy((unsigned char*) buffer->data + buffer->count * elementSize, elements, count * elementSize);
+    buffer->count += count;
+    return true;
+}
+
+static void obj_bufferFree(ObjBuffer* buffer) {
+    free(buffer->data);
+    buffer->data = NULL;
+    buffer->count = buffer->capacity = 0;
+}
+
+static const char* obj_skipBlanks(const char* cursor, const char* end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) cursor++;
+    return cursor;
+}
+
+// returns whether the line starts with the given keyword followed by a blank (cursor is set right after the keyword)
+static bool obj_isKeyword(const char* line, const char* end, const char* keyword, const char** cursor) {
+    const size_t length = strlen(keyword);
+    if ((size_t) (end - line) <= length || memcmp(line, keyword, length) != 0 || (line[length] != ' ' && line[length] != '\t')) return false;
+    *cursor = line + length;
+    return true;
+}
+
+// returns the rest of the line without the leading and trailing blanks
+static ObjName obj_trim(const char* start, const char* end) {
+    start = obj_skipBlanks(start, end);
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')) end--;
+    return (ObjName) { start, (size_t) (end - start) };
+}
+
+// parses a float (skipping the leading blanks) and returns the cursor right after it (NULL if there is no number)
+static const char* obj_parseFloat(const char* cursor, const char* end, float* value) {
+    cursor = obj_skipBlanks(cursor, end);
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) negative = *cursor++ == '-';
+
+    // the digits past the precision of the mantissa only affect the exponent
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; cursor < end && (unsigned int) (*cursor - '0') < 10; cursor++) {
+        if (mantissa < 100000000000000000ull) mantissa = mantissa * 10 + (unsigned int) (*cursor - '0');
+        else exponent++;
+        hasDigits = true;
+    }
+    if (cursor < end && *cursor == '.') {
+        for (cursor++; cursor < end && (unsigned int) (*cursor - '0') < 10; cursor++) {
+            if (mantissa < 100000000000000000ull) {
+                mantissa = mantissa * 10 + (unsigned int) (*cursor - '0');
+                exponent--;
+            }
+            hasDigits = true;
+        }
+    }
+    if (!hasDigits) return NULL;
+
+    if (cursor < end && (*cursor == 'e' || *cursor == 'E')) {
+        const char* next = cursor + 1;
+        bool negativeExponent = false;
+        if (next < end && (*next == '-' || *next == '+')) negativeExponent = *next++ == '-';
+        if (next < end && (unsigned int) (*next - '0') < 10) {
+            int value = 0;
+            for (; next < end && (unsigned int) (*next - '0') < 10; next++) {
+                if (value < 1000) value = value * 10 + (*next - '0');
+            }
+            exponent += negativeExponent ? -value : value;
+            cursor = next;
+        }
+    }
+
+    double result = (double) mantissa;
+    if (mantissa != 0) {
+        if (exponent < 0) {
+            for (; exponent < -22 && result != 0.0; exponent += 22) result /= 1e22;
+            if (exponent >= -22) result /= obj_powersOf10[-exponent];
+        } else {
+            for (; exponent > 22 && result < 1e300; exponent -= 22) result *= 1e22;
+            if (exponent <= 22) result *= obj_powersOf10[exponent];
+        }
+    }
+    *value = (float) (negative ? -result : result);
+    return cursor;
+}
+
+// parses an integer (skipping the leading blanks) and returns the cursor right after it (NULL if there is no number)
+static const char* obj_parseInt(const char* cursor, const char* end, int64_t* value) {
+    cursor = obj_skipBlanks(cursor, end);
+    bool negative = false;
+    if (cursor < end && (*cursor == '-' || *cursor == '+')) negative = *cursor++ == '-';
+    if (cursor == end || (unsigned int) (*cursor - '0') >= 10) return NULL;
+
+    int64_t result = 0;
+    for (; cursor < end && (unsigned int) (*cursor - '0') < 10; cursor++) {
+        if (result < OBJ_MAX_INDEX) result = result * 10 + (*cursor - '0');
+    }
+    *value = negative ? -result : result;
+    return cursor;
+}
+
+// parses a line of an OBJ file, returns the error (NULL on success)
+static const char* obj_parseLine(ObjChunk* chunk, const char* line, const char* end) {
+    const char* cursor;
+
+    if (obj_isKeyword(line, end, "v", &cursor)) {
+        float values[6];
+        int count = 0;
+        for (; count < 6; count++) {
+            const char* next = obj_parseFloat(cursor, end, &values[count]);
+            if (next == NULL) break;
+            cursor = next;
+        }
+        if (count < 3) return "invalid vertex position";
+        if (!obj_bufferPush(&chunk->positions, sizeof(float), values, 3)) return "out of memory";
+
+        // the colors are only stored from the first colored vertex on (the previous vertices get white)
+        if (count >= 6 || chunk->colors.count > 0) {
+            static const float white[3] = { 1.0f, 1.0f, 1.0f };
+            while (chunk->colors.count + 3 < chunk->positions.count) {
+                if (!obj_bufferPush(&chunk->colors, sizeof(float), white, 3)) return "out of memory";
+            }
+            if (!obj_bufferPush(&chunk->colors, sizeof(float), count >= 6 ? values + 3 : white, 3)) return "out of memory";
+        }
+    } else if (obj_isKeyword(line, end, "vt", &cursor)) {
+        float values[2] = { 0.0f, 0.0f };
+        cursor = obj_parseFloat(cursor, end, &values[0]);
+        if (cursor == NULL) return "invalid texture coordinate";
+        obj_parseFloat(cursor, end, &values[1]);
+        if (!obj_bufferPush(&chunk->uvs, sizeof(float), values, 2)) return "out of memory";
+    } else if (obj_isKeyword(line, end, "vn", &cursor)) {
+        float values[3];
+        for (int c = 0; c < 3; c++) {
+            cursor = obj_parseFloat(cursor, end, &values[c]);
+            if (cursor == NULL) return "invalid normal";
+        }
+        if (!obj_bufferPush(&chunk->normals, sizeof(float), values, 3)) return "out of memory";
+    } else if (obj_isKeyword(line, end, "f", &cursor)) {
+        ObjRawFace face = { (uint32_t) chunk->corners.count, 0, chunk->material };
+        const int64_t counts[3] = { (int64_t) chunk->positions.count / 3, (int64_t) chunk->uvs.count / 2, (int64_t) chunk->normals.count / 3 };
+        while (true) {
+            cursor = obj_skipBlanks(cursor, end);
+            if (cursor == end || *cursor == '#') break;
+
+            // "v", "v/vt", "v//vn" or "v/vt/vn"
+            int64_t indices[3] = { 0, 0, 0 };
+            cursor = obj_parseInt(cursor, end, &indices[0]);
+            if (cursor == NULL) return "invalid face";
+            if (cursor < end && *cursor == '/') {
+                cursor++;
+                if (cursor < end && *cursor != '/') {
+                    cursor = obj_parseInt(cursor, end, &indices[1]);
+                    if (cursor == NULL) return "invalid face";
+                }
+                if (cursor < end && *cursor == '/') {
+                    cursor = obj_parseInt(cursor + 1, end, &indices[2]);
+                    if (cursor == NULL) return "invalid face";
+                }
+            }
+            for (int k = 0; k < 3; k++) {
+                if (indices[k] < 0) indices[k] = counts[k] + indices[k] + 1 + OBJ_RELATIVE_BIAS;
+            }
+
+            const ObjRawCorner corner = { indices[0], indices[1], indices[2] };
+            if (!obj_bufferPush(&chunk->corners, sizeof(ObjRawCorner), &corner, 1)) return "out of memory";
+            face.cornerCount++;
+        }
+        // points and lines written as faces are skipped
+        if (face.cornerCount < 3) chunk->corners.count = face.firstCorner;
+        else if (!obj_bufferPush(&chunk->faces, sizeof(ObjRawFace), &face, 1)) return "out of memory";
+    } else if (obj_isKeyword(line, end, "usemtl", &cursor)) {
+        const ObjName name = obj_trim(cursor, end);
+        if (!obj_bufferPush(&chunk->materialNames, sizeof(ObjName), &name, 1)) return "out of memory";
+        chunk->material = (int32_t) chunk->materialNames.count - 1;
+    } else if (obj_isKeyword(line, end, "mtllib", &cursor)) {
+        const ObjName name = obj_trim(cursor, end);
+        if (!obj_bufferPush(&chunk->libraries, sizeof(ObjName), &name, 1)) return "out of memory";
+    }
+    // everything else (comments, objects, groups, smoothing groups, lines, etc...) is ignored
+
+    return NULL;
+}
+
+// step 1: parses all the lines of a chunk
+static void obj_parseChunk(ObjChunk* chunk) {
+    const char* cursor = chunk->start;
+    while (cursor < chunk->end) {
+        const char* lineEnd = (const char*) memchr(cursor, '\n', (size_t) (chunk->end - cursor));
+        if (lineEnd == NULL) lineEnd = chunk->end;
+        const char* line = obj_skipBlanks(cursor, lineEnd);
+        cursor = lineEnd < chunk->end ? lineEnd + 1 : chunk->end;
+
+        chunk->error = obj_parseLine(chunk, line, lineEnd);
+        if (chunk->error != NULL) {
+            chunk->errorLine = line;
+            return;
+        }
+    }
+}
+
+// turns a parsed index into a global 1-based one (0 if missing), returns false if it is out of range
+static bool obj_resolveIndex(int64_t* index, size_t offset, size_t count) {
+    if (*index > OBJ_RELATIVE_BIAS / 2) {
+        *index = *index - OBJ_RELATIVE_BIAS + (int64_t) offset;
+        if (*index <= 0) return false;
+    } else if (*index == 0) {
+        return true;
+    }
+    return *index <= (int64_t) count;
+}
+
+// step 2: makes the indices of a chunk global and copies its elements into the global arrays
+static void obj_resolveChunk(ObjLoader* loader, ObjChunk* chunk) {
+    ObjRawCorner* corners = (ObjRawCorner*) chunk->corners.data;
+    for (size_t i = 0; i < chunk->corners.count; i++) {
+        if (!obj_resolveIndex(&corners[i].position, chunk->positionOffset, loader->positionCount) || corners[i].position == 0
+            || !obj_resolveIndex(&corners[i].uv, chunk->uvOffset, loader->uvCount)
+            || !obj_resolveIndex(&corners[i].normal, chunk->normalOffset, loader->normalCount)) {
+            chunk->error = "face index out of range";
+            break;
+        }
+    }
+
+    if (chunk->positions.count > 0) memcpy(loader->positions + chunk->positionOffset * 3, chunk->positions.data, chunk->positions.count * sizeof(float));
+    if (chunk->uvs.count > 0) memcpy(loader->uvs + chunk->uvOffset * 2, chunk->uvs.data, chunk->uvs.count * sizeof(float));
+    if (chunk->normals.count > 0) memcpy(loader->normals + chunk->normalOffset * 3, chunk->normals.data, chunk->normals.count * sizeof(float));
+    if (loader->colors != NULL) {
+        float* colors = loader->colors + chunk->positionOffset * 3;
+        if (chunk->colors.count == chunk->positions.count) memcpy(colors, chunk->colors.data, chunk->colors.count * sizeof(float));
+        else for (size_t i = 0; i < chunk->positions.count; i++) colors[i] = 1.0f;
+    }
+
+    obj_bufferFree(&chunk->positions);
+    obj_bufferFree(&chunk->colors);
+    obj_bufferFree(&chunk->uvs);
+    obj_bufferFree(&chunk->normals);
+}
+
+static void obj_runTask(ObjLoader* loader, unsigned int index) {
+    if (loader->phase == OBJ_PHASE_PARSE) obj_parseChunk(&loader->chunks[index]);
+    else obj_resolveChunk(loader, &loader->chunks[index]);
+}
+
+static void* obj_threadMain(void* argument) {
+    ObjTask* task = (ObjTask*) argument;
+    PROFILE_THREAD("obj worker");
+    PROFILE_BEGIN("obj_parseChunk");
+    obj_runTask(task->loader, task->chunk);
+    PROFILE_END();
+    return NULL;
+}
+
+// runs a step on all the chunks, one thread per chunk (the calling thread takes the first one)
+static void obj_runPhase(ObjLoader* loader, ObjPhase phase) {
+    loader->phase = phase;
+
+    pthread_t threads[OBJ_MAX_THREADS];
+    ObjTask tasks[OBJ_MAX_THREADS];
+    bool started[OBJ_MAX_THREADS] = { false };
+    for (unsigned int i = 1; i < loader->chunkCount; i++) {
+        tasks[i] = (ObjTask) { loader, i };
+        started[i] = pthread_create(&threads[i], NULL, obj_threadMain, &tasks[i]) == 0;
+    }
+    obj_runTask(loader, 0);
+    for (unsigned int i = 1; i < loader->chunkCount; i++) {
+        // if a thread could not be started its chunk is handled here
+        if (started[i]) pthread_join(threads[i], NULL);
+        else obj_runTask(loader, i);
+    }
+}
+
+// returns the index of the material with the given name (it is added, white, when it does not exist)
+static int obj_findMaterial(ObjBuffer* materials, const char* name, size_t length, const char* path) {
+    if (length >= OBJ_MAX_NAME) length = OBJ_MAX_NAME - 1;
+    ObjMaterial* list = (ObjMaterial*) materials->data;
+    for (size_t i = 0; i < materials->count; i++) {
+        if (strncmp(list[i].name, name, length) == 0 && list[i].name[length] == '\0') return (int) i;
+    }
+
+    console_warning("Material \"%.*s\" used by \"%s\" has not been defined", (int) length, name, path);
+    ObjMaterial material = { .diffuse = { 1.0f, 1.0f, 1.0f, 1.0f } };
+    memcpy(material.name, name, length);
+    if (!obj_bufferPush(materials, sizeof(ObjMaterial), &material, 1)) return -1;
+    return (int) materials->count - 1;
+}
+
+// builds a path relative to the directory of another file (the directory includes the trailing separator)
+static void obj_joinPath(char* result, const char* directory, size_t directoryLength, const char* name, size_t length) {
+    snprintf(result, OBJ_MAX_PATH, "%.*s%.*s", (int) directoryLength, directory, (int) length, name);
+}
+
+// loads the materials of a MTL file (a missing file is not an error, the materials just stay white)
+static bool obj_loadLibrary(ObjBuffer* materials, const char* directory, size_t directoryLength, ObjName name) {
+    char path[OBJ_MAX_PATH];
+    obj_joinPath(path, directory, directoryLength, name.start, name.length);
+    if (!file_exists(path)) {
+        console_warning("Material library \"%s\" not found", path);
+        return true;
+    }
+    FileView view;
+    if (!file_map(path, &view)) return true;
+
+    const char* data = (const char*) view.data;
+    const char* end = data + view.size;
+    ObjMaterial* material = NULL;
+    bool success = true;
+    for (const char* cursor = data; cursor < end && success; ) {
+        const char* lineEnd = (const char*) memchr(cursor, '\n', (size_t) (end - cursor));
+        if (lineEnd == NULL) lineEnd = end;
+        const char* line = obj_skipBlanks(cursor, lineEnd);
+        cursor = lineEnd < end ? lineEnd + 1 : end;
+
+        const char* rest;
+        if (obj_isKeyword(line, lineEnd, "newmtl", &rest)) {
+            const ObjName materialName = obj_trim(rest, lineEnd);
+            ObjMaterial newMaterial = { .diffuse = { 1.0f, 1.0f, 1.0f, 1.0f } };
+            memcpy(newMaterial.name, materialName.start, materialName.length < OBJ_MAX_NAME ? materialName.length : OBJ_MAX_NAME - 1);
+            success = obj_bufferPush(materials, sizeof(ObjMaterial), &newMaterial, 1);
+            material = success ? (ObjMaterial*) materials->data + materials->count - 1 : NULL;
+        } else if (material == NULL) {
+            continue;
+        } else if (obj_isKeyword(line, lineEnd, "Kd", &rest)) {
+            for (int c = 0; c < 3 && rest != NULL; c++) rest = obj_parseFloat(rest, lineEnd, &material->diffuse[c]);
+        } else if (obj_isKeyword(line, lineEnd, "d", &rest)) {
+            obj_parseFloat(rest, lineEnd, &material->diffuse[3]);
+        } else if (obj_isKeyword(line, lineEnd, "Tr", &rest)) {
+            float transparency;
+            if (obj_parseFloat(rest, lineEnd, &transparency) != NULL) material->diffuse[3] = 1.0f - transparency;
+        } else if (obj_isKeyword(line, lineEnd, "map_Kd", &rest)) {
+            // the texture path is the last token (the ones before it are options)
+            const ObjName map = obj_trim(rest, lineEnd);
+            const char* start = map.start + map.length;
+            while (start > map.start && start[-1] != ' ' && start[-1] != '\t') start--;
+            obj_joinPath(material->diffuseMap, directory, directoryLength, start, (size_t) (map.start + map.length - start));
+        }
+    }
+    file_unmap(&view);
+
+    if (!success) console_error("Failed to allocate memory for the materials of \"%s\"", path);
+    return success;
+}
+
+static size_t obj_hashKey(const ObjVertexKey* key) {
+    uint64_t hash = key->position * 0x9E3779B97F4A7C15ull;
+    hash ^= (hash >> 29) + key->uv * 0xBF58476D1CE4E5B9ull;
+    hash ^= (hash >> 31) + key->normal * 0x94D049BB133111EBull;
+    hash ^= (hash >> 30) + (uint32_t) key->material * 0xD6E8FEB86659FD93ull;
+    return (size_t) (hash ^ (hash >> 32));
+}
+
+static bool obj_initMap(ObjVertexMap* map, size_t capacity) {
+    map->keys = (ObjVertexKey*) malloc(capacity * sizeof(ObjVertexKey));
+    map->values = (uint32_t*) malloc(capacity * sizeof(uint32_t));
+    if (map->keys == NULL || map->values == NULL) {
+        free(map->keys);
+        free(map->values);
+        return false;
+    }
+    memset(map->values, 0xFF, capacity * sizeof(uint32_t));
+    map->capacity = capacity;
+    map->count = 0;
+    return true;
+}
+
+static void obj_freeMap(ObjVertexMap* map) {
+    free(map->keys);
+    free(map->values);
+}
+
+// returns the slot of a key (either the one holding it or the empty one where it should go)
+static size_t obj_findSlot(const ObjVertexMap* map, const ObjVertexKey* key) {
+    size_t slot = obj_hashKey(key) & (map->capacity - 1);
+    while (map->values[slot] != UINT32_MAX) {
+        const ObjVertexKey* other = &map->keys[slot];
+        if (other->position == key->position && other->uv == key->uv && other->normal == key->normal && other->material == key->material) break;
+        slot = (slot + 1) & (map->capacity - 1);
+    }
+    return slot;
+}
+
+static bool obj_growMap(ObjVertexMap* map) {
+    ObjVertexMap grown;
+    if (!obj_initMap(&grown, map->capacity * 2)) return false;
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->values[i] == UINT32_MAX) continue;
+        const size_t slot = obj_findSlot(&grown, &map->keys[i]);
+        grown.keys[slot] = map->keys[i];
+        grown.values[slot] = map->values[i];
+    }
+    grown.count = map->count;
+    obj_freeMap(map);
+    *map = grown;
+    return true;
+}
+
+// step 3: deduplicates the face corners into vertices and triangulates the faces, grouping them by material
+static bool obj_build(ObjLoader* loader, ObjModel* model, char* path) {
+    model->hasUvs = loader->uvCount > 0;
+    model->hasNormals = loader->normalCount > 0;
+    model->vertexLength = 3 + 4 + (model->hasUvs ? 2 : 0) + (model->hasNormals ? 3 : 0);
+
+    // count the triangles of every material (group 0 holds the faces without a material)
+    const unsigned int groupCount = model->materialCount + 1;
+    size_t* groupOffsets = (size_t*) calloc(groupCount, sizeof(size_t));
+    if (groupOffsets == NULL) {
+        console_error("Failed to allocate memory for loading \"%s\"", path);
+        return false;
+    }
+    size_t indexCount = 0;
+    for (unsigned int c = 0; c < loader->chunkCount; c++) {
+        const ObjChunk* chunk = &loader->chunks[c];
+        const ObjRawFace* faces = (const ObjRawFace*) chunk->faces.data;
+        for (size_t f = 0; f < chunk->faces.count; f++) {
+            const int material = faces[f].material >= 0 ? chunk->materials[faces[f].material] : chunk->inheritedMaterial;
+            groupOffsets[material + 1] += (faces[f].cornerCount - 2) * 3;
+            indexCount += (faces[f].cornerCount - 2) * 3;
+        }
+    }
+    if (indexCount > UINT_MAX) {
+        console_error("\"%s\" has too many faces", path);
+        free(groupOffsets);
+        return false;
+    }
+
+    model->submeshes = (ObjSubmesh*) malloc(groupCount * sizeof(ObjSubmesh));
+    model->indices = (unsigned int*) malloc((indexCount > 0 ? indexCount : 1) * sizeof(unsigned int));
+    ObjVertexMap map;
+    size_t mapCapacity = 1024;
+    while (mapCapacity < loader->positionCount * 2) mapCapacity *= 2;
+    if (model->submeshes == NULL || model->indices == NULL || !obj_initMap(&map, mapCapacity)) {
+        console_error("Failed to allocate memory for loading \"%s\"", path);
+        free(groupOffsets);
+        return false;
+    }
+
+    // turn the counts into offsets, creating a submesh for every used material
+    size_t offset = 0;
+    for (unsigned int g = 0; g < groupCount; g++) {
+        const size_t count = groupOffsets[g];
+        if (count > 0) model->submeshes[model->submeshCount++] = (ObjSubmesh) { (unsigned int) offset, (unsigned int) count, (int) g - 1 };
+        groupOffsets[g] = offset;
+        offset += count;
+    }
+
+    ObjBuffer vertices = { 0 };
+    bool success = true;
+    for (unsigned int c = 0; c < loader->chunkCount && success; c++) {
+        const ObjChunk* chunk = &loader->chunks[c];
+        const ObjRawFace* faces = (const ObjRawFace*) chunk->faces.data;
+        const ObjRawCorner* corners = (const ObjRawCorner*) chunk->corners.data;
+        for (size_t f = 0; f < chunk->faces.count && success; f++) {
+            const int material = faces[f].material >= 0 ? chunk->materials[faces[f].material] : chunk->inheritedMaterial;
+            size_t* groupOffset = &groupOffsets[material + 1];
+            uint32_t first = 0, previous = 0;
+
+            for (uint32_t k = 0; k < faces[f].cornerCount; k++) {
+                const ObjRawCorner* corner = &corners[faces[f].firstCorner + k];
+                // with vertex colors the material does not change the vertex, so it can be shared between materials
+                const ObjVertexKey key = { (uint32_t) corner->position, (uint32_t) corner->uv, (uint32_t) corner->normal, loader->colors != NULL ? -1 : material };
+
+                if ((map.count + 1) * 2 > map.capacity && !obj_growMap(&map)) {
+                    success = false;
+                    break;
+                }
+                const size_t slot = obj_findSlot(&map, &key);
+                if (map.values[slot] == UINT32_MAX) {
+                    if (vertices.count / model->vertexLength >= UINT32_MAX || !obj_bufferReserve(&vertices, sizeof(float), model->vertexLength)) {
+                        success = false;
+                        break;
+                    }
+                    float* vertex = (float*) vertices.data + vertices.count;
+                    memcpy(vertex, loader->positions + (key.position - 1) * 3, 3 * sizeof(float));
+                    if (loader->colors != NULL) {
+                        memcpy(vertex + 3, loader->colors + (key.position - 1) * 3, 3 * sizeof(float));
+                        vertex[6] = 1.0f;
+                    } else if (material >= 0) {
+                        memcpy(vertex + 3, model->materials[material].diffuse, 4 * sizeof(float));
+                    } else {
+                        vertex[3] = vertex[4] = vertex[5] = vertex[6] = 1.0f;
+                    }
+                    float* next = vertex + 7;
+                    if (model->hasUvs) {
+                        if (key.uv > 0) memcpy(next, loader->uvs + (key.uv - 1) * 2, 2 * sizeof(float));
+                        else next[0] = next[1] = 0.0f;
+                        next += 2;
+                    }
+                    if (model->hasNormals) {
+                        if (key.normal > 0) memcpy(next, loader->normals + (key.normal - 1) * 3, 3 * sizeof(float));
+                        else next[0] = next[1] = next[2] = 0.0f;
+                    }
+
+                    map.keys[slot] = key;
+                    map.values[slot] = (uint32_t) (vertices.count / model->vertexLength);
+                    map.count++;
+                    vertices.count += model->vertexLength;
+                }
+                const uint32_t index = map.values[slot];
+
+                // triangle fan
+                if (k >= 2) {
+                    model->indices[(*groupOffset)++] = first;
+                    model->indices[(*groupOffset)++] = previous;
+                    model->indices[(*groupOffset)++] = index;
+                }
+                if (k == 0) first = index;
+                previous = index;
+            }
+        }
+    }
+
+    obj_freeMap(&map);
+    free(groupOffsets);
+    model->vertices = (float*) vertices.data;
+    model->vertexCount = (unsigned int) (vertices.count / model->vertexLength);
+    model->indexCount = (unsigned int) indexCount;
+
+    if (!success) console_error("Failed to allocate memory for the vertices of \"%s\"", path);
+    return success;
+}
+
+/*
+Loads an OBJ file (and the MTL files it references).
+REMEMBER TO FREE THE MODEL BY CALLING obj_free()!
+Parameters:
+    - path (char*): the OBJ file path ("./file" means it is in "g3ce")
+    - threadCount (unsigned int): the number of parsing threads (0 uses one per CPU core, small files are always parsed by a single thread)
+    - model (ObjModel*): where to store the loaded model
+Returns:
+    true on success, false otherwise (the error has already been logged)
+*/
+bool obj_load(char* path, unsigned int threadCount, ObjModel* model) {
+    PROFILE_FUNCTION();
+
+    memset(model, 0, sizeof(ObjModel));
+
+    FileView view;
+    if (!file_map(path, &view)) return false;
+    // every thread reads its own part of the file, so ask for all of it right away
+    file_advise(&view, FILE_ACCESS_WILLNEED);
+
+    ObjLoader* loader = (ObjLoader*) calloc(1, sizeof(ObjLoader));
+    if (loader == NULL) {
+        console_error("Failed to allocate memory for loading \"%s\"", path);
+        file_unmap(&view);
+        return false;
+    }
+
+    // split the file into line aligned chunks
+    if (threadCount == 0) {
+        const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cores > 0 ? (unsigned int) cores : 1;
+    }
+    const size_t maxChunks = view.size / OBJ_MIN_CHUNK_SIZE;
+    if (threadCount > maxChunks) threadCount = maxChunks > 0 ? (unsigned int) maxChunks : 1;
+    if (threadCount > OBJ_MAX_THREADS) threadCount = OBJ_MAX_THREADS;
+    loader->chunkCount = threadCount;
+
+    const char* data = (const char*) view.data;
+    const char* end = data + view.size;
+    const char* start = data;
+    for (unsigned int i = 0; i < loader->chunkCount; i++) {
+        const char* chunkEnd = i + 1 < loader->chunkCount ? data + view.size / loader->chunkCount * (i + 1) : end;
+        if (chunkEnd < start) chunkEnd = start;
+        if (chunkEnd < end) {
+            const char* newline = (const char*) memchr(chunkEnd, '\n', (size_t) (end - chunkEnd));
+            chunkEnd = newline != NULL ? newline + 1 : end;
+        }
+        loader->chunks[i].start = start;
+        loader->chunks[i].end = chunkEnd;
+        loader->chunks[i].material = -1;
+        start = chunkEnd;
+    }
+
+    // step 1
+    obj_runPhase(loader, OBJ_PHASE_PARSE);
+
+    bool success = true;
+    bool hasColors = false;
+    for (unsigned int i = 0; i < loader->chunkCount && success; i++) {
+        ObjChunk* chunk = &loader->chunks[i];
+        if (chunk->error != NULL) {
+            size_t line = 1;
+            for (const char* cursor = data; cursor < chunk->errorLine; cursor++) line += *cursor == '\n';
+            console_error("Failed to load \"%s\": %s at line %zu", path, chunk->error, line);
+            success = false;
+        }
+        chunk->positionOffset = loader->positionCount;
+        chunk->uvOffset = loader->uvCount;
+        chunk->normalOffset = loader->normalCount;
+        loader->positionCount += chunk->positions.count / 3;
+        loader->uvCount += chunk->uvs.count / 2;
+        loader->normalCount += chunk->normals.count / 3;
+        hasColors = hasColors || chunk->colors.count > 0;
+    }
+
+    // step 2
+    if (success) {
+        loader->positions = (float*) malloc((loader->positionCount > 0 ? loader->positionCount : 1) * 3 * sizeof(float));
+        loader->uvs = (float*) malloc((loader->uvCount > 0 ? loader->uvCount : 1) * 2 * sizeof(float));
+        loader->normals = (float*) malloc((loader->normalCount > 0 ? loader->normalCount : 1) * 3 * sizeof(float));
+        if (hasColors) loader->colors = (float*) malloc((loader->positionCount > 0 ? loader->positionCount : 1) * 3 * sizeof(float));
+        if (loader->positions == NULL || loader->uvs == NULL || loader->normals == NULL || (hasColors && loader->colors == NULL)) {
+            console_error("Failed to allocate memory for loading \"%s\"", path);
+            success = false;
+        }
+    }
+    if (success) {
+        obj_runPhase(loader, OBJ_PHASE_RESOLVE);
+        for (unsigned int i = 0; i < loader->chunkCount && success; i++) {
+            if (loader->chunks[i].error != NULL) {
+                console_error("Failed to load \"%s\": %s", path, loader->chunks[i].error);
+                success = false;
+            }
+        }
+    }
+
+    // materials: load the libraries, then map the chunk material names to the global materials
+    ObjBuffer materials = { 0 };
+    size_t directoryLength = strlen(path);
+    while (directoryLength > 0 && path[directoryLength - 1] != '/' && path[directoryLength - 1] != '\\') directoryLength--;
+    for (unsigned int i = 0; i < loader->chunkCount && success; i++) {
+        const ObjName* libraries = (const ObjName*) loader->chunks[i].libraries.data;
+        for (size_t l = 0; l < loader->chunks[i].libraries.count && success; l++) {
+            // "mtllib" can list more than a file
+            const char* cursor = libraries[l].start;
+            const char* libraryEnd = cursor + libraries[l].length;
+            while (success && (cursor = obj_skipBlanks(cursor, libraryEnd)) < libraryEnd) {
+                const char* nameEnd = cursor;
+                while (nameEnd < libraryEnd && *nameEnd != ' ' && *nameEnd != '\t') nameEnd++;
+                success = obj_loadLibrary(&materials, path, directoryLength, (ObjName) { cursor, (size_t) (nameEnd - cursor) });
+                cursor = nameEnd;
+            }
+        }
+    }
+    int currentMaterial = -1;
+    for (unsigned int i = 0; i < loader->chunkCount && success; i++) {
+        ObjChunk* chunk = &loader->chunks[i];
+        chunk->inheritedMaterial = currentMaterial;
+        chunk->materials = (int*) malloc((chunk->materialNames.count > 0 ? chunk->materialNames.count : 1) * sizeof(int));
+        if (chunk->materials == NULL) {
+            console_error("Failed to allocate memory for loading \"%s\"", path);
+            success = false;
+            break;
+        }
+        const ObjName* names = (const ObjName*) chunk->materialNames.data;
+        for (size_t n = 0; n < chunk->materialNames.count && success; n++) {
+            chunk->materials[n] = obj_findMaterial(&materials, names[n].start, names[n].length, path);
+            success = chunk->materials[n] >= 0;
+        }
+        if (chunk->material >= 0) currentMaterial = chunk->materials[chunk->material];
+    }
+    model->materials = (ObjMaterial*) materials.data;
+    model->materialCount = (unsigned int) materials.count;
+
+    // step 3
+    if (success) success = obj_build(loader, model, path);
+
+    free(loader->positions);
+    free(loader->colors);
+    free(loader->uvs);
+    free(loader->normals);
+    for (unsigned int i = 0; i < loader->chunkCount; i++) {
+        ObjChunk* chunk = &loader->chunks[i];
+        obj_bufferFree(&chunk->positions);
+        obj_bufferFree(&chunk->colors);
+        obj_bufferFree(&chunk->uvs);
+        obj_bufferFree(&chunk->normals);
+        obj_bufferFree(&chunk->corners);
+        obj_bufferFree(&chunk->faces);
+        obj_bufferFree(&chunk->materialNames);
+        obj_bufferFree(&chunk->libraries);
+        free(chunk->materials);
+    }
+    free(loader);
+    file_unmap(&view);
+
+    if (!success) obj_free(model);
+    return success;
+}
+
+// frees the memory of a model loaded by obj_load()
+void obj_free(ObjModel* model) {
+    free(model->vertices);
+    free(model->indices);
+    free(model->materials);
+    free(model->submeshes);
+    memset(model, 0, sizeof(ObjModel));
+}
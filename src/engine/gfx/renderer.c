@@ -3,16 +3,37 @@ RENDERER:
 Contains some useful rendering functions
 */
 
+#include <string.h>
+#include <stdint.h>
+
 #include <glad/glad.h>
 
 #include "engine/gfx/shader.h"
 #include "engine/utils/console.h"
+#include "engine/utils/profiler.h"
 
 #include "engine/gfx/renderer.h"
 
 float clearColor[4] = { 1, 1, 1, 1 };
 Camera* activeCamera = NULL;
 int activeShader = 0;
+RenderStats renderStats = { 0 };
+
+static RenderStats lastStats = { 0 };
+static unsigned int statsDumpInterval = 0;
+static unsigned long long statsFrame = 0;
+
+// returns true if the current OpenGL context supports the given extension (e.g. "GL_EXT_texture_compression_s3tc")
+bool renderer_hasGLExtension(const char* name) {
+    // core profiles only allow querying the extensions one by one
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int i = 0; i < count; i++) {
+        const char* extension = (const char*) glGetStringi(GL_EXTENSIONS, i);
+        if (extension != NULL && strcmp(extension, name) == 0) return true;
+    }
+    return false;
+}
 
 // sets the clear color with RGBA values (default color is white (1, 1, 1, 1))
 void renderer_setGLClearColor(float r, float g, float b, float a) {
@@ -29,6 +50,7 @@ void renderer_setGLPolygonMode(unsigned int mode) {
         return;
     }
     glPolygonMode(GL_FRONT_AND_BACK, mode);
+    renderStats.polygonModeChanges++;
 }
 
 // sets GL cull mode (either to GL_FRONT, GL_BACK (default), GL_FRONT_AND_BACK or 0 (disable face culling))
@@ -44,6 +66,7 @@ void renderer_setGLCullMode(unsigned int mode) {
         glEnable(GL_CULL_FACE);
         glCullFace(mode);
     }
+    renderStats.cullModeChanges++;
 }
 
 // sets GL depth test function
@@ -83,6 +106,7 @@ void renderer_setGLDepthTest(unsigned int depthFunction) {
         glDepthFunc(depthFunction);
         glDepthMask(GL_TRUE);
     }
+    renderStats.depthTestChanges++;
 }
 
 /*
@@ -93,6 +117,7 @@ Parameters:
 void renderer_useShader(unsigned int shader) {
     glUseProgram(shader);
     activeShader = shader;
+    renderStats.shaderBinds++;
 }
 
 /*
@@ -108,6 +133,38 @@ void renderer_bindTexture(unsigned int texture, unsigned int unit) {
     }
     glActiveTexture(GL_TEXTURE0 + unit);
     glBindTexture(GL_TEXTURE_2D, texture);
+    renderStats.textureBinds++;
+}
+
+/*
+Binds a texture array.
+Parameters:
+    - texture (unsigned int): the texture array id
+    - unit (unsigned int): the texture unit to bind the texture array to
+*/
+void renderer_bindTextureArray(unsigned int texture, unsigned int unit) {
+    if (unit > 32) {
+        console_warning("Invalid texture unit for %u. There are a total number of 32 texture units", unit);
+        return;
+    }
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    renderStats.textureBinds++;
+}
+
+/*
+Binds a sampler (its filter and wrapping state override the ones of the texture bound to the same unit).
+Parameters:
+    - sampler (unsigned int): the sampler id (0 unbinds the sampler, restoring the texture own state)
+    - unit (unsigned int): the texture unit to bind the sampler to
+*/
+void renderer_bindSampler(unsigned int sampler, unsigned int unit) {
+    if (unit > 32) {
+        console_warning("Invalid texture unit for %u. There are a total number of 32 texture units", unit);
+        return;
+    }
+    glBindSampler(unit, sampler);
+    renderStats.samplerBinds++;
 }
 
 /*
@@ -121,14 +178,24 @@ void renderer_useCamera(Camera* camera) {
 
 // prepares for rendering (automatically updates the view matrix is a camera and a shader with a view matrix uniform are being currently used)
 void renderer_prepare() {
-    if (shader_hasUniform(activeShader, "view")) {
-        console_warning("The current shader has no view matrix uniform! Try using another shader");
+    if (!shader_hasUniform(activeShader, "view")) {
+        CONSOLE_WARNING_RATE(1, "The current shader has no view matrix uniform! Try using another shader");
     }
     if (activeCamera != NULL && activeShader != 0) {
         shader_setMatrix4(activeShader, "view", camera_getViewMatrix(activeCamera));
     }
 }
 
+// returns the number of triangles drawn by a draw call
+static unsigned int renderer_countTriangles(unsigned int drawMode, unsigned int count) {
+    switch (drawMode) {
+        case GL_TRIANGLES: return count / 3;
+        case GL_TRIANGLE_STRIP:
+        case GL_TRIANGLE_FAN: return count > 2 ? count - 2 : 0;
+        default: return 0;
+    }
+}
+
 /*
 Renders a given mesh.
 Parameters:
@@ -137,18 +204,30 @@ Parameters:
 void renderer_renderMesh(Mesh* mesh) {
     // bind the mesh texture if needed
     if (mesh->texture > 0) {
-        renderer_bindTexture(mesh->texture, mesh->textureUnit);
+        if (mesh->textureTarget == GL_TEXTURE_2D_ARRAY) renderer_bindTextureArray(mesh->texture, mesh->textureUnit);
+        else renderer_bindTexture(mesh->texture, mesh->textureUnit);
+    }
+    // bind the mesh sampler if needed
+    if (mesh->sampler > 0) {
+        renderer_bindSampler(mesh->sampler, mesh->textureUnit);
     }
     // bind the mesh VAO
     glBindVertexArray(mesh->vao);
     // draw
-    glDrawElements(mesh->drawMode, mesh->indicesLength, GL_UNSIGNED_INT, 0);
+    glDrawElements(mesh->drawMode, mesh->indicesLength, mesh->indexType, (void*) (uintptr_t) mesh->indexOffset);
+    renderStats.vertexArrayBinds++;
+    renderStats.drawCalls++;
+    renderStats.vertices += mesh->indicesLength;
+    renderStats.triangles += renderer_countTriangles(mesh->drawMode, mesh->indicesLength);
 
     // unbind
     glBindVertexArray(0);
     
     if (mesh->texture > 0) {
-        glBindTexture(GL_TEXTURE_2D, 0);
+        glBindTexture(mesh->textureTarget, 0);
+    }
+    if (mesh->sampler > 0) {
+        glBindSampler(mesh->textureUnit, 0);
     }
 }
 
@@ -157,6 +236,8 @@ void renderer_renderMesh(Mesh* mesh) {
 // automatically called renderer_prepare() before rendering the object,
 // so you don't need to call it manually before calling this function
 void renderer_renderObject(Object* object) {
+    PROFILE_SCOPE("renderer_renderObject");
+
     // bind the shader assigned to the given object
     if (object->shader > 0) {
         renderer_useShader(object->shader);
@@ -169,10 +250,38 @@ void renderer_renderObject(Object* object) {
     if (shader_hasUniform(activeShader, "model")) {
         shader_setMatrix4(activeShader, "model", transform_getModelMatrix(&(object->transform)));
     } else {
-        console_warning("The current shader has no model matrix uniform! Try using another shader");
+        CONSOLE_WARNING_RATE(1, "The current shader has no model matrix uniform! Try using another shader");
         return;
     }
 
     // render the mesh
     renderer_renderMesh(&(object->mesh));
 }
+
+// STATISTICS
+// returns the counters of the last rendered frame
+RenderStats renderer_getStats() {
+    return lastStats;
+}
+
+// ends the counters of a frame, making them the ones returned by renderer_getStats() (called by the app loop after swapping the buffers)
+void renderer_collectStats() {
+    lastStats = renderStats;
+    memset(&renderStats, 0, sizeof(RenderStats));
+    statsFrame++;
+    if (statsDumpInterval > 0 && statsFrame % statsDumpInterval == 0) renderer_printStats();
+}
+
+// writes the counters of the last rendered frame to the console
+void renderer_printStats() {
+    const RenderStats* stats = &lastStats;
+    console_info("Frame %llu: %u draw calls, %llu triangles, %llu vertices, %u culled objects", statsFrame, stats->drawCalls, stats->triangles, stats->vertices, stats->culledObjects);
+    console_info("    binds: %u shaders, %u vertex arrays, %u textures, %u samplers", stats->shaderBinds, stats->vertexArrayBinds, stats->textureBinds, stats->samplerBinds);
+    console_info("    state: %u polygon mode, %u cull mode, %u depth test changes, %u uniform uploads, %llu buffer bytes uploaded",
+        stats->polygonModeChanges, stats->cullModeChanges, stats->depthTestChanges, stats->uniformUploads, stats->bufferBytesUploaded);
+}
+
+// writes the counters to the console every given number of frames (0, the default, disables it)
+void renderer_setStatsDumpInterval(unsigned int frames) {
+    statsDumpInterval = frames;
+}
@@ -9,18 +9,26 @@ Shader handler
 
 #include "engine/utils/file.h"
 #include "engine/utils/console.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
 
+#include "engine/gfx/renderer.h"
 #include "engine/gfx/shader.h"
 
 // creates a shader from a file path ("./file" means it is in "g3ce")
 unsigned int shader_get(char* path, int type) {
-    const char* source = file_read(path);
-    if (source == NULL) return -1;
+    PROFILE_SCOPE("shader_compile");
 
+    // the source is passed to OpenGL with its length, so it can be used straight from the mapped file
+    FileView view;
+    if (!file_map(path, &view)) return -1;
+
+    const char* source = (const char*) view.data;
+    const int length = (int) view.size;
     unsigned int id = glCreateShader(type);
-    glShaderSource(id, 1, &source, NULL);
+    glShaderSource(id, 1, &source, &length);
     
-    free((void*) source); // FREE THE RETURN VALUE OF file_read(path);
+    file_unmap(&view); // OpenGL keeps its own copy of the source
     
     glCompileShader(id);
 
@@ -39,6 +47,8 @@ unsigned int shader_get(char* path, int type) {
 
 // creates a shader program from the given vertex and fragment shader codes ("./file" means it is in "g3ce")
 unsigned int shader_create(char* vertexPath, char* fragmentPath) {
+    PROFILE_SCOPE("shader_create");
+
     unsigned int vertexID = shader_get(vertexPath, GL_VERTEX_SHADER);
     unsigned int fragmentID = shader_get(fragmentPath, GL_FRAGMENT_SHADER);
 
@@ -59,11 +69,15 @@ unsigned int shader_create(char* vertexPath, char* fragmentPath) {
     glDeleteShader(vertexID);
     glDeleteShader(fragmentID);
 
+    // (the driver does not tell the size of a program, it is only counted)
+    memory_trackGpu(MEMORY_GPU_PROGRAM, programID, MEMORY_TAG_SHADER, 0);
+
     return programID;
 }
 
 // destroys the given shader
 void shader_destroy(unsigned int programID) {
+    memory_untrackGpu(MEMORY_GPU_PROGRAM, programID);
     glDeleteProgram(programID);
 }
 
@@ -78,6 +92,7 @@ bool shader_hasUniform(const unsigned int programID, const char* name) {
 // so remember to call renderer_useShader(int shader) first!
 void shader_setBoolean(const unsigned int programID, const char* name, bool value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform1i(location, value);
 }
 // sets float uniform
@@ -85,6 +100,7 @@ void shader_setBoolean(const unsigned int programID, const char* name, bool valu
 // so remember to call renderer_useShader(int shader) first!
 void shader_setFloat(const unsigned int programID, const char* name, float value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform1f(location, value);
 }
 // sets integer uniform
@@ -92,6 +108,7 @@ void shader_setFloat(const unsigned int programID, const char* name, float value
 // so remember to call renderer_useShader(int shader) first!
 void shader_setInteger(const unsigned int programID, const char* name, int value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform1i(location, value);
 }
 // sets float vector 2 uniform
@@ -99,6 +116,7 @@ void shader_setInteger(const unsigned int programID, const char* name, int value
 // so remember to call renderer_useShader(int shader) first!
 void shader_setFloat2(const unsigned int programID, const char* name, vec2 value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform2f(location, value.x, value.y);
 }
 // sets int vector 2 uniform
@@ -106,6 +124,7 @@ void shader_setFloat2(const unsigned int programID, const char* name, vec2 value
 // so remember to call renderer_useShader(int shader) first!
 void shader_setInteger2(const unsigned int programID, const char* name, int value[2]) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform2i(location, value[0], value[1]);
 }
 // sets float vector 3 uniform
@@ -113,6 +132,7 @@ void shader_setInteger2(const unsigned int programID, const char* name, int valu
 // so remember to call renderer_useShader(int shader) first!
 void shader_setFloat3(const unsigned int programID, const char* name, vec3 value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform3f(location, value.x, value.y, value.z);
 }
 // sets int vector 3 uniform
@@ -120,6 +140,7 @@ void shader_setFloat3(const unsigned int programID, const char* name, vec3 value
 // so remember to call renderer_useShader(int shader) first!
 void shader_setInteger3(const unsigned int programID, const char* name, int value[3]) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform3i(location, value[0], value[1], value[2]);
 }
 // sets float vector 4 uniform
@@ -127,6 +148,7 @@ void shader_setInteger3(const unsigned int programID, const char* name, int valu
 // so remember to call renderer_useShader(int shader) first!
 void shader_setFloat4(const unsigned int programID, const char* name, vec4 value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform4f(location, value.x, value.y, value.z, value.w);
 }
 // sets int vector 4 uniform
@@ -134,6 +156,7 @@ void shader_setFloat4(const unsigned int programID, const char* name, vec4 value
 // so remember to call renderer_useShader(int shader) first!
 void shader_setInteger4(const unsigned int programID, const char* name, int value[4]) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     glUniform4i(location, value[0], value[1], value[2], value[3]);
 }
 // sets 2x2 float matrix uniform
@@ -141,6 +164,7 @@ void shader_setInteger4(const unsigned int programID, const char* name, int valu
 // so remember to call renderer_useShader(int shader) first!
 void shader_setMatrix2(const unsigned int programID, const char* name, mat2 value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     // GL_TRUE is there to transpose the matrix as glUniformMatrix2fv() uses column-major order while linal.h uses row-major order
     glUniformMatrix2fv(location, 1, GL_TRUE, value.entries);
 }
@@ -149,6 +173,7 @@ void shader_setMatrix2(const unsigned int programID, const char* name, mat2 valu
 // so remember to call renderer_useShader(int shader) first!
 void shader_setMatrix3(const unsigned int programID, const char* name, mat3 value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     // GL_TRUE is there to transpose the matrix as glUniformMatrix2fv() uses column-major order while linal.h uses row-major order
     glUniformMatrix3fv(location, 1, GL_TRUE, value.entries);
 }
@@ -157,6 +182,7 @@ void shader_setMatrix3(const unsigned int programID, const char* name, mat3 valu
 // so remember to call renderer_useShader(int shader) first!
 void shader_setMatrix4(const unsigned int programID, const char* name, mat4 value) {
     int location = glGetUniformLocation(programID, name);
+    renderStats.uniformUploads++;
     // GL_TRUE is there to transpose the matrix as glUniformMatrix2fv() uses column-major order while linal.h uses row-major order
     glUniformMatrix4fv(location, 1, GL_TRUE, value.entries);
 }
\ No newline at end of file
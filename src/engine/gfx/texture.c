@@ -1,19 +1,53 @@
 /*
 TEXTURE:
-2D Texture handler module
+2D Texture and 2D Texture Array handler module
 */
 
+#include <stdlib.h>
+
 #include <glad/glad.h>
 #include <stbi/stb_image.h>
 
+#include "engine/gfx/dds.h"
+#include "engine/gfx/mipmap.h"
+#include "engine/gfx/renderer.h"
+#include "engine/utils/file.h"
 #include "engine/utils/console.h"
+#include "engine/utils/memory.h"
+#include "engine/utils/profiler.h"
 
 #include "engine/gfx/texture.h"
 
+// decodes an image file through a read-only mapping of it (stb_image reads it once from start to end, so no copy of the file is made)
+static unsigned char* texture_loadImage(char* path, int* width, int* height, int* channels, int desiredChannels) {
+    FileView view;
+    if (!file_map(path, &view)) return NULL;
+    file_advise(&view, FILE_ACCESS_SEQUENTIAL);
+
+    unsigned char* data = stbi_load_from_memory(view.data, (int) view.size, width, height, channels, desiredChannels);
+
+    file_unmap(&view);
+    return data;
+}
+
+// returns the bytes of an uncompressed texture with a full mip chain (the drivers store the RGB texels as RGBA ones)
+static size_t texture_getMipmappedSize(int width, int height, int layers) {
+    size_t size = 0;
+    while (true) {
+        size += (size_t) width * height * 4;
+        if (width == 1 && height == 1) break;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return size * layers;
+}
+
 // creates a texture loading an image from the given path ("./file" means it is in "g3ce").
 // REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
 // If you assign the texture to a mesh via mesh_assignTexture() destroying the mesh will also destroy the texture.
 unsigned int texture_create(char* path, bool hasTransparency) {
+    PROFILE_FUNCTION();
+
     // generate the texture
     unsigned int texture;
     glGenTextures(1, &texture);
@@ -22,11 +56,12 @@ unsigned int texture_create(char* path, bool hasTransparency) {
 
     // load image file content into the bound texture
     int width, height, channels;
-    unsigned char *data = stbi_load(path, &width, &height, &channels, 0);
+    unsigned char *data = texture_loadImage(path, &width, &height, &channels, 0);
     if (data) {
         glTexImage2D(GL_TEXTURE_2D, 0, hasTransparency ? GL_RGBA : GL_RGB, width, height, 0, hasTransparency ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, data);
         // either do this or set filtering and wrapping parameters before rendering
         glGenerateMipmap(GL_TEXTURE_2D);
+        memory_trackGpu(MEMORY_GPU_TEXTURE, texture, MEMORY_TAG_TEXTURE, texture_getMipmappedSize(width, height, 1));
     } else {
         console_error("Failed to load texture at \"%s\"", path);
         return -1;
@@ -40,8 +75,307 @@ unsigned int texture_create(char* path, bool hasTransparency) {
     return texture;
 }
 
+/*
+Creates a texture decoding an image file (PNG, JPG, ...) that has already been read into memory,
+e.g. by an asynchronous read (see io.h) or from a packed archive.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - data (unsigned char*): the image file content
+    - size (size_t): the image file size in bytes
+    - hasTransparency (bool): whether the image has an alpha channel
+Returns:
+    The texture id
+*/
+unsigned int texture_createFromMemory(const unsigned char* data, size_t size, bool hasTransparency) {
+    PROFILE_FUNCTION();
+
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory(data, (int) size, &width, &height, &channels, hasTransparency ? 4 : 3);
+    if (!pixels) {
+        console_error("Failed to decode texture from memory (%s)", stbi_failure_reason());
+        return -1;
+    }
+
+    // generate the texture
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    // bind the texture
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // RGB rows are not always 4 bytes aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, hasTransparency ? GL_RGBA : GL_RGB, width, height, 0, hasTransparency ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    memory_trackGpu(MEMORY_GPU_TEXTURE, texture, MEMORY_TAG_TEXTURE, texture_getMipmappedSize(width, height, 1));
+
+    // free the stb image
+    stbi_image_free(pixels);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+/*
+Creates a texture loading an image from the given path ("./file" means it is in "g3ce"), generating its mip chain on the CPU
+(see mipmap.h) instead of calling glGenerateMipmap(), so the filter can be chosen and sRGB images are filtered in linear space.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - path (char*): the image path
+    - hasTransparency (bool): whether the image has an alpha channel
+    - filter (MipmapFilter): the filter used for downsampling (MIPMAP_FILTER_BOX or MIPMAP_FILTER_KAISER)
+    - srgb (bool): whether the image colors are sRGB encoded (almost every color texture is)
+Returns:
+    The texture id
+*/
+unsigned int texture_createWithMipmaps(char* path, bool hasTransparency, MipmapFilter filter, bool srgb) {
+    PROFILE_FUNCTION();
+
+    // always load 4 channels, that is what the mip chain generator works with
+    int width, height, channels;
+    unsigned char* data = texture_loadImage(path, &width, &height, &channels, 4);
+    if (!data) {
+        console_error("Failed to load texture at \"%s\"", path);
+        return -1;
+    }
+
+    MipChain chain;
+    const bool generated = mipmap_generate(data, width, height, filter, srgb, &chain);
+    // free the stb image
+    stbi_image_free(data);
+    if (!generated) {
+        console_error("Failed to generate the mip chain of texture at \"%s\"", path);
+        return -1;
+    }
+
+    unsigned int texture = texture_createFromMipChain(&chain, hasTransparency);
+    mipmap_free(&chain);
+
+    return texture;
+}
+
+/*
+Creates a texture from a mip chain generated by mipmap_generate(), uploading all of its levels at once.
+The mip chain can be generated on any thread (e.g. while loading in the background), only this call needs the OpenGL context.
+The mip chain is not freed, so call mipmap_free() when it is not needed anymore.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - chain (MipChain*): the mip chain to upload
+    - hasTransparency (bool): whether the alpha channel has to be kept
+Returns:
+    The texture id
+*/
+unsigned int texture_createFromMipChain(const MipChain* chain, bool hasTransparency) {
+    PROFILE_FUNCTION();
+
+    // generate the texture
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    // bind the texture
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // only the levels of the chain exist, so tell OpenGL not to look for more
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain->levelCount - 1);
+
+    size_t size = 0;
+    for (unsigned int i = 0; i < chain->levelCount; i++) {
+        const MipLevel* level = &chain->levels[i];
+        glTexImage2D(GL_TEXTURE_2D, i, hasTransparency ? GL_RGBA : GL_RGB, level->width, level->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level->data);
+        size += (size_t) level->width * level->height * 4;
+    }
+    memory_trackGpu(MEMORY_GPU_TEXTURE, texture, MEMORY_TAG_TEXTURE, size);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+// compressed formats (they are not part of the core profile, so GLAD does not define them)
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+/*
+Creates a texture loading a block compressed DDS file (BC1, BC3 or BC7) from the given path ("./file" means it is in "g3ce"),
+including all the mip levels stored in the file (see the G3CE_texconv tool to create such files).
+The blocks are uploaded as they are when the driver supports the format, otherwise they are decompressed on the CPU first.
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+*/
+unsigned int texture_createCompressed(char* path) {
+    PROFILE_FUNCTION();
+
+    // the blocks are uploaded straight from the mapped file
+    FileView view;
+    if (!file_map(path, &view)) {
+        console_error("Failed to load compressed texture at \"%s\"", path);
+        return -1;
+    }
+    file_advise(&view, FILE_ACCESS_SEQUENTIAL);
+
+    DdsImage image;
+    if (!dds_parse(view.data, view.size, &image)) {
+        console_error("Failed to parse compressed texture at \"%s\"", path);
+        file_unmap(&view);
+        return -1;
+    }
+
+    // check whether the driver can sample the blocks directly
+    unsigned int glFormat;
+    bool supported;
+    if (image.format == BCN_FORMAT_BC7) {
+        glFormat = GL_COMPRESSED_RGBA_BPTC_UNORM;
+        supported = renderer_hasGLExtension("GL_ARB_texture_compression_bptc");
+    } else {
+        glFormat = image.format == BCN_FORMAT_BC1 ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        supported = renderer_hasGLExtension("GL_EXT_texture_compression_s3tc");
+    }
+
+    // generate the texture
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    // bind the texture
+    glBindTexture(GL_TEXTURE_2D, texture);
+
+    // only the levels stored in the file exist, so tell OpenGL not to look for more
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levelCount - 1);
+
+    size_t size = 0;
+    if (supported) {
+        for (unsigned int i = 0; i < image.levelCount; i++) {
+            DdsLevel* level = &image.levels[i];
+            glCompressedTexImage2D(GL_TEXTURE_2D, i, glFormat, level->width, level->height, 0, level->size, level->data);
+            size += level->size;
+        }
+    } else {
+        console_warning("Compressed texture format not supported by the driver, decompressing \"%s\" on the CPU", path);
+
+        // the first level is the biggest one, so its buffer fits all the others
+        unsigned char* pixels = (unsigned char*) malloc((size_t) image.width * image.height * 4);
+        if (pixels == NULL) {
+            console_error("Failed to allocate memory for decompressing texture at \"%s\"", path);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            glDeleteTextures(1, &texture);
+            file_unmap(&view);
+            return -1;
+        }
+
+        for (unsigned int i = 0; i < image.levelCount; i++) {
+            DdsLevel* level = &image.levels[i];
+            if (!bcn_decompressImage(image.format, level->data, level->width, level->height, pixels)) {
+                console_error("Failed to decompress mip level %u of texture at \"%s\"", i, path);
+                free(pixels);
+                glBindTexture(GL_TEXTURE_2D, 0);
+                glDeleteTextures(1, &texture);
+                file_unmap(&view);
+                return -1;
+            }
+            glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level->width, level->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            size += (size_t) level->width * level->height * 4;
+        }
+
+        free(pixels);
+    }
+
+    memory_trackGpu(MEMORY_GPU_TEXTURE, texture, MEMORY_TAG_TEXTURE, size);
+
+    // the file is not needed anymore once uploaded
+    file_unmap(&view);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    return texture;
+}
+
+/*
+Creates a 2D texture array loading one image per layer from the given paths ("./file" means it is in "g3ce").
+All the images MUST have the same size. Each layer can then be selected in the shader via the third texture coordinate
+(e.g. a per-vertex layer index attribute), so differently textured meshes can share the same texture binding (and draw call).
+REMEMBER TO DESTROY IT BY CALLING texture_destroy()!
+Parameters:
+    - paths (char**): the array of image paths, the first path is layer 0
+    - count (unsigned int): the number of paths (and so of layers)
+    - hasTransparency (bool): whether the images have an alpha channel
+Returns:
+    The texture id (it must be bound as a GL_TEXTURE_2D_ARRAY, see renderer_bindTextureArray() and mesh_assignTextureArray())
+*/
+unsigned int texture_createArray(char** paths, unsigned int count, bool hasTransparency) {
+    PROFILE_FUNCTION();
+
+    if (count == 0) {
+        console_error("Cannot create a texture array with no layers");
+        return -1;
+    }
+
+    // force the number of channels so that every layer has the same memory layout
+    const int channels = hasTransparency ? 4 : 3;
+    const unsigned int format = hasTransparency ? GL_RGBA : GL_RGB;
+
+    // generate the texture
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    // bind the texture
+    glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+
+    // RGB rows are not always 4 bytes aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    int width = 0, height = 0;
+    for (unsigned int layer = 0; layer < count; layer++) {
+        int layerWidth, layerHeight, layerChannels;
+        unsigned char* data = texture_loadImage(paths[layer], &layerWidth, &layerHeight, &layerChannels, channels);
+        if (!data) {
+            console_error("Failed to load texture array layer %u at \"%s\"", layer, paths[layer]);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            glDeleteTextures(1, &texture);
+            return -1;
+        }
+
+        // the first layer decides the size of the whole array
+        if (layer == 0) {
+            width = layerWidth;
+            height = layerHeight;
+            // allocate the storage for all the layers at once
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, format, width, height, count, 0, format, GL_UNSIGNED_BYTE, NULL);
+        } else if (layerWidth != width || layerHeight != height) {
+            console_error("Texture array layer %u at \"%s\" is %dx%d, but the array is %dx%d", layer, paths[layer], layerWidth, layerHeight, width, height);
+            stbi_image_free(data);
+            glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+            glDeleteTextures(1, &texture);
+            return -1;
+        }
+
+        // upload the layer
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, format, GL_UNSIGNED_BYTE, data);
+
+        // free the stb image
+        stbi_image_free(data);
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    // mipmaps are generated for every layer independently
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    memory_trackGpu(MEMORY_GPU_TEXTURE, texture, MEMORY_TAG_TEXTURE, texture_getMipmappedSize(width, height, count));
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    return texture;
+}
+
 // destroys a given texture
 void texture_destroy(unsigned int texture) {
+    memory_untrackGpu(MEMORY_GPU_TEXTURE, texture);
     glDeleteTextures(1, &texture);
 }
 
@@ -63,7 +397,7 @@ void texture_setFilter(unsigned int texture, unsigned int filter, unsigned int m
     }
 
     glBindTexture(GL_TEXTURE_2D, texture);
-    glTextureParameteri(GL_TEXTURE_2D, filter, mode);
+    glTexParameteri(GL_TEXTURE_2D, filter, mode);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -89,7 +423,7 @@ void texture_setWrapping(unsigned int texture, unsigned int wrap, unsigned int m
     }
 
     glBindTexture(GL_TEXTURE_2D, texture);
-    glTextureParameteri(GL_TEXTURE_2D, wrap, mode);
+    glTexParameteri(GL_TEXTURE_2D, wrap, mode);
     glBindTexture(GL_TEXTURE_2D, 0);
 }
 
@@ -1,6 +1,9 @@
 /*
 CAMERA:
 Holds all camera related functions (basically more matrix math!)
+The rotation is stored as a normalized quaternion turning the camera axes into the world ones:
+yawing turns around the world up axis while pitching and rolling turn around the camera own axes,
+so an orbiting camera never locks its gimbal.
 */
 
 #include <stdlib.h>
@@ -8,27 +11,31 @@ Holds all camera related functions (basically more matrix math!)
 
 #include "engine/math/linal.h"
 #include "engine/utils/console.h"
+#include "engine/utils/memory.h"
 
 #include "engine/math/camera.h"
 
+// the heap cameras (see camera_create())
+static Pool camera_pool = POOL_INIT(sizeof(Camera), 16, MEMORY_TAG_ENGINE);
+
 // creates a camera positioned at the world origin (0, 0, 0)
 // and looking forward with rotation angles all set to zero
 // REMEMBER you MUST DESTROY the camera via camera_destroy()!
 Camera* camera_create() {
-    Camera* c = (Camera*) malloc(sizeof(Camera));
+    Camera* c = (Camera*) pool_alloc(&camera_pool);
     if (c == NULL) {
         console_error("Failed to allocate memory for the camera");
         return NULL;
     }
 
     c->position = vec3_zero();
-    c->rotation = vec3_zero();
+    c->rotation = quat_identity();
 
     return c;
 }
 // destroys the given camera
 void camera_destroy(Camera* c) {
-    free(c);
+    pool_free(&camera_pool, c);
 }
 
 // SETTERS
@@ -38,11 +45,11 @@ void camera_setPosition(Camera* c, float x, float y, float z) {
     c->position.y = y;
     c->position.z = z;
 }
-// sets the given camera position to the given pitch, yaw and roll values
+// sets the given camera rotation to the given pitch, yaw and roll values (angles are in degrees)
 void camera_setRotation(Camera* c, float pitch, float yaw, float roll) {
-    c->rotation.x = pitch;
-    c->rotation.y = yaw;
-    c->rotation.z = roll;
+    // the camera pitches first, then yaws and finally rolls (Rz * Ry * Rx),
+    // which is the inverse of the transforms rotation by the negated angles
+    c->rotation = quat_conjugate(quat_fromEuler(vec3_new(-pitch, -yaw, -roll)));
 }
 
 // OPERATIONS
@@ -58,61 +65,46 @@ void camera_move(Camera* c, float xm, float ym, float zm) {
     c->position.y += ym;
     c->position.z += zm;
 }
-// rotates the camera by the given rotation vector
+// rotates the camera by the given rotation vector (pitch, yaw, roll) (angles are in degrees)
 void camera_rotateByVector(Camera* c, vec3 rotation) {
-    c->rotation.x += rotation.x;
-    c->rotation.y += rotation.y;
-    c->rotation.z += rotation.z;
+    camera_rotate(c, rotation.x, rotation.y, rotation.z);
 }
-// rotates the camera by the given angles
+// rotates the camera by the given angles (pitch, yaw, roll) (angles are in degrees)
 void camera_rotate(Camera* c, float xr, float yr, float zr) {
-    c->rotation.x += xr;
-    c->rotation.y += yr;
-    c->rotation.z += zr;
+    // the yaw is applied after the current rotation (world up axis),
+    // the pitch and the roll before it (camera axes), so the horizon stays level without a roll
+    quat rotation = c->rotation;
+    if (yr != 0) rotation = quat_multiply(quat_rotation(vec3_new(0, 1, 0), yr), rotation);
+    if (xr != 0) rotation = quat_multiply(rotation, quat_rotation(vec3_new(1, 0, 0), xr));
+    if (zr != 0) rotation = quat_multiply(rotation, quat_rotation(vec3_new(0, 0, 1), zr));
+    // normalizing keeps the rounding errors from piling up
+    c->rotation = quat_normalize(rotation);
+}
+// rotates the camera by the given angle (in degrees) around the given world axis
+void camera_rotateAxisAngle(Camera* c, vec3 axis, float angle) {
+    c->rotation = quat_normalize(quat_multiply(quat_rotation(vec3_normalize(axis), angle), c->rotation));
+}
+// rotates the camera to look at the given target, with its up vector towards the given up direction
+void camera_lookAt(Camera* c, vec3 target, vec3 up) {
+    // nothing to look at from the target itself, the rotation is kept
+    vec3 forward = vec3_difference(target, c->position);
+    if (vec3_dot(forward, forward) == 0) return;
+    c->rotation = quat_lookRotation(forward, up);
 }
 
 // CAMERA COORDINATE SYSTEM
 // returns the x axis direction of the camera centered coordinate system
 vec3 camera_getPositiveX(Camera* c) {
-    // by taking the world up vector (y axis versor)
-    // and doing a cross product with the forward we get the camera right vector
-    // (as you always get a vector perpendicular to both)
-    vec3 worldUp = vec3_new(0, 1, 0);
-    // be careful because cross product order matters
-    // following the right hand rule we first put world up vector (right index finger),
-    // then the the positive Z vector (right thumb) and we get the positive X vector
-    // pointing to the right (right middle finger)
-    // inverting the order would produce a positive X vector pointing to the negative X
-    vec3 positiveX = vec3_cross(worldUp, camera_getPositiveZ(c));
-
-    return positiveX;
+    // the camera axes are the world ones turned by the camera rotation
+    return quat_vec3_rotate(c->rotation, vec3_new(1, 0, 0));
 }
 // returns the y axis direction of the camera centered coordinate system
 vec3 camera_getPositiveY(Camera* c) {
-    // the camera positive Y vector is given by doing a
-    // cross product between the camera forward and up vectors
-    // (as you always get a vector perpendicular to both)
-
-    // be careful because cross product order matters
-    // following the right hand rule we first put the positive Z vector (right index finger),
-    // then the positive X vector (right thumb) and we get the positive Y vector
-    // pointing positive Y (right middle finger)
-    // inverting the order would produce a positive Y vector pointing to the negative Y
-    vec3 positiveY = vec3_cross(camera_getPositiveZ(c), camera_getPositiveX(c));
-
-    return positiveY;
+    return quat_vec3_rotate(c->rotation, vec3_new(0, 1, 0));
 }
 // returns the z axis direction of the camera centered coordinate system
 vec3 camera_getPositiveZ(Camera* c) {
-    // the positive z direction vector can be obtained through the spherical polar coordinates
-    const float theta = c->rotation.x * DEGREES_TO_RADIANS;
-    const float phi = c->rotation.y * DEGREES_TO_RADIANS;
-    const float x = sinf(phi) * cosf(theta);
-    const float y = -sinf(theta);
-    const float z = cosf(phi) * cosf(theta);
-    vec3 positiveZ = vec3_new(x, y, z);
-
-    return positiveZ;
+    return quat_vec3_rotate(c->rotation, vec3_new(0, 0, 1));
 }
 
 // returns the forward vector (the vector pointing forward with respect to the camera)
@@ -149,15 +141,8 @@ mat4 camera_getViewMatrix(Camera* c) {
     // it's the world that revolves around the camera
     mat4 translationMatrix = mat4_translation(vec3_negate(c->position, TARGET_ALL));
     
-    // use a quaternion based rotation system
-    quat xRot = quat_rotation(vec3_new(1, 0, 0), -c->rotation.x);
-    quat yRot = quat_rotation(vec3_new(0, 1, 0), -c->rotation.y);
-    quat zRot = quat_rotation(vec3_new(0, 0, 1), -c->rotation.z);
-    quat rotationQuat = quat_multiply(xRot, yRot);
-    rotationQuat = quat_multiply(rotationQuat, zRot);
-    // convert to rotation matrix
-    mat4 rotationMatrix = quat_to_mat4(rotationQuat);
-    // mat4 rotationMatrix = mat4_eulerRotation(vec3_new(-(c->pitch), -(c->yaw), 0));
+    // the world rotates the other way around the camera (the conjugate is the inverse of a unit quaternion)
+    mat4 rotationMatrix = quat_to_mat4(quat_conjugate(c->rotation));
 
     // translate first, then rotate
     // this is the right order as you should first translate the world
@@ -390,6 +390,40 @@ quat quat_rotation(vec3 axis, float angle) {
         axis.z * sinHalfT
     );
 }
+// returns a rotation quaternion based on the given Tait-Bryan angles (pitch, yaw, roll) in degrees, composed as the transforms do (Rx * Ry * Rz)
+quat quat_fromEuler(vec3 angles) {
+    // the product of the three axis rotations written out (the roll is applied first, then the yaw and finally the pitch)
+    const float cx = cosf(angles.x * DEGREES_TO_RADIANS / 2), sx = sinf(angles.x * DEGREES_TO_RADIANS / 2);
+    const float cy = cosf(angles.y * DEGREES_TO_RADIANS / 2), sy = sinf(angles.y * DEGREES_TO_RADIANS / 2);
+    const float cz = cosf(angles.z * DEGREES_TO_RADIANS / 2), sz = sinf(angles.z * DEGREES_TO_RADIANS / 2);
+    return quat_new(
+        cx * cy * cz - sx * sy * sz,
+        sx * cy * cz + cx * sy * sz,
+        cx * sy * cz - sx * cy * sz,
+        cx * cy * sz + sx * sy * cz
+    );
+}
+// returns the rotation quaternion turning the negative z axis towards the given forward direction, keeping the y axis as close as possible to the given up direction
+quat quat_lookRotation(vec3 forward, vec3 up) {
+    // the rotated axes are the columns of the rotation matrix
+    const vec3 z = vec3_normalize(vec3_negate(forward, TARGET_ALL));
+    if (vec3_dot(z, z) == 0) return quat_identity();
+    vec3 x = vec3_cross(up, z);
+    if (vec3_dot(x, x) < 1e-12f) {
+        // the up direction is parallel to the forward one, any other will do
+        x = vec3_cross(fabsf(z.z) < 0.9f ? vec3_new(0, 0, 1) : vec3_new(1, 0, 0), z);
+    }
+    x = vec3_normalize(x);
+    const vec3 y = vec3_cross(z, x);
+
+    float entries[16] = {
+        x.x,  y.x,  z.x,  0,
+        x.y,  y.y,  z.y,  0,
+        x.z,  y.z,  z.z,  0,
+        0,    0,    0,    1
+    };
+    return quat_normalize(mat4_to_quat(mat4_new(entries)));
+}
 
 // LINEAR ALGEBRA OPERATIONS
 
@@ -655,7 +689,7 @@ void generic_matrix_multiplication(float* m0, float* m1, unsigned int r0, unsign
             for (int k = 0; k < n; k++) {
                 currentEntry += m0[k + i * n] * m1[j + k * c1];
             }
-            result[j + i * n] = currentEntry;
+            result[j + i * c1] = currentEntry;
         }
     }
 }
@@ -784,6 +818,53 @@ quat quat_multiply(quat q0, quat q1) {
     result.w = q0.w * q1.w - q0.x * q1.x - q0.y * q1.y - q0.z * q1.z;
     return result;
 }
+// evaluates the dot product of two quaternions and returns the result
+float quat_dot(quat q0, quat q1) {
+    return q0.w * q1.w + q0.x * q1.x + q0.y * q1.y + q0.z * q1.z;
+}
+// returns the conjugate of the given quaternion (the inverse rotation of a unit quaternion)
+quat quat_conjugate(quat q) {
+    return quat_new(q.w, -q.x, -q.y, -q.z);
+}
+// normalizes the given quaternion and returns the result (an identity quaternion if its magnitude is zero)
+quat quat_normalize(quat q) {
+    const float magnitude = sqrtf(quat_dot(q, q));
+    if (magnitude == 0) return quat_identity();
+    const float inverse = 1 / magnitude;
+    return quat_new(q.w * inverse, q.x * inverse, q.y * inverse, q.z * inverse);
+}
+// interpolates linearly between two rotation quaternions along the shortest path and returns the normalized result (t from 0 to 1)
+quat quat_nlerp(quat q0, quat q1, float t) {
+    // q and -q are the same rotation, take the one on the same side of q0
+    const float s = quat_dot(q0, q1) < 0 ? -t : t;
+    return quat_normalize(quat_new(
+        q0.w + (q1.w * s - q0.w * t),
+        q0.x + (q1.x * s - q0.x * t),
+        q0.y + (q1.y * s - q0.y * t),
+        q0.z + (q1.z * s - q0.z * t)
+    ));
+}
+// interpolates spherically between two rotation quaternions along the shortest path (constant angular speed) and returns the result (t from 0 to 1)
+quat quat_slerp(quat q0, quat q1, float t) {
+    float cosTheta = quat_dot(q0, q1);
+    if (cosTheta < 0) {
+        q1 = quat_new(-q1.w, -q1.x, -q1.y, -q1.z);
+        cosTheta = -cosTheta;
+    }
+    // the rotations are too close for the sine of their angle to be divided by, the linear interpolation is as good
+    if (cosTheta > 0.9995f) return quat_nlerp(q0, q1, t);
+
+    const float theta = acosf(cosTheta);
+    const float sinTheta = sinf(theta);
+    const float w0 = sinf((1 - t) * theta) / sinTheta;
+    const float w1 = sinf(t * theta) / sinTheta;
+    return quat_new(
+        q0.w * w0 + q1.w * w1,
+        q0.x * w0 + q1.x * w1,
+        q0.y * w0 + q1.y * w1,
+        q0.z * w0 + q1.z * w1
+    );
+}
 
 // MIXED OPERATIONS
 // 2D, 3D
@@ -812,6 +893,15 @@ vec4 mat4_vec4_multiply(mat4 m, vec4 v) {
     return vec4_new(result[0], result[1], result[2], result[3]);
 }
 
+// QUATERNION with VECTOR ROTATION
+// rotates a vector by a rotation quaternion and returns the result
+vec3 quat_vec3_rotate(quat q, vec3 v) {
+    // v + 2w (u x v) + 2 u x (u x v), with u the vector part (cheaper than q * v * q^-1)
+    const vec3 u = vec3_new(q.x, q.y, q.z);
+    const vec3 t = vec3_scale(vec3_cross(u, v), 2);
+    return vec3_sum(vec3_sum(v, vec3_scale(t, q.w)), vec3_cross(u, t));
+}
+
 // MATRIX to QUATERNION and viceversa
 // converts a rotation quaternion to a 4D rotation matrix
 mat4 quat_to_mat4(quat q) {
@@ -852,9 +942,9 @@ quat mat4_to_quat(mat4 m) {
         result.y = (m.entries[2 + 0 * 4] - m.entries[0 + 2 * 4]) / s;
         result.z = (m.entries[0 + 1 * 4] - m.entries[1 + 0 * 4]) / s;
     // 3. trace <= 0
-    } else if (trace <= 0) {
+    } else {
         // m00 is the greatest
-        if (m00 > m11 && m00 > m22) {
+        if (m00 >= m11 && m00 >= m22) {
             const float s = sqrt(1.0f + m.entries[0 + 0 * 4] - m.entries[1 + 1 * 4] - m.entries[2 + 2 * 4]) * 2.0f;
             
             result.w = (m.entries[1 + 2 * 4] - m.entries[2 + 1 * 4]) / s;
@@ -862,7 +952,7 @@ quat mat4_to_quat(mat4 m) {
             result.y = (m.entries[1 + 0 * 4] + m.entries[0 + 1 * 4]) / s;
             result.z = (m.entries[2 + 0 * 4] + m.entries[0 + 2 * 4]) / s;
         // m11 is the greatest
-        } else if (m11 > m00 && m11 > m22) {
+        } else if (m11 >= m22) {
             const float s = sqrt(1.0f + m.entries[1 + 1 * 4] - m.entries[0 + 0 * 4] - m.entries[2 + 2 * 4]) * 2.0f;
             
             result.w = (m.entries[2 + 0 * 4] - m.entries[0 + 2 * 4]) / s;
@@ -870,7 +960,7 @@ quat mat4_to_quat(mat4 m) {
             result.y = 0.25f * s;
             result.z = (m.entries[2 + 1 * 4] + m.entries[1 + 2 * 4]) / s;
         // m22 is the greatest
-        } else if (m22 > m00 && m22 > m11) {
+        } else {
             const float s = sqrt(1.0f + m.entries[2 + 2 * 4] - m.entries[0 + 0 * 4] - m.entries[1 + 1 * 4]) * 2.0f;
             
             result.w = (m.entries[0 + 1 * 4] - m.entries[1 + 0 * 4]) / s;
@@ -879,6 +969,25 @@ quat mat4_to_quat(mat4 m) {
             result.z = 0.25f * s;
         }
     }
+
+    return result;
+}
+// converts a rotation quaternion to the Tait-Bryan angles (pitch, yaw, roll) in degrees of quat_fromEuler()
+vec3 quat_toEuler(quat q) {
+    // the entries of the rotation matrix needed (Rx * Ry * Rz)
+    const float r02 = 2.0f * (q.x * q.z + q.w * q.y);
+    const float sinY = r02 > 1.0f ? 1.0f : r02 < -1.0f ? -1.0f : r02;
+    vec3 angles;
+    angles.y = asinf(sinY);
+    if (fabsf(sinY) < 0.99999f) {
+        angles.x = atan2f(-2.0f * (q.y * q.z - q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.y * q.y));
+        angles.z = atan2f(-2.0f * (q.x * q.y - q.w * q.z), 1.0f - 2.0f * (q.y * q.y + q.z * q.z));
+    } else {
+        // gimbal lock: the roll is folded into the pitch
+        angles.x = atan2f(2.0f * (q.y * q.z + q.w * q.x), 1.0f - 2.0f * (q.x * q.x + q.z * q.z));
+        angles.z = 0.0f;
+    }
+    return vec3_scale(angles, RADIANS_TO_DEGREES);
 }
 
 // OUTPUT
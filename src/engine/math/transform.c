@@ -4,42 +4,48 @@ This is the transform object.
 It contains all the necessary functions and parameters to describe
 an object position, rotation and scaling.
 It essentially serves bridges the gap between local space and world space
+The rotation is stored as a normalized quaternion: the Euler angles (pitch, yaw, roll) are only converted
+from when set or incremented, so building the model matrix costs no trigonometry.
 */
 
 #include <stdlib.h>
 
 #include "engine/utils/console.h"
+#include "engine/utils/memory.h"
 
 #include "engine/math/transform.h"
 
+// the heap transforms (see transform_create())
+static Pool transform_pool = POOL_INIT(sizeof(Transform), 64, MEMORY_TAG_ENGINE);
+
 // creates a stack allocated blank transform and returns it. This does not need to be destroyed
 Transform transform_new() {
     return (Transform) {
         .position = vec3_zero(),
-        .rotation = vec3_zero(),
+        .rotation = quat_identity(),
         .scale = vec3_one()
     };
 }
 
-// creates a blank transform (posision and rotation are zero vectors, while scale is a one vector)
+// creates a blank transform (posision is a zero vector, rotation an identity quaternion, while scale is a one vector)
 // REMEMBER: you MUST also DESTROY IT at the end via transform_destroy()!
 Transform* transform_create() {
-    // dynamic allocation because the object will likely be there for a long time
-    Transform* t = (Transform*) malloc(sizeof(Transform));
+    // dynamic allocation because the object will likely be there for a long time (from a pool, they are all the same size)
+    Transform* t = (Transform*) pool_alloc(&transform_pool);
     if (t == NULL) {
         console_error("Failed to allocate memory for the transform");
         return NULL;
     }
 
     t->position = vec3_zero();
-    t->rotation = vec3_zero();
+    t->rotation = quat_identity();
     t->scale = vec3_one();
 
     return t;
 }
 // destroys the given transform object
 void transform_destroy(Transform* t) {
-    free(t);
+    pool_free(&transform_pool, t);
 }
 
 // SETTERS
@@ -49,11 +55,9 @@ void transform_setPosition(Transform* t, float x, float y, float z) {
     t->position.y = y;
     t->position.z = z;
 }
-// sets the given transform rotation to the given rotation values
+// sets the given transform rotation to the given rotation values (pitch, yaw, roll) (angles are in degrees, applied as Rx * Ry * Rz)
 void transform_setRotation(Transform* t, float pitch, float yaw, float roll) {
-    t->rotation.x = pitch;
-    t->rotation.y = yaw;
-    t->rotation.z = roll;
+    t->rotation = quat_fromEuler(vec3_new(pitch, yaw, roll));
 }
 // sets the given transform scale to the given scale values
 void transform_setScale(Transform* t, float xs, float ys, float zs) {
@@ -69,11 +73,10 @@ void transform_changePosition(Transform* t, vec3 translation) {
     t->position.y += translation.y;
     t->position.z += translation.z;
 }
-// increments the given transform rotation by the given rotation vector (pitch, yaw, roll) (angles are in degrees)
+// rotates the given transform by the given rotation vector (pitch, yaw, roll) around the parent axes (angles are in degrees)
 void transform_changeRotation(Transform* t, vec3 rotation) {
-    t->rotation.x += rotation.x;
-    t->rotation.y += rotation.y;
-    t->rotation.z += rotation.z;
+    // the increment is applied after the current rotation, normalizing keeps the rounding errors from piling up
+    t->rotation = quat_normalize(quat_multiply(quat_fromEuler(rotation), t->rotation));
 }
 // increment the the given transform scale by the given scaling vector (xs, ys, zs)
 void transform_changeScale(Transform* t, vec3 scaling) {
@@ -88,11 +91,9 @@ void transform_changePositionValues(Transform* t, float xm, float ym, float zm)
     t->position.y += ym;
     t->position.z += zm;
 }
-// increments the given transform rotation by the given rotation values (pitch, yaw, roll) (angles are in degrees)
+// rotates the given transform by the given rotation values (pitch, yaw, roll) around the parent axes (angles are in degrees)
 void transform_changeRotationValues(Transform* t, float xr, float yr, float zr) {
-    t->rotation.x += xr;
-    t->rotation.y += yr;
-    t->rotation.z += zr;
+    transform_changeRotation(t, vec3_new(xr, yr, zr));
 }
 // increment the the given transform scale by the given scaling values (xs, ys, zs)
 void transform_changeScaleValues(Transform* t, float xs, float ys, float zs) {
@@ -101,24 +102,24 @@ void transform_changeScaleValues(Transform* t, float xs, float ys, float zs) {
     t->scale.z += zs;
 }
 
+// rotates the given transform by the given angle (in degrees) around the given axis of the parent space
+void transform_rotateAxisAngle(Transform* t, vec3 axis, float angle) {
+    t->rotation = quat_normalize(quat_multiply(quat_rotation(vec3_normalize(axis), angle), t->rotation));
+}
+// rotates the given transform so that its forward (the negative z axis, as for the cameras) points to the given target, with its y axis towards the given up direction
+void transform_lookAt(Transform* t, vec3 target, vec3 up) {
+    // nothing to look at from the target itself, the rotation is kept
+    vec3 forward = vec3_difference(target, t->position);
+    if (vec3_dot(forward, forward) == 0) return;
+    t->rotation = quat_lookRotation(forward, up);
+}
+
 // MATRIX
 // calculates the model matrix for the given transform and returns it
 mat4 transform_getModelMatrix(Transform* t) {
     mat4 scaleMatrix = mat4_scaling(t->scale);
-
-    // TEST
-    // use a quaternion based rotation system
-    quat xRot = quat_rotation(vec3_new(1, 0, 0), t->rotation.x);
-    quat yRot = quat_rotation(vec3_new(0, 1, 0), t->rotation.y);
-    quat zRot = quat_rotation(vec3_new(0, 0, 1), t->rotation.z);
-    quat rotationQuat = quat_multiply(xRot, yRot);
-    rotationQuat = quat_multiply(rotationQuat, zRot);
-    // convert to rotation matrix
-    mat4 rotationMatrix = quat_to_mat4(rotationQuat);
-    
-    // IF TEST FAILES USE THIS
-    // mat4 rotationMatrix = mat4_eulerRotation(t->rotation);
-    
+    // the rotation is already a quaternion
+    mat4 rotationMatrix = quat_to_mat4(t->rotation);
     mat4 translationMatrix = mat4_translation(t->position);
 
     // scale first, then rotate and finally translate
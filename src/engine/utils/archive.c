@@ -0,0 +1,195 @@
+/*
+ARCHIVE:
+Packed asset archives (created by the G3CE_pack tool) and the virtual file system built on top of them.
+Once an archive is mounted, file_map(), file_read() and file_readBytes() (and so the shader and texture loaders)
+look for the requested path inside the mounted archives first and only fall back to the disk when it is not packed.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine/utils/lz4.h"
+#include "engine/utils/console.h"
+
+#include "engine/utils/archive.h"
+
+// a mounted archive, the header and the index point straight into the mapped file
+typedef struct {
+    FileView view;
+    const ArchiveHeader* header;
+    const ArchiveEntry* entries;
+    const char* strings;
+} MountedArchive;
+
+static MountedArchive mounted_archives[ARCHIVE_MAX_MOUNTS];
+static unsigned int mounted_archive_count = 0;
+
+// skips the leading "./" of a path
+static const char* archive_skipCurrentDirectory(const char* path) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+    return path;
+}
+
+// returns the hash of a path, ignoring any leading "./" and treating "\" as "/" (FNV-1a, 64 bits)
+uint64_t archive_hashPath(const char* path) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char* c = archive_skipCurrentDirectory(path); *c != '\0'; c++) {
+        hash ^= (unsigned char) (*c == '\\' ? '/' : *c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// compares a packed path with a requested one (with the same rules as archive_hashPath())
+static bool archive_pathEquals(const char* packedPath, uint32_t packedLength, const char* path) {
+    path = archive_skipCurrentDirectory(path);
+    for (uint32_t i = 0; i < packedLength; i++) {
+        const char c = path[i] == '\\' ? '/' : path[i];
+        if (c == '\0' || c != packedPath[i]) return false;
+    }
+    return path[packedLength] == '\0';
+}
+
+// looks for a path in a mounted archive, returns NULL if it is not there
+static const ArchiveEntry* archive_findEntry(const MountedArchive* archive, const char* path, uint64_t hash) {
+    // binary search of the first entry with the given hash
+    uint32_t low = 0, high = archive->header->entryCount;
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        if (archive->entries[middle].hash < hash) low = middle + 1;
+        else high = middle;
+    }
+
+    // different paths can share the same hash, so compare the paths too
+    for (uint32_t i = low; i < archive->header->entryCount && archive->entries[i].hash == hash; i++) {
+        const ArchiveEntry* entry = &archive->entries[i];
+        if (archive_pathEquals(archive->strings + entry->pathOffset, entry->pathLength, path)) return entry;
+    }
+    return NULL;
+}
+
+// looks for a path in all the mounted archives (the last mounted first), returns NULL if it is not packed
+static const ArchiveEntry* archive_find(const char* path, const MountedArchive** archive) {
+    if (mounted_archive_count == 0) return NULL;
+
+    const uint64_t hash = archive_hashPath(path);
+    for (unsigned int i = mounted_archive_count; i > 0; i--) {
+        const ArchiveEntry* entry = archive_findEntry(&mounted_archives[i - 1], path, hash);
+        if (entry != NULL) {
+            *archive = &mounted_archives[i - 1];
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+/*
+Mounts an archive (mapping it into memory), so that the files it contains can be loaded through the file module.
+Archives mounted later take precedence over the ones mounted before.
+Mount the archives before loading from other threads: the lookups are lock free, but mounting is not.
+Parameters:
+    - path (char*): the archive path ("./file" means it is in "g3ce")
+Returns:
+    true on success, false otherwise
+*/
+bool archive_mount(char* path) {
+    if (mounted_archive_count >= ARCHIVE_MAX_MOUNTS) {
+        console_error("Cannot mount archive at \"%s\", %d archives are already mounted", path, ARCHIVE_MAX_MOUNTS);
+        return false;
+    }
+
+    MountedArchive archive;
+    if (!file_map(path, &archive.view)) {
+        console_error("Failed to mount archive at \"%s\"", path);
+        return false;
+    }
+    // the index is only looked up at random
+    file_advise(&archive.view, FILE_ACCESS_RANDOM);
+
+    const unsigned char* data = archive.view.data;
+    const size_t size = archive.view.size;
+    archive.header = (const ArchiveHeader*) data;
+    if (size < sizeof(ArchiveHeader) || memcmp(archive.header->magic, ARCHIVE_MAGIC, 4) != 0 || archive.header->version != ARCHIVE_VERSION) {
+        console_error("Invalid archive header in \"%s\"", path);
+        file_unmap(&archive.view);
+        return false;
+    }
+
+    // validate the whole index once, so the lookups do not need to check anything
+    const uint64_t indexSize = (uint64_t) archive.header->entryCount * sizeof(ArchiveEntry);
+    if (archive.header->indexOffset % 8 != 0 || archive.header->indexOffset > size || indexSize > size - archive.header->indexOffset || archive.header->stringsOffset > size) {
+        console_error("Truncated archive index in \"%s\"", path);
+        file_unmap(&archive.view);
+        return false;
+    }
+    archive.entries = (const ArchiveEntry*) (data + archive.header->indexOffset);
+    archive.strings = (const char*) (data + archive.header->stringsOffset);
+    for (uint32_t i = 0; i < archive.header->entryCount; i++) {
+        const ArchiveEntry* entry = &archive.entries[i];
+        const bool pathInside = (uint64_t) entry->pathOffset + entry->pathLength <= size - archive.header->stringsOffset;
+        const bool dataInside = entry->offset <= size && entry->size <= size - entry->offset;
+        const bool sorted = i == 0 || archive.entries[i - 1].hash <= entry->hash;
+        if (!pathInside || !dataInside || !sorted) {
+            console_error("Corrupted archive entry %u in \"%s\"", i, path);
+            file_unmap(&archive.view);
+            return false;
+        }
+    }
+
+    mounted_archives[mounted_archive_count++] = archive;
+    return true;
+}
+
+// unmounts all the mounted archives (the views returned by archive_map() without decompressing must not be used anymore)
+void archive_unmountAll() {
+    for (unsigned int i = 0; i < mounted_archive_count; i++) file_unmap(&mounted_archives[i].view);
+    mounted_archive_count = 0;
+}
+
+// returns true if the given path is packed in one of the mounted archives
+bool archive_contains(const char* path) {
+    const MountedArchive* archive;
+    return archive_find(path, &archive) != NULL;
+}
+
+/*
+Looks for a path in the mounted archives and returns a read-only view of its content.
+Uncompressed entries point straight into the mapped archive, compressed ones are decompressed into a heap buffer.
+This function does not log anything when the path is not found, so it can be used to check the archives before the disk.
+REMEMBER TO RELEASE IT BY CALLING file_unmap()!
+Parameters:
+    - path (char*): the path of the packed file (e.g. "./assets/shaders/default_vertex.glsl")
+    - view (FileView*): where to store the view
+Returns:
+    true if the path has been found (and decompressed), false otherwise
+*/
+bool archive_map(const char* path, FileView* view) {
+    const MountedArchive* archive;
+    const ArchiveEntry* entry = archive_find(path, &archive);
+    if (entry == NULL) return false;
+
+    const unsigned char* data = archive->view.data + entry->offset;
+    if (!(entry->flags & ARCHIVE_FLAG_COMPRESSED)) {
+        view->data = data;
+        view->size = entry->size;
+        view->type = FILE_VIEW_ARCHIVE;
+        return true;
+    }
+
+    // allocate at least one byte so that empty files still return a valid pointer
+    unsigned char* buffer = (unsigned char*) malloc(entry->originalSize > 0 ? entry->originalSize : 1);
+    if (buffer == NULL) {
+        console_error("Failed to allocate memory for decompressing packed file \"%s\"", path);
+        return false;
+    }
+    if (!lz4_decompress(data, entry->size, buffer, entry->originalSize)) {
+        console_error("Failed to decompress packed file \"%s\"", path);
+        free(buffer);
+        return false;
+    }
+
+    view->data = buffer;
+    view->size = entry->originalSize;
+    view->type = FILE_VIEW_HEAP;
+    return true;
+}
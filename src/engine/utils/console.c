@@ -1,16 +1,244 @@
 /*
 CONSOLE:
 Output handling (info, warning, error, debug)
+Once console_startAsync() has been called the messages are formatted by the calling thread into a lock-free ring
+buffer (a bounded multi producer queue where every slot has a sequence number telling whether it is free or filled),
+and a background thread writes them out, so logging never waits for the terminal.
 */
 
 #include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
 
 #include "engine/utils/console.h"
 
 #define LOAD_FUNCTION_ARGS va_list args; va_start(args, format);
 
+typedef struct {
+    uint64_t sequence;  // equal to the position when free, position + 1 when filled
+    unsigned int length;
+    bool error;         // written to stderr instead of stdout
+    char text[CONSOLE_MAX_MESSAGE];
+} ConsoleSlot;
+
+static ConsoleSlot* console_slots = NULL;
+static uint64_t console_mask = 0;
+static ConsoleOverflow console_overflow = CONSOLE_OVERFLOW_DROP;
+static uint64_t console_enqueuePosition = 0;
+static uint64_t console_dequeuePosition = 0;
+static uint64_t console_writtenCount = 0; // messages written out by the background thread
+static uint64_t console_droppedCount = 0;
+static bool console_async = false;
+static unsigned int console_writers = 0;  // threads that are pushing a message (console_stopAsync() waits for them)
+static bool console_stopping = false;
+
+static pthread_t console_thread;
+static pthread_mutex_t console_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t console_condition = PTHREAD_COND_INITIALIZER;
+static bool console_sleeping = false;
+
+// signals the unwritten messages are flushed on (before running the previous handler)
+static const int console_crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+#define CONSOLE_CRASH_SIGNAL_COUNT (sizeof(console_crashSignals) / sizeof(console_crashSignals[0]))
+static struct sigaction console_previousHandlers[CONSOLE_CRASH_SIGNAL_COUNT];
+static bool console_handlersInstalled = false;
+
+// formats a message into the buffer (prefix, message, then the color reset and the new line if needed), returns its length
+static unsigned int console_format(char* buffer, size_t size, const char* logLevel, const char* format, va_list* args, bool endWithNewLine) {
+    int length = snprintf(buffer, size, "%s", logLevel);
+    if (length < 0) length = 0;
+    if ((size_t) length < size) {
+        const int written = vsnprintf(buffer + length, size - length, format, *args);
+        if (written > 0) length += written;
+    }
+    if ((size_t) length >= size) length = (int) size - 1; // truncated
+
+    if (endWithNewLine && format != NULL && strlen(format) > 0 && format[strlen(format) - 1] != '\n') {
+        const char ending[] = COLOR_RESET "\n";
+        // keep the ending even when the message has been truncated
+        if ((size_t) length + sizeof(ending) > size) length = (int) (size - sizeof(ending));
+        memcpy(buffer + length, ending, sizeof(ending));
+        length += sizeof(ending) - 1;
+    }
+    return (unsigned int) length;
+}
+
+// claims a free slot (NULL if the ring is full and the overflow policy is to drop the message)
+static ConsoleSlot* console_claimSlot(uint64_t* position) {
+    uint64_t current = __atomic_load_n(&console_enqueuePosition, __ATOMIC_RELAXED);
+    while (true) {
+        ConsoleSlot* slot = &console_slots[current & console_mask];
+        const int64_t difference = (int64_t) (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - current);
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&console_enqueuePosition, &current, current + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *position = current;
+                return slot;
+            }
+        } else if (difference < 0) {
+            // full
+            if (console_overflow == CONSOLE_OVERFLOW_DROP) {
+                __atomic_add_fetch(&console_droppedCount, 1, __ATOMIC_RELAXED);
+                return NULL;
+            }
+            sched_yield();
+            current = __atomic_load_n(&console_enqueuePosition, __ATOMIC_RELAXED);
+        } else {
+            current = __atomic_load_n(&console_enqueuePosition, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+// takes the oldest filled slot (NULL if the ring is empty), it must be released by console_releaseSlot() once written
+static ConsoleSlot* console_takeSlot(uint64_t* position) {
+    uint64_t current = __atomic_load_n(&console_dequeuePosition, __ATOMIC_RELAXED);
+    while (true) {
+        ConsoleSlot* slot = &console_slots[current & console_mask];
+        const int64_t difference = (int64_t) (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) - (current + 1));
+        if (difference == 0) {
+            if (__atomic_compare_exchange_n(&console_dequeuePosition, &current, current + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                *position = current;
+                return slot;
+            }
+        } else if (difference < 0) {
+            return NULL;
+        } else {
+            current = __atomic_load_n(&console_dequeuePosition, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+static void console_releaseSlot(ConsoleSlot* slot, uint64_t position) {
+    __atomic_store_n(&slot->sequence, position + console_mask + 1, __ATOMIC_RELEASE);
+}
+
+// pushes a message to the ring, returns false if it has not been handled (asynchronous output not running)
+static bool console_push(bool error, const char* logLevel, const char* format, va_list* args, bool endWithNewLine) {
+    __atomic_add_fetch(&console_writers, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&console_async, __ATOMIC_SEQ_CST)) {
+        __atomic_sub_fetch(&console_writers, 1, __ATOMIC_SEQ_CST);
+        return false;
+    }
+
+    uint64_t position;
+    ConsoleSlot* slot = console_claimSlot(&position);
+    if (slot != NULL) {
+        slot->length = console_format(slot->text, sizeof(slot->text), logLevel, format, args, endWithNewLine);
+        slot->error = error;
+        __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_SEQ_CST);
+
+        // wake the background thread up only if it is waiting (the mutex is never touched otherwise)
+        if (__atomic_load_n(&console_sleeping, __ATOMIC_SEQ_CST)) {
+            pthread_mutex_lock(&console_mutex);
+            pthread_cond_signal(&console_condition);
+            pthread_mutex_unlock(&console_mutex);
+        }
+    }
+
+    __atomic_sub_fetch(&console_writers, 1, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+// returns whether the oldest slot has been filled
+static bool console_hasMessages() {
+    const uint64_t position = __atomic_load_n(&console_dequeuePosition, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&console_slots[position & console_mask].sequence, __ATOMIC_SEQ_CST) == position + 1;
+}
+
+// writes out all the queued messages (and the number of dropped ones), returns how many have been written
+static unsigned int console_drain(uint64_t* reportedDrops) {
+    unsigned int count = 0;
+    FILE* lastStream = NULL;
+    uint64_t position;
+    ConsoleSlot* slot;
+    while ((slot = console_takeSlot(&position)) != NULL) {
+        FILE* stream = slot->error ? stderr : stdout;
+        // keep the order of the messages across the two streams
+        if (lastStream != NULL && lastStream != stream) fflush(lastStream);
+        fwrite(slot->text, 1, slot->length, stream);
+        lastStream = stream;
+        console_releaseSlot(slot, position);
+        __atomic_add_fetch(&console_writtenCount, 1, __ATOMIC_RELEASE);
+        count++;
+    }
+
+    const uint64_t dropped = __atomic_load_n(&console_droppedCount, __ATOMIC_RELAXED);
+    if (dropped != *reportedDrops) {
+        fprintf(stdout, COLOR_ORANGE "[WARNING]: %llu log messages dropped (the log ring is full)" COLOR_RESET "\n", (unsigned long long) (dropped - *reportedDrops));
+        *reportedDrops = dropped;
+        lastStream = stdout;
+    }
+    if (lastStream != NULL) fflush(lastStream);
+    return count;
+}
+
+static void* console_threadMain(void* argument) {
+    (void) argument;
+    uint64_t reportedDrops = __atomic_load_n(&console_droppedCount, __ATOMIC_RELAXED);
+    while (true) {
+        if (console_drain(&reportedDrops) > 0) continue;
+
+        pthread_mutex_lock(&console_mutex);
+        __atomic_store_n(&console_sleeping, true, __ATOMIC_SEQ_CST);
+        // checked again after announcing the sleep, so a message pushed in between is not missed
+        while (!console_stopping && !console_hasMessages()) pthread_cond_wait(&console_condition, &console_mutex);
+        __atomic_store_n(&console_sleeping, false, __ATOMIC_SEQ_CST);
+        const bool stopping = console_stopping;
+        pthread_mutex_unlock(&console_mutex);
+
+        if (stopping) {
+            console_drain(&reportedDrops);
+            break;
+        }
+    }
+    return NULL;
+}
+
+// writes the queued messages with async-signal-safe calls only, then lets the previous handler run
+static void console_crashHandler(int signal) {
+    uint64_t position;
+    ConsoleSlot* slot;
+    while (console_slots != NULL && (slot = console_takeSlot(&position)) != NULL) {
+        ssize_t result = write(slot->error ? STDERR_FILENO : STDOUT_FILENO, slot->text, slot->length);
+        (void) result;
+        console_releaseSlot(slot, position);
+    }
+
+    for (unsigned int i = 0; i < CONSOLE_CRASH_SIGNAL_COUNT; i++) {
+        if (console_crashSignals[i] == signal) sigaction(signal, &console_previousHandlers[i], NULL);
+    }
+    raise(signal);
+}
+
+static void console_installCrashHandlers() {
+    if (console_handlersInstalled) return;
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = console_crashHandler;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESETHAND;
+    for (unsigned int i = 0; i < CONSOLE_CRASH_SIGNAL_COUNT; i++) sigaction(console_crashSignals[i], &action, &console_previousHandlers[i]);
+    console_handlersInstalled = true;
+}
+
+static void console_removeCrashHandlers() {
+    if (!console_handlersInstalled) return;
+    for (unsigned int i = 0; i < CONSOLE_CRASH_SIGNAL_COUNT; i++) sigaction(console_crashSignals[i], &console_previousHandlers[i], NULL);
+    console_handlersInstalled = false;
+}
+
 // generic output function
 void console_generic_output(FILE* stream, const char* logLevel, const char* format, va_list* args, bool endWithNewLine) {
+    // hand the message to the background thread when the asynchronous output is running
+    if (console_push(stream == stderr, logLevel, format, args, endWithNewLine)) {
+        va_end(*args);
+        return;
+    }
+
     // print prefix
     fprintf(stream, "%s", logLevel);
 
@@ -21,13 +249,141 @@ void console_generic_output(FILE* stream, const char* logLevel, const char* form
     // Add a newline if the format string doesn't end with one.
     // This makes sure each log message appears on a new line.
     if (endWithNewLine && format != NULL && strlen(format) > 0 && format[strlen(format) - 1] != '\n') {
-        printf(COLOR_RESET "\n"); // also reset the color when ending the line
+        fprintf(stream, COLOR_RESET "\n"); // also reset the color when ending the line
     }
 
     // Clean up the va_list object. This is crucial!
     va_end(*args);
 }
 
+/*
+Starts the asynchronous output: from now on the console functions only format their message into a ring buffer
+and a background thread writes it out. The queued messages are also written out if the process crashes.
+Parameters:
+    - capacity (unsigned int): the number of messages the ring can hold (rounded up to a power of two, 0 means CONSOLE_DEFAULT_CAPACITY)
+    - overflow (ConsoleOverflow): what to do when the ring is full (drop the message or wait for a free slot)
+Returns:
+    true on success (or if it was already running), false otherwise (the output stays synchronous)
+*/
+bool console_startAsync(unsigned int capacity, ConsoleOverflow overflow) {
+    if (console_slots != NULL) return true;
+
+    uint64_t slotCount = 2;
+    while (slotCount < (capacity > 0 ? capacity : CONSOLE_DEFAULT_CAPACITY)) slotCount *= 2;
+    ConsoleSlot* slots = (ConsoleSlot*) malloc(slotCount * sizeof(ConsoleSlot));
+    if (slots == NULL) {
+        console_error("Failed to allocate the log ring (%llu messages)", (unsigned long long) slotCount);
+        return false;
+    }
+    for (uint64_t i = 0; i < slotCount; i++) slots[i].sequence = i;
+
+    console_slots = slots;
+    console_mask = slotCount - 1;
+    console_overflow = overflow;
+    console_enqueuePosition = 0;
+    console_dequeuePosition = 0;
+    console_writtenCount = 0;
+    console_stopping = false;
+    if (pthread_create(&console_thread, NULL, console_threadMain, NULL) != 0) {
+        console_slots = NULL;
+        free(slots);
+        console_error("Failed to start the log thread");
+        return false;
+    }
+
+    console_installCrashHandlers();
+    __atomic_store_n(&console_async, true, __ATOMIC_SEQ_CST);
+    return true;
+}
+
+// stops the asynchronous output after writing out all the queued messages (the output goes back to being synchronous)
+void console_stopAsync() {
+    if (console_slots == NULL) return;
+
+    // new messages are written synchronously, the ones being pushed are waited for
+    __atomic_store_n(&console_async, false, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&console_writers, __ATOMIC_SEQ_CST) > 0) sched_yield();
+
+    pthread_mutex_lock(&console_mutex);
+    console_stopping = true;
+    pthread_cond_signal(&console_condition);
+    pthread_mutex_unlock(&console_mutex);
+    pthread_join(console_thread, NULL);
+
+    console_removeCrashHandlers();
+    free(console_slots);
+    console_slots = NULL;
+}
+
+// waits until all the messages queued so far have been written out
+void console_flush() {
+    if (__atomic_load_n(&console_async, __ATOMIC_SEQ_CST)) {
+        // the messages pushed before this call have claimed a position lower than this one
+        const uint64_t target = __atomic_load_n(&console_enqueuePosition, __ATOMIC_SEQ_CST);
+        while (__atomic_load_n(&console_writtenCount, __ATOMIC_ACQUIRE) < target && __atomic_load_n(&console_async, __ATOMIC_SEQ_CST)) {
+            if (__atomic_load_n(&console_sleeping, __ATOMIC_SEQ_CST)) {
+                pthread_mutex_lock(&console_mutex);
+                pthread_cond_signal(&console_condition);
+                pthread_mutex_unlock(&console_mutex);
+            }
+            sched_yield();
+        }
+    }
+    fflush(stdout);
+    fflush(stderr);
+}
+
+// returns the number of messages dropped because the ring was full (with the CONSOLE_OVERFLOW_DROP policy)
+unsigned long long console_getDroppedCount() {
+    return (unsigned long long) __atomic_load_n(&console_droppedCount, __ATOMIC_RELAXED);
+}
+
+/*
+Logs a message at the given level with its location (used by the CONSOLE_* macros).
+Parameters:
+    - level (int): one of the CONSOLE_LEVEL_* levels
+    - file (const char*): the file of the log site
+    - line (int): the line of the log site
+    - suppressed (unsigned int): the number of messages of this site suppressed by the rate limit (reported if not 0)
+    - format (const char*): the printf format of the message
+*/
+void console_logAt(int level, const char* file, int line, unsigned int suppressed, const char* format, ...) {
+    static const char* const levels[] = {
+        "[DEBUG]: ", "[INFO]: ", "[LOG]: ", "[WARNING]: ", "[ERROR]: "
+    };
+    static const char* const colors[] = {
+        COLOR_BLUE, "", COLOR_GREEN, COLOR_ORANGE, COLOR_RED
+    };
+    if (level < CONSOLE_LEVEL_DEBUG || level > CONSOLE_LEVEL_ERROR) return;
+
+    // the location (and the suppressed messages) become part of the prefix, so the message is still formatted only once
+    char prefix[160];
+    if (suppressed > 0) snprintf(prefix, sizeof(prefix), "%s%s%s:%d: (%u similar messages suppressed) ", colors[level], levels[level], file, line, suppressed);
+    else snprintf(prefix, sizeof(prefix), "%s%s%s:%d: ", colors[level], levels[level], file, line);
+
+    LOAD_FUNCTION_ARGS
+    console_generic_output(level == CONSOLE_LEVEL_ERROR ? stderr : stdout, prefix, format, &args, true);
+}
+
+// returns whether a rate limited site can log now (storing in suppressed how many of its messages have been suppressed since the last one)
+bool console_rateLimit(ConsoleRateLimit* limit, unsigned int perSecond, unsigned int* suppressed) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    const uint64_t window = (uint64_t) now.tv_sec;
+
+    // a new second resets the count (concurrent callers may both reset it, letting a message or two more through)
+    if (__atomic_load_n(&limit->window, __ATOMIC_RELAXED) != window) {
+        __atomic_store_n(&limit->window, window, __ATOMIC_RELAXED);
+        __atomic_store_n(&limit->count, 0, __ATOMIC_RELAXED);
+    }
+    if (__atomic_add_fetch(&limit->count, 1, __ATOMIC_RELAXED) > perSecond) {
+        __atomic_add_fetch(&limit->suppressed, 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    *suppressed = __atomic_exchange_n(&limit->suppressed, 0, __ATOMIC_RELAXED);
+    return true;
+}
+
 // literally a printf
 void console_printf(const char* format, ...) {
     LOAD_FUNCTION_ARGS
@@ -68,4 +424,4 @@ void console_error(const char* format, ...) {
 void console_debug(const char* format, ...) {
     LOAD_FUNCTION_ARGS
     console_generic_output(stdout, COLOR_BLUE "[DEBUG]: ", format, &args, true);
-}
\ No newline at end of file
+}
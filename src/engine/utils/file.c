@@ -5,7 +5,17 @@ File reader/writer
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 
+#if defined(__unix__) || defined(__APPLE__)
+#define FILE_HAS_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "engine/utils/archive.h"
 #include "engine/utils/console.h"
 
 #include "engine/utils/file.h"
@@ -29,9 +39,24 @@ bool file_write(char* path, char* content) {
     return true;
 }
 
-// reads a file at path and outputs its content to content ("./file" means it is in "g3ce")
+// reads a file at path and outputs its content to content ("./file" means it is in "g3ce", the mounted archives are looked up first)
 // YOU MUST FREE THE RETURN VALUE!
 char* file_read(char* path) {
+    // packed files take precedence over the ones on the disk
+    FileView view;
+    if (archive_map(path, &view)) {
+        char* buffer = (char*) malloc(view.size + 1); // +1 for \0
+        if (buffer == NULL) {
+            file_unmap(&view);
+            console_error("Failed to allocate memory for reading buffer of file at \"%s\"", path);
+            return NULL;
+        }
+        memcpy(buffer, view.data, view.size);
+        buffer[view.size] = '\0';
+        file_unmap(&view);
+        return buffer;
+    }
+
     // open the file
     FILE* file = file_open(path, "r");
     if (file == NULL) return NULL;
@@ -66,6 +91,173 @@ char* file_read(char* path) {
     return buffer;
 }
 
+// reads a binary file at path and returns its content, storing its size in bytes in length ("./file" means it is in "g3ce", the mounted archives are looked up first)
+// YOU MUST FREE THE RETURN VALUE!
+unsigned char* file_readBytes(char* path, size_t* length) {
+    // packed files take precedence over the ones on the disk
+    FileView view;
+    if (archive_map(path, &view)) {
+        unsigned char* buffer = (unsigned char*) malloc(view.size > 0 ? view.size : 1);
+        if (buffer == NULL) {
+            file_unmap(&view);
+            console_error("Failed to allocate memory for reading buffer of file at \"%s\"", path);
+            return NULL;
+        }
+        memcpy(buffer, view.data, view.size);
+        *length = view.size;
+        file_unmap(&view);
+        return buffer;
+    }
+
+    // open the file
+    FILE* file = file_open(path, "rb");
+    if (file == NULL) return NULL;
+
+    // get file length
+    fseek(file, 0, SEEK_END);
+    long fileLength = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (fileLength < 0) {
+        fclose(file);
+        console_error("Failed to get the size of file at \"%s\"", path);
+        return NULL;
+    }
+
+    // read the file content (allocate at least one byte so that empty files still return a valid pointer)
+    unsigned char* buffer = (unsigned char*) malloc(fileLength > 0 ? fileLength : 1);
+    if (buffer == NULL) {
+        fclose(file);
+        console_error("Failed to allocate memory for reading buffer of file at \"%s\"", path);
+        return NULL;
+    }
+
+    size_t read_bytes = fread(buffer, 1, fileLength, file);
+    fclose(file);
+    // check for having read the whole file
+    if (read_bytes < (size_t) fileLength) {
+        free(buffer);
+        console_error("Failed to read the whole file at \"%s\"", path);
+        return NULL;
+    }
+
+    *length = read_bytes;
+    return buffer;
+}
+
+/*
+Maps a whole file at path ("./file" means it is in "g3ce") into memory as a read-only view, without copying its content.
+The pages are loaded lazily by the OS straight from its page cache, so the content is never double buffered.
+The mounted archives are looked up first (see archive.h), then the disk.
+On platforms without mmap() the file is read into a heap buffer instead (view->type is FILE_VIEW_HEAP).
+REMEMBER TO RELEASE IT BY CALLING file_unmap()!
+Parameters:
+    - path (char*): the file path
+    - view (FileView*): where to store the view
+Returns:
+    true on success, false otherwise
+*/
+bool file_map(char* path, FileView* view) {
+    view->data = NULL;
+    view->size = 0;
+    view->type = FILE_VIEW_HEAP;
+
+    // packed files take precedence over the ones on the disk
+    if (archive_map(path, view)) return true;
+
+#ifdef FILE_HAS_MMAP
+    int descriptor = open(path, O_RDONLY);
+    if (descriptor == -1) {
+        console_error("Failed to open file at \"%s\"", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(descriptor, &info) == -1) {
+        close(descriptor);
+        console_error("Failed to get the size of file at \"%s\"", path);
+        return false;
+    }
+
+    // empty files cannot be mapped, but they still are valid files
+    if (info.st_size == 0) {
+        close(descriptor);
+        static const unsigned char empty[1] = { 0 };
+        view->data = empty;
+        view->type = FILE_VIEW_MAPPED;
+        return true;
+    }
+
+    void* data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    // the mapping keeps its own reference to the file
+    close(descriptor);
+    if (data == MAP_FAILED) {
+        console_error("Failed to map file at \"%s\" into memory", path);
+        return false;
+    }
+
+    view->data = (const unsigned char*) data;
+    view->size = (size_t) info.st_size;
+    view->type = FILE_VIEW_MAPPED;
+    return true;
+#else
+    size_t length;
+    unsigned char* data = file_readBytes(path, &length);
+    if (data == NULL) return false;
+
+    view->data = data;
+    view->size = length;
+    return true;
+#endif
+}
+
+// releases a view created by file_map() (its data must not be used anymore)
+void file_unmap(FileView* view) {
+#ifdef FILE_HAS_MMAP
+    // empty files are not actually mapped
+    if (view->type == FILE_VIEW_MAPPED && view->size > 0) munmap((void*) view->data, view->size);
+#endif
+    // the archive views belong to the mounted archive
+    if (view->type == FILE_VIEW_HEAP) free((void*) view->data);
+    view->data = NULL;
+    view->size = 0;
+    view->type = FILE_VIEW_HEAP;
+}
+
+// tells the OS how a mapped file is going to be accessed (it is just a hint, it does nothing if the file is not mapped)
+void file_advise(FileView* view, FileAccess access) {
+#ifdef FILE_HAS_MMAP
+    if (view->type == FILE_VIEW_HEAP || view->size == 0) return;
+
+    // madvise() needs a page aligned address (the packed files are 4K aligned, but the pages could be bigger)
+    const uintptr_t pageSize = (uintptr_t) sysconf(_SC_PAGESIZE);
+    const uintptr_t start = (uintptr_t) view->data & ~(pageSize - 1);
+    const size_t length = view->size + ((uintptr_t) view->data - start);
+
+    int advice = MADV_NORMAL;
+    if (access == FILE_ACCESS_SEQUENTIAL) advice = MADV_SEQUENTIAL;
+    else if (access == FILE_ACCESS_RANDOM) advice = MADV_RANDOM;
+    else if (access == FILE_ACCESS_WILLNEED) advice = MADV_WILLNEED;
+
+    if (madvise((void*) start, length, advice) != 0) console_warning("Failed to set the access pattern of a mapped file");
+#else
+    (void) view;
+    (void) access;
+#endif
+}
+
+// returns true if a file exists on the disk at path ("./file" means it is in "g3ce", the mounted archives are NOT looked up)
+bool file_exists(char* path) {
+#ifdef FILE_HAS_MMAP
+    struct stat info;
+    return stat(path, &info) == 0 && S_ISREG(info.st_mode);
+#else
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return false;
+    fclose(file);
+    return true;
+#endif
+}
+
 // removes a file at path ("./file" means it is in "g3ce")
 int file_remove(char* path) {
     return remove(path);
@@ -0,0 +1,603 @@
+/*
+IO:
+Asynchronous file reading.
+A read is submitted with io_readFile() and completes in the background: its state can be polled and its callback
+is run by io_poll() (called by the app loop once per frame), so callbacks always run on the thread that polls,
+meaning that they can safely use OpenGL (e.g. to create a texture from the data that has just been read).
+On Linux the reads go through io_uring (many reads in flight with a single system call), otherwise (or when io_uring
+is not available) a small pool of threads performs blocking reads.
+Paths packed in a mounted archive (see archive.h) complete right away without touching the disk.
+The functions of this module are NOT thread safe: submit, poll and release from the same thread.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_HAS_URING
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+#include "engine/utils/archive.h"
+#include "engine/utils/console.h"
+
+#include "engine/utils/io.h"
+
+#define IO_DEFAULT_THREADS 4
+#define IO_MAX_THREADS 16
+#define IO_URING_ENTRIES 128
+// a single read never asks for more than this many bytes (the kernel caps them anyway)
+#define IO_MAX_CHUNK (1u << 30)
+
+struct IoRequest {
+    IoStatus status;        // only written by the polling thread
+    char* path;
+    FileView view;          // the content, once completed
+    unsigned char* buffer;  // the buffer being read into
+    size_t size;
+    size_t offset;          // bytes read so far
+    int descriptor;
+    int error;              // errno of the failure (0 on success)
+    IoCallback callback;
+    void* userData;
+    IoRequest* next;        // the list the request is in (pending, work, done or ready)
+#ifdef IO_HAS_URING
+    struct iovec vector;
+#endif
+};
+
+typedef struct {
+    IoRequest* head;
+    IoRequest* tail;
+} IoList;
+
+static void io_listPush(IoList* list, IoRequest* request) {
+    request->next = NULL;
+    if (list->tail != NULL) list->tail->next = request;
+    else list->head = request;
+    list->tail = request;
+}
+
+static IoRequest* io_listPop(IoList* list) {
+    IoRequest* request = list->head;
+    if (request == NULL) return NULL;
+    list->head = request->next;
+    if (list->head == NULL) list->tail = NULL;
+    request->next = NULL;
+    return request;
+}
+
+// removes a request from anywhere in the list, returns false if it was not there
+static bool io_listRemove(IoList* list, IoRequest* request) {
+    IoRequest* previous = NULL;
+    for (IoRequest* current = list->head; current != NULL; previous = current, current = current->next) {
+        if (current != request) continue;
+        if (previous != NULL) previous->next = current->next;
+        else list->head = current->next;
+        if (list->tail == current) list->tail = previous;
+        current->next = NULL;
+        return true;
+    }
+    return false;
+}
+
+// BACKEND STATE
+static bool io_initialized = false;
+static IoBackend io_backend = IO_BACKEND_AUTO;
+static unsigned int io_inFlight = 0; // submitted to the backend and not collected yet
+static IoList io_ready = { NULL, NULL }; // completed, waiting for their callback to be run by io_poll()
+
+// thread pool backend
+static pthread_t io_threads[IO_MAX_THREADS];
+static unsigned int io_threadCount = 0;
+static pthread_mutex_t io_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t io_workCondition = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t io_doneCondition = PTHREAD_COND_INITIALIZER;
+static IoList io_work = { NULL, NULL }; // protected by io_mutex
+static IoList io_done = { NULL, NULL }; // protected by io_mutex
+static bool io_stopping = false;        // protected by io_mutex
+
+// marks a read as completed (successfully or not) and queues its callback, called by the polling thread only
+static void io_complete(IoRequest* request) {
+    if (request->descriptor != -1) {
+        close(request->descriptor);
+        request->descriptor = -1;
+    }
+
+    if (request->error == 0) {
+        request->view = (FileView) { .data = request->buffer, .size = request->size, .type = FILE_VIEW_HEAP };
+        request->status = IO_STATUS_DONE;
+    } else {
+        console_error("Failed to read file at \"%s\" (%s)", request->path, strerror(request->error));
+        free(request->buffer);
+        request->status = IO_STATUS_FAILED;
+    }
+    request->buffer = NULL;
+
+    io_listPush(&io_ready, request);
+}
+
+// THREAD POOL BACKEND
+// reads the whole file with blocking reads
+static void io_readBlocking(IoRequest* request) {
+    while (request->offset < request->size) {
+        const size_t chunk = request->size - request->offset < IO_MAX_CHUNK ? request->size - request->offset : IO_MAX_CHUNK;
+        const ssize_t result = pread(request->descriptor, request->buffer + request->offset, chunk, (off_t) request->offset);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            // a 0 bytes read means the file got shorter since it was opened
+            request->error = result < 0 ? errno : EIO;
+            return;
+        }
+        request->offset += (size_t) result;
+    }
+}
+
+static void* io_threadMain(void* argument) {
+    (void) argument;
+    pthread_mutex_lock(&io_mutex);
+    while (true) {
+        while (!io_stopping && io_work.head == NULL) pthread_cond_wait(&io_workCondition, &io_mutex);
+        IoRequest* request = io_listPop(&io_work);
+        if (request == NULL) break; // stopping and nothing left to read
+
+        pthread_mutex_unlock(&io_mutex);
+        io_readBlocking(request);
+        pthread_mutex_lock(&io_mutex);
+
+        io_listPush(&io_done, request);
+        pthread_cond_signal(&io_doneCondition);
+    }
+    pthread_mutex_unlock(&io_mutex);
+    return NULL;
+}
+
+static bool io_threadsInit(unsigned int threadCount) {
+    if (threadCount == 0) threadCount = IO_DEFAULT_THREADS;
+    if (threadCount > IO_MAX_THREADS) threadCount = IO_MAX_THREADS;
+
+    io_stopping = false;
+    for (io_threadCount = 0; io_threadCount < threadCount; io_threadCount++) {
+        if (pthread_create(&io_threads[io_threadCount], NULL, io_threadMain, NULL) != 0) break;
+    }
+    if (io_threadCount == 0) {
+        console_error("Failed to create the IO threads");
+        return false;
+    }
+    return true;
+}
+
+static void io_threadsShutdown() {
+    pthread_mutex_lock(&io_mutex);
+    io_stopping = true;
+    pthread_cond_broadcast(&io_workCondition);
+    pthread_mutex_unlock(&io_mutex);
+    for (unsigned int i = 0; i < io_threadCount; i++) pthread_join(io_threads[i], NULL);
+    io_threadCount = 0;
+}
+
+static void io_threadsSubmit(IoRequest* request) {
+    pthread_mutex_lock(&io_mutex);
+    io_listPush(&io_work, request);
+    pthread_cond_signal(&io_workCondition);
+    pthread_mutex_unlock(&io_mutex);
+}
+
+// collects the reads completed by the threads (blocking until at least one completes if wait is true)
+static void io_threadsCollect(bool wait) {
+    pthread_mutex_lock(&io_mutex);
+    while (wait && io_done.head == NULL) pthread_cond_wait(&io_doneCondition, &io_mutex);
+    IoList done = io_done;
+    io_done = (IoList) { NULL, NULL };
+    pthread_mutex_unlock(&io_mutex);
+
+    IoRequest* request;
+    while ((request = io_listPop(&done)) != NULL) {
+        io_inFlight--;
+        io_complete(request);
+    }
+}
+
+// IO_URING BACKEND
+#ifdef IO_HAS_URING
+// the rings shared with the kernel (the indices are read and written with acquire/release semantics)
+typedef struct {
+    int descriptor;
+    void* submissionRing;
+    size_t submissionRingSize;
+    void* completionRing;
+    size_t completionRingSize;
+    struct io_uring_sqe* submissions;
+    size_t submissionsSize;
+    unsigned int* submissionHead;
+    unsigned int* submissionTail;
+    unsigned int* submissionMask;
+    unsigned int* submissionArray;
+    unsigned int submissionEntries;
+    unsigned int* completionHead;
+    unsigned int* completionTail;
+    unsigned int* completionMask;
+    struct io_uring_cqe* completions;
+    unsigned int completionEntries;
+    unsigned int toSubmit; // queued in the submission ring but not passed to the kernel yet
+} IoUring;
+
+static IoUring io_ring;
+static IoList io_pending = { NULL, NULL }; // waiting for room in the ring
+
+static int io_uringEnter(unsigned int toSubmit, unsigned int minComplete, unsigned int flags) {
+    return (int) syscall(__NR_io_uring_enter, io_ring.descriptor, toSubmit, minComplete, flags, NULL, 0);
+}
+
+static void io_uringShutdown() {
+    if (io_ring.submissions != NULL) munmap(io_ring.submissions, io_ring.submissionsSize);
+    if (io_ring.completionRing != NULL && io_ring.completionRing != io_ring.submissionRing) munmap(io_ring.completionRing, io_ring.completionRingSize);
+    if (io_ring.submissionRing != NULL) munmap(io_ring.submissionRing, io_ring.submissionRingSize);
+    if (io_ring.descriptor != -1) close(io_ring.descriptor);
+    memset(&io_ring, 0, sizeof(io_ring));
+    io_ring.descriptor = -1;
+}
+
+static bool io_uringInit() {
+    memset(&io_ring, 0, sizeof(io_ring));
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    io_ring.descriptor = (int) syscall(__NR_io_uring_setup, IO_URING_ENTRIES, &params);
+    if (io_ring.descriptor < 0) {
+        io_ring.descriptor = -1;
+        return false;
+    }
+
+    // map the submission ring, the completion ring (possibly the same mapping) and the submission entries
+    io_ring.submissionRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    io_ring.completionRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    const bool singleMapping = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMapping && io_ring.completionRingSize > io_ring.submissionRingSize) io_ring.submissionRingSize = io_ring.completionRingSize;
+
+    io_ring.submissionRing = mmap(NULL, io_ring.submissionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_ring.descriptor, IORING_OFF_SQ_RING);
+    if (io_ring.submissionRing == MAP_FAILED) {
+        io_ring.submissionRing = NULL;
+        io_uringShutdown();
+        return false;
+    }
+    if (singleMapping) {
+        io_ring.completionRing = io_ring.submissionRing;
+    } else {
+        io_ring.completionRing = mmap(NULL, io_ring.completionRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_ring.descriptor, IORING_OFF_CQ_RING);
+        if (io_ring.completionRing == MAP_FAILED) {
+            io_ring.completionRing = NULL;
+            io_uringShutdown();
+            return false;
+        }
+    }
+    io_ring.submissionsSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    io_ring.submissions = mmap(NULL, io_ring.submissionsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, io_ring.descriptor, IORING_OFF_SQES);
+    if (io_ring.submissions == MAP_FAILED) {
+        io_ring.submissions = NULL;
+        io_uringShutdown();
+        return false;
+    }
+
+    unsigned char* submissionRing = (unsigned char*) io_ring.submissionRing;
+    io_ring.submissionHead = (unsigned int*) (submissionRing + params.sq_off.head);
+    io_ring.submissionTail = (unsigned int*) (submissionRing + params.sq_off.tail);
+    io_ring.submissionMask = (unsigned int*) (submissionRing + params.sq_off.ring_mask);
+    io_ring.submissionArray = (unsigned int*) (submissionRing + params.sq_off.array);
+    io_ring.submissionEntries = params.sq_entries;
+    unsigned char* completionRing = (unsigned char*) io_ring.completionRing;
+    io_ring.completionHead = (unsigned int*) (completionRing + params.cq_off.head);
+    io_ring.completionTail = (unsigned int*) (completionRing + params.cq_off.tail);
+    io_ring.completionMask = (unsigned int*) (completionRing + params.cq_off.ring_mask);
+    io_ring.completions = (struct io_uring_cqe*) (completionRing + params.cq_off.cqes);
+    io_ring.completionEntries = params.cq_entries;
+    return true;
+}
+
+// passes the queued submissions to the kernel, optionally waiting for at least one completion
+static void io_uringFlush(bool wait) {
+    while (io_ring.toSubmit > 0 || wait) {
+        const int result = io_uringEnter(io_ring.toSubmit, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0);
+        if (result < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) continue;
+            console_error("Failed to submit IO requests (%s)", strerror(errno));
+            return;
+        }
+        // the kernel consumes every valid submission (result is how many it consumed)
+        io_ring.toSubmit = (unsigned int) result < io_ring.toSubmit ? io_ring.toSubmit - (unsigned int) result : 0;
+        wait = false;
+    }
+}
+
+// queues the read of the next chunk of a request in the submission ring
+static void io_uringQueueRead(IoRequest* request) {
+    unsigned int tail = *io_ring.submissionTail;
+    // the ring is full, let the kernel consume it first
+    if (tail - __atomic_load_n(io_ring.submissionHead, __ATOMIC_ACQUIRE) >= io_ring.submissionEntries) {
+        io_uringFlush(false);
+        tail = *io_ring.submissionTail;
+    }
+
+    const size_t remaining = request->size - request->offset;
+    request->vector.iov_base = request->buffer + request->offset;
+    request->vector.iov_len = remaining < IO_MAX_CHUNK ? remaining : IO_MAX_CHUNK;
+
+    const unsigned int index = tail & *io_ring.submissionMask;
+    struct io_uring_sqe* submission = &io_ring.submissions[index];
+    memset(submission, 0, sizeof(*submission));
+    submission->opcode = IORING_OP_READV;
+    submission->fd = request->descriptor;
+    submission->addr = (uint64_t) (uintptr_t) &request->vector;
+    submission->len = 1;
+    submission->off = request->offset;
+    submission->user_data = (uint64_t) (uintptr_t) request;
+    io_ring.submissionArray[index] = index;
+
+    __atomic_store_n(io_ring.submissionTail, tail + 1, __ATOMIC_RELEASE);
+    io_ring.toSubmit++;
+}
+
+// submits the pending requests while there is room for their completions
+static void io_uringSubmitPending() {
+    while (io_pending.head != NULL && io_inFlight < io_ring.completionEntries) {
+        io_inFlight++;
+        io_uringQueueRead(io_listPop(&io_pending));
+    }
+}
+
+// collects the completed reads, resubmitting the ones that were only partially read
+static void io_uringCollect(bool wait) {
+    io_uringSubmitPending();
+    io_uringFlush(wait);
+
+    unsigned int head = *io_ring.completionHead;
+    const unsigned int tail = __atomic_load_n(io_ring.completionTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const struct io_uring_cqe* completion = &io_ring.completions[head & *io_ring.completionMask];
+        IoRequest* request = (IoRequest*) (uintptr_t) completion->user_data;
+        const int result = completion->res;
+
+        if (result == -EINTR || result == -EAGAIN) {
+            io_uringQueueRead(request);
+            continue;
+        }
+        if (result <= 0) {
+            // a 0 bytes read means the file got shorter since it was opened
+            request->error = result < 0 ? -result : EIO;
+        } else {
+            request->offset += (size_t) result;
+            if (request->offset < request->size) {
+                io_uringQueueRead(request);
+                continue;
+            }
+        }
+
+        io_inFlight--;
+        io_complete(request);
+    }
+    __atomic_store_n(io_ring.completionHead, head, __ATOMIC_RELEASE);
+
+    // the completed reads made room for the pending ones
+    io_uringSubmitPending();
+    io_uringFlush(false);
+}
+#endif
+
+// collects the completed reads of the backend in use
+static void io_collect(bool wait) {
+#ifdef IO_HAS_URING
+    if (io_backend == IO_BACKEND_URING) {
+        io_uringCollect(wait);
+        return;
+    }
+#endif
+    io_threadsCollect(wait);
+}
+
+/*
+Initializes the asynchronous reading backend (app_create() calls it with IO_BACKEND_AUTO).
+Parameters:
+    - backend (IoBackend): the backend to use
+    - threadCount (unsigned int): the number of reading threads of the thread pool backend (0 picks a default)
+Returns:
+    true on success, false otherwise
+*/
+bool io_init(IoBackend backend, unsigned int threadCount) {
+    if (io_initialized) {
+        console_warning("The IO backend has already been initialized");
+        return true;
+    }
+
+    if (backend == IO_BACKEND_AUTO || backend == IO_BACKEND_URING) {
+#ifdef IO_HAS_URING
+        if (io_uringInit()) {
+            io_backend = IO_BACKEND_URING;
+            io_initialized = true;
+            return true;
+        }
+#endif
+        if (backend == IO_BACKEND_URING) {
+            console_error("io_uring is not available");
+            return false;
+        }
+    }
+
+    if (!io_threadsInit(threadCount)) return false;
+    io_backend = IO_BACKEND_THREADS;
+    io_initialized = true;
+    return true;
+}
+
+// waits for all the reads in flight and shuts the backend down (app_terminate() calls it)
+void io_shutdown() {
+    if (!io_initialized) return;
+    io_waitAll();
+
+#ifdef IO_HAS_URING
+    if (io_backend == IO_BACKEND_URING) io_uringShutdown();
+#endif
+    if (io_backend == IO_BACKEND_THREADS) io_threadsShutdown();
+    io_initialized = false;
+}
+
+// returns the name of the backend in use ("io_uring", "threads" or "none" when not initialized)
+const char* io_getBackendName() {
+    if (!io_initialized) return "none";
+    return io_backend == IO_BACKEND_URING ? "io_uring" : "threads";
+}
+
+/*
+Starts reading a whole file asynchronously ("./file" means it is in "g3ce", the mounted archives are looked up first).
+REMEMBER TO RELEASE THE REQUEST BY CALLING io_release()!
+Parameters:
+    - path (char*): the file path
+    - callback (IoCallback): the function to call when the read completes (it can be NULL)
+    - userData (void*): the pointer passed to the callback
+Returns:
+    the request (NULL if it could not even be submitted, e.g. when the file does not exist)
+*/
+IoRequest* io_readFile(char* path, IoCallback callback, void* userData) {
+    if (!io_initialized) {
+        console_error("Cannot read file at \"%s\", the IO backend has not been initialized", path);
+        return NULL;
+    }
+
+    IoRequest* request = (IoRequest*) calloc(1, sizeof(IoRequest));
+    char* pathCopy = (char*) malloc(strlen(path) + 1);
+    if (request == NULL || pathCopy == NULL) {
+        console_error("Failed to allocate memory for reading file at \"%s\"", path);
+        free(request);
+        free(pathCopy);
+        return NULL;
+    }
+    strcpy(pathCopy, path);
+    request->path = pathCopy;
+    request->descriptor = -1;
+    request->callback = callback;
+    request->userData = userData;
+    request->status = IO_STATUS_PENDING;
+
+    // packed files are already in memory
+    if (archive_map(path, &request->view)) {
+        request->status = IO_STATUS_DONE;
+        io_listPush(&io_ready, request);
+        return request;
+    }
+
+    // opening the file is synchronous, only the reads are not
+    request->descriptor = open(path, O_RDONLY);
+    struct stat info;
+    if (request->descriptor == -1 || fstat(request->descriptor, &info) == -1) {
+        console_error("Failed to open file at \"%s\"", path);
+        if (request->descriptor != -1) close(request->descriptor);
+        free(request->path);
+        free(request);
+        return NULL;
+    }
+
+    // allocate at least one byte so that empty files still have a valid pointer
+    request->size = (size_t) info.st_size;
+    request->buffer = (unsigned char*) malloc(request->size > 0 ? request->size : 1);
+    if (request->buffer == NULL) {
+        console_error("Failed to allocate memory for reading buffer of file at \"%s\"", path);
+        close(request->descriptor);
+        free(request->path);
+        free(request);
+        return NULL;
+    }
+
+    if (request->size == 0) {
+        io_complete(request);
+        return request;
+    }
+
+#ifdef IO_HAS_URING
+    if (io_backend == IO_BACKEND_URING) {
+        // queue it and pass it to the kernel right away, so the read starts before the next poll
+        io_listPush(&io_pending, request);
+        io_uringSubmitPending();
+        io_uringFlush(false);
+        return request;
+    }
+#endif
+    io_inFlight++;
+    io_threadsSubmit(request);
+    return request;
+}
+
+// runs the callbacks of the reads completed since the last call without blocking, returns the number of completed reads
+unsigned int io_poll() {
+    if (!io_initialized) return 0;
+    io_collect(false);
+
+    // take the whole list first, so the callbacks can submit (and release) requests
+    IoList ready = io_ready;
+    io_ready = (IoList) { NULL, NULL };
+    unsigned int count = 0;
+    IoRequest* request;
+    while ((request = io_listPop(&ready)) != NULL) {
+        count++;
+        if (request->callback != NULL) request->callback(request, request->userData);
+    }
+    return count;
+}
+
+// blocks until the given read completes (running the callbacks of all the reads completing in the meantime)
+void io_wait(IoRequest* request) {
+    if (!io_initialized) return;
+    // the callbacks are run only after the request has completed, so they cannot release it while waiting
+    while (request->status == IO_STATUS_PENDING) io_collect(true);
+    io_poll();
+}
+
+// blocks until all the reads in flight complete (running their callbacks)
+void io_waitAll() {
+    if (!io_initialized) return;
+#ifdef IO_HAS_URING
+    while (io_inFlight > 0 || io_pending.head != NULL) io_collect(true);
+#else
+    while (io_inFlight > 0) io_collect(true);
+#endif
+    io_poll();
+}
+
+// returns the status of a read
+IoStatus io_getStatus(IoRequest* request) {
+    return request->status;
+}
+
+// returns the path of a read
+const char* io_getPath(IoRequest* request) {
+    return request->path;
+}
+
+// returns the content of a completed read (the view belongs to the request, so it is valid until io_release() is called)
+const FileView* io_getView(IoRequest* request) {
+    return &request->view;
+}
+
+// releases a completed read and its data (it must not be called on a pending read)
+void io_release(IoRequest* request) {
+    if (request == NULL) return;
+    if (request->status == IO_STATUS_PENDING) {
+        console_warning("Cannot release the read of file at \"%s\" while it is still in flight", request->path);
+        return;
+    }
+
+    // its callback has not been run yet
+    io_listRemove(&io_ready, request);
+
+    file_unmap(&request->view);
+    free(request->path);
+    free(request);
+}
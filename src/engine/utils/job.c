@@ -0,0 +1,469 @@
+/*
+JOB:
+Work-stealing job system.
+Every thread of the pool owns a Chase-Lev deque ("Dynamic Circular Work-Stealing Deque", with the C11 memory orders of
+"Correct and Efficient Work-Stealing for Weak Memory Models") and a ring of job slots: a slot is reused only once its
+job is done, so submitting never allocates. The idle workers sleep on a condition variable, woken only when a job is
+submitted while some of them are sleeping.
+*/
+
+#define _GNU_SOURCE // sched_yield()
+
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "engine/utils/console.h"
+#include "engine/utils/profiler.h"
+
+#include "engine/utils/job.h"
+
+// failed attempts to find a job before a worker goes to sleep
+#define JOB_SPIN_COUNT 256
+#define JOB_CACHE_LINE 64
+
+struct Job {
+    JobFunction function;
+    JobRangeFunction rangeFunction; // set for the batches of job_parallelFor() (function is NULL)
+    void* data;
+    unsigned int start, end;
+    JobCounter* counter;
+    Job* next;  // in the list of the jobs waiting for a counter or in the shared queue
+    bool busy;  // submitted and not done yet (the slot cannot be reused)
+    bool heap;  // submitted by a thread outside of the pool, freed when done
+};
+
+// the deque and the job slots of a thread (top and bottom on their own cache lines, the thieves only write the top)
+typedef struct {
+    _Alignas(JOB_CACHE_LINE) int64_t top;
+    _Alignas(JOB_CACHE_LINE) int64_t bottom;
+    unsigned int nextSlot;
+    Job* jobs[JOB_QUEUE_CAPACITY];
+    Job slots[JOB_QUEUE_CAPACITY];
+} JobQueue;
+
+static JobQueue* job_queues = NULL;
+static unsigned int job_threadCount = 0; // 0 when not initialized
+static pthread_t job_threads[JOB_MAX_THREADS];
+static __thread int job_threadIndex = -1;
+static __thread uint32_t job_randomState = 0;
+
+// jobs queued and not taken yet (it can go below zero for a moment, a job being taken right before it is counted)
+static int job_queued = 0;
+static unsigned int job_sleepers = 0;
+static bool job_stopping = false;
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_condition = PTHREAD_COND_INITIALIZER;
+// jobs submitted by the threads outside of the pool (protected by job_mutex)
+static Job* job_sharedHead = NULL;
+static Job* job_sharedTail = NULL;
+static unsigned int job_sharedCount = 0;
+
+static void job_pause() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// spins for a while, then yields the processor (used while waiting for jobs run by the other threads)
+static void job_backoff(unsigned int* attempts) {
+    if (*attempts < JOB_SPIN_COUNT) {
+        job_pause();
+        (*attempts)++;
+    } else {
+        sched_yield();
+    }
+}
+
+static void job_lockCounter(JobCounter* counter) {
+    while (__atomic_test_and_set(&counter->lock, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&counter->lock, __ATOMIC_RELAXED)) job_pause();
+    }
+}
+
+static void job_unlockCounter(JobCounter* counter) {
+    __atomic_clear(&counter->lock, __ATOMIC_RELEASE);
+}
+
+// DEQUE
+// pushes a job to the bottom of the deque of the calling thread, returns false if it is full
+static bool job_push(JobQueue* queue, Job* job) {
+    const int64_t bottom = __atomic_load_n(&queue->bottom, __ATOMIC_RELAXED);
+    const int64_t top = __atomic_load_n(&queue->top, __ATOMIC_ACQUIRE);
+    if (bottom - top >= JOB_QUEUE_CAPACITY) return false;
+    __atomic_store_n(&queue->jobs[bottom & (JOB_QUEUE_CAPACITY - 1)], job, __ATOMIC_RELAXED);
+    // publishes the job (and its content) to the thieves
+    __atomic_store_n(&queue->bottom, bottom + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+// pops the most recent job from the bottom of the deque of the calling thread
+static Job* job_pop(JobQueue* queue) {
+    const int64_t bottom = __atomic_load_n(&queue->bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&queue->bottom, bottom, __ATOMIC_SEQ_CST);
+    int64_t top = __atomic_load_n(&queue->top, __ATOMIC_SEQ_CST);
+    if (top > bottom) {
+        // empty
+        __atomic_store_n(&queue->bottom, bottom + 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    Job* job = __atomic_load_n(&queue->jobs[bottom & (JOB_QUEUE_CAPACITY - 1)], __ATOMIC_RELAXED);
+    if (top == bottom) {
+        // the last job, a thief may be taking it too
+        if (!__atomic_compare_exchange_n(&queue->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) job = NULL;
+        __atomic_store_n(&queue->bottom, bottom + 1, __ATOMIC_RELAXED);
+    }
+    return job;
+}
+
+// steals the oldest job from the top of the deque of another thread
+static Job* job_steal(JobQueue* queue) {
+    int64_t top = __atomic_load_n(&queue->top, __ATOMIC_SEQ_CST);
+    const int64_t bottom = __atomic_load_n(&queue->bottom, __ATOMIC_SEQ_CST);
+    if (top >= bottom) return NULL;
+
+    Job* job = __atomic_load_n(&queue->jobs[top & (JOB_QUEUE_CAPACITY - 1)], __ATOMIC_RELAXED);
+    // lost the race against the owner or another thief
+    if (!__atomic_compare_exchange_n(&queue->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) return NULL;
+    return job;
+}
+
+// SCHEDULING
+// wakes a sleeping worker, if any (called after a job has been queued)
+static void job_wake() {
+    if (__atomic_load_n(&job_sleepers, __ATOMIC_SEQ_CST) == 0) return;
+    pthread_mutex_lock(&job_mutex);
+    pthread_cond_signal(&job_condition);
+    pthread_mutex_unlock(&job_mutex);
+}
+
+// takes a job: from the deque of the calling thread, then from the shared queue, then from the others
+static Job* job_take() {
+    Job* job = NULL;
+    const int index = job_threadIndex;
+    if (index >= 0) job = job_pop(&job_queues[index]);
+
+    if (job == NULL && __atomic_load_n(&job_sharedCount, __ATOMIC_ACQUIRE) > 0) {
+        pthread_mutex_lock(&job_mutex);
+        job = job_sharedHead;
+        if (job != NULL) {
+            job_sharedHead = job->next;
+            if (job_sharedHead == NULL) job_sharedTail = NULL;
+            __atomic_sub_fetch(&job_sharedCount, 1, __ATOMIC_RELEASE);
+        }
+        pthread_mutex_unlock(&job_mutex);
+    }
+
+    if (job == NULL) {
+        // start from a random victim, so the thieves do not all compete for the same deque
+        const unsigned int count = job_threadCount;
+        if (job_randomState == 0) job_randomState = 0x9E3779B9u * (uint32_t) (index + 2);
+        job_randomState ^= job_randomState << 13;
+        job_randomState ^= job_randomState >> 17;
+        job_randomState ^= job_randomState << 5;
+        const unsigned int first = job_randomState % count;
+        for (unsigned int i = 0; i < count && job == NULL; i++) {
+            const unsigned int victim = (first + i) % count;
+            if ((int) victim != index) job = job_steal(&job_queues[victim]);
+        }
+    }
+
+    if (job != NULL) __atomic_sub_fetch(&job_queued, 1, __ATOMIC_SEQ_CST);
+    return job;
+}
+
+// ends the job of a counter, submitting the jobs waiting for it when it was the last one
+static void job_finish(JobCounter* counter);
+
+static void job_execute(Job* job) {
+    if (job->rangeFunction != NULL) job->rangeFunction(job->start, job->end, job->data);
+    else job->function(job->data);
+
+    JobCounter* counter = job->counter;
+    if (job->heap) free(job);
+    else __atomic_store_n(&job->busy, false, __ATOMIC_RELEASE);
+    if (counter != NULL) job_finish(counter);
+}
+
+// queues a job (or runs it right away when the deque of the calling thread is full)
+static void job_submit(Job* job) {
+    // counted before being queued, so a worker going to sleep cannot miss it
+    __atomic_add_fetch(&job_queued, 1, __ATOMIC_SEQ_CST);
+    if (job_threadIndex >= 0) {
+        if (!job_push(&job_queues[job_threadIndex], job)) {
+            __atomic_sub_fetch(&job_queued, 1, __ATOMIC_SEQ_CST);
+            job_execute(job);
+            return;
+        }
+    } else {
+        job->next = NULL;
+        pthread_mutex_lock(&job_mutex);
+        if (job_sharedTail != NULL) job_sharedTail->next = job;
+        else job_sharedHead = job;
+        job_sharedTail = job;
+        __atomic_add_fetch(&job_sharedCount, 1, __ATOMIC_RELEASE);
+        pthread_mutex_unlock(&job_mutex);
+    }
+    job_wake();
+}
+
+static void job_finish(JobCounter* counter) {
+    // the decrement happens under the lock: job_wait() takes it before returning, so the counter is not touched after it returns
+    job_lockCounter(counter);
+    Job* waiting = NULL;
+    if (__atomic_sub_fetch(&counter->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        waiting = counter->waiting;
+        counter->waiting = NULL;
+    }
+    job_unlockCounter(counter);
+
+    while (waiting != NULL) {
+        Job* next = waiting->next;
+        job_submit(waiting);
+        waiting = next;
+    }
+}
+
+// runs a queued job, returns false if there was none
+static bool job_runOne() {
+    if (job_threadCount == 0) return false;
+    Job* job = job_take();
+    if (job == NULL) return false;
+    job_execute(job);
+    return true;
+}
+
+// returns a free job slot of the calling thread (a heap allocated job for the threads outside of the pool), NULL if there
+// is none: the caller then runs the job right away (the slots still busy can be the ones of the jobs running on this very
+// stack, waiting for others, so helping until they are free could never end)
+static Job* job_allocate() {
+    const int index = job_threadIndex;
+    if (index < 0) {
+        Job* job = calloc(1, sizeof(Job));
+        if (job != NULL) job->heap = true;
+        return job;
+    }
+
+    JobQueue* queue = &job_queues[index];
+    for (unsigned int i = 0; i < JOB_QUEUE_CAPACITY; i++) {
+        Job* job = &queue->slots[queue->nextSlot++ & (JOB_QUEUE_CAPACITY - 1)];
+        if (!__atomic_load_n(&job->busy, __ATOMIC_ACQUIRE)) {
+            memset(job, 0, sizeof(Job));
+            job->busy = true;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+static void* job_threadMain(void* argument) {
+    job_threadIndex = (int) (uintptr_t) argument;
+#ifdef G3CE_PROFILE
+    char name[PROFILER_MAX_THREAD_NAME];
+    snprintf(name, sizeof(name), "job worker %d", job_threadIndex);
+    PROFILE_THREAD(name);
+#endif
+
+    unsigned int attempts = 0;
+    while (true) {
+        if (job_runOne()) {
+            attempts = 0;
+            continue;
+        }
+        if (__atomic_load_n(&job_stopping, __ATOMIC_ACQUIRE)) break;
+        if (attempts < JOB_SPIN_COUNT) {
+            job_pause();
+            attempts++;
+            continue;
+        }
+
+        // sleep until a job is queued
+        pthread_mutex_lock(&job_mutex);
+        __atomic_add_fetch(&job_sleepers, 1, __ATOMIC_SEQ_CST);
+        while (!job_stopping && __atomic_load_n(&job_queued, __ATOMIC_SEQ_CST) <= 0) pthread_cond_wait(&job_condition, &job_mutex);
+        __atomic_sub_fetch(&job_sleepers, 1, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&job_mutex);
+        attempts = 0;
+    }
+    return NULL;
+}
+
+/*
+Starts the worker threads (app_create() calls it), the calling thread becomes the main thread of the pool.
+Parameters:
+    - threadCount (unsigned int): the threads running jobs, the main thread included (0 means one per core)
+Returns:
+    true on success, false otherwise
+*/
+bool job_init(unsigned int threadCount) {
+    if (job_threadCount > 0) return true;
+    if (threadCount == 0) {
+        const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        threadCount = cores > 0 ? (unsigned int) cores : 1;
+    }
+    if (threadCount > JOB_MAX_THREADS) threadCount = JOB_MAX_THREADS;
+
+    job_queues = aligned_alloc(JOB_CACHE_LINE, threadCount * sizeof(JobQueue));
+    if (job_queues == NULL) {
+        console_error("Failed to allocate the job queues");
+        return false;
+    }
+    memset(job_queues, 0, threadCount * sizeof(JobQueue));
+    job_queued = 0;
+    job_stopping = false;
+    job_threadIndex = 0;
+    job_threadCount = threadCount;
+
+    for (unsigned int i = 1; i < threadCount; i++) {
+        if (pthread_create(&job_threads[i], NULL, job_threadMain, (void*) (uintptr_t) i) != 0) {
+            // the queues of the threads that have not been created stay empty
+            console_warning("Failed to create job worker %u, running with %u threads", i, i);
+            job_threadCount = i;
+            break;
+        }
+    }
+    return true;
+}
+
+// runs the jobs still queued and stops the worker threads (app_terminate() calls it)
+void job_shutdown() {
+    if (job_threadCount == 0) return;
+    while (job_runOne()) {}
+
+    pthread_mutex_lock(&job_mutex);
+    __atomic_store_n(&job_stopping, true, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&job_condition);
+    pthread_mutex_unlock(&job_mutex);
+    for (unsigned int i = 1; i < job_threadCount; i++) pthread_join(job_threads[i], NULL);
+    // the jobs submitted by the last jobs run by the workers
+    while (job_runOne()) {}
+
+    free(job_queues);
+    job_queues = NULL;
+    job_threadCount = 0;
+    job_threadIndex = -1;
+}
+
+// returns the threads running jobs (the main thread included, 1 when the pool is not initialized)
+unsigned int job_getThreadCount() {
+    return job_threadCount > 0 ? job_threadCount : 1;
+}
+
+// returns the index of the calling thread in the pool (0 is the main thread, the workers go from 1 to job_getThreadCount() - 1, -1 for the threads outside of the pool)
+int job_getThreadIndex() {
+    return job_threadIndex;
+}
+
+/*
+Submits a job.
+Parameters:
+    - function (JobFunction): the function to run
+    - data (void*): the pointer passed to the function (it must stay valid until the job is done)
+    - counter (JobCounter*): the counter of the job (it can be NULL)
+*/
+void job_run(JobFunction function, void* data, JobCounter* counter) {
+    Job* job = job_threadCount > 0 ? job_allocate() : NULL;
+    if (job == NULL) {
+        // no pool (or no free slot): run it right away
+        function(data);
+        return;
+    }
+    job->function = function;
+    job->data = data;
+    job->counter = counter;
+    if (counter != NULL) __atomic_add_fetch(&counter->pending, 1, __ATOMIC_ACQ_REL);
+    job_submit(job);
+}
+
+/*
+Submits a job which starts only when all the jobs of another counter are done.
+Parameters:
+    - dependency (JobCounter*): the counter to wait for
+    - function (JobFunction): the function to run
+    - data (void*): the pointer passed to the function (it must stay valid until the job is done)
+    - counter (JobCounter*): the counter of the job (it can be NULL, it MUST NOT be the dependency)
+*/
+void job_runAfter(JobCounter* dependency, JobFunction function, void* data, JobCounter* counter) {
+    Job* job = job_threadCount > 0 ? job_allocate() : NULL;
+    if (job == NULL) {
+        job_wait(dependency);
+        function(data);
+        return;
+    }
+    job->function = function;
+    job->data = data;
+    job->counter = counter;
+    if (counter != NULL) __atomic_add_fetch(&counter->pending, 1, __ATOMIC_ACQ_REL);
+
+    // the last job of the dependency submits it when it is done
+    job_lockCounter(dependency);
+    if (__atomic_load_n(&dependency->pending, __ATOMIC_ACQUIRE) > 0) {
+        job->next = dependency->waiting;
+        dependency->waiting = job;
+        job_unlockCounter(dependency);
+        return;
+    }
+    job_unlockCounter(dependency);
+    job_submit(job);
+}
+
+/*
+Runs a function over a range of indices, split in batches run in parallel.
+Parameters:
+    - count (unsigned int): the indices (from 0 to count - 1)
+    - batchSize (unsigned int): the indices of every batch (0 picks a size giving a few batches per thread)
+    - function (JobRangeFunction): the function run on every batch
+    - data (void*): the pointer passed to the function
+    - counter (JobCounter*): the counter of the batches, NULL to wait for all of them before returning
+*/
+void job_parallelFor(unsigned int count, unsigned int batchSize, JobRangeFunction function, void* data, JobCounter* counter) {
+    if (count == 0) return;
+    if (job_threadCount <= 1) {
+        function(0, count, data);
+        return;
+    }
+    // a few batches per thread, so the threads that finish early can steal the rest
+    if (batchSize == 0) batchSize = count / (job_threadCount * 4);
+    if (batchSize == 0) batchSize = 1;
+
+    JobCounter batches = { 0 };
+    JobCounter* target = counter != NULL ? counter : &batches;
+    for (unsigned int start = 0; start < count; start += batchSize) {
+        const unsigned int end = count - start > batchSize ? start + batchSize : count;
+        Job* job = job_allocate();
+        if (job == NULL) {
+            function(start, end, data);
+            continue;
+        }
+        job->rangeFunction = function;
+        job->data = data;
+        job->start = start;
+        job->end = end;
+        job->counter = target;
+        __atomic_add_fetch(&target->pending, 1, __ATOMIC_ACQ_REL);
+        job_submit(job);
+    }
+    if (counter == NULL) job_wait(&batches);
+}
+
+// waits for all the jobs of a counter, running queued jobs meanwhile
+void job_wait(JobCounter* counter) {
+    unsigned int attempts = 0;
+    while (__atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) > 0) {
+        if (job_runOne()) attempts = 0;
+        else job_backoff(&attempts);
+    }
+    // the last job may still be submitting the ones waiting for the counter
+    job_lockCounter(counter);
+    job_unlockCounter(counter);
+}
+
+// returns true if all the jobs of a counter are done
+bool job_isDone(JobCounter* counter) {
+    return __atomic_load_n(&counter->pending, __ATOMIC_ACQUIRE) == 0 && !__atomic_load_n(&counter->lock, __ATOMIC_ACQUIRE);
+}
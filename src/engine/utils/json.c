@@ -0,0 +1,304 @@
+/*
+JSON:
+Minimal JSON parser (and the string writer of the JSON reports).
+The whole text is parsed at once into a flat array of tokens (values, object keys included) in document order, where
+every token knows where its children end, so walking a document never allocates and skipping a value is O(1).
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine/utils/console.h"
+
+#include "engine/utils/json.h"
+
+// deeper documents are rejected instead of risking a stack overflow
+#define JSON_MAX_DEPTH 256
+
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t position;
+    JsonToken* tokens;
+    unsigned int tokenCount;
+    unsigned int tokenCapacity;
+    const char* error;
+} JsonParser;
+
+static void json_skipWhitespace(JsonParser* parser) {
+    while (parser->position < parser->length) {
+        const char c = parser->text[parser->position];
+        if (c != ' ' && c != '\t' && c != '\n' && c != '\r') break;
+        parser->position++;
+    }
+}
+
+// adds a token and returns its index (-1 when out of memory)
+static int json_addToken(JsonParser* parser, JsonType type) {
+    if (parser->tokenCount == parser->tokenCapacity) {
+        const unsigned int capacity = parser->tokenCapacity > 0 ? parser->tokenCapacity * 2 : 256;
+        JsonToken* tokens = (JsonToken*) realloc(parser->tokens, capacity * sizeof(JsonToken));
+        if (tokens == NULL) {
+            parser->error = "out of memory";
+            return -1;
+        }
+        parser->tokens = tokens;
+        parser->tokenCapacity = capacity;
+    }
+    JsonToken* token = &parser->tokens[parser->tokenCount];
+    memset(token, 0, sizeof(JsonToken));
+    token->type = type;
+    token->start = (unsigned int) parser->position;
+    return (int) parser->tokenCount++;
+}
+
+static bool json_parseString(JsonParser* parser) {
+    parser->position++; // opening quote
+    const int index = json_addToken(parser, JSON_STRING);
+    if (index < 0) return false;
+
+    while (parser->position < parser->length) {
+        const char c = parser->text[parser->position];
+        if (c == '"') {
+            parser->tokens[index].length = (unsigned int) parser->position - parser->tokens[index].start;
+            parser->tokens[index].next = parser->tokenCount;
+            parser->position++;
+            return true;
+        }
+        if ((unsigned char) c < 0x20) break;
+        parser->position += c == '\\' ? 2 : 1;
+    }
+    parser->error = "unterminated string";
+    return false;
+}
+
+static bool json_parseNumber(JsonParser* parser) {
+    const int index = json_addToken(parser, JSON_NUMBER);
+    if (index < 0) return false;
+
+    // the text is not null terminated, so the number is copied before converting it
+    char buffer[64];
+    size_t length = 0;
+    while (parser->position < parser->length && length < sizeof(buffer) - 1) {
+        const char c = parser->text[parser->position];
+        if (!((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')) break;
+        buffer[length++] = c;
+        parser->position++;
+    }
+    buffer[length] = '\0';
+
+    char* end;
+    parser->tokens[index].number = strtod(buffer, &end);
+    parser->tokens[index].length = (unsigned int) length;
+    parser->tokens[index].next = parser->tokenCount;
+    if (length == 0 || *end != '\0') {
+        parser->error = "invalid number";
+        return false;
+    }
+    return true;
+}
+
+static bool json_parseLiteral(JsonParser* parser, const char* literal, JsonType type, double value) {
+    const size_t length = strlen(literal);
+    if (parser->length - parser->position < length || memcmp(parser->text + parser->position, literal, length) != 0) {
+        parser->error = "unexpected character";
+        return false;
+    }
+    const int index = json_addToken(parser, type);
+    if (index < 0) return false;
+    parser->tokens[index].length = (unsigned int) length;
+    parser->tokens[index].number = value;
+    parser->tokens[index].next = parser->tokenCount;
+    parser->position += length;
+    return true;
+}
+
+static bool json_parseValue(JsonParser* parser, unsigned int depth) {
+    json_skipWhitespace(parser);
+    if (parser->position >= parser->length) {
+        parser->error = "unexpected end of text";
+        return false;
+    }
+
+    const char c = parser->text[parser->position];
+    if (c == '"') return json_parseString(parser);
+    if (c == '-' || (c >= '0' && c <= '9')) return json_parseNumber(parser);
+    if (c == 't') return json_parseLiteral(parser, "true", JSON_BOOL, 1.0);
+    if (c == 'f') return json_parseLiteral(parser, "false", JSON_BOOL, 0.0);
+    if (c == 'n') return json_parseLiteral(parser, "null", JSON_NULL, 0.0);
+    if (c != '[' && c != '{') {
+        parser->error = "unexpected character";
+        return false;
+    }
+    if (depth >= JSON_MAX_DEPTH) {
+        parser->error = "too deep";
+        return false;
+    }
+
+    // arrays and objects
+    const bool isObject = c == '{';
+    const char close = isObject ? '}' : ']';
+    const int index = json_addToken(parser, isObject ? JSON_OBJECT : JSON_ARRAY);
+    if (index < 0) return false;
+    parser->position++;
+
+    unsigned int count = 0;
+    json_skipWhitespace(parser);
+    if (parser->position < parser->length && parser->text[parser->position] == close) {
+        parser->position++;
+    } else {
+        while (true) {
+            if (isObject) {
+                json_skipWhitespace(parser);
+                if (parser->position >= parser->length || parser->text[parser->position] != '"') {
+                    parser->error = "expected a key";
+                    return false;
+                }
+                if (!json_parseString(parser)) return false;
+                json_skipWhitespace(parser);
+                if (parser->position >= parser->length || parser->text[parser->position] != ':') {
+                    parser->error = "expected ':'";
+                    return false;
+                }
+                parser->position++;
+            }
+            if (!json_parseValue(parser, depth + 1)) return false;
+            count++;
+
+            json_skipWhitespace(parser);
+            if (parser->position < parser->length && parser->text[parser->position] == ',') {
+                parser->position++;
+            } else if (parser->position < parser->length && parser->text[parser->position] == close) {
+                parser->position++;
+                break;
+            } else {
+                parser->error = isObject ? "expected ',' or '}'" : "expected ',' or ']'";
+                return false;
+            }
+        }
+    }
+
+    // the token array could have been reallocated by the children
+    JsonToken* token = &parser->tokens[index];
+    token->count = count;
+    token->length = (unsigned int) parser->position - token->start;
+    token->next = parser->tokenCount;
+    return true;
+}
+
+/*
+Parses a JSON text.
+REMEMBER TO FREE THE DOCUMENT BY CALLING json_free()!
+Parameters:
+    - text (char*): the JSON text (it does not need to be null terminated and it must outlive the document)
+    - length (size_t): the text length in bytes
+    - document (JsonDocument*): where to store the parsed document
+Returns:
+    true on success, false if the text is not valid JSON (the error has already been logged)
+*/
+bool json_parse(const char* text, size_t length, JsonDocument* document) {
+    memset(document, 0, sizeof(JsonDocument));
+    if (length >= 0xFFFFFFFFu) {
+        console_error("JSON text too large (%zu bytes)", length);
+        return false;
+    }
+
+    JsonParser parser = { .text = text, .length = length };
+    bool success = json_parseValue(&parser, 0);
+    if (success) {
+        json_skipWhitespace(&parser);
+        if (parser.position < parser.length) {
+            parser.error = "unexpected text after the root value";
+            success = false;
+        }
+    }
+    if (!success) {
+        console_error("Invalid JSON: %s at offset %zu", parser.error, parser.position);
+        free(parser.tokens);
+        return false;
+    }
+
+    document->text = text;
+    document->tokens = parser.tokens;
+    document->tokenCount = parser.tokenCount;
+    return true;
+}
+
+// frees a document parsed by json_parse()
+void json_free(JsonDocument* document) {
+    free(document->tokens);
+    memset(document, 0, sizeof(JsonDocument));
+}
+
+// returns the type of a token (JSON_NULL for the missing token -1)
+JsonType json_getType(const JsonDocument* document, int token) {
+    if (token < 0 || (unsigned int) token >= document->tokenCount) return JSON_NULL;
+    return document->tokens[token].type;
+}
+
+// returns the value token of an object member (-1 if the token is not an object or it has no such member)
+int json_getMember(const JsonDocument* document, int object, const char* key) {
+    if (json_getType(document, object) != JSON_OBJECT) return -1;
+    unsigned int child = (unsigned int) object + 1;
+    for (unsigned int i = 0; i < document->tokens[object].count; i++) {
+        const unsigned int value = child + 1;
+        if (json_equals(document, (int) child, key)) return (int) value;
+        child = document->tokens[value].next;
+    }
+    return -1;
+}
+
+// returns the token of an array element (-1 if the token is not an array or the index is out of range)
+int json_getElement(const JsonDocument* document, int array, unsigned int index) {
+    if (json_getType(document, array) != JSON_ARRAY || index >= document->tokens[array].count) return -1;
+    unsigned int child = (unsigned int) array + 1;
+    for (unsigned int i = 0; i < index; i++) child = document->tokens[child].next;
+    return (int) child;
+}
+
+// returns the number of elements of an array or members of an object (0 for any other token)
+unsigned int json_getCount(const JsonDocument* document, int token) {
+    const JsonType type = json_getType(document, token);
+    return type == JSON_ARRAY || type == JSON_OBJECT ? document->tokens[token].count : 0;
+}
+
+// returns the value of a number or boolean token (fallback for any other token)
+double json_getNumber(const JsonDocument* document, int token, double fallback) {
+    const JsonType type = json_getType(document, token);
+    return type == JSON_NUMBER || type == JSON_BOOL ? document->tokens[token].number : fallback;
+}
+
+// returns whether a token is a string equal to the given one
+bool json_equals(const JsonDocument* document, int token, const char* string) {
+    if (json_getType(document, token) != JSON_STRING) return false;
+    const JsonToken* value = &document->tokens[token];
+    return strlen(string) == value->length && memcmp(document->text + value->start, string, value->length) == 0;
+}
+
+// copies a string token into the buffer (always null terminated, truncated if needed), returns false if the token is not a string
+bool json_copyString(const JsonDocument* document, int token, char* buffer, size_t size) {
+    if (size == 0) return false;
+    buffer[0] = '\0';
+    if (json_getType(document, token) != JSON_STRING) return false;
+    const JsonToken* value = &document->tokens[token];
+    const size_t length = value->length < size - 1 ? value->length : size - 1;
+    memcpy(buffer, document->text + value->start, length);
+    buffer[length] = '\0';
+    return true;
+}
+
+// writes a string as a JSON string (quotes, backslashes and control characters escaped), NULL is written as null
+void json_writeString(FILE* file, const char* string) {
+    if (string == NULL) {
+        fputs("null", file);
+        return;
+    }
+    fputc('"', file);
+    for (const char* c = string; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') fprintf(file, "\\%c", *c);
+        else if ((unsigned char) *c < 0x20) fprintf(file, "\\u%04x", (unsigned int) (unsigned char) *c);
+        else fputc(*c, file);
+    }
+    fputc('"', file);
+}
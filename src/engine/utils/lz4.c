@@ -0,0 +1,178 @@
+/*
+LZ4:
+LZ4 block format compressor and decompressor (no frame format, the sizes have to be stored by the caller).
+The compressor is a simple greedy one: fast, but it does not reach the ratio of the reference high compression mode.
+*/
+
+#include <string.h>
+#include <stdint.h>
+
+#include "engine/utils/lz4.h"
+
+// a block is a list of sequences: token (literals length << 4 | match length - 4), literals, 2 bytes offset, match.
+// The format requires the last 5 bytes to be literals and the last match to start at least 12 bytes before the end.
+#define LZ4_MIN_MATCH 4
+#define LZ4_LAST_LITERALS 5
+#define LZ4_MATCH_FIND_LIMIT 12
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 12
+
+static uint32_t lz4_read32(const unsigned char* data) {
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+static uint32_t lz4_hash(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+// writes the extra bytes of a length that did not fit in its 4 bits of the token
+static size_t lz4_writeLength(unsigned char* output, size_t length) {
+    size_t written = 0;
+    while (length >= 255) {
+        output[written++] = 255;
+        length -= 255;
+    }
+    output[written++] = (unsigned char) length;
+    return written;
+}
+
+// returns the maximum compressed size of size bytes (the output buffer of lz4_compress() should be this big)
+size_t lz4_compressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+/*
+Compresses a buffer to an LZ4 block.
+Parameters:
+    - source (unsigned char*): the data to compress
+    - sourceSize (size_t): the size of the data in bytes
+    - destination (unsigned char*): where to write the compressed block
+    - destinationCapacity (size_t): the size of the destination buffer in bytes
+Returns:
+    the size of the compressed block, 0 if it does not fit in the destination buffer
+*/
+size_t lz4_compress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationCapacity) {
+    // positions (+ 1, so 0 means empty) of the last occurrence of every hashed 4 bytes sequence
+    uint32_t table[1 << LZ4_HASH_BITS];
+    memset(table, 0, sizeof(table));
+
+    size_t input = 0, anchor = 0, output = 0;
+    if (sourceSize > LZ4_MATCH_FIND_LIMIT) {
+        const size_t matchFindLimit = sourceSize - LZ4_MATCH_FIND_LIMIT;
+        const size_t matchLimit = sourceSize - LZ4_LAST_LITERALS;
+
+        while (input <= matchFindLimit) {
+            const uint32_t sequence = lz4_read32(source + input);
+            const uint32_t hash = lz4_hash(sequence);
+            const size_t candidate = table[hash];
+            table[hash] = (uint32_t) input + 1;
+
+            if (candidate == 0 || input - (candidate - 1) > LZ4_MAX_OFFSET || lz4_read32(source + candidate - 1) != sequence) {
+                input++;
+                continue;
+            }
+            const size_t match = candidate - 1;
+
+            // extend the match as much as possible
+            size_t matchLength = LZ4_MIN_MATCH;
+            while (input + matchLength < matchLimit && source[match + matchLength] == source[input + matchLength]) matchLength++;
+
+            // token + literals length + literals + offset + match length
+            const size_t literalLength = input - anchor;
+            if (output + 1 + literalLength / 255 + 1 + literalLength + 2 + (matchLength - LZ4_MIN_MATCH) / 255 + 1 > destinationCapacity) return 0;
+
+            unsigned char* token = destination + output++;
+            *token = (unsigned char) ((literalLength < 15 ? literalLength : 15) << 4);
+            if (literalLength >= 15) output += lz4_writeLength(destination + output, literalLength - 15);
+            memcpy(destination + output, source + anchor, literalLength);
+            output += literalLength;
+
+            const size_t offset = input - match;
+            destination[output++] = offset & 0xff;
+            destination[output++] = (offset >> 8) & 0xff;
+
+            const size_t extraLength = matchLength - LZ4_MIN_MATCH;
+            *token |= (unsigned char) (extraLength < 15 ? extraLength : 15);
+            if (extraLength >= 15) output += lz4_writeLength(destination + output, extraLength - 15);
+
+            input += matchLength;
+            anchor = input;
+        }
+    }
+
+    // the remaining bytes are stored as the literals of the last sequence
+    const size_t literalLength = sourceSize - anchor;
+    if (output + 1 + literalLength / 255 + 1 + literalLength > destinationCapacity) return 0;
+    destination[output++] = (unsigned char) ((literalLength < 15 ? literalLength : 15) << 4);
+    if (literalLength >= 15) output += lz4_writeLength(destination + output, literalLength - 15);
+    memcpy(destination + output, source + anchor, literalLength);
+    output += literalLength;
+
+    return output;
+}
+
+/*
+Decompresses an LZ4 block (every offset and length is checked, so corrupted blocks are rejected instead of overflowing).
+Parameters:
+    - source (unsigned char*): the compressed block
+    - sourceSize (size_t): the size of the compressed block in bytes
+    - destination (unsigned char*): where to write the decompressed data
+    - destinationSize (size_t): the exact size of the decompressed data in bytes
+Returns:
+    true on success, false if the block is corrupted or does not decompress to exactly destinationSize bytes
+*/
+bool lz4_decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize) {
+    size_t input = 0, output = 0;
+    while (input < sourceSize) {
+        const unsigned char token = source[input++];
+
+        // literals
+        size_t literalLength = token >> 4;
+        if (literalLength == 15) {
+            unsigned char byte;
+            do {
+                if (input >= sourceSize) return false;
+                byte = source[input++];
+                literalLength += byte;
+            } while (byte == 255);
+        }
+        if (literalLength > sourceSize - input || literalLength > destinationSize - output) return false;
+        memcpy(destination + output, source + input, literalLength);
+        input += literalLength;
+        output += literalLength;
+
+        // the last sequence has no match
+        if (input == sourceSize) break;
+
+        // match
+        if (sourceSize - input < 2) return false;
+        const size_t offset = source[input] | ((size_t) source[input + 1] << 8);
+        input += 2;
+        if (offset == 0 || offset > output) return false;
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15) {
+            unsigned char byte;
+            do {
+                if (input >= sourceSize) return false;
+                byte = source[input++];
+                matchLength += byte;
+            } while (byte == 255);
+        }
+        matchLength += LZ4_MIN_MATCH;
+        if (matchLength > destinationSize - output) return false;
+
+        // the match can overlap the bytes being written (e.g. offset 1 repeats the last byte), so copy byte by byte in that case
+        const unsigned char* match = destination + output - offset;
+        if (offset >= matchLength) {
+            memcpy(destination + output, match, matchLength);
+        } else {
+            for (size_t i = 0; i < matchLength; i++) destination[output + i] = match[i];
+        }
+        output += matchLength;
+    }
+
+    return output == destinationSize;
+}
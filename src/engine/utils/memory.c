@@ -0,0 +1,494 @@
+/*
+MEMORY:
+Arenas, pools and memory tracking.
+A tracked heap allocation starts with a header holding its size and its tag (padded to MEMORY_ALIGNMENT), so it can be
+untracked when freed. The counters are updated with atomics, the peak with a compare and swap loop. The tracked GPU
+objects are kept in a hash table (open addressing, linear probing) from their type and name to their size and tag.
+The scratch arenas are registered in a list when their thread creates them, so memory_shutdown() frees them all (the
+generation works like the profiler one: after a shutdown every thread creates its arena again).
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine/utils/console.h"
+
+#include "engine/utils/memory.h"
+
+#define MEMORY_DEFAULT_BLOCK_SIZE 4096
+#define MEMORY_DEFAULT_BLOCK_LENGTH 64
+#define MEMORY_GPU_DEFAULT_CAPACITY 256
+// the leaked GPU objects listed by memory_shutdown() at most
+#define MEMORY_MAX_LEAKS_LISTED 16
+
+// the header of a tracked heap allocation
+typedef struct {
+    _Alignas(MEMORY_ALIGNMENT) size_t size;
+    MemoryTag tag;
+} MemoryHeader;
+
+// a tracked GPU object (key is 0 for the empty slots)
+typedef struct {
+    uint64_t key;
+    size_t bytes;
+    MemoryTag tag;
+} MemoryGpuEntry;
+
+struct ArenaBlock {
+    ArenaBlock* previous;
+    size_t size;     // bytes used
+    size_t capacity; // bytes of data
+    _Alignas(MEMORY_ALIGNMENT) unsigned char data[];
+};
+
+// a scratch arena and the link to the next one (see memory_getScratch())
+typedef struct MemoryScratch {
+    Arena arena;
+    struct MemoryScratch* next;
+} MemoryScratch;
+
+static MemoryStats memory_stats[MEMORY_TAG_COUNT][MEMORY_KIND_COUNT];
+static bool memory_overBudget[MEMORY_TAG_COUNT][MEMORY_KIND_COUNT];
+static const char* memory_tagNames[MEMORY_TAG_COUNT] = { "engine", "mesh", "texture", "shader", "user" };
+static const char* memory_kindNames[MEMORY_KIND_COUNT] = { "heap", "GPU" };
+static const char* memory_gpuObjectNames[] = { "buffer", "texture", "program" };
+
+static pthread_mutex_t memory_gpuMutex = PTHREAD_MUTEX_INITIALIZER;
+static MemoryGpuEntry* memory_gpuEntries = NULL;
+static unsigned int memory_gpuCount = 0;
+static unsigned int memory_gpuCapacity = 0; // a power of two
+
+static Arena memory_frame = ARENA_INIT(MEMORY_FRAME_CAPACITY, MEMORY_TAG_ENGINE);
+
+static pthread_mutex_t memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+static MemoryScratch* memory_scratches = NULL;
+static unsigned int memory_generation = 1; // incremented by memory_shutdown(), so the threads create their arena again
+static __thread MemoryScratch* memory_scratch = NULL;
+static __thread unsigned int memory_scratchGeneration = 0;
+
+static size_t memory_align(size_t size) {
+    return (size + MEMORY_ALIGNMENT - 1) / MEMORY_ALIGNMENT * MEMORY_ALIGNMENT;
+}
+
+// adds bytes and allocations (both can be negative) to the counters of a tag and a kind, warning when they go over the budget
+static void memory_count(MemoryTag tag, MemoryKind kind, long long bytes, int allocations) {
+    MemoryStats* stats = &memory_stats[tag][kind];
+    const size_t live = __atomic_add_fetch(&stats->live, (size_t) bytes, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->allocations, (unsigned int) allocations, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&stats->peak, __ATOMIC_RELAXED);
+    while (live > peak && !__atomic_compare_exchange_n(&stats->peak, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    // warn once every time the budget is crossed
+    const size_t budget = __atomic_load_n(&stats->budget, __ATOMIC_RELAXED);
+    const bool over = budget > 0 && live > budget;
+    if (over != __atomic_load_n(&memory_overBudget[tag][kind], __ATOMIC_RELAXED)
+        && __atomic_exchange_n(&memory_overBudget[tag][kind], over, __ATOMIC_RELAXED) != over && over) {
+        console_warning("The %s %s memory is over its budget: %zu bytes live, %zu bytes budget", memory_tagNames[tag], memory_kindNames[kind], live, budget);
+    }
+}
+
+// HEAP
+// allocates size bytes tracked with a tag (aligned to MEMORY_ALIGNMENT), returns NULL on failure (free it with memory_free())
+void* memory_alloc(MemoryTag tag, size_t size) {
+    MemoryHeader* header = malloc(sizeof(MemoryHeader) + size);
+    if (header == NULL) return NULL;
+    header->size = size;
+    header->tag = tag;
+    memory_count(tag, MEMORY_HEAP, (long long) size, 1);
+    return header + 1;
+}
+
+// allocates count elements of size bytes set to zero, tracked with a tag, returns NULL on failure (free it with memory_free())
+void* memory_calloc(MemoryTag tag, size_t count, size_t size) {
+    if (size > 0 && count > SIZE_MAX / size) return NULL;
+    void* memory = memory_alloc(tag, count * size);
+    if (memory != NULL) memset(memory, 0, count * size);
+    return memory;
+}
+
+// resizes an allocation of memory_alloc() (NULL allocates a new one with the tag), returns NULL on failure (the allocation is left untouched)
+void* memory_realloc(MemoryTag tag, void* memory, size_t size) {
+    if (memory == NULL) return memory_alloc(tag, size);
+    MemoryHeader* header = (MemoryHeader*) memory - 1;
+    const size_t previousSize = header->size;
+    const MemoryTag previousTag = header->tag;
+    header = realloc(header, sizeof(MemoryHeader) + size);
+    if (header == NULL) return NULL;
+    header->size = size;
+    memory_count(previousTag, MEMORY_HEAP, (long long) size - (long long) previousSize, 0);
+    return header + 1;
+}
+
+// frees an allocation of memory_alloc() (NULL is ignored)
+void memory_free(void* memory) {
+    if (memory == NULL) return;
+    MemoryHeader* header = (MemoryHeader*) memory - 1;
+    memory_count(header->tag, MEMORY_HEAP, -(long long) header->size, -1);
+    free(header);
+}
+
+// ARENAS
+// gives a block back: it becomes the spare if it is the largest one, otherwise it is freed
+static void arena_freeBlock(Arena* arena, ArenaBlock* block) {
+    if (arena->spare == NULL || block->capacity > arena->spare->capacity) {
+        memory_free(arena->spare);
+        arena->spare = block;
+    } else {
+        memory_free(block);
+    }
+}
+
+// chains a block of at least size bytes (the spare one if it is large enough), returns false if it cannot allocate
+static bool arena_pushBlock(Arena* arena, size_t size) {
+    const size_t blockSize = arena->blockSize > 0 ? arena->blockSize : MEMORY_DEFAULT_BLOCK_SIZE;
+    const size_t capacity = size > blockSize ? size : blockSize;
+    ArenaBlock* block;
+    if (arena->spare != NULL && arena->spare->capacity >= capacity) {
+        block = arena->spare;
+        arena->spare = NULL;
+    } else {
+        block = memory_alloc(arena->tag, sizeof(ArenaBlock) + capacity);
+        if (block == NULL) {
+            console_error("Failed to allocate an arena block of %zu bytes", capacity);
+            return false;
+        }
+        block->capacity = capacity;
+    }
+    block->size = 0;
+    block->previous = arena->block;
+    arena->block = block;
+    return true;
+}
+
+// allocates size bytes from an arena (aligned to MEMORY_ALIGNMENT), returns NULL on failure
+void* arena_alloc(Arena* arena, size_t size) {
+    size = memory_align(size > 0 ? size : 1);
+    ArenaBlock* block = arena->block;
+    if (block == NULL || block->capacity - block->size < size) {
+        if (!arena_pushBlock(arena, size)) return NULL;
+        block = arena->block;
+    }
+    void* memory = block->data + block->size;
+    block->size += size;
+    return memory;
+}
+
+// returns the state of an arena, every allocation made after it is freed by arena_rewind()
+ArenaMark arena_getMark(Arena* arena) {
+    return (ArenaMark) { .block = arena->block, .size = arena->block != NULL ? arena->block->size : 0 };
+}
+
+// frees all the allocations made after a mark (the blocks chained after it are freed too)
+void arena_rewind(Arena* arena, ArenaMark mark) {
+    while (arena->block != mark.block) {
+        ArenaBlock* previous = arena->block->previous;
+        arena_freeBlock(arena, arena->block);
+        arena->block = previous;
+    }
+    if (arena->block != NULL) arena->block->size = mark.size;
+}
+
+// frees all the allocations of an arena, keeping a single block large enough for all of them
+void arena_reset(Arena* arena) {
+    if (arena->block == NULL) return;
+    if (arena->block->previous == NULL) {
+        arena->block->size = 0;
+        return;
+    }
+    // the allocations did not fit in a block: the next block holds them all, so the next time they do
+    const size_t used = arena_getUsed(arena);
+    if (used > arena->blockSize) arena->blockSize = used;
+    arena_rewind(arena, (ArenaMark) { .block = NULL, .size = 0 });
+}
+
+// frees all the blocks of an arena (it can still be used, it starts over)
+void arena_release(Arena* arena) {
+    arena_rewind(arena, (ArenaMark) { .block = NULL, .size = 0 });
+    memory_free(arena->spare);
+    arena->spare = NULL;
+}
+
+// returns the bytes allocated from an arena
+size_t arena_getUsed(Arena* arena) {
+    size_t used = 0;
+    for (ArenaBlock* block = arena->block; block != NULL; block = block->previous) used += block->size;
+    return used;
+}
+
+// POOLS
+// (the blocks are not tracked, the elements in use are)
+// (a short critical section: the waiting threads yield, the owner may have been preempted)
+static void pool_lock(Pool* pool) {
+    while (__atomic_test_and_set(&pool->lock, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(&pool->lock, __ATOMIC_RELAXED)) sched_yield();
+    }
+}
+
+static void pool_unlock(Pool* pool) {
+    __atomic_clear(&pool->lock, __ATOMIC_RELEASE);
+}
+
+// allocates an element from a pool (its content is undefined), returns NULL on failure
+void* pool_alloc(Pool* pool) {
+    pool_lock(pool);
+    if (pool->freeList == NULL) {
+        // a block starts with the link to the previous one (padded to keep the elements aligned)
+        const size_t stride = pool->stride > 0 ? pool->stride : MEMORY_ALIGNMENT;
+        const unsigned int length = pool->blockLength > 0 ? pool->blockLength : MEMORY_DEFAULT_BLOCK_LENGTH;
+        unsigned char* block = malloc(MEMORY_ALIGNMENT + stride * length);
+        if (block == NULL) {
+            pool_unlock(pool);
+            console_error("Failed to allocate a pool block of %u elements of %zu bytes", length, stride);
+            return NULL;
+        }
+        *(void**) block = pool->blocks;
+        pool->blocks = block;
+        // the elements are chained in order, the first one on top
+        for (unsigned int i = length; i-- > 0;) {
+            void** element = (void**) (block + MEMORY_ALIGNMENT + i * stride);
+            *element = pool->freeList;
+            pool->freeList = element;
+        }
+    }
+    void** element = pool->freeList;
+    pool->freeList = *element;
+    pool->count++;
+    pool_unlock(pool);
+    memory_count(pool->tag, MEMORY_HEAP, (long long) pool->stride, 1);
+    return element;
+}
+
+// gives an element back to a pool (NULL is ignored)
+void pool_free(Pool* pool, void* element) {
+    if (element == NULL) return;
+    pool_lock(pool);
+    *(void**) element = pool->freeList;
+    pool->freeList = element;
+    pool->count--;
+    pool_unlock(pool);
+    memory_count(pool->tag, MEMORY_HEAP, -(long long) pool->stride, -1);
+}
+
+// frees all the blocks of a pool, the elements MUST NOT be used anymore (it can still be used, it starts over)
+void pool_release(Pool* pool) {
+    pool_lock(pool);
+    void* block = pool->blocks;
+    while (block != NULL) {
+        void* previous = *(void**) block;
+        free(block);
+        block = previous;
+    }
+    pool->blocks = NULL;
+    pool->freeList = NULL;
+    const unsigned int count = pool->count;
+    pool->count = 0;
+    pool_unlock(pool);
+    memory_count(pool->tag, MEMORY_HEAP, -(long long) (count * pool->stride), -(int) count);
+}
+
+// TRACKING
+static unsigned int memory_gpuSlot(uint64_t key) {
+    return (unsigned int) ((key * 0x9E3779B97F4A7C15ull) >> 32) & (memory_gpuCapacity - 1);
+}
+
+static uint64_t memory_gpuKey(MemoryGpuObject type, unsigned int name) {
+    return ((uint64_t) type + 1) << 32 | name;
+}
+
+// returns the slot of a key, or the empty slot where it would go (the mutex must be locked and the table allocated)
+static unsigned int memory_findGpu(uint64_t key) {
+    unsigned int slot = memory_gpuSlot(key);
+    while (memory_gpuEntries[slot].key != 0 && memory_gpuEntries[slot].key != key) slot = (slot + 1) & (memory_gpuCapacity - 1);
+    return slot;
+}
+
+// doubles the table (the mutex must be locked), returns false if it cannot allocate
+static bool memory_growGpu() {
+    const unsigned int capacity = memory_gpuCapacity > 0 ? memory_gpuCapacity * 2 : MEMORY_GPU_DEFAULT_CAPACITY;
+    MemoryGpuEntry* entries = calloc(capacity, sizeof(MemoryGpuEntry));
+    if (entries == NULL) {
+        console_error("Failed to track %u GPU objects", capacity / 2);
+        return false;
+    }
+    MemoryGpuEntry* previous = memory_gpuEntries;
+    const unsigned int previousCapacity = memory_gpuCapacity;
+    memory_gpuEntries = entries;
+    memory_gpuCapacity = capacity;
+    for (unsigned int i = 0; i < previousCapacity; i++) {
+        if (previous[i].key != 0) memory_gpuEntries[memory_findGpu(previous[i].key)] = previous[i];
+    }
+    free(previous);
+    return true;
+}
+
+// tracks the size of a GPU object (replacing its previous size if it is already tracked, e.g. after a new glBufferData())
+void memory_trackGpu(MemoryGpuObject type, unsigned int name, MemoryTag tag, size_t bytes) {
+    const uint64_t key = memory_gpuKey(type, name);
+    pthread_mutex_lock(&memory_gpuMutex);
+    // (at most half full, so the probes stay short)
+    if ((memory_gpuCount + 1) * 2 > memory_gpuCapacity && !memory_growGpu()) {
+        pthread_mutex_unlock(&memory_gpuMutex);
+        return;
+    }
+    MemoryGpuEntry* entry = &memory_gpuEntries[memory_findGpu(key)];
+    if (entry->key != 0) {
+        memory_count(entry->tag, MEMORY_GPU, -(long long) entry->bytes, -1);
+    } else {
+        entry->key = key;
+        memory_gpuCount++;
+    }
+    entry->bytes = bytes;
+    entry->tag = tag;
+    memory_count(tag, MEMORY_GPU, (long long) bytes, 1);
+    pthread_mutex_unlock(&memory_gpuMutex);
+}
+
+// stops tracking a GPU object once deleted (the objects not tracked are ignored)
+void memory_untrackGpu(MemoryGpuObject type, unsigned int name) {
+    const uint64_t key = memory_gpuKey(type, name);
+    pthread_mutex_lock(&memory_gpuMutex);
+    if (memory_gpuCount == 0) {
+        pthread_mutex_unlock(&memory_gpuMutex);
+        return;
+    }
+    unsigned int slot = memory_findGpu(key);
+    if (memory_gpuEntries[slot].key == 0) {
+        pthread_mutex_unlock(&memory_gpuMutex);
+        return;
+    }
+    memory_count(memory_gpuEntries[slot].tag, MEMORY_GPU, -(long long) memory_gpuEntries[slot].bytes, -1);
+    memory_gpuCount--;
+
+    // the entries after it in its cluster move back if the slot is between them and their home (no tombstones)
+    unsigned int next = slot;
+    while (true) {
+        next = (next + 1) & (memory_gpuCapacity - 1);
+        if (memory_gpuEntries[next].key == 0) break;
+        const unsigned int home = memory_gpuSlot(memory_gpuEntries[next].key);
+        if (((next - home) & (memory_gpuCapacity - 1)) >= ((next - slot) & (memory_gpuCapacity - 1))) {
+            memory_gpuEntries[slot] = memory_gpuEntries[next];
+            slot = next;
+        }
+    }
+    memory_gpuEntries[slot].key = 0;
+    pthread_mutex_unlock(&memory_gpuMutex);
+}
+
+// sets the budget of a tag and a kind in bytes: a warning is logged when the live bytes go over it (0 removes it)
+void memory_setBudget(MemoryTag tag, MemoryKind kind, size_t budget) {
+    __atomic_store_n(&memory_stats[tag][kind].budget, budget, __ATOMIC_RELAXED);
+    // (checked right away, the live bytes may already be over it)
+    memory_count(tag, kind, 0, 0);
+}
+
+// returns the counters of a tag and a kind
+MemoryStats memory_getStats(MemoryTag tag, MemoryKind kind) {
+    const MemoryStats* stats = &memory_stats[tag][kind];
+    return (MemoryStats) {
+        .live = __atomic_load_n(&stats->live, __ATOMIC_RELAXED),
+        .peak = __atomic_load_n(&stats->peak, __ATOMIC_RELAXED),
+        .allocations = __atomic_load_n(&stats->allocations, __ATOMIC_RELAXED),
+        .budget = __atomic_load_n(&stats->budget, __ATOMIC_RELAXED)
+    };
+}
+
+// returns the name of a tag ("engine", "mesh", "texture", "shader" or "user")
+const char* memory_getTagName(MemoryTag tag) {
+    return tag < MEMORY_TAG_COUNT ? memory_tagNames[tag] : "unknown";
+}
+
+// logs the counters of every tag
+void memory_logStats() {
+    console_output("%-8s %-4s %14s %14s %12s %14s", "tag", "kind", "live bytes", "peak bytes", "allocations", "budget");
+    for (unsigned int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        for (unsigned int kind = 0; kind < MEMORY_KIND_COUNT; kind++) {
+            const MemoryStats stats = memory_getStats(tag, kind);
+            if (stats.peak == 0 && stats.allocations == 0 && stats.budget == 0) continue;
+            char budget[32] = "-";
+            if (stats.budget > 0) snprintf(budget, sizeof(budget), "%zu", stats.budget);
+            console_output("%-8s %-4s %14zu %14zu %12u %14s", memory_tagNames[tag], memory_kindNames[kind], stats.live, stats.peak, stats.allocations, budget);
+        }
+    }
+}
+
+// ENGINE ARENAS
+// allocates size bytes from the frame arena, valid until the next frame starts (main thread only), returns NULL on failure
+void* memory_frameAlloc(size_t size) {
+    return arena_alloc(&memory_frame, size);
+}
+
+// returns the frame arena (main thread only)
+Arena* memory_getFrameArena() {
+    return &memory_frame;
+}
+
+// frees the allocations of the frame arena (the app loop calls it at the start of every frame)
+void memory_beginFrame() {
+    arena_reset(&memory_frame);
+}
+
+/*
+Returns the scratch arena of the calling thread, creating it on the first call. Take a mark before allocating and
+rewind the arena to it once done, so the callers up the stack keep their own allocations:
+ArenaMark mark = arena_getMark(scratch); ... arena_alloc(scratch, size) ... arena_rewind(scratch, mark);
+Returns:
+    The arena, NULL if it could not be allocated
+*/
+Arena* memory_getScratch() {
+    if (memory_scratch != NULL && memory_scratchGeneration == __atomic_load_n(&memory_generation, __ATOMIC_ACQUIRE)) return &memory_scratch->arena;
+
+    MemoryScratch* scratch = memory_alloc(MEMORY_TAG_ENGINE, sizeof(MemoryScratch));
+    if (scratch == NULL) {
+        console_error("Failed to allocate a scratch arena");
+        return NULL;
+    }
+    scratch->arena = (Arena) ARENA_INIT(MEMORY_SCRATCH_CAPACITY, MEMORY_TAG_ENGINE);
+    pthread_mutex_lock(&memory_mutex);
+    scratch->next = memory_scratches;
+    memory_scratches = scratch;
+    memory_scratchGeneration = memory_generation;
+    pthread_mutex_unlock(&memory_mutex);
+
+    memory_scratch = scratch;
+    return &scratch->arena;
+}
+
+// frees the frame arena and the scratch arenas of all the threads (no other thread may be using them anymore), it is called by app_terminate()
+void memory_shutdown() {
+    arena_release(&memory_frame);
+    pthread_mutex_lock(&memory_mutex);
+    MemoryScratch* scratch = memory_scratches;
+    while (scratch != NULL) {
+        MemoryScratch* next = scratch->next;
+        arena_release(&scratch->arena);
+        memory_free(scratch);
+        scratch = next;
+    }
+    memory_scratches = NULL;
+    __atomic_add_fetch(&memory_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&memory_mutex);
+    memory_scratch = NULL;
+
+    // whatever is still tracked has leaked
+    for (unsigned int tag = 0; tag < MEMORY_TAG_COUNT; tag++) {
+        for (unsigned int kind = 0; kind < MEMORY_KIND_COUNT; kind++) {
+            const MemoryStats stats = memory_getStats(tag, kind);
+            if (stats.allocations == 0) continue;
+            console_warning("Memory leak: %u %s %s allocations (%zu bytes) were never freed", stats.allocations, memory_tagNames[tag], memory_kindNames[kind], stats.live);
+        }
+    }
+    pthread_mutex_lock(&memory_gpuMutex);
+    unsigned int listed = 0;
+    for (unsigned int i = 0; i < memory_gpuCapacity && listed < MEMORY_MAX_LEAKS_LISTED; i++) {
+        const MemoryGpuEntry* entry = &memory_gpuEntries[i];
+        if (entry->key == 0) continue;
+        console_warning("    %s %u (%s, %zu bytes)", memory_gpuObjectNames[(entry->key >> 32) - 1], (unsigned int) entry->key, memory_tagNames[entry->tag], entry->bytes);
+        listed++;
+    }
+    if (memory_gpuCount > listed) console_warning("    ... and %u more GPU objects", memory_gpuCount - listed);
+    pthread_mutex_unlock(&memory_gpuMutex);
+}
@@ -0,0 +1,408 @@
+/*
+PROFILER:
+CPU frame profiler.
+Every thread owns a ring of completed events, written only by that thread and published with an atomic counter,
+so profiling a scope never takes a lock. profiler_frame() reads the new events of every ring and aggregates them per
+scope name (looked up by pointer first, so most lookups are a single hash probe).
+The ring of a thread that exits is given back and reused by the next thread that starts profiling, so short-lived
+threads (e.g. the OBJ loader workers) do not add a ring each.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "engine/utils/file.h"
+#include "engine/utils/console.h"
+#include "engine/utils/json.h"
+
+#include "engine/utils/profiler.h"
+
+// must be a power of two, greater than PROFILER_MAX_SCOPES
+#define PROFILER_LOOKUP_SIZE 1024
+
+typedef struct {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    unsigned int depth;
+} ProfilerEvent;
+
+typedef struct ProfilerThread {
+    ProfilerEvent events[PROFILER_RING_EVENTS];
+    uint64_t count;      // events written so far (only written by the owner thread)
+    uint64_t aggregated; // events aggregated so far (only used by profiler_frame())
+    // open scopes
+    const char* stackNames[PROFILER_MAX_DEPTH];
+    uint64_t stackStarts[PROFILER_MAX_DEPTH];
+    unsigned int depth;
+    unsigned int id;
+    bool gpu;            // the GPU track (its events are added by profiler_addGpuEvent())
+    bool released;       // its thread exited, the next thread without a ring takes it over
+    char name[PROFILER_MAX_THREAD_NAME];
+    struct ProfilerThread* next;
+} ProfilerThread;
+
+typedef struct {
+    const char* name;
+    bool gpu;
+    unsigned int depth;
+    unsigned int pendingCalls; // calls of the frame being aggregated
+    uint64_t pendingTime;      // nanoseconds of the frame being aggregated
+    unsigned int calls;
+    unsigned int frames;
+    double last;
+    double min;
+    double max;
+    double total;
+} ProfilerScope;
+
+static pthread_mutex_t profiler_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ProfilerThread* profiler_threads = NULL;
+static unsigned int profiler_threadCount = 0;
+static unsigned int profiler_generation = 1; // incremented by profiler_shutdown(), so the threads register again
+static uint64_t profiler_startTime = 0;
+
+static ProfilerThread* profiler_gpuTrack = NULL;
+
+// the key whose destructor gives the ring of an exiting thread back
+static pthread_key_t profiler_threadKey;
+static pthread_once_t profiler_threadKeyOnce = PTHREAD_ONCE_INIT;
+
+static __thread ProfilerThread* profiler_current = NULL;
+static __thread unsigned int profiler_currentGeneration = 0;
+
+static ProfilerScope profiler_scopes[PROFILER_MAX_SCOPES];
+static unsigned int profiler_scopeCount = 0;
+static struct {
+    const char* name;
+    bool gpu;
+    unsigned int scope;
+} profiler_lookup[PROFILER_LOOKUP_SIZE];
+static ProfilerScope profiler_frameScope = { .name = "frame interval" };
+static uint64_t profiler_lastFrame = 0;
+
+// returns the profiler clock in nanoseconds (monotonic)
+uint64_t profiler_getTime() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000ull + (uint64_t) now.tv_nsec;
+}
+
+// creates a ring and adds it to the list (the mutex must be locked), NULL if out of memory
+static ProfilerThread* profiler_createThread(const char* name) {
+    ProfilerThread* thread = (ProfilerThread*) calloc(1, sizeof(ProfilerThread));
+    if (thread == NULL) return NULL;
+    if (profiler_startTime == 0) profiler_startTime = profiler_getTime();
+    thread->id = profiler_threadCount++;
+    if (name != NULL) snprintf(thread->name, sizeof(thread->name), "%s", name);
+    else snprintf(thread->name, sizeof(thread->name), "thread %u", thread->id);
+    thread->next = profiler_threads;
+    profiler_threads = thread;
+    return thread;
+}
+
+// gives the ring of an exiting thread back (the destructor of profiler_threadKey)
+static void profiler_releaseThread(void* value) {
+    pthread_mutex_lock(&profiler_mutex);
+    // the ring may have been freed by profiler_shutdown() in the meantime, so it is only touched if still listed
+    for (ProfilerThread* thread = profiler_threads; thread != NULL; thread = thread->next) {
+        if (thread == value) {
+            thread->released = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&profiler_mutex);
+}
+
+static void profiler_createThreadKey() {
+    pthread_key_create(&profiler_threadKey, profiler_releaseThread);
+}
+
+// returns the ring of the calling thread, taking over a released one or creating it on the first call (NULL if out of memory)
+static ProfilerThread* profiler_getThread() {
+    if (profiler_current != NULL && profiler_currentGeneration == __atomic_load_n(&profiler_generation, __ATOMIC_ACQUIRE)) return profiler_current;
+    pthread_once(&profiler_threadKeyOnce, profiler_createThreadKey);
+
+    pthread_mutex_lock(&profiler_mutex);
+    ProfilerThread* thread = profiler_threads;
+    while (thread != NULL && !thread->released) thread = thread->next;
+    if (thread != NULL) {
+        // the events of the previous owner stay in the ring, the count goes on from them
+        thread->released = false;
+        thread->depth = 0;
+        snprintf(thread->name, sizeof(thread->name), "thread %u", thread->id);
+    } else {
+        thread = profiler_createThread(NULL);
+    }
+    profiler_currentGeneration = profiler_generation;
+    pthread_mutex_unlock(&profiler_mutex);
+
+    profiler_current = thread;
+    if (thread != NULL) pthread_setspecific(profiler_threadKey, thread);
+    return thread;
+}
+
+// appends an event to a ring (only from the thread writing to it)
+static void profiler_push(ProfilerThread* thread, const char* name, unsigned int depth, uint64_t start, uint64_t end) {
+    const uint64_t count = thread->count;
+    ProfilerEvent* event = &thread->events[count & (PROFILER_RING_EVENTS - 1)];
+    event->name = name;
+    event->start = start;
+    event->end = end;
+    event->depth = depth;
+    __atomic_store_n(&thread->count, count + 1, __ATOMIC_RELEASE);
+}
+
+// begins a scope on the calling thread (see PROFILE_BEGIN())
+void profiler_begin(const char* name) {
+    ProfilerThread* thread = profiler_getThread();
+    if (thread == NULL) return;
+    if (thread->depth < PROFILER_MAX_DEPTH) {
+        thread->stackNames[thread->depth] = name;
+        thread->stackStarts[thread->depth] = profiler_getTime();
+    }
+    thread->depth++;
+}
+
+// ends the last scope begun on the calling thread (see PROFILE_END())
+void profiler_end() {
+    ProfilerThread* thread = profiler_current;
+    if (thread == NULL || thread->depth == 0 || profiler_currentGeneration != __atomic_load_n(&profiler_generation, __ATOMIC_ACQUIRE)) return;
+    thread->depth--;
+    if (thread->depth >= PROFILER_MAX_DEPTH) return; // too deep to be recorded
+
+    profiler_push(thread, thread->stackNames[thread->depth], thread->depth, thread->stackStarts[thread->depth], profiler_getTime());
+}
+
+// ends the last scope begun on the calling thread (cleanup function of PROFILE_SCOPE())
+void profiler_endScope(int* scope) {
+    (void) scope;
+    profiler_end();
+}
+
+// names the calling thread in the exported traces (the main thread is called "main" by the app loop)
+void profiler_setThreadName(const char* name) {
+    ProfilerThread* thread = profiler_getThread();
+    if (thread == NULL) return;
+    pthread_mutex_lock(&profiler_mutex);
+    snprintf(thread->name, sizeof(thread->name), "%s", name);
+    pthread_mutex_unlock(&profiler_mutex);
+}
+
+/*
+Adds a scope measured on the GPU to the "GPU" track (used by the GPU profiler, only from the thread owning the context).
+Parameters:
+    - name (const char*): the scope name
+    - depth (unsigned int): the nesting level of the scope
+    - start (uint64_t): when the scope started, in nanoseconds of the profiler clock
+    - end (uint64_t): when the scope ended, in nanoseconds of the profiler clock
+*/
+void profiler_addGpuEvent(const char* name, unsigned int depth, uint64_t start, uint64_t end) {
+    if (profiler_gpuTrack == NULL) {
+        pthread_mutex_lock(&profiler_mutex);
+        profiler_gpuTrack = profiler_createThread("GPU");
+        if (profiler_gpuTrack != NULL) profiler_gpuTrack->gpu = true;
+        pthread_mutex_unlock(&profiler_mutex);
+        if (profiler_gpuTrack == NULL) return;
+    }
+    profiler_push(profiler_gpuTrack, name, depth, start, end);
+}
+
+// returns the aggregated scope of a name (NULL if there are too many scopes)
+static ProfilerScope* profiler_findScope(const char* name, bool gpu, unsigned int depth) {
+    unsigned int slot = (unsigned int) ((((uintptr_t) name >> 3) ^ gpu) * 2654435761u) & (PROFILER_LOOKUP_SIZE - 1);
+    while (profiler_lookup[slot].name != NULL) {
+        if (profiler_lookup[slot].name == name && profiler_lookup[slot].gpu == gpu) return &profiler_scopes[profiler_lookup[slot].scope];
+        slot = (slot + 1) & (PROFILER_LOOKUP_SIZE - 1);
+    }
+
+    // a new pointer: the same name can come from another literal
+    unsigned int scope = 0;
+    while (scope < profiler_scopeCount && (profiler_scopes[scope].gpu != gpu || strcmp(profiler_scopes[scope].name, name) != 0)) scope++;
+    if (scope == profiler_scopeCount) {
+        if (profiler_scopeCount == PROFILER_MAX_SCOPES) return NULL;
+        memset(&profiler_scopes[scope], 0, sizeof(ProfilerScope));
+        profiler_scopes[scope].name = name;
+        profiler_scopes[scope].gpu = gpu;
+        profiler_scopes[scope].depth = depth;
+        profiler_scopeCount++;
+    }
+    // the lookup holds at most one pointer per scope and per literal, it never fills up in practice
+    if (profiler_scopeCount < PROFILER_LOOKUP_SIZE / 2) {
+        profiler_lookup[slot].name = name;
+        profiler_lookup[slot].gpu = gpu;
+        profiler_lookup[slot].scope = scope;
+    }
+    return &profiler_scopes[scope];
+}
+
+// folds the pending time of a scope into its statistics
+static void profiler_closeFrame(ProfilerScope* scope, uint64_t time, unsigned int calls) {
+    scope->calls = calls;
+    scope->last = (double) time / 1000000.0;
+    if (calls == 0) return;
+    scope->min = scope->frames == 0 || scope->last < scope->min ? scope->last : scope->min;
+    scope->max = scope->frames == 0 || scope->last > scope->max ? scope->last : scope->max;
+    scope->total += scope->last;
+    scope->frames++;
+}
+
+/*
+Marks the end of a frame: aggregates the scopes ended since the previous call on all the threads.
+It is called by the app loop after swapping the buffers.
+*/
+void profiler_frame() {
+    const uint64_t now = profiler_getTime();
+
+    pthread_mutex_lock(&profiler_mutex);
+    for (ProfilerThread* thread = profiler_threads; thread != NULL; thread = thread->next) {
+        const uint64_t count = __atomic_load_n(&thread->count, __ATOMIC_ACQUIRE);
+        uint64_t index = thread->aggregated;
+        // the oldest ones were overwritten, and the slot of the next event (count) is the one of the oldest left, which may be being written
+        if (count - index >= PROFILER_RING_EVENTS) index = count - PROFILER_RING_EVENTS + 1;
+
+        for (; index < count; index++) {
+            const ProfilerEvent event = thread->events[index & (PROFILER_RING_EVENTS - 1)];
+            // the owner may have wrapped around while the event was being copied (it writes the slot of count before incrementing it)
+            if (__atomic_load_n(&thread->count, __ATOMIC_ACQUIRE) - index >= PROFILER_RING_EVENTS) continue;
+            ProfilerScope* scope = profiler_findScope(event.name, thread->gpu, event.depth);
+            if (scope == NULL) continue;
+            scope->pendingCalls++;
+            scope->pendingTime += event.end - event.start;
+        }
+        thread->aggregated = count;
+    }
+    pthread_mutex_unlock(&profiler_mutex);
+
+    for (unsigned int i = 0; i < profiler_scopeCount; i++) {
+        profiler_closeFrame(&profiler_scopes[i], profiler_scopes[i].pendingTime, profiler_scopes[i].pendingCalls);
+        profiler_scopes[i].pendingCalls = 0;
+        profiler_scopes[i].pendingTime = 0;
+    }
+    if (profiler_lastFrame != 0) profiler_closeFrame(&profiler_frameScope, now - profiler_lastFrame, 1);
+    profiler_lastFrame = now;
+}
+
+static ProfilerScopeStats profiler_toStats(const ProfilerScope* scope) {
+    return (ProfilerScopeStats) {
+        .name = scope->name,
+        .gpu = scope->gpu,
+        .depth = scope->depth,
+        .calls = scope->calls,
+        .frames = scope->frames,
+        .last = scope->last,
+        .min = scope->min,
+        .avg = scope->frames > 0 ? scope->total / scope->frames : 0.0,
+        .max = scope->max
+    };
+}
+
+/*
+Copies the per scope statistics (in the order the scopes have been first seen).
+Parameters:
+    - stats (ProfilerScopeStats*): where to store the statistics
+    - maxScopes (unsigned int): the capacity of stats
+Returns:
+    the number of scopes copied
+*/
+unsigned int profiler_getScopeStats(ProfilerScopeStats* stats, unsigned int maxScopes) {
+    const unsigned int count = profiler_scopeCount < maxScopes ? profiler_scopeCount : maxScopes;
+    for (unsigned int i = 0; i < count; i++) stats[i] = profiler_toStats(&profiler_scopes[i]);
+    return count;
+}
+
+// returns the statistics of the whole frame (the time between two profiler_frame() calls)
+ProfilerScopeStats profiler_getFrameStats() {
+    return profiler_toStats(&profiler_frameScope);
+}
+
+// resets the min, avg and max of all the scopes
+void profiler_resetStats() {
+    for (unsigned int i = 0; i < profiler_scopeCount; i++) {
+        profiler_scopes[i].frames = 0;
+        profiler_scopes[i].total = 0.0;
+        profiler_scopes[i].min = 0.0;
+        profiler_scopes[i].max = 0.0;
+    }
+    profiler_frameScope.frames = 0;
+    profiler_frameScope.total = 0.0;
+    profiler_frameScope.min = 0.0;
+    profiler_frameScope.max = 0.0;
+}
+
+// writes the per scope statistics to the console (indented by nesting level)
+void profiler_printStats() {
+    const ProfilerScopeStats frame = profiler_getFrameStats();
+    console_output("%-40s %9s %9s %9s %9s %7s", "scope (ms per frame)", "last", "min", "avg", "max", "calls");
+    console_output("%-40s %9.3f %9.3f %9.3f %9.3f %7u", frame.name, frame.last, frame.min, frame.avg, frame.max, frame.calls);
+    for (unsigned int i = 0; i < profiler_scopeCount; i++) {
+        const ProfilerScopeStats scope = profiler_toStats(&profiler_scopes[i]);
+        // the GPU scopes are marked with a '*' in front
+        const int indent = (int) (scope.depth < 8 ? scope.depth : 8) * 2 + (scope.gpu ? 2 : 0);
+        console_output("%s%*s%-*.*s %9.3f %9.3f %9.3f %9.3f %7u", scope.gpu ? "* " : "", indent - (scope.gpu ? 2 : 0), "", 40 - indent, 40 - indent, scope.name,
+            scope.last, scope.min, scope.avg, scope.max, scope.calls);
+    }
+}
+
+/*
+Exports the events still in the rings of all the threads as a Chrome trace (JSON Trace Event Format).
+Parameters:
+    - path (char*): the output file path ("./file" means it is in "g3ce")
+Returns:
+    true on success, false otherwise
+*/
+bool profiler_exportChromeTrace(char* path) {
+    FILE* file = file_open(path, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    pthread_mutex_lock(&profiler_mutex);
+    for (ProfilerThread* thread = profiler_threads; thread != NULL; thread = thread->next) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", thread->id);
+        json_writeString(file, thread->name);
+        fprintf(file, "}}");
+        first = false;
+
+        const uint64_t count = __atomic_load_n(&thread->count, __ATOMIC_ACQUIRE);
+        for (uint64_t index = count >= PROFILER_RING_EVENTS ? count - PROFILER_RING_EVENTS + 1 : 0; index < count; index++) {
+            const ProfilerEvent event = thread->events[index & (PROFILER_RING_EVENTS - 1)];
+            if (__atomic_load_n(&thread->count, __ATOMIC_ACQUIRE) - index >= PROFILER_RING_EVENTS) continue;
+            // complete events, in microseconds since the first profiled scope
+            fprintf(file, ",\n{\"name\":");
+            json_writeString(file, event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->id,
+                (double) (int64_t) (event.start - profiler_startTime) / 1000.0, (double) (event.end - event.start) / 1000.0);
+        }
+    }
+    pthread_mutex_unlock(&profiler_mutex);
+    fprintf(file, "\n]}\n");
+
+    const bool success = ferror(file) == 0;
+    if (fclose(file) != 0 || !success) {
+        console_error("Failed to write the trace at \"%s\"", path);
+        return false;
+    }
+    return true;
+}
+
+// frees the rings of all the threads (no thread may be profiling anymore), it is called by app_terminate()
+void profiler_shutdown() {
+    pthread_mutex_lock(&profiler_mutex);
+    ProfilerThread* thread = profiler_threads;
+    while (thread != NULL) {
+        ProfilerThread* next = thread->next;
+        free(thread);
+        thread = next;
+    }
+    profiler_threads = NULL;
+    profiler_gpuTrack = NULL;
+    profiler_threadCount = 0;
+    __atomic_add_fetch(&profiler_generation, 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&profiler_mutex);
+    profiler_current = NULL;
+}
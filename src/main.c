@@ -1,3 +1,6 @@
+#include <stdlib.h>
+#include <string.h>
+
 #include "engine/app.h"
 #include "engine/core/window.h"
 #include "engine/core/input.h"
@@ -13,17 +16,28 @@
 
 #include "main.h"
 
-int main() {
+int main(int argc, char** argv) {
     // create the app
-    app_create(800, 600, "My GLFW Window", 1);
+    if (argc > 1 && strcmp(argv[1], "--benchmark") == 0) {
+        // "G3CE --benchmark [frames] [report]" renders the frames offscreen (no display needed) and writes a JSON benchmark report
+        AppBenchmark benchmark = {
+            .frames = argc > 2 ? (unsigned int) atoi(argv[2]) : 1000,
+            .warmupFrames = 60,
+            .timestep = 1.0 / 60.0,
+            .reportPath = argc > 3 ? argv[3] : "./benchmark.json"
+        };
+        app_createHeadless(800, 600, benchmark);
+    } else {
+        app_create(800, 600, "My GLFW Window", 1);
+    }
 
     // app setup
     renderer_setGLClearColor(1, 1, 1, 1);
     renderer_setGLCullMode(GL_BACK);
     renderer_setGLDepthTest(GL_LESS);
     
-    // main app loop
-    app_loop(main_init, main_tick, main_draw, main_exit, on_resize);
+    // main app loop (60 updates per second, whatever the frame rate)
+    app_loopFixed(60.0, 0, main_init, main_tick, main_draw, main_exit, on_resize);
     // close the app when the loop is broken (you can break out of the loop ONLY by calling app_requestClose())
     app_terminate();
     
@@ -34,6 +48,9 @@ unsigned int shader;
 unsigned int texture;
 Object* cube;
 Camera* camera;
+// the camera state of the previous update and the one rendered (interpolated between the last two updates)
+Camera previousCamera;
+Camera renderCamera;
 
 mat4 projectionMatrix;
 
@@ -118,7 +135,9 @@ void main_init() {
     // setup camera
     camera = camera_create();
     camera->position.z = 3.0f;
-    renderer_useCamera(camera);
+    previousCamera = *camera;
+    renderCamera = *camera;
+    renderer_useCamera(&renderCamera);
     // camera_setRotation(camera, -30, 45, 0); // enable this when orthographic projection is on to have isometric view
 
     texture = texture_create("./assets/textures/wall.jpg", false);
@@ -135,8 +154,10 @@ void main_init() {
     cube = object_create(mesh);
 }
 
-// tick function (called once every frame, here you should put all you update code)
+// tick function (called 60 times per second, here you should put all you update code)
 void main_tick() {
+    previousCamera = *camera;
+
     // close the app when the ESCAPE key is pressed
     if (input_isKeyPressed(GLFW_KEY_ESCAPE)) {
         app_requestClose();
@@ -167,10 +188,10 @@ void main_tick() {
     // make the vector magnitude go to the maximum speed (in this case 0.1f);
     move = vec3_scale(move, 0.1f);
 
-    // camera motion speed is 0.1 units per tick
+    // camera motion speed is 0.1 units per tick (6 units per second)
     camera_moveByVector(camera, move);
 
-    // camera rotation speed is 1.5 degrees per tick
+    // camera rotation speed is 1.5 degrees per tick (90 degrees per second)
     if (input_isKeyDown(GLFW_KEY_LEFT)) camera_rotate(camera, 0, 1.5f, 0);
     if (input_isKeyDown(GLFW_KEY_RIGHT)) camera_rotate(camera, 0, -1.5f, 0);
     if (input_isKeyDown(GLFW_KEY_UP)) camera_rotate(camera, 1.5f, 0, 0);
@@ -184,7 +205,11 @@ void main_tick() {
 }
 
 // draw function (called once every frame, here you should put all you rendering code)
-void main_draw() {
+void main_draw(float alpha) {
+    // render the camera between its last two updates (smooth motion when the frame rate is not the update rate)
+    renderCamera.position = vec3_sum(previousCamera.position, vec3_scale(vec3_difference(camera->position, previousCamera.position), alpha));
+    renderCamera.rotation = quat_nlerp(previousCamera.rotation, camera->rotation, alpha);
+
     // renderer_prepare(); // called by renderer_renderObject()
     // YOU CAN UPLOAD UNIFORMS ONLY WHEN USING THE SHADER!!!
     // upload the updated matrices
@@ -195,9 +220,8 @@ void main_draw() {
 
 // exit function (called after breaking out from the app main loop, before terminating the app)
 void main_exit() {
-    // mesh_destroy(mesh);
+    mesh_delete(&cube->mesh); // the cube holds a copy of the stack mesh, deleting it also deletes its texture
     object_destroy(cube);
-    // texture_destroy(texture); // no need for this as it is assigned to the cube object that is freed when calling object_destroy()
     shader_destroy(shader);
     // transform_destroy(transform);
     camera_destroy(camera);
@@ -0,0 +1,465 @@
+/*
+BENCH:
+Microbenchmarks of the engine hot paths (math, transforms, camera, command buffers and the CPU side of renderer_renderObject()).
+Every benchmark is calibrated to run enough operations per repetition to last at least the minimum time, warmed up,
+then repeated: the report gives the nanoseconds per operation (mean, median, min, max, standard deviation and the 95%
+confidence interval of the mean) on the console and optionally as JSON, to track them over time.
+The renderer benchmarks need an OpenGL context, they run on an offscreen one (see window_createHeadless()), so they
+also work without a display (on Mesa's llvmpipe), and are skipped when it cannot be created.
+The profiler scopes are not compiled in, the hot paths are measured as in Release builds.
+
+Usage: G3CE_bench [-f filter] [-r repetitions] [-t min time per repetition in ms] [-j report.json] [--no-gl]
+(run it from "g3ce", the renderer benchmarks load the demo shader and texture from the assets folder)
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "engine/core/object.h"
+#include "engine/core/window.h"
+#include "engine/gfx/commandbuffer.h"
+#include "engine/gfx/mesh.h"
+#include "engine/gfx/renderer.h"
+#include "engine/gfx/shader.h"
+#include "engine/gfx/texture.h"
+#include "engine/math/camera.h"
+#include "engine/math/linal.h"
+#include "engine/math/transform.h"
+#include "engine/utils/console.h"
+#include "engine/utils/file.h"
+#include "engine/utils/json.h"
+#include "engine/utils/profiler.h"
+#include "engine/globals.h"
+
+// draws recorded in a command buffer before it is reset (or submitted)
+#define BENCH_COMMAND_DRAWS 64
+// inputs of every benchmark, cycled through so the compiler cannot fold the operations (a power of two)
+#define BENCH_INPUTS 64
+#define BENCH_MAX_RESULTS 64
+#define BENCH_MAX_REPETITIONS 1000
+// repetitions run (and discarded) before the measured ones, at least this many milliseconds
+#define BENCH_WARMUP_TIME 100.0
+
+// forces the compiler to compute the pointed value (and to assume it is read)
+#define BENCH_KEEP(pointer) __asm__ volatile("" : : "r"(pointer) : "memory")
+
+typedef struct {
+    const char* name;
+    // runs the operation the given number of times
+    void (*run)(uint64_t iterations);
+    // run after every repetition, outside of the timing (NULL for none)
+    void (*settle)();
+    bool gl; // needs the OpenGL context
+} Benchmark;
+
+typedef struct {
+    const char* name;
+    uint64_t iterations; // operations per repetition
+    unsigned int repetitions;
+    double mean, median, min, max, stddev;
+    double ci95; // half width of the 95% confidence interval of the mean
+} BenchmarkResult;
+
+// INPUTS
+static mat4 bench_matrices[BENCH_INPUTS];
+static vec4 bench_vectors4[BENCH_INPUTS];
+static vec3 bench_vectors3[BENCH_INPUTS];
+static quat bench_quaternions[BENCH_INPUTS];
+static Transform bench_transforms[BENCH_INPUTS];
+static Camera bench_cameras[BENCH_INPUTS];
+static Object* bench_object = NULL;
+static Camera* bench_camera = NULL;
+static unsigned int bench_shader = 0;
+static CommandBuffer* bench_commands = NULL;
+static Object bench_recordedObject; // only recorded, never drawn (its mesh is empty)
+
+// xorshift, the inputs are the same on every run
+static uint32_t bench_state = 0x9E3779B9u;
+static float bench_random(float min, float max) {
+    bench_state ^= bench_state << 13;
+    bench_state ^= bench_state >> 17;
+    bench_state ^= bench_state << 5;
+    return min + (max - min) * (float) (bench_state >> 8) / (float) (1u << 24);
+}
+
+static void bench_createInputs() {
+    for (unsigned int i = 0; i < BENCH_INPUTS; i++) {
+        for (unsigned int j = 0; j < 16; j++) bench_matrices[i].entries[j] = bench_random(-2.0f, 2.0f);
+        bench_vectors4[i] = vec4_new(bench_random(-10.0f, 10.0f), bench_random(-10.0f, 10.0f), bench_random(-10.0f, 10.0f), 1.0f);
+        bench_vectors3[i] = vec3_new(bench_random(-10.0f, 10.0f), bench_random(-10.0f, 10.0f), bench_random(-10.0f, 10.0f));
+        bench_quaternions[i] = quat_rotation(vec3_normalize(vec3_new(bench_random(-1.0f, 1.0f), bench_random(-1.0f, 1.0f), 1.0f)), bench_random(0.0f, 360.0f));
+
+        bench_transforms[i] = transform_new();
+        transform_setPosition(&bench_transforms[i], bench_random(-50.0f, 50.0f), bench_random(-50.0f, 50.0f), bench_random(-50.0f, 50.0f));
+        transform_setRotation(&bench_transforms[i], bench_random(0.0f, 360.0f), bench_random(0.0f, 360.0f), bench_random(0.0f, 360.0f));
+        transform_setScale(&bench_transforms[i], bench_random(0.5f, 2.0f), bench_random(0.5f, 2.0f), bench_random(0.5f, 2.0f));
+
+        bench_cameras[i].position = bench_vectors3[i];
+        camera_setRotation(&bench_cameras[i], bench_random(-89.0f, 89.0f), bench_random(0.0f, 360.0f), 0.0f);
+    }
+}
+
+// MATH BENCHMARKS
+static void bench_mat4Multiply(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        mat4 result = mat4_multiply(bench_matrices[i & (BENCH_INPUTS - 1)], bench_matrices[(i + 1) & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_mat4Transpose(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        mat4 result = mat4_transpose(bench_matrices[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_mat4Vec4Multiply(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        vec4 result = mat4_vec4_multiply(bench_matrices[i & (BENCH_INPUTS - 1)], bench_vectors4[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_vec3Normalize(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        vec3 result = vec3_normalize(bench_vectors3[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_vec3Cross(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        vec3 result = vec3_cross(bench_vectors3[i & (BENCH_INPUTS - 1)], bench_vectors3[(i + 1) & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_quatMultiply(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        quat result = quat_multiply(bench_quaternions[i & (BENCH_INPUTS - 1)], bench_quaternions[(i + 1) & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_quatRotation(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        quat result = quat_rotation(bench_vectors3[i & (BENCH_INPUTS - 1)], (float) (i & 255));
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_quatToMat4(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        mat4 result = quat_to_mat4(bench_quaternions[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_quatSlerp(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        quat result = quat_slerp(bench_quaternions[i & (BENCH_INPUTS - 1)], bench_quaternions[(i + 1) & (BENCH_INPUTS - 1)], (float) (i & 255) / 255.0f);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_quatNlerp(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        quat result = quat_nlerp(bench_quaternions[i & (BENCH_INPUTS - 1)], bench_quaternions[(i + 1) & (BENCH_INPUTS - 1)], (float) (i & 255) / 255.0f);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_mat4EulerRotation(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        mat4 result = mat4_eulerRotation(bench_vectors3[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_transformGetModelMatrix(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        mat4 result = transform_getModelMatrix(&bench_transforms[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_cameraGetViewMatrix(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        mat4 result = camera_getViewMatrix(&bench_cameras[i & (BENCH_INPUTS - 1)]);
+        BENCH_KEEP(&result);
+    }
+}
+
+static void bench_commandbufferDrawObject(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        if (bench_commands->drawCount == BENCH_COMMAND_DRAWS) commandbuffer_reset(bench_commands);
+        bench_recordedObject.transform = bench_transforms[i & (BENCH_INPUTS - 1)];
+        commandbuffer_drawObject(bench_commands, &bench_recordedObject);
+    }
+    BENCH_KEEP(bench_commands->data);
+}
+
+// RENDERER BENCHMARKS
+// creates the cube, the shader and the camera the renderer benchmarks draw with, returns false if they cannot be created
+static bool bench_createScene() {
+    float vertices[] = {
+        // position            // color                    UVs
+        -0.5f, -0.5f, -0.5f,   1.0f, 0.0f, 0.0f, 1.0f,     0.0f, 0.0f,
+         0.5f, -0.5f, -0.5f,   0.0f, 1.0f, 0.0f, 1.0f,     1.0f, 0.0f,
+         0.5f,  0.5f, -0.5f,   0.0f, 0.0f, 1.0f, 1.0f,     1.0f, 1.0f,
+        -0.5f,  0.5f, -0.5f,   1.0f, 1.0f, 1.0f, 1.0f,     0.0f, 1.0f,
+        -0.5f, -0.5f,  0.5f,   1.0f, 0.0f, 0.0f, 1.0f,     1.0f, 0.0f,
+         0.5f, -0.5f,  0.5f,   0.0f, 1.0f, 0.0f, 1.0f,     0.0f, 0.0f,
+         0.5f,  0.5f,  0.5f,   0.0f, 0.0f, 1.0f, 1.0f,     0.0f, 1.0f,
+        -0.5f,  0.5f,  0.5f,   1.0f, 1.0f, 1.0f, 1.0f,     1.0f, 1.0f,
+    };
+    unsigned int indices[] = {
+        4, 5, 6, 4, 6, 7, // front
+        1, 0, 3, 1, 3, 2, // back
+        3, 7, 6, 3, 6, 2, // top
+        0, 1, 5, 0, 5, 4, // bottom
+        1, 2, 6, 1, 6, 5, // right
+        0, 4, 7, 0, 7, 3, // left
+    };
+
+    bench_shader = shader_create("./assets/shaders/texture_vertex.glsl", "./assets/shaders/texture_fragment.glsl");
+    if (bench_shader == (unsigned int) -1) return false;
+    renderer_useShader(bench_shader);
+    shader_setInteger(bench_shader, "texture", 0);
+    shader_setMatrix4(bench_shader, "projection", matrix_getPerspectiveProjection(800.0f, 600.0f, 60.0f, 0.1f, 100.0f));
+
+    bench_camera = camera_create();
+    bench_camera->position.z = 3.0f;
+    renderer_useCamera(bench_camera);
+
+    Mesh mesh = mesh_new(vertices, sizeof(vertices), indices, sizeof(indices), 3+4+2, GL_TRIANGLES);
+    mesh_registerVertexAttribute(&mesh, 0, 3); // position attribute
+    mesh_registerVertexAttribute(&mesh, 1, 4); // color attribute
+    mesh_registerVertexAttribute(&mesh, 2, 2); // uv attribute
+    const unsigned int texture = texture_create("./assets/textures/wall.jpg", false);
+    if (texture != (unsigned int) -1) mesh_assignTexture(&mesh, texture, 0);
+    bench_object = object_create(mesh);
+    return bench_object != NULL;
+}
+
+// draws the cube from a different transform every time (the CPU side: state binds, uniform uploads and the draw call submission)
+static void bench_renderObject(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench_object->transform = bench_transforms[i & (BENCH_INPUTS - 1)];
+        renderer_renderObject(bench_object);
+    }
+}
+
+// the same, with the camera moving every time (the view matrix is uploaded again)
+static void bench_renderObjectMovingCamera(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        *bench_camera = bench_cameras[i & (BENCH_INPUTS - 1)];
+        bench_object->transform = bench_transforms[i & (BENCH_INPUTS - 1)];
+        renderer_renderObject(bench_object);
+    }
+}
+
+// records the cube like bench_renderObject() draws it, submitting the buffer every BENCH_COMMAND_DRAWS draws (recording and replay)
+static void bench_commandbufferSubmit(uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; i++) {
+        bench_object->transform = bench_transforms[i & (BENCH_INPUTS - 1)];
+        commandbuffer_drawObject(bench_commands, bench_object);
+        if (bench_commands->drawCount == BENCH_COMMAND_DRAWS) {
+            commandbuffer_submit(&bench_commands, 1);
+            commandbuffer_reset(bench_commands);
+        }
+    }
+}
+
+// lets the driver execute the queued draw calls (so they do not pile up) and resets the render counters
+static void bench_finishFrame() {
+    glFinish();
+    renderer_collectStats();
+}
+
+static const Benchmark bench_benchmarks[] = {
+    { "mat4_multiply", bench_mat4Multiply, NULL, false },
+    { "mat4_transpose", bench_mat4Transpose, NULL, false },
+    { "mat4_vec4_multiply", bench_mat4Vec4Multiply, NULL, false },
+    { "vec3_normalize", bench_vec3Normalize, NULL, false },
+    { "vec3_cross", bench_vec3Cross, NULL, false },
+    { "quat_multiply", bench_quatMultiply, NULL, false },
+    { "quat_rotation", bench_quatRotation, NULL, false },
+    { "quat_to_mat4", bench_quatToMat4, NULL, false },
+    { "quat_slerp", bench_quatSlerp, NULL, false },
+    { "quat_nlerp", bench_quatNlerp, NULL, false },
+    { "mat4_eulerRotation", bench_mat4EulerRotation, NULL, false },
+    { "transform_getModelMatrix", bench_transformGetModelMatrix, NULL, false },
+    { "camera_getViewMatrix", bench_cameraGetViewMatrix, NULL, false },
+    { "commandbuffer_drawObject", bench_commandbufferDrawObject, NULL, false },
+    { "renderer_renderObject", bench_renderObject, bench_finishFrame, true },
+    { "renderer_renderObject (moving camera)", bench_renderObjectMovingCamera, bench_finishFrame, true },
+    { "commandbuffer_submit", bench_commandbufferSubmit, bench_finishFrame, true },
+};
+
+// STATISTICS
+static int bench_compareDoubles(const void* a, const void* b) {
+    const double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+// two-sided 95% quantile of the Student's t distribution with the given degrees of freedom
+static double bench_studentT95(unsigned int degrees) {
+    static const double table[] = {
+        0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (degrees < sizeof(table) / sizeof(table[0])) return table[degrees];
+    if (degrees < 60) return 2.000;
+    if (degrees < 120) return 1.980;
+    return 1.960;
+}
+
+// returns the nanoseconds per operation of a repetition of the given number of operations
+static double bench_measure(const Benchmark* benchmark, uint64_t iterations) {
+    const uint64_t start = profiler_getTime();
+    benchmark->run(iterations);
+    const uint64_t end = profiler_getTime();
+    if (benchmark->settle != NULL) benchmark->settle();
+    return (double) (end - start) / (double) iterations;
+}
+
+// calibrates, warms up and repeats a benchmark
+static BenchmarkResult bench_run(const Benchmark* benchmark, unsigned int repetitions, double minTime) {
+    BenchmarkResult result = { .name = benchmark->name, .repetitions = repetitions };
+
+    // double the operations until a repetition lasts the minimum time
+    uint64_t iterations = 1;
+    double time = 0.0;
+    while ((time = bench_measure(benchmark, iterations) * (double) iterations / 1000000.0) < minTime && iterations < (1ull << 40)) {
+        // jump close to the target when the measurement is significant
+        if (time > minTime / 100.0) iterations = (uint64_t) ((double) iterations * minTime / time * 1.1) + 1;
+        else iterations *= 2;
+    }
+    result.iterations = iterations;
+
+    // warmup (caches, branch predictors, frequency scaling)
+    for (double warmup = 0.0; warmup < BENCH_WARMUP_TIME;) warmup += bench_measure(benchmark, iterations) * (double) iterations / 1000000.0;
+
+    double samples[BENCH_MAX_REPETITIONS];
+    double total = 0.0;
+    for (unsigned int i = 0; i < repetitions; i++) {
+        samples[i] = bench_measure(benchmark, iterations);
+        total += samples[i];
+    }
+    result.mean = total / repetitions;
+    double variance = 0.0;
+    for (unsigned int i = 0; i < repetitions; i++) variance += (samples[i] - result.mean) * (samples[i] - result.mean);
+    result.stddev = repetitions > 1 ? sqrt(variance / (repetitions - 1)) : 0.0;
+    result.ci95 = repetitions > 1 ? bench_studentT95(repetitions - 1) * result.stddev / sqrt((double) repetitions) : 0.0;
+
+    qsort(samples, repetitions, sizeof(double), bench_compareDoubles);
+    result.min = samples[0];
+    result.max = samples[repetitions - 1];
+    result.median = repetitions % 2 == 1 ? samples[repetitions / 2] : (samples[repetitions / 2 - 1] + samples[repetitions / 2]) / 2.0;
+    return result;
+}
+
+// writes the results as JSON (times in nanoseconds per operation)
+static bool bench_writeReport(char* path, const BenchmarkResult* results, unsigned int count, unsigned int repetitions, double minTime, bool gl) {
+    FILE* file = file_open(path, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "{\n  \"repetitions\": %u, \"minTime\": %.3f, \"warmupTime\": %.3f,\n", repetitions, minTime, BENCH_WARMUP_TIME);
+    fprintf(file, "  \"gl\": ");
+    if (gl) {
+        fprintf(file, "{\"vendor\": ");
+        json_writeString(file, (const char*) glGetString(GL_VENDOR));
+        fprintf(file, ", \"renderer\": ");
+        json_writeString(file, (const char*) glGetString(GL_RENDERER));
+        fprintf(file, ", \"version\": ");
+        json_writeString(file, (const char*) glGetString(GL_VERSION));
+        fprintf(file, "},\n");
+    } else {
+        fprintf(file, "null,\n");
+    }
+    fprintf(file, "  \"benchmarks\": [");
+    for (unsigned int i = 0; i < count; i++) {
+        const BenchmarkResult* result = &results[i];
+        fprintf(file, "%s\n    {\"name\": ", i == 0 ? "" : ",");
+        json_writeString(file, result->name);
+        fprintf(file, ", \"unit\": \"ns/op\", \"iterations\": %llu, \"repetitions\": %u, \"mean\": %.4f, \"median\": %.4f, \"min\": %.4f, \"max\": %.4f, \"stddev\": %.4f, \"ci95\": %.4f}",
+            (unsigned long long) result->iterations, result->repetitions, result->mean, result->median, result->min, result->max, result->stddev, result->ci95);
+    }
+    fprintf(file, "%s]\n}\n", count > 0 ? "\n  " : "");
+
+    const bool success = ferror(file) == 0;
+    if (fclose(file) != 0 || !success) {
+        console_error("Failed to write the report at \"%s\"", path);
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* filter = NULL;
+    char* reportPath = NULL;
+    unsigned int repetitions = 20;
+    double minTime = 20.0;
+    bool useGL = true;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) filter = argv[++i];
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) repetitions = (unsigned int) atoi(argv[++i]);
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) minTime = atof(argv[++i]);
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) reportPath = argv[++i];
+        else if (strcmp(argv[i], "--no-gl") == 0) useGL = false;
+        else {
+            console_output("Usage: %s [-f filter] [-r repetitions] [-t min time per repetition in ms] [-j report.json] [--no-gl]", argv[0]);
+            return 1;
+        }
+    }
+    if (repetitions < 2) repetitions = 2;
+    if (repetitions > BENCH_MAX_REPETITIONS) repetitions = BENCH_MAX_REPETITIONS;
+    if (minTime <= 0.0) minTime = 20.0;
+
+    bench_createInputs();
+    bench_commands = commandbuffer_create(0);
+    if (bench_commands == NULL) return 1;
+
+    // the renderer benchmarks draw into an offscreen framebuffer
+    bool gl = false;
+    if (useGL) {
+        window = window_createHeadless(800, 600);
+        gl = window != NULL && bench_createScene();
+        if (!gl) console_warning("No OpenGL context, the renderer benchmarks are skipped");
+    }
+
+    static BenchmarkResult results[BENCH_MAX_RESULTS];
+    unsigned int count = 0;
+    console_output("%-40s %12s %10s %12s %12s %12s %8s", "benchmark (ns/op)", "mean", "+- 95%", "median", "min", "max", "rsd");
+    for (unsigned int i = 0; i < sizeof(bench_benchmarks) / sizeof(bench_benchmarks[0]) && count < BENCH_MAX_RESULTS; i++) {
+        const Benchmark* benchmark = &bench_benchmarks[i];
+        if (filter != NULL && strstr(benchmark->name, filter) == NULL) continue;
+        if (benchmark->gl && !gl) continue;
+
+        const BenchmarkResult result = bench_run(benchmark, repetitions, minTime);
+        results[count++] = result;
+        console_output("%-40s %12.3f %10.3f %12.3f %12.3f %12.3f %7.2f%%", result.name, result.mean, result.ci95, result.median, result.min, result.max,
+            result.mean > 0.0 ? result.stddev / result.mean * 100.0 : 0.0);
+    }
+
+    bool success = true;
+    if (reportPath != NULL) success = bench_writeReport(reportPath, results, count, repetitions, minTime, gl);
+
+    if (gl) {
+        object_destroy(bench_object);
+        camera_destroy(bench_camera);
+        shader_destroy(bench_shader);
+        window_destroy();
+    }
+    commandbuffer_destroy(bench_commands);
+    return success ? 0 : 1;
+}
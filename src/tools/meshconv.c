@@ -0,0 +1,141 @@
+/*
+MESHCONV:
+Offline mesh converter.
+Converts Wavefront OBJ files (loaded via obj_load(), see obj.h) into a binary mesh file that can be loaded at runtime via mesh_load() (see meshfile.h).
+The vertices are interleaved as: position (3 floats, location 0), color (4 normalized bytes, location 1, the vertex or material color),
+UV (2 floats, location 2, only if the OBJ has UVs), normal (3 floats, location 4, only if the OBJ has normals).
+Each additional OBJ is stored as a lower level of detail (LOD) of the first one, together with the distance from which it should be used:
+all the LODs share the same vertex buffer, each one with its own range of indices.
+
+Usage: G3CE_meshconv <output.g3mesh> <lod0.obj> [<distance> <lodN.obj>]...
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "engine/gfx/meshfile.h"
+#include "engine/gfx/obj.h"
+#include "engine/utils/console.h"
+
+// the shared output of all the LODs
+typedef struct {
+    unsigned char* vertices;
+    uint32_t vertexCount;
+    uint32_t* indices;
+    size_t indexCount;
+    unsigned int stride;
+    bool hasUvs;
+    bool hasNormals;
+} MeshOutput;
+
+// appends the vertices and indices of a model to the output, converting them to the output layout
+static bool meshconv_append(MeshOutput* output, ObjModel* model, char* path) {
+    if ((uint64_t) output->vertexCount + model->vertexCount > UINT32_MAX) {
+        console_error("Too many vertices in \"%s\"", path);
+        return false;
+    }
+    unsigned char* vertices = (unsigned char*) realloc(output->vertices, ((size_t) output->vertexCount + model->vertexCount) * output->stride + 1);
+    if (vertices != NULL) output->vertices = vertices;
+    uint32_t* indices = (uint32_t*) realloc(output->indices, (output->indexCount + model->indexCount) * sizeof(uint32_t) + 1);
+    if (indices != NULL) output->indices = indices;
+    if (vertices == NULL || indices == NULL) {
+        console_error("Failed to allocate memory for converting \"%s\"", path);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < model->vertexCount; i++) {
+        const float* source = model->vertices + (size_t) i * model->vertexLength;
+        unsigned char* vertex = output->vertices + ((size_t) output->vertexCount + i) * output->stride;
+
+        memcpy(vertex, source, 3 * sizeof(float));
+        vertex += 3 * sizeof(float);
+        for (int c = 0; c < 4; c++) {
+            const float value = source[3 + c];
+            vertex[c] = (unsigned char) (value <= 0.0f ? 0 : value >= 1.0f ? 255 : value * 255.0f + 0.5f);
+        }
+        vertex += 4;
+        const float* next = source + 7;
+        if (output->hasUvs) {
+            const float zero[2] = { 0.0f, 0.0f };
+            memcpy(vertex, model->hasUvs ? next : zero, 2 * sizeof(float));
+            vertex += 2 * sizeof(float);
+        }
+        if (model->hasUvs) next += 2;
+        if (output->hasNormals) {
+            const float zero[3] = { 0.0f, 0.0f, 0.0f };
+            memcpy(vertex, model->hasNormals ? next : zero, 3 * sizeof(float));
+        }
+    }
+
+    for (unsigned int i = 0; i < model->indexCount; i++) output->indices[output->indexCount + i] = output->vertexCount + model->indices[i];
+    output->vertexCount += model->vertexCount;
+    output->indexCount += model->indexCount;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc % 2 == 0) {
+        console_output("Usage: %s <output.g3mesh> <lod0.obj> [<distance> <lodN.obj>]...", argv[0]);
+        return 1;
+    }
+
+    const unsigned int lodCount = (unsigned int) (argc - 1) / 2;
+    if (lodCount > MESHFILE_MAX_LODS) {
+        console_error("Too many LODs (%u, the maximum is %d)", lodCount, MESHFILE_MAX_LODS);
+        return 1;
+    }
+
+    MeshOutput output = { 0 };
+    MeshFileAttribute attributes[4];
+    unsigned int attributeCount = 0;
+    MeshFileLod lods[MESHFILE_MAX_LODS];
+    bool success = true;
+    for (unsigned int i = 0; i < lodCount && success; i++) {
+        lods[i].indexStart = (uint32_t) output.indexCount;
+        lods[i].distance = i > 0 ? strtof(argv[1 + i * 2], NULL) : 0.0f;
+        if (i > 0 && lods[i].distance <= lods[i - 1].distance) {
+            console_error("The LOD distances must be increasing (%g after %g)", lods[i].distance, lods[i - 1].distance);
+            success = false;
+            break;
+        }
+
+        ObjModel model;
+        success = obj_load(argv[2 + i * 2], 0, &model);
+        if (!success) break;
+
+        // the layout is the same for all the LODs: it has UVs and normals if the full detail OBJ has them
+        if (i == 0) {
+            output.hasUvs = model.hasUvs;
+            output.hasNormals = model.hasNormals;
+            attributes[attributeCount++] = (MeshFileAttribute) { MESHFILE_LOCATION_POSITION, 3, MESHFILE_TYPE_FLOAT, 0, output.stride };
+            output.stride += 3 * sizeof(float);
+            attributes[attributeCount++] = (MeshFileAttribute) { MESHFILE_LOCATION_COLOR, 4, MESHFILE_TYPE_UNSIGNED_BYTE, 1, output.stride };
+            output.stride += 4;
+            if (output.hasUvs) {
+                attributes[attributeCount++] = (MeshFileAttribute) { MESHFILE_LOCATION_UV, 2, MESHFILE_TYPE_FLOAT, 0, output.stride };
+                output.stride += 2 * sizeof(float);
+            }
+            if (output.hasNormals) {
+                attributes[attributeCount++] = (MeshFileAttribute) { MESHFILE_LOCATION_NORMAL, 3, MESHFILE_TYPE_FLOAT, 0, output.stride };
+                output.stride += 3 * sizeof(float);
+            }
+        }
+
+        success = meshconv_append(&output, &model, argv[2 + i * 2]);
+        lods[i].indexCount = (uint32_t) (output.indexCount - lods[i].indexStart);
+        obj_free(&model);
+    }
+
+    if (success) {
+        success = meshfile_write(argv[1], attributes, attributeCount, output.vertices, output.vertexCount, output.stride,
+            output.indices, lods, lodCount, MESHFILE_DRAW_TRIANGLES);
+    }
+    if (success) {
+        console_info("Converted %u LODs (%u vertices, %zu indices, %u bytes per vertex) into \"%s\"", lodCount, output.vertexCount, output.indexCount, output.stride, argv[1]);
+    }
+
+    free(output.vertices);
+    free(output.indices);
+    return success ? 0 : 1;
+}
@@ -0,0 +1,125 @@
+/*
+MIPBENCH:
+Mip chain generation benchmark.
+Compares the time the driver takes to build a mip chain via glGenerateMipmap() with the CPU generator (see mipmap.h),
+both on its own (the part that can run on a worker thread) and including the upload of all the levels.
+
+Usage: G3CE_mipbench <input image> [iterations]
+*/
+
+#include <stdlib.h>
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <stbi/stb_image.h>
+
+#include "engine/gfx/mipmap.h"
+#include "engine/utils/console.h"
+
+// uploads the full size image and lets the driver build the rest of the chain
+static void mipbench_driver(const unsigned char* pixels, int width, int height) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    // wait for the driver to actually do the work
+    glFinish();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+}
+
+// uploads every level of an already generated mip chain
+static void mipbench_upload(const MipChain* chain) {
+    unsigned int texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, chain->levelCount - 1);
+    for (unsigned int i = 0; i < chain->levelCount; i++) {
+        const MipLevel* level = &chain->levels[i];
+        glTexImage2D(GL_TEXTURE_2D, i, GL_RGBA, level->width, level->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, level->data);
+    }
+    glFinish();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDeleteTextures(1, &texture);
+}
+
+// runs the CPU generator with the given settings and prints its average timings (in milliseconds)
+static void mipbench_cpu(const char* name, const unsigned char* pixels, int width, int height, MipmapFilter filter, bool srgb, int iterations) {
+    double generateTime = 0.0, uploadTime = 0.0;
+    for (int i = 0; i < iterations; i++) {
+        MipChain chain;
+        const double start = glfwGetTime();
+        if (!mipmap_generate(pixels, width, height, filter, srgb, &chain)) return;
+        const double generated = glfwGetTime();
+        mipbench_upload(&chain);
+        const double uploaded = glfwGetTime();
+        mipmap_free(&chain);
+
+        generateTime += generated - start;
+        uploadTime += uploaded - generated;
+    }
+    console_output("%-22s %10.3f ms generate %10.3f ms upload %10.3f ms total", name,
+        generateTime * 1000.0 / iterations, uploadTime * 1000.0 / iterations, (generateTime + uploadTime) * 1000.0 / iterations);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        console_output("Usage: %s <input image> [iterations]", argv[0]);
+        return 1;
+    }
+    const int iterations = argc > 2 && atoi(argv[2]) > 0 ? atoi(argv[2]) : 20;
+
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(argv[1], &width, &height, &channels, 4);
+    if (pixels == NULL) {
+        console_error("Failed to load image at \"%s\"", argv[1]);
+        return 1;
+    }
+
+    // the driver path needs an OpenGL context, an invisible window is enough
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "G3CE mipbench", NULL, NULL);
+    if (window == NULL) {
+        console_error("Failed to create GLFW window");
+        stbi_image_free(pixels);
+        glfwTerminate();
+        return 1;
+    }
+    glfwMakeContextCurrent(window);
+    if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
+        console_error("Failed to load GLAD");
+        stbi_image_free(pixels);
+        glfwTerminate();
+        return 1;
+    }
+
+    console_info("%dx%d image, %u mip levels, %d iterations, CPU filters use %s", width, height,
+        mipmap_getLevelCount(width, height), iterations, mipmap_getInstructionSet());
+
+    // warm up the driver (the first texture upload is always slower)
+    mipbench_driver(pixels, width, height);
+
+    double driverTime = 0.0;
+    for (int i = 0; i < iterations; i++) {
+        const double start = glfwGetTime();
+        mipbench_driver(pixels, width, height);
+        driverTime += glfwGetTime() - start;
+    }
+    console_output("%-22s %10.3f ms total", "glGenerateMipmap", driverTime * 1000.0 / iterations);
+
+    mipbench_cpu("CPU box", pixels, width, height, MIPMAP_FILTER_BOX, false, iterations);
+    mipbench_cpu("CPU box (sRGB)", pixels, width, height, MIPMAP_FILTER_BOX, true, iterations);
+    mipbench_cpu("CPU Kaiser", pixels, width, height, MIPMAP_FILTER_KAISER, false, iterations);
+    mipbench_cpu("CPU Kaiser (sRGB)", pixels, width, height, MIPMAP_FILTER_KAISER, true, iterations);
+
+    stbi_image_free(pixels);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return 0;
+}
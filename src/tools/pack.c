@@ -0,0 +1,258 @@
+/*
+PACK:
+Asset packer.
+Bundles files and whole directories (recursively) into a single archive that can be mounted at runtime via archive_mount(),
+so the engine loads all of them with a single mapping and a hash lookup each instead of opening every file (see archive.h).
+The files are stored with the path they are given with (e.g. "assets/shaders/default_vertex.glsl"), so run it from "g3ce".
+
+Usage: G3CE_pack <output archive> [-c] <file or directory>...
+    -c  LZ4 compress the files that get at least 10% smaller (the others are stored as they are)
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "engine/utils/archive.h"
+#include "engine/utils/lz4.h"
+#include "engine/utils/file.h"
+#include "engine/utils/console.h"
+
+// a file to pack
+typedef struct {
+    char* path;          // normalized path (no leading "./", "/" separators)
+    unsigned char* data; // the data to store (compressed or not)
+    size_t size;         // the size of the data to store
+    size_t originalSize; // the size of the file
+    bool compressed;
+    uint64_t hash;
+} PackFile;
+
+typedef struct {
+    PackFile* files;
+    size_t count;
+    size_t capacity;
+} PackList;
+
+// returns a normalized copy of a path (no leading "./", "/" separators)
+static char* pack_normalizePath(const char* path) {
+    while (path[0] == '.' && (path[1] == '/' || path[1] == '\\')) path += 2;
+    char* normalized = (char*) malloc(strlen(path) + 1);
+    if (normalized == NULL) return NULL;
+    for (size_t i = 0; ; i++) {
+        normalized[i] = path[i] == '\\' ? '/' : path[i];
+        if (path[i] == '\0') break;
+    }
+    return normalized;
+}
+
+// reads a file and adds it to the list (compressing it if requested)
+static bool pack_addFile(PackList* list, const char* path, bool compress) {
+    if (list->count == list->capacity) {
+        const size_t capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        PackFile* files = (PackFile*) realloc(list->files, capacity * sizeof(PackFile));
+        if (files == NULL) {
+            console_error("Failed to allocate memory for the file list");
+            return false;
+        }
+        list->files = files;
+        list->capacity = capacity;
+    }
+
+    PackFile file = { 0 };
+    file.path = pack_normalizePath(path);
+    if (file.path == NULL) {
+        console_error("Failed to allocate memory for path \"%s\"", path);
+        return false;
+    }
+    file.data = file_readBytes((char*) path, &file.originalSize);
+    if (file.data == NULL) {
+        free(file.path);
+        return false;
+    }
+    file.size = file.originalSize;
+    file.hash = archive_hashPath(file.path);
+
+    if (compress && file.originalSize > 0) {
+        const size_t bound = lz4_compressBound(file.originalSize);
+        unsigned char* compressed = (unsigned char*) malloc(bound);
+        const size_t compressedSize = compressed != NULL ? lz4_compress(file.data, file.originalSize, compressed, bound) : 0;
+        // only keep the compressed data when it is worth the decompression time
+        if (compressedSize > 0 && compressedSize <= file.originalSize - file.originalSize / 10) {
+            free(file.data);
+            file.data = compressed;
+            file.size = compressedSize;
+            file.compressed = true;
+        } else {
+            free(compressed);
+        }
+    }
+
+    list->files[list->count++] = file;
+    return true;
+}
+
+// adds a file or all the files of a directory (recursively) to the list, skipping the archive being written
+static bool pack_addPath(PackList* list, const char* path, const char* outputPath, bool compress) {
+    struct stat info;
+    if (stat(path, &info) != 0) {
+        console_error("No file or directory at \"%s\"", path);
+        return false;
+    }
+
+    if (!S_ISDIR(info.st_mode)) {
+        char* normalized = pack_normalizePath(path);
+        const bool isOutput = normalized != NULL && strcmp(normalized, outputPath) == 0;
+        free(normalized);
+        return isOutput ? true : pack_addFile(list, path, compress);
+    }
+
+    DIR* directory = opendir(path);
+    if (directory == NULL) {
+        console_error("Failed to open directory at \"%s\"", path);
+        return false;
+    }
+
+    bool success = true;
+    struct dirent* child;
+    while (success && (child = readdir(directory)) != NULL) {
+        if (strcmp(child->d_name, ".") == 0 || strcmp(child->d_name, "..") == 0) continue;
+
+        const size_t length = strlen(path) + 1 + strlen(child->d_name) + 1;
+        char* childPath = (char*) malloc(length);
+        if (childPath == NULL) {
+            console_error("Failed to allocate memory for a path in \"%s\"", path);
+            success = false;
+            break;
+        }
+        snprintf(childPath, length, "%s/%s", path, child->d_name);
+        success = pack_addPath(list, childPath, outputPath, compress);
+        free(childPath);
+    }
+    closedir(directory);
+
+    return success;
+}
+
+// sorts the files by hash (and by path for the, very unlikely, equal hashes) as the archive index requires
+static int pack_compareFiles(const void* a, const void* b) {
+    const PackFile* first = (const PackFile*) a;
+    const PackFile* second = (const PackFile*) b;
+    if (first->hash != second->hash) return first->hash < second->hash ? -1 : 1;
+    return strcmp(first->path, second->path);
+}
+
+// returns the given offset rounded up to the next ARCHIVE_ALIGNMENT multiple
+static uint64_t pack_align(uint64_t offset) {
+    return (offset + ARCHIVE_ALIGNMENT - 1) / ARCHIVE_ALIGNMENT * ARCHIVE_ALIGNMENT;
+}
+
+// writes padding bytes up to the given offset
+static bool pack_pad(FILE* file, uint64_t offset) {
+    static const unsigned char zeros[ARCHIVE_ALIGNMENT] = { 0 };
+    const long position = ftell(file);
+    if (position < 0 || (uint64_t) position > offset) return false;
+    const size_t padding = (size_t) (offset - (uint64_t) position);
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+// writes the archive (header, index, path strings and the aligned data of every file)
+static bool pack_write(PackList* list, char* outputPath) {
+    qsort(list->files, list->count, sizeof(PackFile), pack_compareFiles);
+
+    ArchiveHeader header = { 0 };
+    memcpy(header.magic, ARCHIVE_MAGIC, 4);
+    header.version = ARCHIVE_VERSION;
+    header.entryCount = (uint32_t) list->count;
+    header.indexOffset = sizeof(ArchiveHeader);
+    header.stringsOffset = header.indexOffset + list->count * sizeof(ArchiveEntry);
+
+    ArchiveEntry* entries = (ArchiveEntry*) calloc(list->count > 0 ? list->count : 1, sizeof(ArchiveEntry));
+    if (entries == NULL) {
+        console_error("Failed to allocate memory for the archive index");
+        return false;
+    }
+
+    // lay out the path strings first, then the data
+    uint64_t stringsSize = 0;
+    for (size_t i = 0; i < list->count; i++) {
+        entries[i].hash = list->files[i].hash;
+        entries[i].pathOffset = (uint32_t) stringsSize;
+        entries[i].pathLength = (uint32_t) strlen(list->files[i].path);
+        stringsSize += entries[i].pathLength;
+    }
+    uint64_t offset = header.stringsOffset + stringsSize;
+    for (size_t i = 0; i < list->count; i++) {
+        offset = pack_align(offset);
+        entries[i].offset = offset;
+        entries[i].size = list->files[i].size;
+        entries[i].originalSize = list->files[i].originalSize;
+        entries[i].flags = list->files[i].compressed ? ARCHIVE_FLAG_COMPRESSED : 0;
+        offset += list->files[i].size;
+    }
+
+    FILE* file = file_open(outputPath, "wb");
+    if (file == NULL) {
+        free(entries);
+        return false;
+    }
+
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (success && list->count > 0) success = fwrite(entries, sizeof(ArchiveEntry), list->count, file) == list->count;
+    for (size_t i = 0; i < list->count && success; i++) {
+        success = fwrite(list->files[i].path, 1, entries[i].pathLength, file) == entries[i].pathLength;
+    }
+    for (size_t i = 0; i < list->count && success; i++) {
+        success = pack_pad(file, entries[i].offset) && fwrite(list->files[i].data, 1, list->files[i].size, file) == list->files[i].size;
+    }
+    fclose(file);
+    free(entries);
+
+    if (!success) console_error("Failed to write archive at \"%s\"", outputPath);
+    return success;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        console_output("Usage: %s <output archive> [-c] <file or directory>...", argv[0]);
+        return 1;
+    }
+
+    char* outputPath = pack_normalizePath(argv[1]);
+    if (outputPath == NULL) return 1;
+
+    PackList list = { 0 };
+    bool compress = false;
+    bool success = true;
+    for (int i = 2; i < argc && success; i++) {
+        if (strcmp(argv[i], "-c") == 0) compress = true;
+        else success = pack_addPath(&list, argv[i], outputPath, compress);
+    }
+
+    // two paths could have been given twice (or through a file and its directory)
+    if (success) {
+        qsort(list.files, list.count, sizeof(PackFile), pack_compareFiles);
+        for (size_t i = 1; i < list.count && success; i++) {
+            if (strcmp(list.files[i - 1].path, list.files[i].path) == 0) {
+                console_error("File \"%s\" has been given more than once", list.files[i].path);
+                success = false;
+            }
+        }
+    }
+    if (success) success = pack_write(&list, outputPath);
+
+    size_t totalSize = 0, storedSize = 0, compressedCount = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        totalSize += list.files[i].originalSize;
+        storedSize += list.files[i].size;
+        if (list.files[i].compressed) compressedCount++;
+        free(list.files[i].path);
+        free(list.files[i].data);
+    }
+    free(list.files);
+
+    if (success) console_info("Packed %zu files (%zu compressed, %zu -> %zu bytes) into \"%s\"", list.count, compressedCount, totalSize, storedSize, outputPath);
+    free(outputPath);
+    return success ? 0 : 1;
+}
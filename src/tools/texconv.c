@@ -0,0 +1,77 @@
+/*
+TEXCONV:
+Offline texture compressor.
+Loads an image, builds its whole mip chain (box or Kaiser filter, optionally gamma-correct) and compresses
+every level to BC1, BC3 or BC7, storing the result into a DDS file that can be loaded at runtime via texture_createCompressed().
+
+Usage: G3CE_texconv <input image> <output.dds> [bc1|bc3|bc7] [box|kaiser] [srgb]
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <stbi/stb_image.h>
+
+#include "engine/gfx/bcn.h"
+#include "engine/gfx/dds.h"
+#include "engine/gfx/mipmap.h"
+#include "engine/utils/console.h"
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        console_output("Usage: %s <input image> <output.dds> [bc1|bc3|bc7] [box|kaiser] [srgb]", argv[0]);
+        return 1;
+    }
+
+    BcnFormat format = BCN_FORMAT_BC1;
+    MipmapFilter filter = MIPMAP_FILTER_BOX;
+    bool srgb = false;
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "bc1") == 0) format = BCN_FORMAT_BC1;
+        else if (strcmp(argv[i], "bc3") == 0) format = BCN_FORMAT_BC3;
+        else if (strcmp(argv[i], "bc7") == 0) format = BCN_FORMAT_BC7;
+        else if (strcmp(argv[i], "box") == 0) filter = MIPMAP_FILTER_BOX;
+        else if (strcmp(argv[i], "kaiser") == 0) filter = MIPMAP_FILTER_KAISER;
+        else if (strcmp(argv[i], "srgb") == 0) srgb = true;
+        else {
+            console_error("Unknown option \"%s\" (use bc1, bc3, bc7, box, kaiser or srgb)", argv[i]);
+            return 1;
+        }
+    }
+
+    // flip the image just like the engine does when loading textures, so the UVs match
+    stbi_set_flip_vertically_on_load(true);
+    int width, height, channels;
+    unsigned char* pixels = stbi_load(argv[1], &width, &height, &channels, 4);
+    if (pixels == NULL) {
+        console_error("Failed to load image at \"%s\"", argv[1]);
+        return 1;
+    }
+
+    // build the whole mip chain at once
+    MipChain chain;
+    bool success = mipmap_generate(pixels, width, height, filter, srgb, &chain);
+    stbi_image_free(pixels);
+    if (!success) return 1;
+
+    const unsigned int levelCount = chain.levelCount < DDS_MAX_LEVELS ? chain.levelCount : DDS_MAX_LEVELS;
+    unsigned char* levels[DDS_MAX_LEVELS] = { NULL };
+    for (unsigned int i = 0; i < levelCount && success; i++) {
+        const MipLevel* level = &chain.levels[i];
+        levels[i] = (unsigned char*) malloc(bcn_getImageSize(format, level->width, level->height));
+        if (levels[i] == NULL) {
+            console_error("Failed to allocate memory for mip level %u", i);
+            success = false;
+            break;
+        }
+        bcn_compressImage(format, level->data, level->width, level->height, levels[i]);
+    }
+    mipmap_free(&chain);
+
+    if (success) success = dds_write(argv[2], format, width, height, levels, levelCount);
+    for (unsigned int i = 0; i < levelCount; i++) free(levels[i]);
+
+    if (!success) return 1;
+    console_info("Compressed \"%s\" (%dx%d, %u mip levels) to \"%s\"", argv[1], width, height, levelCount, argv[2]);
+    return 0;
+}